@@ -91,37 +91,39 @@ class QUICHE_EXPORT_PRIVATE HpackHuffmanDecoder {
   ~HpackHuffmanDecoder();
 
   // Prepare for decoding a new Huffman encoded string.
-  void Reset() { bit_buffer_.Reset(); }
+  void Reset() { state_ = 0; }
 
   // Decode the portion of a HPACK Huffman encoded string that is in |input|,
-  // appending the decoded symbols into |*output|, stopping when more bits are
-  // needed to determine the next symbol, which/ means that the input has been
-  // drained, and also that the bit_buffer_ is empty or that the bits that are
-  // in it are not a whole symbol.
+  // appending the decoded symbols into |*output|. The input is decoded a
+  // byte at a time by a state machine built from the Huffman table of the
+  // HPACK spec. Its 256 states are the internal nodes of the code tree, i.e.
+  // the leading bits of a code which is not yet complete, and a table of
+  // 256 x 256 transitions gives, for each state and input byte, the next
+  // state and the (at most two) symbols whose codes the byte completes.
   // If |input| is the start of a string, the caller must first call Reset.
   // If |input| includes the end of the encoded string, the caller must call
   // InputProperlyTerminated after Decode has returned true in order to
   // determine if the encoded string was properly terminated.
   // Returns false if something went wrong (e.g. the encoding contains the code
   // EOS symbol). Otherwise returns true, in which case input has been fully
-  // decoded or buffered; in particular, if the low-order bit of the final byte
-  // of the input is not the last bit of an encoded symbol, then bit_buffer_
-  // will contain the leading bits of the code for that symbol, but not the
-  // final bits of that code.
+  // decoded; in particular, if the low-order bit of the final byte of the input
+  // is not the last bit of an encoded symbol, then state_ records the leading
+  // bits of the code for that symbol, but not the final bits of that code.
   // Note that output should be empty, but that it is not cleared by Decode().
   bool Decode(quiche::QuicheStringPiece input, std::string* output);
 
-  // Is what remains in the bit_buffer_ valid at the end of an encoded string?
+  // Are the bits of the incomplete code recorded in state_ valid at the end of
+  // an encoded string, i.e. at most 7 bits, all of them 1?
   // Call after passing the the final portion of a Huffman string to Decode,
   // and getting true as the result.
-  bool InputProperlyTerminated() const {
-    return bit_buffer_.InputProperlyTerminated();
-  }
+  bool InputProperlyTerminated() const;
 
   std::string DebugString() const;
 
  private:
-  HuffmanBitBuffer bit_buffer_;
+  // The node of the Huffman code tree reached by the bits decoded since the
+  // last complete code; 0 is the root.
+  uint8_t state_;
 };
 
 inline std::ostream& operator<<(std::ostream& out,
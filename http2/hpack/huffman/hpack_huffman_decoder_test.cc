@@ -11,6 +11,7 @@
 #include "testing/gtest/include/gtest/gtest.h"
 #include "net/third_party/quiche/src/http2/decoder/decode_buffer.h"
 #include "net/third_party/quiche/src/http2/decoder/decode_status.h"
+#include "net/third_party/quiche/src/http2/hpack/huffman/huffman_spec_tables.h"
 #include "net/third_party/quiche/src/http2/platform/api/http2_string_utils.h"
 #include "net/third_party/quiche/src/http2/platform/api/http2_test_helpers.h"
 #include "net/third_party/quiche/src/http2/tools/random_decoder_test.h"
@@ -239,6 +240,103 @@ TEST_F(HpackHuffmanDecoderTest, SpecResponseExamples) {
   }
 }
 
+// Returns the code of |symbol| (which may be the EOS symbol, 256) as a string
+// of '0' and '1' characters.
+std::string CodeBits(size_t symbol) {
+  std::string bits;
+  const uint32_t code = HuffmanSpecTables::kRightCodes[symbol];
+  for (size_t i = HuffmanSpecTables::kCodeLengths[symbol]; i > 0; --i) {
+    bits.push_back(((code >> (i - 1)) & 1) ? '1' : '0');
+  }
+  return bits;
+}
+
+// Packs a string of '0' and '1' characters, whose length must be a multiple
+// of 8, into bytes.
+std::string PackBits(const std::string& bits) {
+  std::string bytes;
+  for (size_t i = 0; i + 8 <= bits.size(); i += 8) {
+    uint8_t byte = 0;
+    for (size_t j = i; j < i + 8; ++j) {
+      byte = (byte << 1) | (bits[j] == '1' ? 1 : 0);
+    }
+    bytes.push_back(static_cast<char>(byte));
+  }
+  return bytes;
+}
+
+// Pads |bits| to a whole number of bytes with the leading bits of EOS.
+std::string PadWithEos(std::string bits) {
+  while (bits.size() % 8 != 0) {
+    bits.push_back('1');
+  }
+  return bits;
+}
+
+TEST_F(HpackHuffmanDecoderTest, EveryCodeInSpecTable) {
+  HpackHuffmanDecoder decoder;
+  std::string all_bits;
+  std::string all_symbols;
+  for (size_t symbol = 0; symbol != 256; ++symbol) {
+    std::string buffer;
+    decoder.Reset();
+    EXPECT_TRUE(decoder.Decode(PackBits(PadWithEos(CodeBits(symbol))), &buffer))
+        << decoder;
+    EXPECT_TRUE(decoder.InputProperlyTerminated()) << decoder;
+    EXPECT_EQ(std::string(1, static_cast<char>(symbol)), buffer);
+    all_bits += CodeBits(symbol);
+    all_symbols.push_back(static_cast<char>(symbol));
+  }
+
+  // Decode all the codes back to back, a byte at a time, so that codes start
+  // at every offset within a byte.
+  const std::string encoded = PackBits(PadWithEos(all_bits));
+  std::string buffer;
+  decoder.Reset();
+  for (char c : encoded) {
+    ASSERT_TRUE(decoder.Decode(quiche::QuicheStringPiece(&c, 1), &buffer))
+        << decoder;
+  }
+  EXPECT_TRUE(decoder.InputProperlyTerminated()) << decoder;
+  EXPECT_EQ(all_symbols, buffer);
+}
+
+TEST_F(HpackHuffmanDecoderTest, ExplicitEosIsAnError) {
+  HpackHuffmanDecoder decoder;
+  std::string buffer;
+  EXPECT_FALSE(decoder.Decode(PackBits(PadWithEos(CodeBits(256))), &buffer));
+
+  decoder.Reset();
+  buffer.clear();
+  EXPECT_FALSE(decoder.Decode(
+      PackBits(PadWithEos(CodeBits('a') + CodeBits(256))), &buffer));
+}
+
+TEST_F(HpackHuffmanDecoderTest, InvalidPadding) {
+  HpackHuffmanDecoder decoder;
+  std::string buffer;
+
+  // Eight or more bits of padding.
+  EXPECT_TRUE(decoder.Decode(
+      PackBits(PadWithEos(CodeBits('a') + "11111111")), &buffer));
+  EXPECT_FALSE(decoder.InputProperlyTerminated()) << decoder;
+  EXPECT_EQ("a", buffer);
+
+  // Padding which is not a prefix of EOS.
+  decoder.Reset();
+  buffer.clear();
+  EXPECT_TRUE(decoder.Decode(PackBits(CodeBits('a') + "110"), &buffer));
+  EXPECT_FALSE(decoder.InputProperlyTerminated()) << decoder;
+  EXPECT_EQ("a", buffer);
+
+  // An incomplete code is not padding, even if it starts with 1 bits.
+  decoder.Reset();
+  buffer.clear();
+  EXPECT_TRUE(decoder.Decode(PackBits("11111110"), &buffer));
+  EXPECT_FALSE(decoder.InputProperlyTerminated()) << decoder;
+  EXPECT_EQ("", buffer);
+}
+
 }  // namespace
 }  // namespace test
 }  // namespace http2
@@ -7,8 +7,6 @@
 #include "net/third_party/quiche/src/http2/hpack/huffman/huffman_spec_tables.h"
 #include "net/third_party/quiche/src/http2/platform/api/http2_logging.h"
 
-// TODO(jamessynge): Remove use of binary literals, that is a C++ 14 feature.
-
 namespace http2 {
 
 size_t ExactHuffmanSize(quiche::QuicheStringPiece plain) {
@@ -63,48 +61,44 @@ size_t BoundedHuffmanSize(quiche::QuicheStringPiece plain) {
 
 void HuffmanEncode(quiche::QuicheStringPiece plain, std::string* huffman) {
   DCHECK(huffman != nullptr);
-  huffman->clear();         // Note that this doesn't release memory.
-  uint64_t bit_buffer = 0;  // High-bit is next bit to output. Not clear if that
-                            // is more performant than having the low-bit be the
-                            // last to be output.
-  size_t bits_unused = 64;  // Number of bits available for the next code.
+  // Size the output exactly up front, so that the loop below can store whole
+  // 32-bit words into it rather than appending a byte at a time.
+  const size_t encoded_size = ExactHuffmanSize(plain);
+  huffman->clear();  // Note that this doesn't release memory.
+  huffman->resize(encoded_size);
+  if (encoded_size == 0) {
+    return;
+  }
+  char* out = &(*huffman)[0];
+  uint64_t bit_buffer = 0;  // The low-order |bit_count| bits are yet to be
+                            // output, the highest of those being next.
+  size_t bit_count = 0;     // Always less than 32 between symbols, so there is
+                            // room for a code of up to 32 bits.
   for (uint8_t c : plain) {
-    size_t code_length = HuffmanSpecTables::kCodeLengths[c];
-    if (bits_unused < code_length) {
-      // There isn't enough room in bit_buffer for the code of c.
-      // Flush until bits_unused > 56 (i.e. 64 - 8).
-      do {
-        char h = static_cast<char>(bit_buffer >> 56);
-        bit_buffer <<= 8;
-        bits_unused += 8;
-        // Perhaps would be more efficient if we populated an array of chars,
-        // so we don't have to call push_back each time. Reconsider if used
-        // for production.
-        huffman->push_back(h);
-      } while (bits_unused <= 56);
+    const size_t code_length = HuffmanSpecTables::kCodeLengths[c];
+    bit_buffer =
+        (bit_buffer << code_length) | HuffmanSpecTables::kRightCodes[c];
+    bit_count += code_length;
+    if (bit_count >= 32) {
+      bit_count -= 32;
+      const uint32_t word = static_cast<uint32_t>(bit_buffer >> bit_count);
+      out[0] = static_cast<char>(word >> 24);
+      out[1] = static_cast<char>(word >> 16);
+      out[2] = static_cast<char>(word >> 8);
+      out[3] = static_cast<char>(word);
+      out += 4;
     }
-    uint64_t code = HuffmanSpecTables::kRightCodes[c];
-    size_t shift_by = bits_unused - code_length;
-    bit_buffer |= (code << shift_by);
-    bits_unused -= code_length;
-  }
-  // bit_buffer contains (64-bits_unused) bits that still need to be flushed.
-  // Output whole bytes until we don't have any whole bytes left.
-  size_t bits_used = 64 - bits_unused;
-  while (bits_used >= 8) {
-    char h = static_cast<char>(bit_buffer >> 56);
-    bit_buffer <<= 8;
-    bits_used -= 8;
-    huffman->push_back(h);
   }
-  if (bits_used > 0) {
-    // We have less than a byte left to output. The spec calls for padding out
-    // the final byte with the leading bits of the EOS symbol (30 1-bits).
-    constexpr uint64_t leading_eos_bits = 0b11111111;
-    bit_buffer |= (leading_eos_bits << (56 - bits_used));
-    char h = static_cast<char>(bit_buffer >> 56);
-    huffman->push_back(h);
+  // The spec calls for padding out the final byte with the leading bits of the
+  // EOS symbol (30 1-bits).
+  const size_t padding = (8 - bit_count % 8) % 8;
+  bit_buffer = (bit_buffer << padding) | ((1u << padding) - 1);
+  bit_count += padding;
+  while (bit_count > 0) {
+    bit_count -= 8;
+    *out++ = static_cast<char>(bit_buffer >> bit_count);
   }
+  DCHECK_EQ(out, &(*huffman)[0] + encoded_size);
 }
 
 }  // namespace http2
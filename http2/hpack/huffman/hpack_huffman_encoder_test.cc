@@ -5,12 +5,37 @@
 #include "net/third_party/quiche/src/http2/hpack/huffman/hpack_huffman_encoder.h"
 
 #include "testing/gtest/include/gtest/gtest.h"
+#include "net/third_party/quiche/src/http2/hpack/huffman/huffman_spec_tables.h"
 #include "net/third_party/quiche/src/http2/platform/api/http2_string_utils.h"
 #include "net/third_party/quiche/src/common/platform/api/quiche_arraysize.h"
 
 namespace http2 {
 namespace {
 
+// Encodes |plain| a bit at a time, straight from the tables of the spec.
+std::string ReferenceHuffmanEncode(const std::string& plain) {
+  std::string huffman;
+  uint8_t byte = 0;
+  size_t bit_count = 0;
+  auto append_bit = [&](bool bit) {
+    byte = (byte << 1) | (bit ? 1 : 0);
+    if (++bit_count % 8 == 0) {
+      huffman.push_back(static_cast<char>(byte));
+      byte = 0;
+    }
+  };
+  for (const uint8_t c : plain) {
+    const uint32_t code = HuffmanSpecTables::kRightCodes[c];
+    for (size_t i = HuffmanSpecTables::kCodeLengths[c]; i > 0; --i) {
+      append_bit((code >> (i - 1)) & 1);
+    }
+  }
+  while (bit_count % 8 != 0) {
+    append_bit(true);
+  }
+  return huffman;
+}
+
 TEST(HuffmanEncoderTest, SpecRequestExamples) {
   std::string test_table[] = {
       Http2HexDecode("f1e3c2e5f23a6ba0ab90f4ff"),
@@ -92,5 +117,27 @@ TEST(HuffmanEncoderTest, EncodedSizeAgreesWithEncodeString) {
   }
 }
 
+TEST(HuffmanEncoderTest, AgreesWithSpecTables) {
+  // Cover every code, and strings of every length up to 64 bytes so that the
+  // encoding ends at every offset within a 32-bit word.
+  std::string all_symbols;
+  for (size_t i = 0; i != 256; ++i) {
+    all_symbols.push_back(static_cast<char>(i));
+  }
+  for (size_t length = 0; length <= 64; ++length) {
+    for (size_t offset = 0; offset + length <= all_symbols.size();
+         offset += 16) {
+      const std::string plain_string = all_symbols.substr(offset, length);
+      std::string huffman_encoded;
+      HuffmanEncode(plain_string, &huffman_encoded);
+      EXPECT_EQ(ReferenceHuffmanEncode(plain_string), huffman_encoded)
+          << "length: " << length << ", offset: " << offset;
+    }
+  }
+  std::string huffman_encoded;
+  HuffmanEncode(all_symbols, &huffman_encoded);
+  EXPECT_EQ(ReferenceHuffmanEncode(all_symbols), huffman_encoded);
+}
+
 }  // namespace
 }  // namespace http2
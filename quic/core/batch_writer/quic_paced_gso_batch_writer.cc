@@ -0,0 +1,414 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/third_party/quiche/src/quic/core/batch_writer/quic_paced_gso_batch_writer.h"
+
+#include <errno.h>
+#include <netinet/in.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include "net/third_party/quiche/src/quic/core/quic_syscall_wrapper.h"
+#include "net/third_party/quiche/src/quic/core/quic_utils.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_bug_tracker.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_flag_utils.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_flags.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_logging.h"
+
+namespace quic {
+
+namespace {
+
+// Maximum number of trains sent by one sendmmsg call.
+const size_t kMaxTrainsPerSendmmsg = 64;
+
+const size_t kCmsgSpace =
+    kCmsgSpaceForIp + kCmsgSpaceForSegmentSize + kCmsgSpaceForTxTime;
+
+}  // namespace
+
+class QuicPacedGsoBatchWriter::FlushAlarmDelegate
+    : public QuicAlarm::Delegate {
+ public:
+  explicit FlushAlarmDelegate(QuicPacedGsoBatchWriter* writer)
+      : writer_(writer) {}
+
+  void OnAlarm() override {
+    WriteResult result = writer_->FlushTrains();
+    if (result.status == WRITE_STATUS_BLOCKED) {
+      // The trains left behind go out with the next flush once the socket
+      // is writable again.
+      writer_->write_blocked_ = true;
+    }
+  }
+
+ private:
+  QuicPacedGsoBatchWriter* writer_;
+};
+
+size_t QuicPacedGsoBatchWriter::PeerAddressHash::operator()(
+    const QuicSocketAddress& address) const {
+  const sockaddr_storage raw_address = address.generic_address();
+  size_t length = 0;
+  if (raw_address.ss_family == AF_INET) {
+    length = sizeof(sockaddr_in);
+  } else if (raw_address.ss_family == AF_INET6) {
+    length = sizeof(sockaddr_in6);
+  }
+  return QuicUtils::FNV1a_64_Hash(quiche::QuicheStringPiece(
+      reinterpret_cast<const char*>(&raw_address), length));
+}
+
+QuicPacedGsoBatchWriter::QuicPacedGsoBatchWriter(
+    int fd,
+    clockid_t clockid_for_release_time,
+    QuicTime::Delta release_time_quantum,
+    size_t buffer_size)
+    : fd_(fd),
+      clockid_for_release_time_(clockid_for_release_time),
+      supports_release_time_(
+          GetQuicRestartFlag(quic_support_release_time_for_gso) &&
+          QuicLinuxSocketUtils::EnableReleaseTime(fd,
+                                                  clockid_for_release_time)),
+      release_time_quantum_ns_(release_time_quantum.ToMicroseconds() * 1000),
+      write_blocked_(false),
+      buffer_size_(buffer_size),
+      buffer_(new char[buffer_size]),
+      buffer_used_(0),
+      num_buffered_packets_(0),
+      mmsghdrs_(kMaxTrainsPerSendmmsg),
+      peer_addresses_(kMaxTrainsPerSendmmsg),
+      cbufs_(new char[kMaxTrainsPerSendmmsg * kCmsgSpace]),
+      clock_(nullptr),
+      num_trains_sent_(0),
+      num_packets_sent_(0),
+      num_sendmmsg_calls_(0),
+      num_trains_dropped_(0) {
+  DCHECK_GE(buffer_size_, kMaxOutgoingPacketSize);
+  if (supports_release_time_) {
+    QUIC_RESTART_FLAG_COUNT(quic_support_release_time_for_gso);
+    QUIC_LOG_FIRST_N(INFO, 5) << "Release time is enabled.";
+  } else {
+    QUIC_LOG_FIRST_N(INFO, 5) << "Release time is not enabled.";
+  }
+}
+
+QuicPacedGsoBatchWriter::QuicPacedGsoBatchWriter(
+    int fd,
+    clockid_t clockid_for_release_time,
+    QuicTime::Delta release_time_quantum,
+    size_t buffer_size,
+    ReleaseTimeForceEnabler /*enabler*/)
+    : fd_(fd),
+      clockid_for_release_time_(clockid_for_release_time),
+      supports_release_time_(true),
+      release_time_quantum_ns_(release_time_quantum.ToMicroseconds() * 1000),
+      write_blocked_(false),
+      buffer_size_(buffer_size),
+      buffer_(new char[buffer_size]),
+      buffer_used_(0),
+      num_buffered_packets_(0),
+      mmsghdrs_(kMaxTrainsPerSendmmsg),
+      peer_addresses_(kMaxTrainsPerSendmmsg),
+      cbufs_(new char[kMaxTrainsPerSendmmsg * kCmsgSpace]),
+      clock_(nullptr),
+      num_trains_sent_(0),
+      num_packets_sent_(0),
+      num_sendmmsg_calls_(0),
+      num_trains_dropped_(0) {
+  QUIC_DLOG(INFO) << "Release time forcefully enabled.";
+}
+
+QuicPacedGsoBatchWriter::~QuicPacedGsoBatchWriter() {
+  if (flush_alarm_ != nullptr) {
+    flush_alarm_->Cancel();
+  }
+}
+
+void QuicPacedGsoBatchWriter::SetFlushAlarm(QuicAlarmFactory* alarm_factory,
+                                            const QuicClock* clock) {
+  flush_alarm_.reset(alarm_factory->CreateAlarm(new FlushAlarmDelegate(this)));
+  clock_ = clock;
+}
+
+WriteResult QuicPacedGsoBatchWriter::WritePacket(
+    const char* buffer,
+    size_t buf_len,
+    const QuicIpAddress& self_address,
+    const QuicSocketAddress& peer_address,
+    PerPacketOptions* options) {
+  if (write_blocked_) {
+    return WriteResult(WRITE_STATUS_BLOCKED, EWOULDBLOCK);
+  }
+  if (buf_len > kMaxOutgoingPacketSize) {
+    return WriteResult(WRITE_STATUS_MSG_TOO_BIG, EMSGSIZE);
+  }
+
+  uint64_t release_time = 0;
+  uint64_t due_time = 0;
+  bool can_burst = true;
+  if (supports_release_time_) {
+    due_time = NowInNanosForReleaseTime();
+    if (options != nullptr && !options->release_time_delay.IsZero()) {
+      due_time += options->release_time_delay.ToMicroseconds() * 1000;
+      release_time = due_time;
+      can_burst = options->allow_burst;
+    }
+  }
+
+  // |buffer| is already in place if it came from GetNextWriteLocation().
+  const bool in_place = buffer == buffer_.get() + buffer_used_;
+  if (!in_place && FreeBufferSpace() < buf_len) {
+    if (FlushTrains().status != WRITE_STATUS_OK) {
+      write_blocked_ = true;
+      return WriteResult(WRITE_STATUS_BLOCKED, EWOULDBLOCK);
+    }
+  }
+  char* location = buffer_.get() + buffer_used_;
+  if (!in_place) {
+    memcpy(location, buffer, buf_len);
+  }
+  buffer_used_ += buf_len;
+  AddSegment(location, buf_len, self_address, peer_address, release_time,
+             due_time, can_burst);
+
+  if (FreeBufferSpace() >= kMaxOutgoingPacketSize) {
+    return WriteResult(WRITE_STATUS_OK, 0);
+  }
+  // Out of space for another packet, so send everything now.
+  WriteResult result = FlushTrains();
+  if (result.status != WRITE_STATUS_OK) {
+    write_blocked_ = true;
+    return WriteResult(WRITE_STATUS_BLOCKED_DATA_BUFFERED, EWOULDBLOCK);
+  }
+  return result;
+}
+
+void QuicPacedGsoBatchWriter::SetWritable() {
+  write_blocked_ = false;
+  // The connections which wrote the remaining trains may have nothing left to
+  // write, so they would never flush them.
+  if (!trains_.empty() && Flush().status == WRITE_STATUS_BLOCKED) {
+    write_blocked_ = true;
+  }
+}
+
+QuicByteCount QuicPacedGsoBatchWriter::GetMaxPacketSize(
+    const QuicSocketAddress& /*peer_address*/) const {
+  return kMaxOutgoingPacketSize;
+}
+
+QuicPacketBuffer QuicPacedGsoBatchWriter::GetNextWriteLocation(
+    const QuicIpAddress& /*self_address*/,
+    const QuicSocketAddress& /*peer_address*/) {
+  if (FreeBufferSpace() < kMaxOutgoingPacketSize) {
+    return {nullptr, nullptr};
+  }
+  return {buffer_.get() + buffer_used_, nullptr};
+}
+
+WriteResult QuicPacedGsoBatchWriter::Flush() {
+  if (flush_alarm_ == nullptr) {
+    return FlushTrains();
+  }
+  if (!trains_.empty() && !flush_alarm_->IsSet()) {
+    flush_alarm_->Set(clock_->ApproximateNow());
+  }
+  return WriteResult(WRITE_STATUS_OK, 0);
+}
+
+WriteResult QuicPacedGsoBatchWriter::FlushTrains() {
+  int total_bytes_sent = 0;
+  size_t num_consumed = 0;
+  while (num_consumed < trains_.size()) {
+    const size_t num_trains =
+        std::min(kMaxTrainsPerSendmmsg, trains_.size() - num_consumed);
+    int bytes_sent = 0;
+    const int rc = SendTrains(num_consumed, num_trains, &bytes_sent);
+    if (rc < 0) {
+      RemoveTrains(num_consumed);
+      return WriteResult(WRITE_STATUS_BLOCKED, EWOULDBLOCK);
+    }
+    num_consumed += rc;
+    total_bytes_sent += bytes_sent;
+  }
+  RemoveTrains(num_consumed);
+  if (flush_alarm_ != nullptr) {
+    flush_alarm_->Cancel();
+  }
+  return WriteResult(WRITE_STATUS_OK, total_bytes_sent);
+}
+
+uint64_t QuicPacedGsoBatchWriter::NowInNanosForReleaseTime() const {
+  struct timespec ts;
+
+  if (clock_gettime(clockid_for_release_time_, &ts) != 0) {
+    return 0;
+  }
+
+  return ts.tv_sec * (1000ULL * 1000 * 1000) + ts.tv_nsec;
+}
+
+bool QuicPacedGsoBatchWriter::CanJoin(const Train& train,
+                                      size_t buf_len,
+                                      const QuicIpAddress& self_address,
+                                      uint64_t due_time,
+                                      bool can_burst) const {
+  // The segment can join if all of the following are true:
+  // [0] It has the same source address. The destination matches already.
+  // [1] It is no longer than the segments already in the train.
+  // [2] The train stays within the GSO segment and size limits.
+  // [3] It may be sent without delay, or is due within the release time
+  //     quantum of the train.
+  return train.self_address == self_address &&                    // [0]
+         buf_len <= train.segment_size &&                         // [1]
+         train.segments.size() < MaxSegments(train.segment_size) &&  // [2]
+         train.num_bytes + buf_len <= kMaxGsoPacketSize &&        // [2]
+         (can_burst ||                                            // [3]
+          due_time <= train.due_time + release_time_quantum_ns_);
+}
+
+void QuicPacedGsoBatchWriter::AddSegment(const char* buffer,
+                                         size_t buf_len,
+                                         const QuicIpAddress& self_address,
+                                         const QuicSocketAddress& peer_address,
+                                         uint64_t release_time,
+                                         uint64_t due_time,
+                                         bool can_burst) {
+  ++num_buffered_packets_;
+  iovec segment{const_cast<char*>(buffer), buf_len};
+
+  auto it = open_trains_.find(peer_address);
+  if (it != open_trains_.end()) {
+    Train& train = trains_[it->second];
+    DCHECK(train.open);
+    if (CanJoin(train, buf_len, self_address, due_time, can_burst)) {
+      train.segments.push_back(segment);
+      train.num_bytes += buf_len;
+      // A shorter segment has to be the last one.
+      if (buf_len < train.segment_size ||
+          train.segments.size() == MaxSegments(train.segment_size)) {
+        train.open = false;
+        open_trains_.erase(it);
+      }
+      return;
+    }
+    train.open = false;
+  }
+
+  trains_.push_back(Train{self_address, peer_address, release_time, due_time,
+                          buf_len, buf_len, /*open=*/true, {segment}});
+  open_trains_[peer_address] = trains_.size() - 1;
+}
+
+int QuicPacedGsoBatchWriter::SendTrains(size_t first,
+                                        size_t num_trains,
+                                        int* bytes_sent) {
+  DCHECK_LE(num_trains, kMaxTrainsPerSendmmsg);
+  *bytes_sent = 0;
+  memset(cbufs_.get(), 0, num_trains * kCmsgSpace);
+  for (size_t i = 0; i < num_trains; ++i) {
+    Train& train = trains_[first + i];
+    msghdr* hdr = &mmsghdrs_[i].msg_hdr;
+    memset(&mmsghdrs_[i], 0, sizeof(mmsghdrs_[i]));
+
+    peer_addresses_[i] = train.peer_address.generic_address();
+    hdr->msg_name = &peer_addresses_[i];
+    hdr->msg_namelen = peer_addresses_[i].ss_family == AF_INET
+                           ? sizeof(sockaddr_in)
+                           : sizeof(sockaddr_in6);
+    hdr->msg_iov = train.segments.data();
+    hdr->msg_iovlen = train.segments.size();
+
+    hdr->msg_control = cbufs_.get() + i * kCmsgSpace;
+    hdr->msg_controllen = kCmsgSpace;
+    cmsghdr* cmsg = CMSG_FIRSTHDR(hdr);
+    size_t controllen = 0;
+    if (train.self_address.IsInitialized()) {
+      controllen += CMSG_SPACE(
+          QuicLinuxSocketUtils::SetIpInfoInCmsg(train.self_address, cmsg));
+      cmsg = CMSG_NXTHDR(hdr, cmsg);
+    }
+    if (train.segments.size() > 1) {
+      cmsg->cmsg_level = SOL_UDP;
+      cmsg->cmsg_type = UDP_SEGMENT;
+      cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+      *reinterpret_cast<uint16_t*>(CMSG_DATA(cmsg)) = train.segment_size;
+      controllen += CMSG_SPACE(sizeof(uint16_t));
+      cmsg = CMSG_NXTHDR(hdr, cmsg);
+    }
+    if (train.release_time != 0) {
+      cmsg->cmsg_level = SOL_SOCKET;
+      cmsg->cmsg_type = SO_TXTIME;
+      cmsg->cmsg_len = CMSG_LEN(sizeof(uint64_t));
+      memcpy(CMSG_DATA(cmsg), &train.release_time, sizeof(uint64_t));
+      controllen += CMSG_SPACE(sizeof(uint64_t));
+    }
+    hdr->msg_controllen = controllen;
+    if (controllen == 0) {
+      hdr->msg_control = nullptr;
+    }
+  }
+
+  int rc;
+  do {
+    rc = GetGlobalSyscallWrapper()->Sendmmsg(fd_, mmsghdrs_.data(), num_trains,
+                                             0);
+  } while (rc < 0 && errno == EINTR);
+  ++num_sendmmsg_calls_;
+
+  if (rc < 0) {
+    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+      return -1;
+    }
+    // sendmmsg only fails if the first message could not be sent.
+    const Train& train = trains_[first];
+    ++num_trains_dropped_;
+    QUIC_LOG_FIRST_N(ERROR, 100)
+        << "Dropping GSO train of " << train.segments.size()
+        << " segments to " << train.peer_address.ToString() << ": "
+        << strerror(errno);
+    return 1;
+  }
+  if (rc == 0) {
+    QUIC_BUG << "sendmmsg returned 0 for " << num_trains << " trains.";
+    ++num_trains_dropped_;
+    return 1;
+  }
+
+  for (int i = 0; i < rc; ++i) {
+    const Train& train = trains_[first + i];
+    *bytes_sent += train.num_bytes;
+    num_packets_sent_ += train.segments.size();
+  }
+  num_trains_sent_ += rc;
+  QUIC_DVLOG(1) << "Sent " << rc << " out of " << num_trains
+                << " GSO trains, " << *bytes_sent << " bytes.";
+  return rc;
+}
+
+void QuicPacedGsoBatchWriter::RemoveTrains(size_t num_trains) {
+  if (num_trains == 0) {
+    return;
+  }
+  for (size_t i = 0; i < num_trains; ++i) {
+    num_buffered_packets_ -= trains_[i].segments.size();
+  }
+  trains_.erase(trains_.begin(), trains_.begin() + num_trains);
+  if (trains_.empty()) {
+    open_trains_.clear();
+    buffer_used_ = 0;
+    return;
+  }
+  // Only happens after the socket blocked, so rebuilding the index is fine.
+  open_trains_.clear();
+  for (size_t i = 0; i < trains_.size(); ++i) {
+    if (trains_[i].open) {
+      open_trains_[trains_[i].peer_address] = i;
+    }
+  }
+}
+
+}  // namespace quic
@@ -0,0 +1,204 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef QUICHE_QUIC_CORE_BATCH_WRITER_QUIC_PACED_GSO_BATCH_WRITER_H_
+#define QUICHE_QUIC_CORE_BATCH_WRITER_QUIC_PACED_GSO_BATCH_WRITER_H_
+
+#include <sys/uio.h>
+#include <time.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "net/third_party/quiche/src/quic/core/quic_alarm.h"
+#include "net/third_party/quiche/src/quic/core/quic_alarm_factory.h"
+#include "net/third_party/quiche/src/quic/core/quic_clock.h"
+#include "net/third_party/quiche/src/quic/core/quic_linux_socket_utils.h"
+#include "net/third_party/quiche/src/quic/core/quic_packet_writer.h"
+#include "net/third_party/quiche/src/quic/core/quic_time.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_containers.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_export.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_ip_address.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_socket_address.h"
+
+namespace quic {
+
+// Default size of the buffer packets are held in until they are sent.
+const size_t kDefaultPacedGsoBufferSize = 512 * kMaxOutgoingPacketSize;
+
+// QuicPacedGsoBatchWriter sends packets written by many connections sharing a
+// UDP socket as GSO trains: runs of segments to the same destination whose
+// release times fall within a quantum of each other. Each train is sent as
+// one message with a single SO_TXTIME release time, and all buffered trains
+// go out in one sendmmsg call.
+//
+// Unlike QuicGsoBatchWriter, which must flush whenever consecutive writes go
+// to different destinations or are due at different times, trains to
+// different destinations are built side by side, so paced packets from
+// interleaved connections still coalesce. With a flush alarm, Flush() calls
+// made by individual connections only schedule that alarm, so everything
+// written during one event loop iteration is sent together.
+//
+// A train which fails to send for any reason other than the socket being
+// blocked is dropped, and treated as lost by its connections, because the
+// error cannot be attributed to the caller of Flush().
+class QUIC_EXPORT_PRIVATE QuicPacedGsoBatchWriter : public QuicPacketWriter {
+ public:
+  // Segments due within |release_time_quantum| of the first segment of a
+  // train may join it, and are released with it. |clockid_for_release_time|:
+  // FQ qdisc requires CLOCK_MONOTONIC, EDF requires CLOCK_TAI.
+  QuicPacedGsoBatchWriter(int fd,
+                          clockid_t clockid_for_release_time,
+                          QuicTime::Delta release_time_quantum,
+                          size_t buffer_size);
+  QuicPacedGsoBatchWriter(const QuicPacedGsoBatchWriter&) = delete;
+  QuicPacedGsoBatchWriter& operator=(const QuicPacedGsoBatchWriter&) = delete;
+  ~QuicPacedGsoBatchWriter() override;
+
+  // Defers sending on Flush() to an alarm created by |alarm_factory|, which
+  // fires at the end of the current event loop iteration. |clock| must
+  // outlive this writer.
+  void SetFlushAlarm(QuicAlarmFactory* alarm_factory, const QuicClock* clock);
+
+  // QuicPacketWriter implementation.
+  WriteResult WritePacket(const char* buffer,
+                          size_t buf_len,
+                          const QuicIpAddress& self_address,
+                          const QuicSocketAddress& peer_address,
+                          PerPacketOptions* options) override;
+  bool IsWriteBlocked() const override { return write_blocked_; }
+  // Also sends the trains left behind when the socket blocked, or with a
+  // flush alarm, schedules it to do so.
+  void SetWritable() override;
+  QuicByteCount GetMaxPacketSize(
+      const QuicSocketAddress& peer_address) const override;
+  bool SupportsReleaseTime() const override { return supports_release_time_; }
+  bool IsBatchMode() const override { return true; }
+  QuicPacketBuffer GetNextWriteLocation(
+      const QuicIpAddress& self_address,
+      const QuicSocketAddress& peer_address) override;
+  // Sends all buffered trains, or with a flush alarm, schedules it to do so
+  // and returns WriteResult(WRITE_STATUS_OK, 0).
+  WriteResult Flush() override;
+
+  // Sends all buffered trains now. Returns WRITE_STATUS_BLOCKED if the socket
+  // blocked, in which case the unsent trains stay buffered, and otherwise
+  // WriteResult(WRITE_STATUS_OK, <bytes_sent>).
+  WriteResult FlushTrains();
+
+  int fd() const { return fd_; }
+  size_t num_buffered_packets() const { return num_buffered_packets_; }
+  size_t num_buffered_trains() const { return trains_.size(); }
+
+  // Statistics over the lifetime of the writer.
+  uint64_t num_trains_sent() const { return num_trains_sent_; }
+  uint64_t num_packets_sent() const { return num_packets_sent_; }
+  uint64_t num_sendmmsg_calls() const { return num_sendmmsg_calls_; }
+  uint64_t num_trains_dropped() const { return num_trains_dropped_; }
+
+ protected:
+  // Test only constructor to forcefully enable release time.
+  struct QUIC_EXPORT_PRIVATE ReleaseTimeForceEnabler {};
+  QuicPacedGsoBatchWriter(int fd,
+                          clockid_t clockid_for_release_time,
+                          QuicTime::Delta release_time_quantum,
+                          size_t buffer_size,
+                          ReleaseTimeForceEnabler enabler);
+
+  QuicAlarm* flush_alarm() const { return flush_alarm_.get(); }
+
+  // Get the current time in nanos on |clockid_for_release_time_|.
+  virtual uint64_t NowInNanosForReleaseTime() const;
+
+  static size_t MaxSegments(size_t gso_size) {
+    // Same limits as QuicGsoBatchWriter::MaxSegments().
+    return gso_size <= 2 ? 16 : 45;
+  }
+
+ private:
+  class FlushAlarmDelegate;
+
+  // Consecutive segments to one destination, sent as one GSO message.
+  struct QUIC_EXPORT_PRIVATE Train {
+    QuicIpAddress self_address;
+    QuicSocketAddress peer_address;
+    // Release time of the first segment, 0 if it can be sent immediately.
+    uint64_t release_time;
+    // |release_time|, or the time the first segment was written if 0.
+    uint64_t due_time;
+    // Length of the first segment. Only the last may be shorter.
+    size_t segment_size;
+    size_t num_bytes;
+    // Whether the train can take more segments.
+    bool open;
+    std::vector<iovec> segments;
+  };
+
+  struct QUIC_EXPORT_PRIVATE PeerAddressHash {
+    size_t operator()(const QuicSocketAddress& address) const;
+  };
+
+  // Returns true if a segment of |buf_len| bytes may be appended to |train|.
+  bool CanJoin(const Train& train,
+               size_t buf_len,
+               const QuicIpAddress& self_address,
+               uint64_t due_time,
+               bool can_burst) const;
+
+  // Appends a buffered packet to the open train to its destination, or to a
+  // new one. |release_time| is 0 if the packet can be sent immediately, and
+  // |due_time| is the time it should be sent.
+  void AddSegment(const char* buffer,
+                  size_t buf_len,
+                  const QuicIpAddress& self_address,
+                  const QuicSocketAddress& peer_address,
+                  uint64_t release_time,
+                  uint64_t due_time,
+                  bool can_burst);
+
+  // Sends |num_trains| trains starting at |trains_[first]| with one sendmmsg
+  // call. Returns the number of trains consumed, sent or dropped, and sets
+  // |*bytes_sent|. Returns -1 if the socket is blocked.
+  int SendTrains(size_t first, size_t num_trains, int* bytes_sent);
+
+  // Forgets all trains before |trains_[num_trains]|, resetting the buffer
+  // once no trains are left.
+  void RemoveTrains(size_t num_trains);
+
+  size_t FreeBufferSpace() const { return buffer_size_ - buffer_used_; }
+
+  const int fd_;
+  const clockid_t clockid_for_release_time_;
+  const bool supports_release_time_;
+  const uint64_t release_time_quantum_ns_;
+  bool write_blocked_;
+
+  const size_t buffer_size_;
+  std::unique_ptr<char[]> buffer_;
+  size_t buffer_used_;
+  size_t num_buffered_packets_;
+
+  // In the order they were started, which is the order they are sent in.
+  std::vector<Train> trains_;
+  // Index into |trains_| of the open train to each peer.
+  QuicHashMap<QuicSocketAddress, size_t, PeerAddressHash> open_trains_;
+
+  // Scratch space for building messages, reused between flushes.
+  std::vector<mmsghdr> mmsghdrs_;
+  std::vector<sockaddr_storage> peer_addresses_;
+  std::unique_ptr<char[]> cbufs_;
+
+  std::unique_ptr<QuicAlarm> flush_alarm_;
+  const QuicClock* clock_;
+
+  uint64_t num_trains_sent_;
+  uint64_t num_packets_sent_;
+  uint64_t num_sendmmsg_calls_;
+  uint64_t num_trains_dropped_;
+};
+
+}  // namespace quic
+
+#endif  // QUICHE_QUIC_CORE_BATCH_WRITER_QUIC_PACED_GSO_BATCH_WRITER_H_
@@ -0,0 +1,408 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/third_party/quiche/src/quic/core/batch_writer/quic_paced_gso_batch_writer.h"
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+#include "net/third_party/quiche/src/quic/platform/api/quic_ip_address.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_test.h"
+#include "net/third_party/quiche/src/quic/test_tools/mock_clock.h"
+#include "net/third_party/quiche/src/quic/test_tools/quic_mock_syscall_wrapper.h"
+#include "net/third_party/quiche/src/quic/test_tools/quic_test_utils.h"
+
+using testing::_;
+using testing::Invoke;
+using testing::StrictMock;
+
+namespace quic {
+namespace test {
+namespace {
+
+size_t MessageLength(const msghdr& msg) {
+  size_t length = 0;
+  for (size_t i = 0; i < msg.msg_iovlen; ++i) {
+    length += msg.msg_iov[i].iov_len;
+  }
+  return length;
+}
+
+// Returns the UDP_SEGMENT size of |msg|, or 0 if there is none.
+uint16_t SegmentSize(const msghdr& msg) {
+  for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr;
+       cmsg = CMSG_NXTHDR(const_cast<msghdr*>(&msg), cmsg)) {
+    if (cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_SEGMENT) {
+      return *reinterpret_cast<uint16_t*>(CMSG_DATA(cmsg));
+    }
+  }
+  return 0;
+}
+
+// Returns the SO_TXTIME release time of |msg|, or 0 if there is none.
+uint64_t ReleaseTime(const msghdr& msg) {
+  for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr;
+       cmsg = CMSG_NXTHDR(const_cast<msghdr*>(&msg), cmsg)) {
+    if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SO_TXTIME) {
+      uint64_t release_time;
+      memcpy(&release_time, CMSG_DATA(cmsg), sizeof(release_time));
+      return release_time;
+    }
+  }
+  return 0;
+}
+
+uint64_t MillisToNanos(uint64_t milliseconds) {
+  return milliseconds * 1000000;
+}
+
+class QUIC_EXPORT_PRIVATE TestQuicPacedGsoBatchWriter
+    : public QuicPacedGsoBatchWriter {
+ public:
+  using QuicPacedGsoBatchWriter::flush_alarm;
+  using QuicPacedGsoBatchWriter::MaxSegments;
+  using QuicPacedGsoBatchWriter::QuicPacedGsoBatchWriter;
+
+  static std::unique_ptr<TestQuicPacedGsoBatchWriter>
+  NewInstanceWithReleaseTimeSupport(size_t buffer_size) {
+    return std::unique_ptr<TestQuicPacedGsoBatchWriter>(
+        new TestQuicPacedGsoBatchWriter(
+            /*fd=*/-1, CLOCK_MONOTONIC, QuicTime::Delta::FromMilliseconds(1),
+            buffer_size, ReleaseTimeForceEnabler()));
+  }
+
+  uint64_t NowInNanosForReleaseTime() const override {
+    return MillisToNanos(forced_release_time_ms_);
+  }
+
+  void ForceReleaseTimeMs(uint64_t forced_release_time_ms) {
+    forced_release_time_ms_ = forced_release_time_ms;
+  }
+
+ private:
+  uint64_t forced_release_time_ms_ = 1;
+};
+
+struct QUIC_EXPORT_PRIVATE TestPerPacketOptions : public PerPacketOptions {
+  std::unique_ptr<quic::PerPacketOptions> Clone() const override {
+    return std::make_unique<TestPerPacketOptions>(*this);
+  }
+};
+
+class QuicPacedGsoBatchWriterTest : public QuicTest {
+ protected:
+  QuicPacedGsoBatchWriterTest()
+      : writer_(TestQuicPacedGsoBatchWriter::NewInstanceWithReleaseTimeSupport(
+            kDefaultPacedGsoBufferSize)) {
+    memset(packet_buffer_, 0, sizeof(packet_buffer_));
+  }
+
+  WriteResult WritePacket(size_t packet_size,
+                          const QuicSocketAddress& peer_address,
+                          PerPacketOptions* options = nullptr) {
+    return writer_->WritePacket(&packet_buffer_[0], packet_size, self_address_,
+                                peer_address, options);
+  }
+
+  QuicIpAddress self_address_ = QuicIpAddress::Loopback4();
+  QuicSocketAddress peer_address1_{QuicIpAddress::Loopback4(), 443};
+  QuicSocketAddress peer_address2_{QuicIpAddress::Loopback4(), 444};
+  char packet_buffer_[1500];
+  StrictMock<MockQuicSyscallWrapper> mock_syscalls_;
+  ScopedGlobalSyscallWrapperOverride syscall_override_{&mock_syscalls_};
+  std::unique_ptr<TestQuicPacedGsoBatchWriter> writer_;
+};
+
+TEST_F(QuicPacedGsoBatchWriterTest, InterleavedDestinations) {
+  // Packets to two destinations are interleaved, as they would be when two
+  // connections write in turn.
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_EQ(WriteResult(WRITE_STATUS_OK, 0),
+              WritePacket(1200, peer_address1_));
+    ASSERT_EQ(WriteResult(WRITE_STATUS_OK, 0),
+              WritePacket(1000, peer_address2_));
+  }
+  EXPECT_EQ(6u, writer_->num_buffered_packets());
+  EXPECT_EQ(2u, writer_->num_buffered_trains());
+
+  EXPECT_CALL(mock_syscalls_, Sendmmsg(_, _, _, _))
+      .WillOnce(Invoke([this](int /*sockfd*/, mmsghdr* msgvec,
+                              unsigned int vlen, int /*flags*/) {
+        EXPECT_EQ(2u, vlen);
+        EXPECT_EQ(3600u, MessageLength(msgvec[0].msg_hdr));
+        EXPECT_EQ(1200u, SegmentSize(msgvec[0].msg_hdr));
+        EXPECT_EQ(peer_address1_,
+                  QuicSocketAddress(*reinterpret_cast<const sockaddr_storage*>(
+                      msgvec[0].msg_hdr.msg_name)));
+        EXPECT_EQ(3000u, MessageLength(msgvec[1].msg_hdr));
+        EXPECT_EQ(1000u, SegmentSize(msgvec[1].msg_hdr));
+        EXPECT_EQ(peer_address2_,
+                  QuicSocketAddress(*reinterpret_cast<const sockaddr_storage*>(
+                      msgvec[1].msg_hdr.msg_name)));
+        return 2;
+      }));
+  EXPECT_EQ(WriteResult(WRITE_STATUS_OK, 6600), writer_->Flush());
+  EXPECT_EQ(0u, writer_->num_buffered_packets());
+  EXPECT_EQ(0u, writer_->num_buffered_trains());
+  EXPECT_EQ(2u, writer_->num_trains_sent());
+  EXPECT_EQ(6u, writer_->num_packets_sent());
+  EXPECT_EQ(1u, writer_->num_sendmmsg_calls());
+}
+
+TEST_F(QuicPacedGsoBatchWriterTest, ShorterSegmentEndsTrain) {
+  ASSERT_EQ(WriteResult(WRITE_STATUS_OK, 0), WritePacket(1200, peer_address1_));
+  ASSERT_EQ(WriteResult(WRITE_STATUS_OK, 0), WritePacket(100, peer_address1_));
+  EXPECT_EQ(1u, writer_->num_buffered_trains());
+  // Neither a longer nor a shorter segment may follow a shorter one.
+  ASSERT_EQ(WriteResult(WRITE_STATUS_OK, 0), WritePacket(1200, peer_address1_));
+  EXPECT_EQ(2u, writer_->num_buffered_trains());
+
+  EXPECT_CALL(mock_syscalls_, Sendmmsg(_, _, _, _))
+      .WillOnce(Invoke([](int /*sockfd*/, mmsghdr* msgvec, unsigned int vlen,
+                          int /*flags*/) {
+        EXPECT_EQ(2u, vlen);
+        EXPECT_EQ(1300u, MessageLength(msgvec[0].msg_hdr));
+        EXPECT_EQ(1200u, SegmentSize(msgvec[0].msg_hdr));
+        // A train of one segment needs no UDP_SEGMENT.
+        EXPECT_EQ(1200u, MessageLength(msgvec[1].msg_hdr));
+        EXPECT_EQ(0u, SegmentSize(msgvec[1].msg_hdr));
+        return 2;
+      }));
+  EXPECT_EQ(WriteResult(WRITE_STATUS_OK, 2500), writer_->Flush());
+}
+
+TEST_F(QuicPacedGsoBatchWriterTest, MaxSegments) {
+  const size_t max_segments = TestQuicPacedGsoBatchWriter::MaxSegments(1000);
+  for (size_t i = 0; i < max_segments + 1; ++i) {
+    ASSERT_EQ(WriteResult(WRITE_STATUS_OK, 0),
+              WritePacket(1000, peer_address1_));
+  }
+  EXPECT_EQ(2u, writer_->num_buffered_trains());
+
+  EXPECT_CALL(mock_syscalls_, Sendmmsg(_, _, _, _))
+      .WillOnce(Invoke([max_segments](int /*sockfd*/, mmsghdr* msgvec,
+                                      unsigned int vlen, int /*flags*/) {
+        EXPECT_EQ(2u, vlen);
+        EXPECT_EQ(max_segments, msgvec[0].msg_hdr.msg_iovlen);
+        EXPECT_EQ(1u, msgvec[1].msg_hdr.msg_iovlen);
+        return 2;
+      }));
+  EXPECT_EQ(WriteResult(WRITE_STATUS_OK, 1000 * (max_segments + 1)),
+            writer_->Flush());
+}
+
+TEST_F(QuicPacedGsoBatchWriterTest, ReleaseTime) {
+  TestPerPacketOptions options;
+
+  // The 1st packet has no delay, and is sent without a release time.
+  ASSERT_EQ(WriteResult(WRITE_STATUS_OK, 0),
+            WritePacket(1200, peer_address1_, &options));
+
+  // The 2nd packet is due within the quantum of the 1st, so it joins it.
+  options.release_time_delay = QuicTime::Delta::FromMicroseconds(500);
+  ASSERT_EQ(WriteResult(WRITE_STATUS_OK, 0),
+            WritePacket(1200, peer_address1_, &options));
+  EXPECT_EQ(1u, writer_->num_buffered_trains());
+
+  // The 3rd packet is due too late, and starts a train of its own.
+  options.release_time_delay = QuicTime::Delta::FromMilliseconds(3);
+  ASSERT_EQ(WriteResult(WRITE_STATUS_OK, 0),
+            WritePacket(1200, peer_address1_, &options));
+  EXPECT_EQ(2u, writer_->num_buffered_trains());
+
+  // The 4th packet is due even later, but allows burst.
+  options.release_time_delay = QuicTime::Delta::FromMilliseconds(5);
+  options.allow_burst = true;
+  ASSERT_EQ(WriteResult(WRITE_STATUS_OK, 0),
+            WritePacket(1200, peer_address1_, &options));
+  EXPECT_EQ(2u, writer_->num_buffered_trains());
+
+  // Pretend 2ms have elapsed. The 5th packet is due at the same time as the
+  // 3rd one.
+  writer_->ForceReleaseTimeMs(3);
+  options.release_time_delay = QuicTime::Delta::FromMilliseconds(1);
+  options.allow_burst = false;
+  ASSERT_EQ(WriteResult(WRITE_STATUS_OK, 0),
+            WritePacket(1200, peer_address1_, &options));
+  EXPECT_EQ(2u, writer_->num_buffered_trains());
+
+  EXPECT_CALL(mock_syscalls_, Sendmmsg(_, _, _, _))
+      .WillOnce(Invoke([](int /*sockfd*/, mmsghdr* msgvec, unsigned int vlen,
+                          int /*flags*/) {
+        EXPECT_EQ(2u, vlen);
+        EXPECT_EQ(2400u, MessageLength(msgvec[0].msg_hdr));
+        EXPECT_EQ(0u, ReleaseTime(msgvec[0].msg_hdr));
+        EXPECT_EQ(3600u, MessageLength(msgvec[1].msg_hdr));
+        EXPECT_EQ(MillisToNanos(4), ReleaseTime(msgvec[1].msg_hdr));
+        return 2;
+      }));
+  EXPECT_EQ(WriteResult(WRITE_STATUS_OK, 6000), writer_->Flush());
+}
+
+TEST_F(QuicPacedGsoBatchWriterTest, FlushBlocked) {
+  ASSERT_EQ(WriteResult(WRITE_STATUS_OK, 0), WritePacket(1200, peer_address1_));
+  ASSERT_EQ(WriteResult(WRITE_STATUS_OK, 0), WritePacket(1200, peer_address2_));
+
+  // Only the first train is sent before the socket blocks.
+  EXPECT_CALL(mock_syscalls_, Sendmmsg(_, _, _, _))
+      .WillOnce(Invoke([](int /*sockfd*/, mmsghdr* /*msgvec*/,
+                          unsigned int vlen, int /*flags*/) {
+        EXPECT_EQ(2u, vlen);
+        return 1;
+      }))
+      .WillOnce(Invoke([](int /*sockfd*/, mmsghdr* /*msgvec*/,
+                          unsigned int vlen, int /*flags*/) {
+        EXPECT_EQ(1u, vlen);
+        errno = EWOULDBLOCK;
+        return -1;
+      }));
+  EXPECT_EQ(WRITE_STATUS_BLOCKED, writer_->Flush().status);
+  EXPECT_EQ(1u, writer_->num_buffered_trains());
+  EXPECT_EQ(1u, writer_->num_buffered_packets());
+
+  // The remaining train is sent once the socket is writable.
+  EXPECT_CALL(mock_syscalls_, Sendmmsg(_, _, _, _))
+      .WillOnce(Invoke([this](int /*sockfd*/, mmsghdr* msgvec,
+                              unsigned int vlen, int /*flags*/) {
+        EXPECT_EQ(1u, vlen);
+        EXPECT_EQ(peer_address2_,
+                  QuicSocketAddress(*reinterpret_cast<const sockaddr_storage*>(
+                      msgvec[0].msg_hdr.msg_name)));
+        return 1;
+      }));
+  EXPECT_EQ(WriteResult(WRITE_STATUS_OK, 1200), writer_->Flush());
+  EXPECT_EQ(0u, writer_->num_buffered_trains());
+}
+
+TEST_F(QuicPacedGsoBatchWriterTest, WriteBlockedWhenFull) {
+  writer_ = TestQuicPacedGsoBatchWriter::NewInstanceWithReleaseTimeSupport(
+      2 * kMaxOutgoingPacketSize);
+
+  ASSERT_EQ(WriteResult(WRITE_STATUS_OK, 0), WritePacket(1200, peer_address1_));
+  EXPECT_CALL(mock_syscalls_, Sendmmsg(_, _, _, _))
+      .WillOnce(Invoke([](int /*sockfd*/, mmsghdr* /*msgvec*/,
+                          unsigned int /*vlen*/, int /*flags*/) {
+        errno = EWOULDBLOCK;
+        return -1;
+      }));
+  EXPECT_EQ(WRITE_STATUS_BLOCKED_DATA_BUFFERED,
+            WritePacket(1200, peer_address2_).status);
+  EXPECT_TRUE(writer_->IsWriteBlocked());
+  EXPECT_EQ(2u, writer_->num_buffered_packets());
+  EXPECT_EQ(WRITE_STATUS_BLOCKED, WritePacket(1200, peer_address2_).status);
+
+  // The buffered packets are sent as soon as the socket is writable.
+  EXPECT_CALL(mock_syscalls_, Sendmmsg(_, _, _, _))
+      .WillOnce(Invoke([](int /*sockfd*/, mmsghdr* /*msgvec*/,
+                          unsigned int vlen, int /*flags*/) { return vlen; }));
+  writer_->SetWritable();
+  EXPECT_FALSE(writer_->IsWriteBlocked());
+  EXPECT_EQ(0u, writer_->num_buffered_packets());
+  EXPECT_EQ(WriteResult(WRITE_STATUS_OK, 0), writer_->Flush());
+}
+
+TEST_F(QuicPacedGsoBatchWriterTest, SendErrorDropsTrain) {
+  ASSERT_EQ(WriteResult(WRITE_STATUS_OK, 0), WritePacket(1200, peer_address1_));
+  ASSERT_EQ(WriteResult(WRITE_STATUS_OK, 0), WritePacket(1200, peer_address2_));
+
+  EXPECT_CALL(mock_syscalls_, Sendmmsg(_, _, _, _))
+      .WillOnce(Invoke([](int /*sockfd*/, mmsghdr* /*msgvec*/,
+                          unsigned int vlen, int /*flags*/) {
+        EXPECT_EQ(2u, vlen);
+        errno = EPERM;
+        return -1;
+      }))
+      .WillOnce(Invoke([](int /*sockfd*/, mmsghdr* /*msgvec*/,
+                          unsigned int vlen, int /*flags*/) {
+        EXPECT_EQ(1u, vlen);
+        return 1;
+      }));
+  EXPECT_EQ(WriteResult(WRITE_STATUS_OK, 1200), writer_->Flush());
+  EXPECT_FALSE(writer_->IsWriteBlocked());
+  EXPECT_EQ(1u, writer_->num_trains_dropped());
+  EXPECT_EQ(1u, writer_->num_trains_sent());
+  EXPECT_EQ(0u, writer_->num_buffered_trains());
+}
+
+TEST_F(QuicPacedGsoBatchWriterTest, FlushAlarm) {
+  MockClock clock;
+  clock.AdvanceTime(QuicTime::Delta::FromMilliseconds(1));
+  MockAlarmFactory alarm_factory;
+  writer_->SetFlushAlarm(&alarm_factory, &clock);
+
+  // Flush() without buffered packets does not arm the alarm.
+  EXPECT_EQ(WriteResult(WRITE_STATUS_OK, 0), writer_->Flush());
+  EXPECT_FALSE(writer_->flush_alarm()->IsSet());
+
+  // Flushes from two connections are coalesced into one sendmmsg call.
+  ASSERT_EQ(WriteResult(WRITE_STATUS_OK, 0), WritePacket(1200, peer_address1_));
+  EXPECT_EQ(WriteResult(WRITE_STATUS_OK, 0), writer_->Flush());
+  EXPECT_TRUE(writer_->flush_alarm()->IsSet());
+  ASSERT_EQ(WriteResult(WRITE_STATUS_OK, 0), WritePacket(1200, peer_address2_));
+  EXPECT_EQ(WriteResult(WRITE_STATUS_OK, 0), writer_->Flush());
+  EXPECT_EQ(2u, writer_->num_buffered_trains());
+
+  EXPECT_CALL(mock_syscalls_, Sendmmsg(_, _, _, _))
+      .WillOnce(Invoke([](int /*sockfd*/, mmsghdr* /*msgvec*/,
+                          unsigned int vlen, int /*flags*/) {
+        EXPECT_EQ(2u, vlen);
+        return 2;
+      }));
+  alarm_factory.FireAlarm(writer_->flush_alarm());
+  EXPECT_EQ(0u, writer_->num_buffered_trains());
+  EXPECT_EQ(1u, writer_->num_sendmmsg_calls());
+  EXPECT_FALSE(writer_->IsWriteBlocked());
+
+  // The writer becomes blocked if the alarm cannot send everything.
+  ASSERT_EQ(WriteResult(WRITE_STATUS_OK, 0), WritePacket(1200, peer_address1_));
+  EXPECT_EQ(WriteResult(WRITE_STATUS_OK, 0), writer_->Flush());
+  EXPECT_CALL(mock_syscalls_, Sendmmsg(_, _, _, _))
+      .WillOnce(Invoke([](int /*sockfd*/, mmsghdr* /*msgvec*/,
+                          unsigned int /*vlen*/, int /*flags*/) {
+        errno = EWOULDBLOCK;
+        return -1;
+      }));
+  alarm_factory.FireAlarm(writer_->flush_alarm());
+  EXPECT_TRUE(writer_->IsWriteBlocked());
+  EXPECT_EQ(1u, writer_->num_buffered_trains());
+}
+
+TEST_F(QuicPacedGsoBatchWriterTest, SetWritableRearmsFlushAlarm) {
+  MockClock clock;
+  clock.AdvanceTime(QuicTime::Delta::FromMilliseconds(1));
+  MockAlarmFactory alarm_factory;
+  writer_->SetFlushAlarm(&alarm_factory, &clock);
+
+  ASSERT_EQ(WriteResult(WRITE_STATUS_OK, 0), WritePacket(1200, peer_address1_));
+  EXPECT_EQ(WriteResult(WRITE_STATUS_OK, 0), writer_->Flush());
+  EXPECT_CALL(mock_syscalls_, Sendmmsg(_, _, _, _))
+      .WillOnce(Invoke([](int /*sockfd*/, mmsghdr* /*msgvec*/,
+                          unsigned int /*vlen*/, int /*flags*/) {
+        errno = EAGAIN;
+        return -1;
+      }));
+  alarm_factory.FireAlarm(writer_->flush_alarm());
+  EXPECT_TRUE(writer_->IsWriteBlocked());
+  EXPECT_FALSE(writer_->flush_alarm()->IsSet());
+
+  // No connection flushes again, but the train still goes out once the
+  // socket is writable.
+  writer_->SetWritable();
+  EXPECT_FALSE(writer_->IsWriteBlocked());
+  EXPECT_TRUE(writer_->flush_alarm()->IsSet());
+  EXPECT_CALL(mock_syscalls_, Sendmmsg(_, _, _, _))
+      .WillOnce(Invoke([](int /*sockfd*/, mmsghdr* /*msgvec*/,
+                          unsigned int vlen, int /*flags*/) {
+        EXPECT_EQ(1u, vlen);
+        return 1;
+      }));
+  alarm_factory.FireAlarm(writer_->flush_alarm());
+  EXPECT_EQ(0u, writer_->num_buffered_trains());
+  EXPECT_EQ(1u, writer_->num_trains_sent());
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace quic
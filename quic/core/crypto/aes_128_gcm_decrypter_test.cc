@@ -288,5 +288,22 @@ TEST_F(Aes128GcmDecrypterTest, GenerateHeaderProtectionMask) {
       expected_mask.size());
 }
 
+TEST_F(Aes128GcmDecrypterTest, WriteHeaderProtectionMask) {
+  Aes128GcmDecrypter decrypter;
+  std::string key =
+      quiche::QuicheTextUtils::HexDecode("d9132370cb18476ab833649cf080d970");
+  std::string sample =
+      quiche::QuicheTextUtils::HexDecode("d1d7998068517adb769b48b924a32c47");
+  QuicDataReader sample_reader(sample.data(), sample.size());
+  ASSERT_TRUE(decrypter.SetHeaderProtectionKey(key));
+  char mask[QuicDecrypter::kHeaderProtectionMaskLength];
+  ASSERT_TRUE(decrypter.WriteHeaderProtectionMask(&sample_reader, mask));
+  std::string expected_mask =
+      quiche::QuicheTextUtils::HexDecode("b132c37d6164da4ea4dc9b763aceec27");
+  quiche::test::CompareCharArraysWithHexError(
+      "header protection mask", mask, sizeof(mask), expected_mask.data(),
+      sizeof(mask));
+}
+
 }  // namespace test
 }  // namespace quic
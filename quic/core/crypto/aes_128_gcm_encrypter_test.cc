@@ -273,5 +273,21 @@ TEST_F(Aes128GcmEncrypterTest, GenerateHeaderProtectionMask) {
       expected_mask.size());
 }
 
+TEST_F(Aes128GcmEncrypterTest, WriteHeaderProtectionMask) {
+  Aes128GcmEncrypter encrypter;
+  std::string key =
+      quiche::QuicheTextUtils::HexDecode("d9132370cb18476ab833649cf080d970");
+  std::string sample =
+      quiche::QuicheTextUtils::HexDecode("d1d7998068517adb769b48b924a32c47");
+  ASSERT_TRUE(encrypter.SetHeaderProtectionKey(key));
+  char mask[QuicEncrypter::kHeaderProtectionMaskLength];
+  ASSERT_TRUE(encrypter.WriteHeaderProtectionMask(sample, mask));
+  std::string expected_mask =
+      quiche::QuicheTextUtils::HexDecode("b132c37d6164da4ea4dc9b763aceec27");
+  quiche::test::CompareCharArraysWithHexError(
+      "header protection mask", mask, sizeof(mask), expected_mask.data(),
+      sizeof(mask));
+}
+
 }  // namespace test
 }  // namespace quic
@@ -293,5 +293,22 @@ TEST_F(Aes256GcmDecrypterTest, GenerateHeaderProtectionMask) {
       expected_mask.size());
 }
 
+TEST_F(Aes256GcmDecrypterTest, WriteHeaderProtectionMask) {
+  Aes256GcmDecrypter decrypter;
+  std::string key = quiche::QuicheTextUtils::HexDecode(
+      "ed23ecbf54d426def5c52c3dcfc84434e62e57781d3125bb21ed91b7d3e07788");
+  std::string sample =
+      quiche::QuicheTextUtils::HexDecode("4d190c474be2b8babafb49ec4e38e810");
+  QuicDataReader sample_reader(sample.data(), sample.size());
+  ASSERT_TRUE(decrypter.SetHeaderProtectionKey(key));
+  char mask[QuicDecrypter::kHeaderProtectionMaskLength];
+  ASSERT_TRUE(decrypter.WriteHeaderProtectionMask(&sample_reader, mask));
+  std::string expected_mask =
+      quiche::QuicheTextUtils::HexDecode("db9ed4e6ccd033af2eae01407199c56e");
+  quiche::test::CompareCharArraysWithHexError(
+      "header protection mask", mask, sizeof(mask), expected_mask.data(),
+      sizeof(mask));
+}
+
 }  // namespace test
 }  // namespace quic
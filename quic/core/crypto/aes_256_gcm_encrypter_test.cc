@@ -255,5 +255,21 @@ TEST_F(Aes256GcmEncrypterTest, GenerateHeaderProtectionMask) {
       expected_mask.size());
 }
 
+TEST_F(Aes256GcmEncrypterTest, WriteHeaderProtectionMask) {
+  Aes256GcmEncrypter encrypter;
+  std::string key = quiche::QuicheTextUtils::HexDecode(
+      "ed23ecbf54d426def5c52c3dcfc84434e62e57781d3125bb21ed91b7d3e07788");
+  std::string sample =
+      quiche::QuicheTextUtils::HexDecode("4d190c474be2b8babafb49ec4e38e810");
+  ASSERT_TRUE(encrypter.SetHeaderProtectionKey(key));
+  char mask[QuicEncrypter::kHeaderProtectionMaskLength];
+  ASSERT_TRUE(encrypter.WriteHeaderProtectionMask(sample, mask));
+  std::string expected_mask =
+      quiche::QuicheTextUtils::HexDecode("db9ed4e6ccd033af2eae01407199c56e");
+  quiche::test::CompareCharArraysWithHexError(
+      "header protection mask", mask, sizeof(mask), expected_mask.data(),
+      sizeof(mask));
+}
+
 }  // namespace test
 }  // namespace quic
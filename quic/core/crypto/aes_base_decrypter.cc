@@ -4,6 +4,8 @@
 
 #include "net/third_party/quiche/src/quic/core/crypto/aes_base_decrypter.h"
 
+#include <cstring>
+
 #include "third_party/boringssl/src/include/openssl/aes.h"
 #include "net/third_party/quiche/src/quic/platform/api/quic_bug_tracker.h"
 #include "net/third_party/quiche/src/common/platform/api/quiche_string_piece.h"
@@ -36,4 +38,17 @@ std::string AesBaseDecrypter::GenerateHeaderProtectionMask(
   return out;
 }
 
+bool AesBaseDecrypter::WriteHeaderProtectionMask(QuicDataReader* sample_reader,
+                                                 char* mask) {
+  quiche::QuicheStringPiece sample;
+  if (!sample_reader->ReadStringPiece(&sample, AES_BLOCK_SIZE)) {
+    return false;
+  }
+  uint8_t block[AES_BLOCK_SIZE];
+  AES_encrypt(reinterpret_cast<const uint8_t*>(sample.data()), block,
+              &pne_key_);
+  memcpy(mask, block, kHeaderProtectionMaskLength);
+  return true;
+}
+
 }  // namespace quic
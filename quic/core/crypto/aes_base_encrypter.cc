@@ -4,6 +4,8 @@
 
 #include "net/third_party/quiche/src/quic/core/crypto/aes_base_encrypter.h"
 
+#include <cstring>
+
 #include "third_party/boringssl/src/include/openssl/aes.h"
 #include "net/third_party/quiche/src/quic/platform/api/quic_bug_tracker.h"
 #include "net/third_party/quiche/src/common/platform/api/quiche_string_piece.h"
@@ -35,4 +37,17 @@ std::string AesBaseEncrypter::GenerateHeaderProtectionMask(
   return out;
 }
 
+bool AesBaseEncrypter::WriteHeaderProtectionMask(
+    quiche::QuicheStringPiece sample,
+    char* mask) {
+  if (sample.size() != AES_BLOCK_SIZE) {
+    return false;
+  }
+  uint8_t block[AES_BLOCK_SIZE];
+  AES_encrypt(reinterpret_cast<const uint8_t*>(sample.data()), block,
+              &pne_key_);
+  memcpy(mask, block, kHeaderProtectionMaskLength);
+  return true;
+}
+
 }  // namespace quic
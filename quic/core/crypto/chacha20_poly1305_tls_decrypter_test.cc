@@ -186,5 +186,21 @@ TEST_F(ChaCha20Poly1305TlsDecrypterTest, GenerateHeaderProtectionMask) {
       expected_mask.size());
 }
 
+TEST_F(ChaCha20Poly1305TlsDecrypterTest, WriteHeaderProtectionMask) {
+  ChaCha20Poly1305TlsDecrypter decrypter;
+  std::string key = quiche::QuicheTextUtils::HexDecode(
+      "6a067f432787bd6034dd3f08f07fc9703a27e58c70e2d88d948b7f6489923cc7");
+  std::string sample =
+      quiche::QuicheTextUtils::HexDecode("1210d91cceb45c716b023f492c29e612");
+  QuicDataReader sample_reader(sample.data(), sample.size());
+  ASSERT_TRUE(decrypter.SetHeaderProtectionKey(key));
+  char mask[QuicDecrypter::kHeaderProtectionMaskLength];
+  ASSERT_TRUE(decrypter.WriteHeaderProtectionMask(&sample_reader, mask));
+  std::string expected_mask = quiche::QuicheTextUtils::HexDecode("1cc2cd98dc");
+  quiche::test::CompareCharArraysWithHexError(
+      "header protection mask", mask, sizeof(mask), expected_mask.data(),
+      sizeof(mask));
+}
+
 }  // namespace test
 }  // namespace quic
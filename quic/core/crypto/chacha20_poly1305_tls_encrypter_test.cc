@@ -171,5 +171,20 @@ TEST_F(ChaCha20Poly1305TlsEncrypterTest, GenerateHeaderProtectionMask) {
       expected_mask.size());
 }
 
+TEST_F(ChaCha20Poly1305TlsEncrypterTest, WriteHeaderProtectionMask) {
+  ChaCha20Poly1305TlsEncrypter encrypter;
+  std::string key = quiche::QuicheTextUtils::HexDecode(
+      "6a067f432787bd6034dd3f08f07fc9703a27e58c70e2d88d948b7f6489923cc7");
+  std::string sample =
+      quiche::QuicheTextUtils::HexDecode("1210d91cceb45c716b023f492c29e612");
+  ASSERT_TRUE(encrypter.SetHeaderProtectionKey(key));
+  char mask[QuicEncrypter::kHeaderProtectionMaskLength];
+  ASSERT_TRUE(encrypter.WriteHeaderProtectionMask(sample, mask));
+  std::string expected_mask = quiche::QuicheTextUtils::HexDecode("1cc2cd98dc");
+  quiche::test::CompareCharArraysWithHexError(
+      "header protection mask", mask, sizeof(mask), expected_mask.data(),
+      sizeof(mask));
+}
+
 }  // namespace test
 }  // namespace quic
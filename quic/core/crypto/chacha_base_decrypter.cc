@@ -27,19 +27,28 @@ bool ChaChaBaseDecrypter::SetHeaderProtectionKey(
 
 std::string ChaChaBaseDecrypter::GenerateHeaderProtectionMask(
     QuicDataReader* sample_reader) {
+  std::string out(kHeaderProtectionMaskLength, 0);
+  if (!WriteHeaderProtectionMask(sample_reader, &out[0])) {
+    return std::string();
+  }
+  return out;
+}
+
+bool ChaChaBaseDecrypter::WriteHeaderProtectionMask(
+    QuicDataReader* sample_reader,
+    char* mask) {
   quiche::QuicheStringPiece sample;
   if (!sample_reader->ReadStringPiece(&sample, 16)) {
-    return std::string();
+    return false;
   }
   const uint8_t* nonce = reinterpret_cast<const uint8_t*>(sample.data()) + 4;
   uint32_t counter;
   QuicDataReader(sample.data(), 4, quiche::HOST_BYTE_ORDER)
       .ReadUInt32(&counter);
-  const uint8_t zeroes[] = {0, 0, 0, 0, 0};
-  std::string out(QUICHE_ARRAYSIZE(zeroes), 0);
-  CRYPTO_chacha_20(reinterpret_cast<uint8_t*>(const_cast<char*>(out.data())),
-                   zeroes, QUICHE_ARRAYSIZE(zeroes), pne_key_, nonce, counter);
-  return out;
+  const uint8_t zeroes[kHeaderProtectionMaskLength] = {0, 0, 0, 0, 0};
+  CRYPTO_chacha_20(reinterpret_cast<uint8_t*>(mask), zeroes,
+                   QUICHE_ARRAYSIZE(zeroes), pne_key_, nonce, counter);
+  return true;
 }
 
 }  // namespace quic
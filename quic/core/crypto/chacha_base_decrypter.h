@@ -20,6 +20,8 @@ class QUIC_EXPORT_PRIVATE ChaChaBaseDecrypter : public AeadBaseDecrypter {
   bool SetHeaderProtectionKey(quiche::QuicheStringPiece key) override;
   std::string GenerateHeaderProtectionMask(
       QuicDataReader* sample_reader) override;
+  bool WriteHeaderProtectionMask(QuicDataReader* sample_reader,
+                                 char* mask) override;
 
  private:
   // The key used for packet number encryption.
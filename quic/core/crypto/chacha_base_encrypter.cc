@@ -25,18 +25,27 @@ bool ChaChaBaseEncrypter::SetHeaderProtectionKey(
 
 std::string ChaChaBaseEncrypter::GenerateHeaderProtectionMask(
     quiche::QuicheStringPiece sample) {
-  if (sample.size() != 16) {
+  std::string out(kHeaderProtectionMaskLength, 0);
+  if (!WriteHeaderProtectionMask(sample, &out[0])) {
     return std::string();
   }
+  return out;
+}
+
+bool ChaChaBaseEncrypter::WriteHeaderProtectionMask(
+    quiche::QuicheStringPiece sample,
+    char* mask) {
+  if (sample.size() != 16) {
+    return false;
+  }
   const uint8_t* nonce = reinterpret_cast<const uint8_t*>(sample.data()) + 4;
   uint32_t counter;
   QuicDataReader(sample.data(), 4, quiche::HOST_BYTE_ORDER)
       .ReadUInt32(&counter);
-  const uint8_t zeroes[] = {0, 0, 0, 0, 0};
-  std::string out(QUICHE_ARRAYSIZE(zeroes), 0);
-  CRYPTO_chacha_20(reinterpret_cast<uint8_t*>(const_cast<char*>(out.data())),
-                   zeroes, QUICHE_ARRAYSIZE(zeroes), pne_key_, nonce, counter);
-  return out;
+  const uint8_t zeroes[kHeaderProtectionMaskLength] = {0, 0, 0, 0, 0};
+  CRYPTO_chacha_20(reinterpret_cast<uint8_t*>(mask), zeroes,
+                   QUICHE_ARRAYSIZE(zeroes), pne_key_, nonce, counter);
+  return true;
 }
 
 }  // namespace quic
@@ -20,6 +20,8 @@ class QUIC_EXPORT_PRIVATE ChaChaBaseEncrypter : public AeadBaseEncrypter {
   bool SetHeaderProtectionKey(quiche::QuicheStringPiece key) override;
   std::string GenerateHeaderProtectionMask(
       quiche::QuicheStringPiece sample) override;
+  bool WriteHeaderProtectionMask(quiche::QuicheStringPiece sample,
+                                 char* mask) override;
 
  private:
   // The key used for packet number encryption.
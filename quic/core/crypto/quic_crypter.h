@@ -5,6 +5,8 @@
 #ifndef QUICHE_QUIC_CORE_CRYPTO_QUIC_CRYPTER_H_
 #define QUICHE_QUIC_CORE_CRYPTO_QUIC_CRYPTER_H_
 
+#include <cstddef>
+
 #include "net/third_party/quiche/src/quic/core/quic_versions.h"
 #include "net/third_party/quiche/src/quic/platform/api/quic_export.h"
 #include "net/third_party/quiche/src/common/platform/api/quiche_string_piece.h"
@@ -17,6 +19,10 @@ namespace quic {
 // decrypters.
 class QUIC_EXPORT_PRIVATE QuicCrypter {
  public:
+  // Number of header protection mask bytes applied to a packet: one for the
+  // first byte and up to four for the packet number.
+  enum : size_t { kHeaderProtectionMaskLength = 5 };
+
   virtual ~QuicCrypter() {}
 
   // Sets the symmetric encryption/decryption key. Returns true on success,
@@ -4,6 +4,7 @@
 
 #include "net/third_party/quiche/src/quic/core/crypto/quic_decrypter.h"
 
+#include <cstring>
 #include <string>
 #include <utility>
 
@@ -78,4 +79,14 @@ void QuicDecrypter::DiversifyPreliminaryKey(
   *out_nonce_prefix = std::string(hkdf.server_write_iv());
 }
 
+bool QuicDecrypter::WriteHeaderProtectionMask(QuicDataReader* sample_reader,
+                                              char* mask) {
+  std::string out = GenerateHeaderProtectionMask(sample_reader);
+  if (out.size() < kHeaderProtectionMaskLength) {
+    return false;
+  }
+  memcpy(mask, out.data(), kHeaderProtectionMaskLength);
+  return true;
+}
+
 }  // namespace quic
@@ -69,6 +69,12 @@ class QUIC_EXPORT_PRIVATE QuicDecrypter : public QuicCrypter {
   virtual std::string GenerateHeaderProtectionMask(
       QuicDataReader* sample_reader) = 0;
 
+  // Like GenerateHeaderProtectionMask, but writes the first
+  // kHeaderProtectionMaskLength bytes of the mask to |mask| rather than
+  // returning a string. Returns false on failure.
+  virtual bool WriteHeaderProtectionMask(QuicDataReader* sample_reader,
+                                         char* mask);
+
   // The ID of the cipher. Return 0x03000000 ORed with the 'cryptographic suite
   // selector'.
   virtual uint32_t cipher_id() const = 0;
@@ -4,6 +4,8 @@
 
 #include "net/third_party/quiche/src/quic/core/crypto/quic_encrypter.h"
 
+#include <cstring>
+#include <string>
 #include <utility>
 
 #include "third_party/boringssl/src/include/openssl/tls1.h"
@@ -58,4 +60,14 @@ std::unique_ptr<QuicEncrypter> QuicEncrypter::CreateFromCipherSuite(
   }
 }
 
+bool QuicEncrypter::WriteHeaderProtectionMask(quiche::QuicheStringPiece sample,
+                                              char* mask) {
+  std::string out = GenerateHeaderProtectionMask(sample);
+  if (out.size() < kHeaderProtectionMaskLength) {
+    return false;
+  }
+  memcpy(mask, out.data(), kHeaderProtectionMaskLength);
+  return true;
+}
+
 }  // namespace quic
@@ -49,6 +49,13 @@ class QUIC_EXPORT_PRIVATE QuicEncrypter : public QuicCrypter {
   virtual std::string GenerateHeaderProtectionMask(
       quiche::QuicheStringPiece sample) = 0;
 
+  // Like GenerateHeaderProtectionMask, but writes the first
+  // kHeaderProtectionMaskLength bytes of the mask to |mask| rather than
+  // returning a string, so that protecting a packet does not allocate. Returns
+  // false on failure.
+  virtual bool WriteHeaderProtectionMask(quiche::QuicheStringPiece sample,
+                                         char* mask);
+
   // Returns the maximum length of plaintext that can be encrypted
   // to ciphertext no larger than |ciphertext_size|.
   virtual size_t GetMaxPlaintextSize(size_t ciphertext_size) const = 0;
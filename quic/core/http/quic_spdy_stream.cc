@@ -4,6 +4,7 @@
 
 #include "net/third_party/quiche/src/quic/core/http/quic_spdy_stream.h"
 
+#include <algorithm>
 #include <limits>
 #include <string>
 #include <utility>
@@ -471,6 +472,30 @@ void QuicSpdyStream::MarkConsumed(size_t num_bytes) {
   sequencer()->MarkConsumed(body_manager_.OnBodyConsumed(num_bytes));
 }
 
+bool QuicSpdyStream::ReadBodySlice(size_t max_length,
+                                   QuicReceivedSlice* slice) {
+  DCHECK(FinishedReadingHeaders());
+  if (!VersionUsesHttp3(transport_version())) {
+    return sequencer()->ReadSlice(max_length, slice);
+  }
+
+  // The first body fragment starts at the sequencer's read position, since
+  // non-body bytes before it have already been marked consumed.
+  iovec iov;
+  if (body_manager_.PeekBody(&iov, 1) == 0) {
+    return false;
+  }
+  if (!sequencer()->ReadSlice(std::min(max_length, iov.iov_len), slice)) {
+    return false;
+  }
+  // Mark consumed any non-body bytes trailing the part of the fragment read.
+  const size_t bytes_to_consume = body_manager_.OnBodyConsumed(slice->length());
+  if (bytes_to_consume > slice->length()) {
+    sequencer()->MarkConsumed(bytes_to_consume - slice->length());
+  }
+  return true;
+}
+
 bool QuicSpdyStream::IsDoneReading() const {
   bool done_reading_headers = FinishedReadingHeaders();
   bool done_reading_body = sequencer()->IsClosed();
@@ -174,6 +174,11 @@ class QUIC_EXPORT_PRIVATE QuicSpdyStream
   virtual int GetReadableRegions(iovec* iov, size_t iov_len) const;
   void MarkConsumed(size_t num_bytes);
 
+  // Consumes up to |max_length| bytes of body and moves them into |slice|
+  // without copying when possible, see QuicStreamSequencer::ReadSlice().
+  // Returns false if no body is available.
+  bool ReadBodySlice(size_t max_length, QuicReceivedSlice* slice);
+
   // Returns true if header contains a valid 3-digit status and parse the status
   // code to |status_code|.
   static bool ParseHeaderStatusCode(const spdy::SpdyHeaderBlock& header,
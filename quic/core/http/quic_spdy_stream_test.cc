@@ -828,6 +828,33 @@ TEST_P(QuicSpdyStreamTest, ProcessHeadersAndBodyMarkConsumed) {
   EXPECT_EQ(data.length(), stream_->flow_controller()->bytes_consumed());
 }
 
+TEST_P(QuicSpdyStreamTest, ProcessHeadersAndReadBodySlice) {
+  Initialize(!kShouldProcessData);
+  std::string body1 = "this is body 1";
+  std::string data1 = UsesHttp3() ? DataFrame(body1) : body1;
+  std::string body2 = "body 2";
+  std::string data2 = UsesHttp3() ? DataFrame(body2) : body2;
+  std::string data = data1 + data2;
+
+  ProcessHeaders(false, headers_);
+  QuicStreamFrame frame(GetNthClientInitiatedBidirectionalId(0), false, 0,
+                        quiche::QuicheStringPiece(data));
+  stream_->OnStreamFrame(frame);
+  stream_->ConsumeHeaderList();
+
+  std::string read_body;
+  QuicReceivedSlice slice;
+  ASSERT_TRUE(stream_->ReadBodySlice(5, &slice));
+  EXPECT_EQ(body1.substr(0, 5), slice.AsStringPiece());
+  read_body.append(slice.data(), slice.length());
+  while (stream_->ReadBodySlice(1024, &slice)) {
+    read_body.append(slice.data(), slice.length());
+  }
+  EXPECT_EQ(body1 + body2, read_body);
+  EXPECT_FALSE(stream_->HasBytesToRead());
+  EXPECT_EQ(data.length(), stream_->flow_controller()->bytes_consumed());
+}
+
 TEST_P(QuicSpdyStreamTest, ProcessHeadersAndConsumeMultipleBody) {
   Initialize(!kShouldProcessData);
   std::string body1 = "this is body 1";
@@ -0,0 +1,359 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/third_party/quiche/src/quic/core/io_uring/quic_io_uring.h"
+
+#include <errno.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include "net/third_party/quiche/src/quic/platform/api/quic_bug_tracker.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_logging.h"
+
+namespace quic {
+namespace {
+
+int IoUringSetup(uint32_t entries, io_uring_params* params) {
+  return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+size_t RoundUpToPageSize(size_t size) {
+  const size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  return (size + page_size - 1) / page_size * page_size;
+}
+
+template <typename T>
+T* AtOffset(void* base, uint32_t offset) {
+  return reinterpret_cast<T*>(static_cast<char*>(base) + offset);
+}
+
+}  // namespace
+
+QuicIoUring::QuicIoUring()
+    : ring_fd_(-1),
+      features_(0),
+      sq_ring_(nullptr),
+      sq_ring_size_(0),
+      sq_head_(nullptr),
+      sq_tail_(nullptr),
+      sq_ring_mask_(0),
+      sq_ring_entries_(0),
+      sqes_(nullptr),
+      sqes_size_(0),
+      sqe_tail_(0),
+      submitted_tail_(0),
+      cq_ring_(nullptr),
+      cq_ring_size_(0),
+      cq_head_(nullptr),
+      cq_tail_(nullptr),
+      cq_ring_mask_(0),
+      cqes_(nullptr) {}
+
+QuicIoUring::~QuicIoUring() {
+  Cleanup();
+}
+
+bool QuicIoUring::Initialize(uint32_t num_entries,
+                             uint32_t completion_queue_multiplier) {
+  DCHECK(!initialized());
+  io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  params.flags = IORING_SETUP_CQSIZE;
+  params.cq_entries = num_entries * std::max(completion_queue_multiplier, 1u);
+#if defined(IORING_SETUP_COOP_TASKRUN)
+  // Completions are only ever reaped from the thread which submits, so there
+  // is no need to interrupt it when they arrive.
+  params.flags |= IORING_SETUP_COOP_TASKRUN;
+#endif
+  ring_fd_ = IoUringSetup(num_entries, &params);
+#if defined(IORING_SETUP_COOP_TASKRUN)
+  if (ring_fd_ < 0 && errno == EINVAL) {
+    params.flags &= ~IORING_SETUP_COOP_TASKRUN;
+    ring_fd_ = IoUringSetup(num_entries, &params);
+  }
+#endif
+  if (ring_fd_ < 0) {
+    QUIC_PLOG(WARNING) << "io_uring_setup failed";
+    ring_fd_ = -1;
+    return false;
+  }
+  features_ = params.features;
+  if (!(features_ & IORING_FEAT_EXT_ARG)) {
+    QUIC_LOG(WARNING) << "io_uring does not support IORING_FEAT_EXT_ARG.";
+    Cleanup();
+    return false;
+  }
+
+  sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+  cq_ring_size_ =
+      params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  const bool single_mmap = features_ & IORING_FEAT_SINGLE_MMAP;
+  if (single_mmap) {
+    sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+  }
+  sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+  if (sq_ring_ == MAP_FAILED) {
+    QUIC_PLOG(ERROR) << "Failed to map io_uring submission queue";
+    sq_ring_ = nullptr;
+    Cleanup();
+    return false;
+  }
+  if (single_mmap) {
+    cq_ring_ = sq_ring_;
+  } else {
+    cq_ring_ = mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_CQ_RING);
+    if (cq_ring_ == MAP_FAILED) {
+      QUIC_PLOG(ERROR) << "Failed to map io_uring completion queue";
+      cq_ring_ = nullptr;
+      Cleanup();
+      return false;
+    }
+  }
+  sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+  void* sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+  if (sqes == MAP_FAILED) {
+    QUIC_PLOG(ERROR) << "Failed to map io_uring submission queue entries";
+    Cleanup();
+    return false;
+  }
+  sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+  sq_head_ = AtOffset<uint32_t>(sq_ring_, params.sq_off.head);
+  sq_tail_ = AtOffset<uint32_t>(sq_ring_, params.sq_off.tail);
+  sq_ring_mask_ = *AtOffset<uint32_t>(sq_ring_, params.sq_off.ring_mask);
+  sq_ring_entries_ = *AtOffset<uint32_t>(sq_ring_, params.sq_off.ring_entries);
+  // Entries are always submitted in order, so the indirection array is the
+  // identity mapping.
+  uint32_t* sq_array = AtOffset<uint32_t>(sq_ring_, params.sq_off.array);
+  for (uint32_t i = 0; i < sq_ring_entries_; ++i) {
+    sq_array[i] = i;
+  }
+  sqe_tail_ = submitted_tail_ = *sq_tail_;
+
+  cq_head_ = AtOffset<uint32_t>(cq_ring_, params.cq_off.head);
+  cq_tail_ = AtOffset<uint32_t>(cq_ring_, params.cq_off.tail);
+  cq_ring_mask_ = *AtOffset<uint32_t>(cq_ring_, params.cq_off.ring_mask);
+  cqes_ = AtOffset<io_uring_cqe>(cq_ring_, params.cq_off.cqes);
+
+  QUIC_DVLOG(1) << "io_uring initialized with " << params.sq_entries
+                << " submission and " << params.cq_entries
+                << " completion entries, features: " << features_;
+  return true;
+}
+
+io_uring_sqe* QuicIoUring::GetSqe() {
+  DCHECK(initialized());
+  const uint32_t head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+  if (sqe_tail_ - head >= sq_ring_entries_) {
+    return nullptr;
+  }
+  io_uring_sqe* sqe = &sqes_[sqe_tail_ & sq_ring_mask_];
+  ++sqe_tail_;
+  memset(sqe, 0, sizeof(*sqe));
+  return sqe;
+}
+
+int QuicIoUring::Submit() {
+  const uint32_t to_submit = FlushSubmissions();
+  if (to_submit == 0) {
+    return 0;
+  }
+  int rc;
+  do {
+    rc = Enter(to_submit, 0, 0, nullptr, 0);
+  } while (rc == -EINTR);
+  return rc;
+}
+
+int QuicIoUring::SubmitAndWait(uint32_t min_completions,
+                               QuicTime::Delta timeout) {
+  const uint32_t to_submit = FlushSubmissions();
+  uint32_t flags = IORING_ENTER_GETEVENTS;
+  __kernel_timespec ts;
+  io_uring_getevents_arg arg;
+  const void* arg_ptr = nullptr;
+  size_t arg_size = 0;
+  if (!timeout.IsInfinite()) {
+    const int64_t timeout_us = std::max<int64_t>(0, timeout.ToMicroseconds());
+    ts.tv_sec = timeout_us / 1000000;
+    ts.tv_nsec = (timeout_us % 1000000) * 1000;
+    memset(&arg, 0, sizeof(arg));
+    arg.sigmask_sz = _NSIG / 8;
+    arg.ts = reinterpret_cast<uint64_t>(&ts);
+    arg_ptr = &arg;
+    arg_size = sizeof(arg);
+    flags |= IORING_ENTER_EXT_ARG;
+  }
+  const int rc = Enter(to_submit, min_completions, flags, arg_ptr, arg_size);
+  if (rc == -ETIME || rc == -EINTR) {
+    // Waiting was cut short, which callers treat like any other wakeup.
+    return 0;
+  }
+  return rc;
+}
+
+int QuicIoUring::RegisterBufferRing(io_uring_buf_ring* buffer_ring,
+                                    uint32_t num_entries,
+                                    uint16_t group_id) {
+  io_uring_buf_reg reg;
+  memset(&reg, 0, sizeof(reg));
+  reg.ring_addr = reinterpret_cast<uint64_t>(buffer_ring);
+  reg.ring_entries = num_entries;
+  reg.bgid = group_id;
+  if (syscall(__NR_io_uring_register, ring_fd_, IORING_REGISTER_PBUF_RING,
+              &reg, 1) < 0) {
+    return -errno;
+  }
+  return 0;
+}
+
+int QuicIoUring::UnregisterBufferRing(uint16_t group_id) {
+  io_uring_buf_reg reg;
+  memset(&reg, 0, sizeof(reg));
+  reg.bgid = group_id;
+  if (syscall(__NR_io_uring_register, ring_fd_, IORING_UNREGISTER_PBUF_RING,
+              &reg, 1) < 0) {
+    return -errno;
+  }
+  return 0;
+}
+
+int QuicIoUring::Enter(uint32_t to_submit,
+                       uint32_t min_complete,
+                       uint32_t flags,
+                       const void* arg,
+                       size_t arg_size) {
+  const long rc = syscall(__NR_io_uring_enter, ring_fd_, to_submit,
+                          min_complete, flags, arg, arg_size);
+  if (rc < 0) {
+    return -errno;
+  }
+  return static_cast<int>(rc);
+}
+
+uint32_t QuicIoUring::FlushSubmissions() {
+  if (sqe_tail_ != submitted_tail_) {
+    __atomic_store_n(sq_tail_, sqe_tail_, __ATOMIC_RELEASE);
+    submitted_tail_ = sqe_tail_;
+  }
+  // Includes entries left over by an earlier, partially failed submission.
+  return submitted_tail_ - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+}
+
+void QuicIoUring::Cleanup() {
+  if (sqes_ != nullptr) {
+    munmap(sqes_, sqes_size_);
+    sqes_ = nullptr;
+  }
+  if (cq_ring_ != nullptr && cq_ring_ != sq_ring_) {
+    munmap(cq_ring_, cq_ring_size_);
+  }
+  cq_ring_ = nullptr;
+  if (sq_ring_ != nullptr) {
+    munmap(sq_ring_, sq_ring_size_);
+    sq_ring_ = nullptr;
+  }
+  if (ring_fd_ >= 0) {
+    close(ring_fd_);
+    ring_fd_ = -1;
+  }
+}
+
+QuicIoUringBufferRing::QuicIoUringBufferRing()
+    : ring_(nullptr),
+      group_id_(0),
+      num_buffers_(0),
+      buffer_size_(0),
+      buffer_ring_(nullptr),
+      buffer_ring_size_(0),
+      buffers_(nullptr),
+      buffers_size_(0),
+      tail_(0) {}
+
+QuicIoUringBufferRing::~QuicIoUringBufferRing() {
+  if (buffer_ring_ == nullptr) {
+    return;
+  }
+  if (ring_ != nullptr) {
+    ring_->UnregisterBufferRing(group_id_);
+  }
+  munmap(buffer_ring_, buffer_ring_size_);
+  munmap(buffers_, buffers_size_);
+}
+
+bool QuicIoUringBufferRing::Initialize(QuicIoUring* ring,
+                                       uint16_t group_id,
+                                       uint16_t num_buffers,
+                                       size_t buffer_size) {
+  DCHECK(buffer_ring_ == nullptr);
+  if (num_buffers == 0 || (num_buffers & (num_buffers - 1)) != 0 ||
+      num_buffers > 32768) {
+    QUIC_BUG << "Invalid number of buffers: " << num_buffers;
+    return false;
+  }
+  // The descriptor ring must be page aligned.
+  buffer_ring_size_ = RoundUpToPageSize(num_buffers * sizeof(io_uring_buf));
+  void* buffer_ring = mmap(nullptr, buffer_ring_size_, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (buffer_ring == MAP_FAILED) {
+    QUIC_PLOG(ERROR) << "Failed to allocate buffer ring";
+    return false;
+  }
+  buffers_size_ = RoundUpToPageSize(num_buffers * buffer_size);
+  void* buffers = mmap(nullptr, buffers_size_, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (buffers == MAP_FAILED) {
+    QUIC_PLOG(ERROR) << "Failed to allocate " << buffers_size_
+                     << " bytes of receive buffers";
+    munmap(buffer_ring, buffer_ring_size_);
+    return false;
+  }
+  const int rc = ring->RegisterBufferRing(
+      static_cast<io_uring_buf_ring*>(buffer_ring), num_buffers, group_id);
+  if (rc < 0) {
+    QUIC_LOG(WARNING) << "Failed to register buffer ring: " << strerror(-rc);
+    munmap(buffer_ring, buffer_ring_size_);
+    munmap(buffers, buffers_size_);
+    return false;
+  }
+
+  ring_ = ring;
+  group_id_ = group_id;
+  num_buffers_ = num_buffers;
+  buffer_size_ = buffer_size;
+  buffer_ring_ = static_cast<io_uring_buf_ring*>(buffer_ring);
+  buffers_ = static_cast<char*>(buffers);
+  tail_ = 0;
+  for (uint32_t buffer_id = 0; buffer_id < num_buffers; ++buffer_id) {
+    Recycle(static_cast<uint16_t>(buffer_id));
+  }
+  Publish();
+  return true;
+}
+
+void QuicIoUringBufferRing::Recycle(uint16_t buffer_id) {
+  DCHECK_LT(buffer_id, num_buffers_);
+  // Not |buffer_ring_->bufs|, whose flexible array wrapper has a nonzero
+  // size in C++ and so shifts the array.
+  io_uring_buf* buf = reinterpret_cast<io_uring_buf*>(buffer_ring_) +
+                      (tail_ & (num_buffers_ - 1));
+  buf->addr = reinterpret_cast<uint64_t>(GetBuffer(buffer_id));
+  buf->len = static_cast<uint32_t>(buffer_size_);
+  buf->bid = buffer_id;
+  ++tail_;
+}
+
+void QuicIoUringBufferRing::Publish() {
+  __atomic_store_n(&buffer_ring_->tail, tail_, __ATOMIC_RELEASE);
+}
+
+}  // namespace quic
@@ -0,0 +1,170 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Thin wrappers around the Linux io_uring interface, using the raw system
+// calls so that no userspace library is needed.
+
+#ifndef QUICHE_QUIC_CORE_IO_URING_QUIC_IO_URING_H_
+#define QUICHE_QUIC_CORE_IO_URING_QUIC_IO_URING_H_
+
+#include <linux/io_uring.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "net/third_party/quiche/src/quic/core/quic_time.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_export.h"
+
+namespace quic {
+
+// A single io_uring instance: a submission queue and a completion queue shared
+// with the kernel. Not thread safe.
+class QUIC_EXPORT_PRIVATE QuicIoUring {
+ public:
+  QuicIoUring();
+  QuicIoUring(const QuicIoUring&) = delete;
+  QuicIoUring& operator=(const QuicIoUring&) = delete;
+  ~QuicIoUring();
+
+  // Sets up a ring with at least |num_entries| submission queue entries, and
+  // |completion_queue_multiplier| times as many completion queue entries.
+  // Returns false if io_uring, or one of the features used here, is not
+  // supported by the kernel.
+  bool Initialize(uint32_t num_entries, uint32_t completion_queue_multiplier);
+
+  bool initialized() const { return ring_fd_ >= 0; }
+
+  int ring_fd() const { return ring_fd_; }
+
+  // Returns a zeroed submission queue entry, or nullptr if the submission
+  // queue is full, in which case Submit() makes room. Entries are not seen by
+  // the kernel until the next Submit() or SubmitAndWait().
+  io_uring_sqe* GetSqe();
+
+  // Number of entries returned by GetSqe() which have not been submitted.
+  uint32_t pending_submissions() const { return sqe_tail_ - submitted_tail_; }
+
+  // Submits all pending entries without waiting. Returns the number of
+  // entries submitted, or -errno.
+  int Submit();
+
+  // Submits all pending entries, then waits until at least |min_completions|
+  // completions are available or |timeout| has passed, whichever comes first.
+  // An infinite |timeout| waits forever. Returns the number of entries
+  // submitted, or -errno. Timing out is not an error.
+  int SubmitAndWait(uint32_t min_completions, QuicTime::Delta timeout);
+
+  // Calls |visitor| with each available completion, in order. Each completion
+  // is consumed before |visitor| sees it, so |visitor| may queue new
+  // submissions. Returns the number of completions visited.
+  template <typename Visitor>
+  size_t ForEachCompletion(Visitor visitor) {
+    size_t num_visited = 0;
+    uint32_t head = *cq_head_;
+    while (head != __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) {
+      const io_uring_cqe cqe = cqes_[head & cq_ring_mask_];
+      ++head;
+      __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+      visitor(cqe);
+      ++num_visited;
+      head = *cq_head_;
+    }
+    return num_visited;
+  }
+
+  // Registers |buffer_ring|, which holds |num_entries| buffer descriptors,
+  // as provided buffer group |group_id|. Returns 0 or -errno.
+  int RegisterBufferRing(io_uring_buf_ring* buffer_ring,
+                         uint32_t num_entries,
+                         uint16_t group_id);
+  int UnregisterBufferRing(uint16_t group_id);
+
+ private:
+  int Enter(uint32_t to_submit,
+            uint32_t min_complete,
+            uint32_t flags,
+            const void* arg,
+            size_t arg_size);
+
+  // Makes pending entries visible to the kernel and returns their number.
+  uint32_t FlushSubmissions();
+
+  void Cleanup();
+
+  int ring_fd_;
+  uint32_t features_;
+
+  // Submission queue.
+  void* sq_ring_;
+  size_t sq_ring_size_;
+  uint32_t* sq_head_;
+  uint32_t* sq_tail_;
+  uint32_t sq_ring_mask_;
+  uint32_t sq_ring_entries_;
+  io_uring_sqe* sqes_;
+  size_t sqes_size_;
+  // Tail including entries handed out by GetSqe() but not yet submitted.
+  uint32_t sqe_tail_;
+  // The tail the kernel has last been told about.
+  uint32_t submitted_tail_;
+
+  // Completion queue. Shares its mapping with the submission queue if the
+  // kernel supports IORING_FEAT_SINGLE_MMAP.
+  void* cq_ring_;
+  size_t cq_ring_size_;
+  uint32_t* cq_head_;
+  uint32_t* cq_tail_;
+  uint32_t cq_ring_mask_;
+  io_uring_cqe* cqes_;
+};
+
+// A ring of equally sized buffers which the kernel picks from for operations
+// submitted with IOSQE_BUFFER_SELECT, e.g. multishot receives. The buffer id
+// the kernel picked is reported in the completion flags.
+class QUIC_EXPORT_PRIVATE QuicIoUringBufferRing {
+ public:
+  QuicIoUringBufferRing();
+  QuicIoUringBufferRing(const QuicIoUringBufferRing&) = delete;
+  QuicIoUringBufferRing& operator=(const QuicIoUringBufferRing&) = delete;
+  // Unregisters the ring from the io_uring, which must still be alive.
+  ~QuicIoUringBufferRing();
+
+  // Allocates |num_buffers| buffers of |buffer_size| bytes each, registers
+  // them with |ring| as group |group_id| and hands all of them to the kernel.
+  // |num_buffers| must be a power of two no larger than 32768.
+  bool Initialize(QuicIoUring* ring,
+                  uint16_t group_id,
+                  uint16_t num_buffers,
+                  size_t buffer_size);
+
+  char* GetBuffer(uint16_t buffer_id) const {
+    return buffers_ + static_cast<size_t>(buffer_id) * buffer_size_;
+  }
+
+  // Gives |buffer_id| back to the kernel. Takes effect on the next Publish().
+  void Recycle(uint16_t buffer_id);
+
+  // Makes all recycled buffers available to the kernel.
+  void Publish();
+
+  uint16_t group_id() const { return group_id_; }
+  size_t buffer_size() const { return buffer_size_; }
+  uint16_t num_buffers() const { return num_buffers_; }
+
+ private:
+  QuicIoUring* ring_;  // Not owned.
+  uint16_t group_id_;
+  uint16_t num_buffers_;
+  size_t buffer_size_;
+  io_uring_buf_ring* buffer_ring_;
+  size_t buffer_ring_size_;
+  char* buffers_;
+  size_t buffers_size_;
+  // Tail including recycled but not yet published buffers.
+  uint16_t tail_;
+};
+
+}  // namespace quic
+
+#endif  // QUICHE_QUIC_CORE_IO_URING_QUIC_IO_URING_H_
@@ -0,0 +1,159 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/third_party/quiche/src/quic/core/io_uring/quic_io_uring_batch_writer.h"
+
+#include <errno.h>
+
+#include <cstring>
+
+#include "net/third_party/quiche/src/quic/platform/api/quic_bug_tracker.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_logging.h"
+
+namespace quic {
+
+QuicIoUringBatchWriter::QuicIoUringBatchWriter(QuicIoUringEventLoop* event_loop,
+                                               int fd,
+                                               size_t max_sends_in_flight)
+    : event_loop_(event_loop),
+      blocked_writer_(nullptr),
+      fd_(fd),
+      write_blocked_(false),
+      bytes_since_flush_(0),
+      num_send_errors_(0) {
+  DCHECK_GT(max_sends_in_flight, 0u);
+  slots_.reserve(max_sends_in_flight);
+  free_slots_.reserve(max_sends_in_flight);
+  for (size_t i = 0; i < max_sends_in_flight; ++i) {
+    slots_.push_back(std::make_unique<SendSlot>(this));
+    free_slots_.push_back(slots_.back().get());
+  }
+}
+
+QuicIoUringBatchWriter::~QuicIoUringBatchWriter() {
+  blocked_writer_ = nullptr;
+  event_loop_->CancelSubmissionQueueNotification(this);
+  const bool done = event_loop_->RunEventLoopUntil(
+      [this] { return num_sends_in_flight() == 0; },
+      QuicTime::Delta::FromMilliseconds(kIoUringShutdownTimeoutMs));
+  QUIC_BUG_IF(!done) << num_sends_in_flight() << " sends on fd " << fd_
+                     << " still in flight after " << kIoUringShutdownTimeoutMs
+                     << "ms.";
+}
+
+WriteResult QuicIoUringBatchWriter::WritePacket(
+    const char* buffer,
+    size_t buf_len,
+    const QuicIpAddress& self_address,
+    const QuicSocketAddress& peer_address,
+    PerPacketOptions* /*options*/) {
+  DCHECK(peer_address.IsInitialized());
+  if (write_blocked_) {
+    return WriteResult(WRITE_STATUS_BLOCKED, EWOULDBLOCK);
+  }
+  if (buf_len > kMaxOutgoingPacketSize) {
+    return WriteResult(WRITE_STATUS_MSG_TOO_BIG, EMSGSIZE);
+  }
+  if (free_slots_.empty()) {
+    write_blocked_ = true;
+    return WriteResult(WRITE_STATUS_BLOCKED, EWOULDBLOCK);
+  }
+
+  SendSlot* slot = free_slots_.back();
+  io_uring_sqe* sqe = event_loop_->PrepareSubmission(slot);
+  if (sqe == nullptr) {
+    // The submission queue stays full until the event loop submits it and
+    // reaps completions, which is no reason to fail the connection.
+    write_blocked_ = true;
+    event_loop_->NotifyWhenSubmissionQueueAvailable(this);
+    return WriteResult(WRITE_STATUS_BLOCKED, EWOULDBLOCK);
+  }
+  free_slots_.pop_back();
+
+  // |buffer| is already in place if it came from GetNextWriteLocation().
+  if (buffer != slot->buffer) {
+    memcpy(slot->buffer, buffer, buf_len);
+  }
+  slot->iov.iov_base = slot->buffer;
+  slot->iov.iov_len = buf_len;
+  slot->raw_peer_address = peer_address.generic_address();
+
+  msghdr* hdr = &slot->hdr;
+  hdr->msg_name = &slot->raw_peer_address;
+  hdr->msg_namelen = slot->raw_peer_address.ss_family == AF_INET
+                         ? sizeof(sockaddr_in)
+                         : sizeof(sockaddr_in6);
+  hdr->msg_iov = &slot->iov;
+  hdr->msg_iovlen = 1;
+  hdr->msg_flags = 0;
+  hdr->msg_control = nullptr;
+  hdr->msg_controllen = 0;
+  if (self_address.IsInitialized()) {
+    memset(slot->cbuf, 0, sizeof(slot->cbuf));
+    hdr->msg_control = slot->cbuf;
+    hdr->msg_controllen = CMSG_SPACE(QuicLinuxSocketUtils::SetIpInfoInCmsg(
+        self_address, reinterpret_cast<cmsghdr*>(slot->cbuf)));
+  }
+
+  sqe->opcode = IORING_OP_SENDMSG;
+  sqe->fd = fd_;
+  sqe->addr = reinterpret_cast<uint64_t>(hdr);
+  sqe->len = 1;
+
+  bytes_since_flush_ += buf_len;
+  return WriteResult(WRITE_STATUS_OK, 0);
+}
+
+QuicByteCount QuicIoUringBatchWriter::GetMaxPacketSize(
+    const QuicSocketAddress& /*peer_address*/) const {
+  return kMaxOutgoingPacketSize;
+}
+
+QuicPacketBuffer QuicIoUringBatchWriter::GetNextWriteLocation(
+    const QuicIpAddress& /*self_address*/,
+    const QuicSocketAddress& /*peer_address*/) {
+  if (write_blocked_ || free_slots_.empty()) {
+    return {nullptr, nullptr};
+  }
+  return {free_slots_.back()->buffer, nullptr};
+}
+
+WriteResult QuicIoUringBatchWriter::Flush() {
+  // The sends are already queued on the ring, which submits them at the
+  // start of the next event loop turn.
+  WriteResult result(WRITE_STATUS_OK, bytes_since_flush_);
+  bytes_since_flush_ = 0;
+  return result;
+}
+
+void QuicIoUringBatchWriter::OnSendComplete(SendSlot* slot, int result) {
+  if (result < 0) {
+    ++num_send_errors_;
+    QUIC_LOG_FIRST_N(ERROR, 100)
+        << "Error writing packet to "
+        << QuicSocketAddress(slot->raw_peer_address).ToString() << ": "
+        << strerror(-result);
+  }
+  free_slots_.push_back(slot);
+  MaybeUnblock();
+}
+
+void QuicIoUringBatchWriter::OnSubmissionQueueAvailable() {
+  if (!free_slots_.empty()) {
+    MaybeUnblock();
+  }
+}
+
+void QuicIoUringBatchWriter::MaybeUnblock() {
+  if (!write_blocked_) {
+    return;
+  }
+  write_blocked_ = false;
+  event_loop_->CancelSubmissionQueueNotification(this);
+  if (blocked_writer_ != nullptr) {
+    blocked_writer_->OnBlockedWriterCanWrite();
+  }
+}
+
+}  // namespace quic
@@ -0,0 +1,123 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef QUICHE_QUIC_CORE_IO_URING_QUIC_IO_URING_BATCH_WRITER_H_
+#define QUICHE_QUIC_CORE_IO_URING_QUIC_IO_URING_BATCH_WRITER_H_
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "net/third_party/quiche/src/quic/core/io_uring/quic_io_uring_event_loop.h"
+#include "net/third_party/quiche/src/quic/core/quic_blocked_writer_interface.h"
+#include "net/third_party/quiche/src/quic/core/quic_linux_socket_utils.h"
+#include "net/third_party/quiche/src/quic/core/quic_packet_writer.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_aligned.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_export.h"
+
+namespace quic {
+
+// Default number of packets a QuicIoUringBatchWriter can have in flight.
+const size_t kDefaultIoUringMaxSendsInFlight = 256;
+
+// A batch mode packet writer which queues one sendmsg operation per packet on
+// an io_uring. The operations are submitted together with the event loop's
+// next wait, so a loop turn costs one system call no matter how many packets
+// were written during it.
+//
+// Packets are copied into, or written in place through GetNextWriteLocation()
+// to, one of a fixed number of send slots, each of which is busy until the
+// kernel completes its send. The writer is blocked while all slots are busy,
+// or while the ring's submission queue is full, and notifies its blocked
+// writer once a slot or the queue frees up. Send errors are only
+// known asynchronously; they are logged and counted, and the packets are
+// treated as lost.
+class QUIC_EXPORT_PRIVATE QuicIoUringBatchWriter
+    : public QuicPacketWriter,
+      public QuicIoUringEventLoop::SubmissionQueueObserver {
+ public:
+  // |event_loop| must outlive the writer.
+  QuicIoUringBatchWriter(QuicIoUringEventLoop* event_loop,
+                         int fd,
+                         size_t max_sends_in_flight);
+  QuicIoUringBatchWriter(const QuicIoUringBatchWriter&) = delete;
+  QuicIoUringBatchWriter& operator=(const QuicIoUringBatchWriter&) = delete;
+  // Runs |event_loop| until all sends have completed, for at most
+  // kIoUringShutdownTimeoutMs.
+  ~QuicIoUringBatchWriter() override;
+
+  // |blocked_writer| is notified when the writer stops being blocked. May be
+  // nullptr.
+  void set_blocked_writer(QuicBlockedWriterInterface* blocked_writer) {
+    blocked_writer_ = blocked_writer;
+  }
+
+  // QuicPacketWriter interface.
+  WriteResult WritePacket(const char* buffer,
+                          size_t buf_len,
+                          const QuicIpAddress& self_address,
+                          const QuicSocketAddress& peer_address,
+                          PerPacketOptions* options) override;
+  bool IsWriteBlocked() const override { return write_blocked_; }
+  void SetWritable() override { write_blocked_ = false; }
+  QuicByteCount GetMaxPacketSize(
+      const QuicSocketAddress& peer_address) const override;
+  bool SupportsReleaseTime() const override { return false; }
+  bool IsBatchMode() const override { return true; }
+  QuicPacketBuffer GetNextWriteLocation(
+      const QuicIpAddress& self_address,
+      const QuicSocketAddress& peer_address) override;
+  WriteResult Flush() override;
+
+  // QuicIoUringEventLoop::SubmissionQueueObserver interface.
+  void OnSubmissionQueueAvailable() override;
+
+  size_t num_sends_in_flight() const {
+    return slots_.size() - free_slots_.size();
+  }
+
+  // Number of sends which the kernel failed.
+  uint64_t num_send_errors() const { return num_send_errors_; }
+
+ private:
+  struct QUIC_EXPORT_PRIVATE SendSlot
+      : public QuicIoUringEventLoop::CompletionHandler {
+    explicit SendSlot(QuicIoUringBatchWriter* writer) : writer(writer) {}
+
+    void OnCompletion(const io_uring_cqe& cqe) override {
+      writer->OnSendComplete(this, cqe.res);
+    }
+
+    QuicIoUringBatchWriter* writer;
+    msghdr hdr;
+    iovec iov;
+    sockaddr_storage raw_peer_address;
+    QUIC_CACHELINE_ALIGNED char cbuf[kCmsgSpaceForIp];
+    QUIC_CACHELINE_ALIGNED char buffer[kMaxOutgoingPacketSize];
+  };
+
+  void OnSendComplete(SendSlot* slot, int result);
+
+  // Unblocks the writer and notifies |blocked_writer_|, if it is blocked.
+  void MaybeUnblock();
+
+  QuicIoUringEventLoop* event_loop_;            // Not owned.
+  QuicBlockedWriterInterface* blocked_writer_;  // Not owned.
+  const int fd_;
+  bool write_blocked_;
+  std::vector<std::unique_ptr<SendSlot>> slots_;
+  std::vector<SendSlot*> free_slots_;
+  // Bytes written since the last Flush().
+  size_t bytes_since_flush_;
+  uint64_t num_send_errors_;
+};
+
+}  // namespace quic
+
+#endif  // QUICHE_QUIC_CORE_IO_URING_QUIC_IO_URING_BATCH_WRITER_H_
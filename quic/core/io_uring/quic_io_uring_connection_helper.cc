@@ -0,0 +1,30 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/third_party/quiche/src/quic/core/io_uring/quic_io_uring_connection_helper.h"
+
+#include "net/third_party/quiche/src/quic/core/crypto/quic_random.h"
+
+namespace quic {
+
+QuicIoUringConnectionHelper::QuicIoUringConnectionHelper(
+    QuicIoUringEventLoop* event_loop)
+    : event_loop_(event_loop), random_generator_(QuicRandom::GetInstance()) {}
+
+QuicIoUringConnectionHelper::~QuicIoUringConnectionHelper() = default;
+
+const QuicClock* QuicIoUringConnectionHelper::GetClock() const {
+  return event_loop_->clock();
+}
+
+QuicRandom* QuicIoUringConnectionHelper::GetRandomGenerator() {
+  return random_generator_;
+}
+
+QuicBufferAllocator*
+QuicIoUringConnectionHelper::GetStreamSendBufferAllocator() {
+  return &buffer_allocator_;
+}
+
+}  // namespace quic
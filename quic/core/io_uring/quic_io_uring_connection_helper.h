@@ -0,0 +1,43 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// The io_uring-specific helper for QuicConnection, which uses the clock of a
+// QuicIoUringEventLoop.
+
+#ifndef QUICHE_QUIC_CORE_IO_URING_QUIC_IO_URING_CONNECTION_HELPER_H_
+#define QUICHE_QUIC_CORE_IO_URING_QUIC_IO_URING_CONNECTION_HELPER_H_
+
+#include "net/third_party/quiche/src/quic/core/io_uring/quic_io_uring_event_loop.h"
+#include "net/third_party/quiche/src/quic/core/quic_connection.h"
+#include "net/third_party/quiche/src/quic/core/quic_simple_buffer_allocator.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_export.h"
+
+namespace quic {
+
+class QuicRandom;
+
+class QUIC_EXPORT_PRIVATE QuicIoUringConnectionHelper
+    : public QuicConnectionHelperInterface {
+ public:
+  // |event_loop| must outlive the helper.
+  explicit QuicIoUringConnectionHelper(QuicIoUringEventLoop* event_loop);
+  QuicIoUringConnectionHelper(const QuicIoUringConnectionHelper&) = delete;
+  QuicIoUringConnectionHelper& operator=(const QuicIoUringConnectionHelper&) =
+      delete;
+  ~QuicIoUringConnectionHelper() override;
+
+  // QuicConnectionHelperInterface
+  const QuicClock* GetClock() const override;
+  QuicRandom* GetRandomGenerator() override;
+  QuicBufferAllocator* GetStreamSendBufferAllocator() override;
+
+ private:
+  QuicIoUringEventLoop* event_loop_;  // Not owned.
+  QuicRandom* random_generator_;
+  SimpleBufferAllocator buffer_allocator_;
+};
+
+}  // namespace quic
+
+#endif  // QUICHE_QUIC_CORE_IO_URING_QUIC_IO_URING_CONNECTION_HELPER_H_
@@ -0,0 +1,207 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/third_party/quiche/src/quic/core/io_uring/quic_io_uring_event_loop.h"
+
+#include <errno.h>
+#include <time.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include "net/third_party/quiche/src/quic/core/quic_arena_scoped_ptr.h"
+#include "net/third_party/quiche/src/quic/core/quic_timing_wheel_alarm.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_logging.h"
+
+namespace quic {
+namespace {
+
+int64_t ReadClockInMicroseconds(clockid_t clock_id) {
+  timespec ts;
+  clock_gettime(clock_id, &ts);
+  return static_cast<int64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+}  // namespace
+
+QuicIoUringClock::QuicIoUringClock() : approximate_now_(QuicTime::Zero()) {
+  Update();
+}
+
+QuicIoUringClock::~QuicIoUringClock() = default;
+
+QuicTime QuicIoUringClock::ApproximateNow() const {
+  return approximate_now_;
+}
+
+QuicTime QuicIoUringClock::Now() const {
+  return CreateTimeFromMicroseconds(ReadClockInMicroseconds(CLOCK_MONOTONIC));
+}
+
+QuicWallTime QuicIoUringClock::WallNow() const {
+  return QuicWallTime::FromUNIXMicroseconds(
+      ReadClockInMicroseconds(CLOCK_REALTIME));
+}
+
+void QuicIoUringClock::Update() {
+  approximate_now_ = Now();
+}
+
+QuicIoUringEventLoop::QuicIoUringEventLoop(QuicTime::Delta alarm_granularity)
+    : timing_wheel_(alarm_granularity, clock_.ApproximateNow()),
+      next_buffer_group_id_(0) {}
+
+QuicIoUringEventLoop::~QuicIoUringEventLoop() = default;
+
+bool QuicIoUringEventLoop::Initialize(uint32_t num_entries) {
+  // Multishot receives produce many completions per submission.
+  return ring_.Initialize(num_entries, /*completion_queue_multiplier=*/8);
+}
+
+io_uring_sqe* QuicIoUringEventLoop::PrepareSubmission(
+    CompletionHandler* handler) {
+  io_uring_sqe* sqe = ring_.GetSqe();
+  if (sqe == nullptr) {
+    const int rc = ring_.Submit();
+    if (rc < 0) {
+      QUIC_LOG_FIRST_N(ERROR, 100)
+          << "Failed to submit to io_uring: " << strerror(-rc);
+      return nullptr;
+    }
+    sqe = ring_.GetSqe();
+    if (sqe == nullptr) {
+      return nullptr;
+    }
+  }
+  sqe->user_data = reinterpret_cast<uint64_t>(handler);
+  return sqe;
+}
+
+void QuicIoUringEventLoop::Submit() {
+  const int rc = ring_.Submit();
+  if (rc < 0) {
+    QUIC_LOG_FIRST_N(ERROR, 100)
+        << "Failed to submit to io_uring: " << strerror(-rc);
+  }
+}
+
+void QuicIoUringEventLoop::NotifyWhenSubmissionQueueAvailable(
+    SubmissionQueueObserver* observer) {
+  if (std::find(submission_queue_observers_.begin(),
+                submission_queue_observers_.end(),
+                observer) == submission_queue_observers_.end()) {
+    submission_queue_observers_.push_back(observer);
+  }
+}
+
+void QuicIoUringEventLoop::CancelSubmissionQueueNotification(
+    SubmissionQueueObserver* observer) {
+  for (std::vector<SubmissionQueueObserver*>* observers :
+       {&submission_queue_observers_, &notifying_observers_}) {
+    observers->erase(
+        std::remove(observers->begin(), observers->end(), observer),
+        observers->end());
+  }
+}
+
+bool QuicIoUringEventLoop::CancelSubmissions(CompletionHandler* handler) {
+  // The completion of the cancellation itself is not delivered anywhere.
+  io_uring_sqe* sqe = PrepareSubmission(nullptr);
+  if (sqe == nullptr) {
+    QUIC_LOG(ERROR) << "Failed to cancel io_uring operations.";
+    return false;
+  }
+  sqe->opcode = IORING_OP_ASYNC_CANCEL;
+  sqe->fd = -1;
+  sqe->addr = reinterpret_cast<uint64_t>(handler);
+  sqe->cancel_flags = IORING_ASYNC_CANCEL_ALL;
+  return true;
+}
+
+void QuicIoUringEventLoop::RunEventLoopOnce(QuicTime::Delta max_wait) {
+  clock_.Update();
+  QuicTime::Delta wait = max_wait;
+  const QuicTime next_alarm = timing_wheel_.NextWakeupTime();
+  if (next_alarm != QuicTime::Infinite()) {
+    wait = std::min(wait, std::max(QuicTime::Delta::Zero(),
+                                   next_alarm - clock_.ApproximateNow()));
+  }
+
+  const int rc = ring_.SubmitAndWait(/*min_completions=*/1, wait);
+  if (rc < 0) {
+    QUIC_LOG_FIRST_N(ERROR, 100)
+        << "io_uring_enter failed: " << strerror(-rc);
+  }
+
+  clock_.Update();
+  ring_.ForEachCompletion([](const io_uring_cqe& cqe) {
+    CompletionHandler* handler =
+        reinterpret_cast<CompletionHandler*>(cqe.user_data);
+    if (handler != nullptr) {
+      handler->OnCompletion(cqe);
+    }
+  });
+  // The entries queued before this turn have been submitted and completions
+  // reaped, so the observers can retry. Those which fail again register for
+  // the next turn.
+  // An observer may cancel others while being notified, so each is taken
+  // off the list before it is called.
+  notifying_observers_.swap(submission_queue_observers_);
+  while (!notifying_observers_.empty()) {
+    SubmissionQueueObserver* observer = notifying_observers_.back();
+    notifying_observers_.pop_back();
+    observer->OnSubmissionQueueAvailable();
+  }
+  timing_wheel_.AdvanceTo(clock_.ApproximateNow());
+}
+
+bool QuicIoUringEventLoop::RunEventLoopUntil(const std::function<bool()>& done,
+                                             QuicTime::Delta timeout) {
+  const QuicTime deadline = clock_.Now() + timeout;
+  while (!done()) {
+    const QuicTime now = clock_.Now();
+    if (now >= deadline) {
+      return false;
+    }
+    RunEventLoopOnce(deadline - now);
+  }
+  return true;
+}
+
+void QuicIoUringEventLoop::Schedule(QuicTimingWheel::Timer* timer,
+                                    QuicTime deadline) {
+  if (timing_wheel_.empty()) {
+    // Bring an idle wheel up to date, so that |timer| lands in a low level.
+    timing_wheel_.AdvanceTo(clock_.ApproximateNow());
+  }
+  // RunEventLoopOnce() picks up the new wakeup time on its next turn.
+  timing_wheel_.Schedule(timer, deadline);
+}
+
+void QuicIoUringEventLoop::Cancel(QuicTimingWheel::Timer* timer) {
+  timing_wheel_.Cancel(timer);
+}
+
+QuicIoUringAlarmFactory::QuicIoUringAlarmFactory(
+    QuicIoUringEventLoop* event_loop)
+    : event_loop_(event_loop) {}
+
+QuicIoUringAlarmFactory::~QuicIoUringAlarmFactory() = default;
+
+QuicAlarm* QuicIoUringAlarmFactory::CreateAlarm(QuicAlarm::Delegate* delegate) {
+  return new QuicTimingWheelAlarm(
+      event_loop_, QuicArenaScopedPtr<QuicAlarm::Delegate>(delegate));
+}
+
+QuicArenaScopedPtr<QuicAlarm> QuicIoUringAlarmFactory::CreateAlarm(
+    QuicArenaScopedPtr<QuicAlarm::Delegate> delegate,
+    QuicConnectionArena* arena) {
+  if (arena != nullptr) {
+    return arena->New<QuicTimingWheelAlarm>(event_loop_, std::move(delegate));
+  }
+  return QuicArenaScopedPtr<QuicAlarm>(
+      new QuicTimingWheelAlarm(event_loop_, std::move(delegate)));
+}
+
+}  // namespace quic
@@ -0,0 +1,166 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// An event loop driven entirely by an io_uring. Socket I/O is submitted to the
+// ring by QuicIoUringPacketReader and QuicIoUringBatchWriter, and alarms are
+// kept in a QuicTimingWheel whose next expiry bounds the time the loop waits
+// for completions. Each loop turn submits everything queued since the last
+// one and waits for completions with a single io_uring_enter call.
+
+#ifndef QUICHE_QUIC_CORE_IO_URING_QUIC_IO_URING_EVENT_LOOP_H_
+#define QUICHE_QUIC_CORE_IO_URING_QUIC_IO_URING_EVENT_LOOP_H_
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "net/third_party/quiche/src/quic/core/io_uring/quic_io_uring.h"
+#include "net/third_party/quiche/src/quic/core/quic_alarm.h"
+#include "net/third_party/quiche/src/quic/core/quic_alarm_factory.h"
+#include "net/third_party/quiche/src/quic/core/quic_clock.h"
+#include "net/third_party/quiche/src/quic/core/quic_one_block_arena.h"
+#include "net/third_party/quiche/src/quic/core/quic_time.h"
+#include "net/third_party/quiche/src/quic/core/quic_timing_wheel.h"
+#include "net/third_party/quiche/src/quic/core/quic_timing_wheel_alarm.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_export.h"
+
+namespace quic {
+
+// A monotonic clock whose ApproximateNow() is refreshed once per event loop
+// turn.
+class QUIC_EXPORT_PRIVATE QuicIoUringClock : public QuicClock {
+ public:
+  QuicIoUringClock();
+  QuicIoUringClock(const QuicIoUringClock&) = delete;
+  QuicIoUringClock& operator=(const QuicIoUringClock&) = delete;
+  ~QuicIoUringClock() override;
+
+  // QuicClock interface.
+  QuicTime ApproximateNow() const override;
+  QuicTime Now() const override;
+  QuicWallTime WallNow() const override;
+
+  // Sets the value returned by ApproximateNow() to Now().
+  void Update();
+
+ private:
+  QuicTime approximate_now_;
+};
+
+// How long the io_uring packet reader and writer wait for their operations
+// to complete when they are destroyed.
+const int64_t kIoUringShutdownTimeoutMs = 1000;
+
+class QUIC_EXPORT_PRIVATE QuicIoUringEventLoop
+    : public QuicTimingWheelScheduler {
+ public:
+  // Receives the completions of operations submitted through
+  // PrepareSubmission(). A handler must stay alive until all of its
+  // operations have completed.
+  class QUIC_EXPORT_PRIVATE CompletionHandler {
+   public:
+    virtual ~CompletionHandler() {}
+
+    virtual void OnCompletion(const io_uring_cqe& cqe) = 0;
+  };
+
+  // Waits for room in the submission queue after PrepareSubmission() failed.
+  class QUIC_EXPORT_PRIVATE SubmissionQueueObserver {
+   public:
+    virtual ~SubmissionQueueObserver() {}
+
+    // Called at the end of the loop turn after the observer registered, once
+    // the turn has submitted queued entries and dispatched completions.
+    virtual void OnSubmissionQueueAvailable() = 0;
+  };
+
+  // Alarms fire up to |alarm_granularity| late.
+  explicit QuicIoUringEventLoop(QuicTime::Delta alarm_granularity);
+  QuicIoUringEventLoop(const QuicIoUringEventLoop&) = delete;
+  QuicIoUringEventLoop& operator=(const QuicIoUringEventLoop&) = delete;
+  ~QuicIoUringEventLoop() override;
+
+  // Sets up the ring with |num_entries| submission queue entries. Returns
+  // false if io_uring is not usable on this system.
+  bool Initialize(uint32_t num_entries);
+
+  // Returns a submission queue entry whose completion is delivered to
+  // |handler|. The caller fills in everything but the user data. The entry is
+  // submitted by the next RunEventLoopOnce() or Submit(). Returns nullptr if
+  // the submission queue is full and cannot be drained.
+  io_uring_sqe* PrepareSubmission(CompletionHandler* handler);
+
+  // Submits all prepared entries right away rather than at the start of the
+  // next loop turn.
+  void Submit();
+
+  // Notifies |observer| once, at the end of the next loop turn. No-op if
+  // |observer| is already waiting.
+  void NotifyWhenSubmissionQueueAvailable(SubmissionQueueObserver* observer);
+
+  // Stops |observer| from being notified. No-op if it is not waiting.
+  void CancelSubmissionQueueNotification(SubmissionQueueObserver* observer);
+
+  // Asks the kernel to cancel all operations of |handler|. Their completions,
+  // usually with -ECANCELED, are still delivered to |handler|. Returns false
+  // if the cancellation could not be queued.
+  bool CancelSubmissions(CompletionHandler* handler);
+
+  // Submits prepared entries, waits up to |max_wait| for completions, or
+  // until the next alarm is due, and dispatches completions and expired
+  // alarms. An infinite |max_wait| only returns once there is work to do.
+  void RunEventLoopOnce(QuicTime::Delta max_wait);
+
+  // Runs the loop until |done| returns true, or for at most |timeout|.
+  // Returns false if |timeout| passed first.
+  bool RunEventLoopUntil(const std::function<bool()>& done,
+                         QuicTime::Delta timeout);
+
+  // QuicTimingWheelScheduler interface. The wheel is advanced at the end of
+  // each loop turn.
+  void Schedule(QuicTimingWheel::Timer* timer, QuicTime deadline) override;
+  void Cancel(QuicTimingWheel::Timer* timer) override;
+
+  // Returns a new id for a provided buffer group of this ring.
+  uint16_t AllocateBufferGroupId() { return next_buffer_group_id_++; }
+
+  QuicIoUring* ring() { return &ring_; }
+
+  const QuicIoUringClock* clock() const { return &clock_; }
+
+  QuicTimingWheel* timing_wheel() { return &timing_wheel_; }
+
+ private:
+  QuicIoUring ring_;
+  QuicIoUringClock clock_;
+  QuicTimingWheel timing_wheel_;
+  uint16_t next_buffer_group_id_;
+  // Observers to notify at the end of the next loop turn.
+  std::vector<SubmissionQueueObserver*> submission_queue_observers_;
+  // Observers still to be notified at the end of the current loop turn.
+  std::vector<SubmissionQueueObserver*> notifying_observers_;
+};
+
+// Creates alarms which are kept in the timing wheel of a QuicIoUringEventLoop.
+class QUIC_EXPORT_PRIVATE QuicIoUringAlarmFactory : public QuicAlarmFactory {
+ public:
+  // |event_loop| must outlive the alarms.
+  explicit QuicIoUringAlarmFactory(QuicIoUringEventLoop* event_loop);
+  QuicIoUringAlarmFactory(const QuicIoUringAlarmFactory&) = delete;
+  QuicIoUringAlarmFactory& operator=(const QuicIoUringAlarmFactory&) = delete;
+  ~QuicIoUringAlarmFactory() override;
+
+  // QuicAlarmFactory interface.
+  QuicAlarm* CreateAlarm(QuicAlarm::Delegate* delegate) override;
+  QuicArenaScopedPtr<QuicAlarm> CreateAlarm(
+      QuicArenaScopedPtr<QuicAlarm::Delegate> delegate,
+      QuicConnectionArena* arena) override;
+
+ private:
+  QuicIoUringEventLoop* event_loop_;  // Not owned.
+};
+
+}  // namespace quic
+
+#endif  // QUICHE_QUIC_CORE_IO_URING_QUIC_IO_URING_EVENT_LOOP_H_
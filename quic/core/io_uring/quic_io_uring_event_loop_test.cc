@@ -0,0 +1,243 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/third_party/quiche/src/quic/core/io_uring/quic_io_uring_event_loop.h"
+
+#include <memory>
+#include <vector>
+
+#include "net/third_party/quiche/src/quic/core/quic_arena_scoped_ptr.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_logging.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_test.h"
+
+namespace quic {
+namespace test {
+namespace {
+
+const QuicTime::Delta kGranularity = QuicTime::Delta::FromMilliseconds(1);
+
+class TestDelegate : public QuicAlarm::Delegate {
+ public:
+  explicit TestDelegate(const QuicClock* clock)
+      : clock_(clock), fire_time_(QuicTime::Zero()) {}
+
+  void OnAlarm() override { fire_time_ = clock_->ApproximateNow(); }
+
+  bool fired() const { return fire_time_ != QuicTime::Zero(); }
+  QuicTime fire_time() const { return fire_time_; }
+
+ private:
+  const QuicClock* clock_;
+  QuicTime fire_time_;
+};
+
+class RecordingHandler : public QuicIoUringEventLoop::CompletionHandler {
+ public:
+  void OnCompletion(const io_uring_cqe& cqe) override {
+    completions_.push_back(cqe);
+  }
+
+  const std::vector<io_uring_cqe>& completions() const { return completions_; }
+
+ private:
+  std::vector<io_uring_cqe> completions_;
+};
+
+class CountingObserver
+    : public QuicIoUringEventLoop::SubmissionQueueObserver {
+ public:
+  void OnSubmissionQueueAvailable() override { ++num_notifications_; }
+
+  int num_notifications() const { return num_notifications_; }
+
+ private:
+  int num_notifications_ = 0;
+};
+
+// The boolean parameter denotes whether or not to use an arena.
+class QuicIoUringEventLoopTest : public QuicTestWithParam<bool> {
+ protected:
+  QuicIoUringEventLoopTest()
+      : event_loop_(kGranularity), alarm_factory_(&event_loop_) {}
+
+  void SetUp() override {
+    supported_ = event_loop_.Initialize(64);
+    if (!supported_) {
+      QUIC_LOG(WARNING) << "io_uring is not supported, skipping test.";
+    }
+  }
+
+  QuicConnectionArena* GetArenaParam() {
+    return GetParam() ? &arena_ : nullptr;
+  }
+
+  QuicArenaScopedPtr<QuicAlarm> CreateAlarm(TestDelegate** delegate) {
+    *delegate = new TestDelegate(event_loop_.clock());
+    return alarm_factory_.CreateAlarm(
+        QuicArenaScopedPtr<QuicAlarm::Delegate>(*delegate), GetArenaParam());
+  }
+
+  // Runs the event loop until |done| returns true, or a second has passed.
+  template <typename Predicate>
+  bool RunUntil(Predicate done) {
+    const QuicTime deadline =
+        event_loop_.clock()->Now() + QuicTime::Delta::FromSeconds(1);
+    while (!done()) {
+      if (event_loop_.clock()->Now() > deadline) {
+        return false;
+      }
+      event_loop_.RunEventLoopOnce(QuicTime::Delta::FromMilliseconds(10));
+    }
+    return true;
+  }
+
+  bool supported_ = false;
+  QuicIoUringEventLoop event_loop_;
+  QuicIoUringAlarmFactory alarm_factory_;
+  QuicConnectionArena arena_;
+};
+
+INSTANTIATE_TEST_SUITE_P(UseArena,
+                         QuicIoUringEventLoopTest,
+                         ::testing::ValuesIn({true, false}),
+                         ::testing::PrintToStringParamName());
+
+TEST_P(QuicIoUringEventLoopTest, CompletionIsDispatchedToHandler) {
+  if (!supported_) {
+    return;
+  }
+  RecordingHandler handler;
+  io_uring_sqe* sqe = event_loop_.PrepareSubmission(&handler);
+  ASSERT_NE(nullptr, sqe);
+  sqe->opcode = IORING_OP_NOP;
+
+  ASSERT_TRUE(RunUntil([&handler] { return !handler.completions().empty(); }));
+  ASSERT_EQ(1u, handler.completions().size());
+  EXPECT_EQ(0, handler.completions()[0].res);
+}
+
+TEST_P(QuicIoUringEventLoopTest, AlarmFires) {
+  if (!supported_) {
+    return;
+  }
+  TestDelegate* delegate;
+  QuicArenaScopedPtr<QuicAlarm> alarm = CreateAlarm(&delegate);
+
+  const QuicTime deadline =
+      event_loop_.clock()->Now() + QuicTime::Delta::FromMilliseconds(5);
+  alarm->Set(deadline);
+  // The wait is bounded by the alarm rather than by |max_wait|.
+  const QuicTime start = event_loop_.clock()->Now();
+  while (!delegate->fired() &&
+         event_loop_.clock()->Now() - start < QuicTime::Delta::FromSeconds(1)) {
+    event_loop_.RunEventLoopOnce(QuicTime::Delta::Infinite());
+  }
+  ASSERT_TRUE(delegate->fired());
+  EXPECT_LE(deadline, delegate->fire_time());
+  EXPECT_FALSE(alarm->IsSet());
+}
+
+TEST_P(QuicIoUringEventLoopTest, CancelledAlarmDoesNotFire) {
+  if (!supported_) {
+    return;
+  }
+  TestDelegate* cancelled_delegate;
+  QuicArenaScopedPtr<QuicAlarm> cancelled_alarm =
+      CreateAlarm(&cancelled_delegate);
+  TestDelegate* delegate;
+  QuicArenaScopedPtr<QuicAlarm> alarm = CreateAlarm(&delegate);
+
+  const QuicTime now = event_loop_.clock()->Now();
+  cancelled_alarm->Set(now + QuicTime::Delta::FromMilliseconds(2));
+  alarm->Set(now + QuicTime::Delta::FromMilliseconds(5));
+  cancelled_alarm->Cancel();
+
+  ASSERT_TRUE(RunUntil([delegate] { return delegate->fired(); }));
+  EXPECT_FALSE(cancelled_delegate->fired());
+}
+
+TEST_P(QuicIoUringEventLoopTest, UpdatedAlarmFiresAtNewDeadline) {
+  if (!supported_) {
+    return;
+  }
+  TestDelegate* delegate;
+  QuicArenaScopedPtr<QuicAlarm> alarm = CreateAlarm(&delegate);
+
+  const QuicTime now = event_loop_.clock()->Now();
+  alarm->Set(now + QuicTime::Delta::FromMilliseconds(1));
+  const QuicTime deadline = now + QuicTime::Delta::FromMilliseconds(10);
+  alarm->Update(deadline, QuicTime::Delta::Zero());
+
+  ASSERT_TRUE(RunUntil([delegate] { return delegate->fired(); }));
+  EXPECT_LE(deadline, delegate->fire_time());
+}
+
+TEST_P(QuicIoUringEventLoopTest, ManyAlarms) {
+  if (!supported_) {
+    return;
+  }
+  const int kNumAlarms = 100;
+  std::vector<TestDelegate*> delegates(kNumAlarms);
+  std::vector<QuicArenaScopedPtr<QuicAlarm>> alarms;
+  const QuicTime now = event_loop_.clock()->Now();
+  for (int i = 0; i < kNumAlarms; ++i) {
+    // Too many alarms for the arena.
+    delegates[i] = new TestDelegate(event_loop_.clock());
+    alarms.push_back(alarm_factory_.CreateAlarm(
+        QuicArenaScopedPtr<QuicAlarm::Delegate>(delegates[i]), nullptr));
+    alarms.back()->Set(now + QuicTime::Delta::FromMicroseconds(100 * i));
+  }
+
+  ASSERT_TRUE(RunUntil([&delegates] {
+    for (TestDelegate* delegate : delegates) {
+      if (!delegate->fired()) {
+        return false;
+      }
+    }
+    return true;
+  }));
+  for (int i = 0; i < kNumAlarms; ++i) {
+    EXPECT_LE(now + QuicTime::Delta::FromMicroseconds(100 * i),
+              delegates[i]->fire_time());
+  }
+}
+
+TEST_P(QuicIoUringEventLoopTest, RunEventLoopOnceWaitsAtMostMaxWait) {
+  if (!supported_) {
+    return;
+  }
+  const QuicTime start = event_loop_.clock()->Now();
+  event_loop_.RunEventLoopOnce(QuicTime::Delta::FromMilliseconds(5));
+  const QuicTime::Delta elapsed = event_loop_.clock()->ApproximateNow() - start;
+  EXPECT_LE(QuicTime::Delta::FromMilliseconds(5), elapsed);
+  EXPECT_GT(QuicTime::Delta::FromSeconds(1), elapsed);
+}
+
+TEST_P(QuicIoUringEventLoopTest, SubmissionQueueObserverIsNotifiedOnce) {
+  if (!supported_) {
+    return;
+  }
+  CountingObserver observer;
+  event_loop_.NotifyWhenSubmissionQueueAvailable(&observer);
+  event_loop_.NotifyWhenSubmissionQueueAvailable(&observer);
+  event_loop_.RunEventLoopOnce(QuicTime::Delta::Zero());
+  EXPECT_EQ(1, observer.num_notifications());
+  event_loop_.RunEventLoopOnce(QuicTime::Delta::Zero());
+  EXPECT_EQ(1, observer.num_notifications());
+}
+
+TEST_P(QuicIoUringEventLoopTest, CancelledSubmissionQueueObserver) {
+  if (!supported_) {
+    return;
+  }
+  CountingObserver observer;
+  event_loop_.NotifyWhenSubmissionQueueAvailable(&observer);
+  event_loop_.CancelSubmissionQueueNotification(&observer);
+  event_loop_.RunEventLoopOnce(QuicTime::Delta::Zero());
+  EXPECT_EQ(0, observer.num_notifications());
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace quic
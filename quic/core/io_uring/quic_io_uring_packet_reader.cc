@@ -0,0 +1,195 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/third_party/quiche/src/quic/core/io_uring/quic_io_uring_packet_reader.h"
+
+#include <errno.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include "net/third_party/quiche/src/quic/core/quic_packet_reader.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_bug_tracker.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_flag_utils.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_logging.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_socket_address.h"
+
+namespace quic {
+
+QuicIoUringPacketReader::QuicIoUringPacketReader(
+    QuicIoUringEventLoop* event_loop,
+    ProcessPacketInterface* processor)
+    : event_loop_(event_loop),
+      processor_(processor),
+      fd_(-1),
+      port_(0),
+      receiving_(false),
+      stopping_(false),
+      num_buffer_exhaustions_(0) {
+  memset(&msg_, 0, sizeof(msg_));
+  msg_.msg_namelen = sizeof(sockaddr_storage);
+  msg_.msg_controllen = kDefaultUdpPacketControlBufferSize;
+}
+
+QuicIoUringPacketReader::~QuicIoUringPacketReader() {
+  // Stop() is retried each turn in case the cancellation could not be queued.
+  const bool stopped = event_loop_->RunEventLoopUntil(
+      [this] {
+        Stop();
+        return !receiving_;
+      },
+      QuicTime::Delta::FromMilliseconds(kIoUringShutdownTimeoutMs));
+  QUIC_BUG_IF(!stopped) << "Receive on fd " << fd_
+                        << " still pending after "
+                        << kIoUringShutdownTimeoutMs << "ms.";
+}
+
+bool QuicIoUringPacketReader::Start(int fd, int port) {
+  DCHECK(!receiving_);
+  if (buffer_ring_.num_buffers() == 0 &&
+      !buffer_ring_.Initialize(
+          event_loop_->ring(), event_loop_->AllocateBufferGroupId(),
+          kNumIoUringReceiveBuffers,
+          sizeof(io_uring_recvmsg_out) + msg_.msg_namelen +
+              msg_.msg_controllen + kMaxIncomingPacketSize)) {
+    return false;
+  }
+  fd_ = fd;
+  port_ = port;
+  stopping_ = false;
+  return Arm();
+}
+
+void QuicIoUringPacketReader::Stop() {
+  if (!receiving_ || stopping_) {
+    return;
+  }
+  stopping_ = event_loop_->CancelSubmissions(this);
+}
+
+bool QuicIoUringPacketReader::Arm() {
+  io_uring_sqe* sqe = event_loop_->PrepareSubmission(this);
+  if (sqe == nullptr) {
+    QUIC_LOG(ERROR) << "Failed to submit receive on fd " << fd_;
+    return false;
+  }
+  sqe->opcode = IORING_OP_RECVMSG;
+  sqe->fd = fd_;
+  sqe->addr = reinterpret_cast<uint64_t>(&msg_);
+  sqe->len = 1;
+  sqe->ioprio = IORING_RECV_MULTISHOT;
+  sqe->flags = IOSQE_BUFFER_SELECT;
+  sqe->buf_group = buffer_ring_.group_id();
+  receiving_ = true;
+  return true;
+}
+
+void QuicIoUringPacketReader::OnCompletion(const io_uring_cqe& cqe) {
+  if (cqe.flags & IORING_CQE_F_BUFFER) {
+    const uint16_t buffer_id =
+        static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+    if (cqe.res > 0) {
+      DispatchPacket(buffer_id, static_cast<size_t>(cqe.res));
+    }
+    buffer_ring_.Recycle(buffer_id);
+    buffer_ring_.Publish();
+  }
+
+  if (cqe.flags & IORING_CQE_F_MORE) {
+    return;
+  }
+
+  // The multishot receive has terminated.
+  receiving_ = false;
+  if (stopping_) {
+    stopping_ = false;
+    return;
+  }
+  if (cqe.res >= 0 || cqe.res == -ENOBUFS || cqe.res == -EINTR) {
+    if (cqe.res == -ENOBUFS) {
+      ++num_buffer_exhaustions_;
+    }
+    Arm();
+    return;
+  }
+  QUIC_LOG_FIRST_N(ERROR, 100)
+      << "Stopped receiving on fd " << fd_ << ": " << strerror(-cqe.res);
+}
+
+void QuicIoUringPacketReader::DispatchPacket(uint16_t buffer_id,
+                                             size_t length) {
+  char* buffer = buffer_ring_.GetBuffer(buffer_id);
+  if (length < sizeof(io_uring_recvmsg_out) + msg_.msg_namelen +
+                   msg_.msg_controllen) {
+    QUIC_BUG << "Receive buffer too short: " << length;
+    return;
+  }
+  const io_uring_recvmsg_out* out =
+      reinterpret_cast<const io_uring_recvmsg_out*>(buffer);
+  char* name = buffer + sizeof(io_uring_recvmsg_out);
+  char* control = name + msg_.msg_namelen;
+  char* payload = control + msg_.msg_controllen;
+
+  if (QUIC_PREDICT_FALSE(out->flags & MSG_CTRUNC)) {
+    QUIC_BUG << "Control buffer too small. size:" << msg_.msg_controllen
+             << ", need:" << out->controllen;
+    return;
+  }
+  if (QUIC_PREDICT_FALSE(out->flags & MSG_TRUNC)) {
+    QUIC_LOG_FIRST_N(WARNING, 100)
+        << "Received truncated QUIC packet: buffer size:"
+        << kMaxIncomingPacketSize << " packet size:" << out->payloadlen;
+    return;
+  }
+  if (out->namelen == 0 || out->namelen > msg_.msg_namelen) {
+    QUIC_BUG << "Unable to get peer socket address.";
+    return;
+  }
+
+  QuicUdpPacketInfo packet_info;
+  msghdr hdr;
+  memset(&hdr, 0, sizeof(hdr));
+  hdr.msg_control = control;
+  hdr.msg_controllen = out->controllen;
+  socket_api_.ReadControlMessages(
+      &hdr,
+      BitMask64(QuicUdpPacketInfoBit::V4_SELF_IP,
+                QuicUdpPacketInfoBit::V6_SELF_IP, QuicUdpPacketInfoBit::TTL,
+                QuicUdpPacketInfoBit::GOOGLE_PACKET_HEADER),
+      &packet_info);
+
+  QuicSocketAddress peer_address =
+      QuicSocketAddress(reinterpret_cast<const sockaddr*>(name), out->namelen)
+          .Normalized();
+  QuicIpAddress self_ip = QuicPacketReader::GetSelfIpFromPacketInfo(
+      packet_info, peer_address.host().IsIPv6());
+  if (!self_ip.IsInitialized()) {
+    QUIC_BUG << "Unable to get self IP address.";
+    return;
+  }
+
+  bool has_ttl = packet_info.HasValue(QuicUdpPacketInfoBit::TTL);
+  int ttl = has_ttl ? packet_info.ttl() : 0;
+  if (!has_ttl) {
+    QUIC_CODE_COUNT(quic_io_uring_packet_reader_no_ttl);
+  }
+
+  char* headers = nullptr;
+  size_t headers_length = 0;
+  if (packet_info.HasValue(QuicUdpPacketInfoBit::GOOGLE_PACKET_HEADER)) {
+    headers = packet_info.google_packet_headers().buffer;
+    headers_length = packet_info.google_packet_headers().buffer_len;
+  }
+
+  const size_t payload_length =
+      std::min<size_t>(out->payloadlen, length - (payload - buffer));
+  QuicReceivedPacket packet(payload, payload_length,
+                            event_loop_->clock()->ApproximateNow(),
+                            /*owns_buffer=*/false, ttl, has_ttl, headers,
+                            headers_length, /*owns_header_buffer=*/false);
+  processor_->ProcessPacket(QuicSocketAddress(self_ip, port_), peer_address,
+                            packet);
+}
+
+}  // namespace quic
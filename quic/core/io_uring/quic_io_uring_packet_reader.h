@@ -0,0 +1,86 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Reads incoming QUIC packets from a UDP socket with a single multishot
+// recvmsg operation, which keeps receiving into a provided buffer ring until
+// it is stopped, so that no system call is made per packet or per batch.
+
+#ifndef QUICHE_QUIC_CORE_IO_URING_QUIC_IO_URING_PACKET_READER_H_
+#define QUICHE_QUIC_CORE_IO_URING_QUIC_IO_URING_PACKET_READER_H_
+
+#include <sys/socket.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "net/third_party/quiche/src/quic/core/io_uring/quic_io_uring.h"
+#include "net/third_party/quiche/src/quic/core/io_uring/quic_io_uring_event_loop.h"
+#include "net/third_party/quiche/src/quic/core/quic_packets.h"
+#include "net/third_party/quiche/src/quic/core/quic_process_packet_interface.h"
+#include "net/third_party/quiche/src/quic/core/quic_udp_socket.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_export.h"
+
+namespace quic {
+
+// Number of receive buffers handed to the kernel by each reader.
+const uint16_t kNumIoUringReceiveBuffers = 256;
+
+class QUIC_EXPORT_PRIVATE QuicIoUringPacketReader
+    : public QuicIoUringEventLoop::CompletionHandler {
+ public:
+  // Packets are passed to |processor| from within
+  // |event_loop|->RunEventLoopOnce(). |event_loop| must outlive the reader.
+  QuicIoUringPacketReader(QuicIoUringEventLoop* event_loop,
+                          ProcessPacketInterface* processor);
+  QuicIoUringPacketReader(const QuicIoUringPacketReader&) = delete;
+  QuicIoUringPacketReader& operator=(const QuicIoUringPacketReader&) = delete;
+  // Stops receiving, running |event_loop| until the kernel lets go of the
+  // receive buffers, for at most kIoUringShutdownTimeoutMs.
+  ~QuicIoUringPacketReader() override;
+
+  // Starts receiving packets on |fd|, which is bound to |port| and set up by
+  // QuicUdpSocketApi::Create(). UDP GRO must not be enabled on |fd|. Returns
+  // false if the kernel does not support provided buffer rings.
+  bool Start(int fd, int port);
+
+  // Stops receiving. Packets may still be dispatched until the kernel has
+  // acknowledged the cancellation, after which receiving() is false. If the
+  // cancellation cannot be queued, Stop() may be called again later.
+  void Stop();
+
+  // True while a receive operation is outstanding.
+  bool receiving() const { return receiving_; }
+
+  // Number of times the kernel ran out of receive buffers, which means
+  // packets may have queued up in, or been dropped by, the socket.
+  uint64_t num_buffer_exhaustions() const { return num_buffer_exhaustions_; }
+
+  // QuicIoUringEventLoop::CompletionHandler interface.
+  void OnCompletion(const io_uring_cqe& cqe) override;
+
+ private:
+  // Submits the multishot receive.
+  bool Arm();
+
+  // Parses and dispatches the packet in the receive buffer |buffer_id|.
+  void DispatchPacket(uint16_t buffer_id, size_t length);
+
+  QuicIoUringEventLoop* event_loop_;   // Not owned.
+  ProcessPacketInterface* processor_;  // Not owned.
+  QuicUdpSocketApi socket_api_;
+  QuicIoUringBufferRing buffer_ring_;
+  // Describes the layout of each receive buffer to the kernel: after an
+  // io_uring_recvmsg_out header come |msg_namelen| bytes of peer address,
+  // |msg_controllen| bytes of control messages and then the payload.
+  msghdr msg_;
+  int fd_;
+  int port_;
+  bool receiving_;
+  bool stopping_;
+  uint64_t num_buffer_exhaustions_;
+};
+
+}  // namespace quic
+
+#endif  // QUICHE_QUIC_CORE_IO_URING_QUIC_IO_URING_PACKET_READER_H_
@@ -0,0 +1,267 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/third_party/quiche/src/quic/core/io_uring/quic_io_uring_packet_reader.h"
+
+#include <sys/socket.h>
+
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "net/third_party/quiche/src/quic/core/io_uring/quic_io_uring_batch_writer.h"
+#include "net/third_party/quiche/src/quic/core/io_uring/quic_io_uring_event_loop.h"
+#include "net/third_party/quiche/src/quic/core/quic_constants.h"
+#include "net/third_party/quiche/src/quic/core/quic_udp_socket.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_logging.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_socket_address.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_test.h"
+
+namespace quic {
+namespace test {
+namespace {
+
+struct ReceivedPacket {
+  QuicSocketAddress self_address;
+  QuicSocketAddress peer_address;
+  std::string payload;
+};
+
+class RecordingProcessor : public ProcessPacketInterface {
+ public:
+  void ProcessPacket(const QuicSocketAddress& self_address,
+                     const QuicSocketAddress& peer_address,
+                     const QuicReceivedPacket& packet) override {
+    packets_.push_back(
+        {self_address, peer_address,
+         std::string(packet.data(), packet.length())});
+  }
+
+  const std::vector<ReceivedPacket>& packets() const { return packets_; }
+
+ private:
+  std::vector<ReceivedPacket> packets_;
+};
+
+class CountingBlockedWriter : public QuicBlockedWriterInterface {
+ public:
+  void OnBlockedWriterCanWrite() override { ++num_can_write_; }
+  bool IsWriterBlocked() const override { return false; }
+
+  int num_can_write() const { return num_can_write_; }
+
+ private:
+  int num_can_write_ = 0;
+};
+
+class QuicIoUringPacketReaderTest : public QuicTest {
+ protected:
+  QuicIoUringPacketReaderTest()
+      : event_loop_(kAlarmGranularity),
+        server_fd_(kQuicInvalidSocketFd),
+        client_fd_(kQuicInvalidSocketFd) {}
+
+  ~QuicIoUringPacketReaderTest() override {
+    // The reader and writer wait for their operations in their destructors,
+    // and need the sockets to still be open.
+    reader_.reset();
+    writer_.reset();
+    api_.Destroy(client_fd_);
+    api_.Destroy(server_fd_);
+  }
+
+  void SetUp() override {
+    supported_ = event_loop_.Initialize(64);
+    if (!supported_) {
+      QUIC_LOG(WARNING) << "io_uring is not supported, skipping test.";
+      return;
+    }
+    server_fd_ = api_.Create(AF_INET, kDefaultSocketReceiveBuffer,
+                             kDefaultSocketReceiveBuffer);
+    ASSERT_NE(kQuicInvalidSocketFd, server_fd_);
+    ASSERT_TRUE(api_.Bind(server_fd_,
+                          QuicSocketAddress(QuicIpAddress::Loopback4(), 0)));
+    ASSERT_EQ(0, server_address_.FromSocket(server_fd_));
+
+    client_fd_ = api_.Create(AF_INET, kDefaultSocketReceiveBuffer,
+                             kDefaultSocketReceiveBuffer);
+    ASSERT_NE(kQuicInvalidSocketFd, client_fd_);
+    ASSERT_TRUE(api_.Bind(client_fd_,
+                          QuicSocketAddress(QuicIpAddress::Loopback4(), 0)));
+    ASSERT_EQ(0, client_address_.FromSocket(client_fd_));
+
+    reader_ =
+        std::make_unique<QuicIoUringPacketReader>(&event_loop_, &processor_);
+    if (!reader_->Start(server_fd_, server_address_.port())) {
+      QUIC_LOG(WARNING) << "Multishot receive is not supported, skipping test.";
+      supported_ = false;
+    }
+  }
+
+  void SendFromClient(const std::string& payload) {
+    QuicUdpPacketInfo packet_info;
+    packet_info.SetPeerAddress(server_address_);
+    ASSERT_EQ(WRITE_STATUS_OK,
+              api_.WritePacket(client_fd_, payload.data(), payload.size(),
+                               packet_info)
+                  .status);
+  }
+
+  // Runs the event loop until |num_packets| have been received, or a second
+  // has passed.
+  void RunUntilReceived(size_t num_packets) {
+    const QuicTime deadline =
+        event_loop_.clock()->Now() + QuicTime::Delta::FromSeconds(1);
+    while (processor_.packets().size() < num_packets &&
+           event_loop_.clock()->Now() < deadline) {
+      event_loop_.RunEventLoopOnce(QuicTime::Delta::FromMilliseconds(10));
+    }
+  }
+
+  bool supported_ = false;
+  QuicIoUringEventLoop event_loop_;
+  QuicUdpSocketApi api_;
+  QuicUdpSocketFd server_fd_;
+  QuicUdpSocketFd client_fd_;
+  QuicSocketAddress server_address_;
+  QuicSocketAddress client_address_;
+  RecordingProcessor processor_;
+  std::unique_ptr<QuicIoUringPacketReader> reader_;
+  std::unique_ptr<QuicIoUringBatchWriter> writer_;
+};
+
+TEST_F(QuicIoUringPacketReaderTest, ReceivesPackets) {
+  if (!supported_) {
+    return;
+  }
+  // More packets than receive buffers.
+  const size_t kNumPackets = 2 * kNumIoUringReceiveBuffers;
+  for (size_t i = 0; i < kNumPackets; ++i) {
+    SendFromClient("packet " + std::to_string(i));
+  }
+  RunUntilReceived(kNumPackets);
+
+  ASSERT_EQ(kNumPackets, processor_.packets().size());
+  for (size_t i = 0; i < kNumPackets; ++i) {
+    const ReceivedPacket& packet = processor_.packets()[i];
+    EXPECT_EQ("packet " + std::to_string(i), packet.payload);
+    EXPECT_EQ(server_address_, packet.self_address);
+    EXPECT_EQ(client_address_, packet.peer_address);
+  }
+  EXPECT_TRUE(reader_->receiving());
+}
+
+TEST_F(QuicIoUringPacketReaderTest, Stop) {
+  if (!supported_) {
+    return;
+  }
+  SendFromClient("before");
+  RunUntilReceived(1);
+  ASSERT_EQ(1u, processor_.packets().size());
+
+  reader_->Stop();
+  for (int i = 0; i < 100 && reader_->receiving(); ++i) {
+    event_loop_.RunEventLoopOnce(QuicTime::Delta::FromMilliseconds(10));
+  }
+  EXPECT_FALSE(reader_->receiving());
+
+  SendFromClient("after");
+  event_loop_.RunEventLoopOnce(QuicTime::Delta::FromMilliseconds(10));
+  EXPECT_EQ(1u, processor_.packets().size());
+
+  // Restarting picks up the packet queued in the socket.
+  ASSERT_TRUE(reader_->Start(server_fd_, server_address_.port()));
+  RunUntilReceived(2);
+  ASSERT_EQ(2u, processor_.packets().size());
+  EXPECT_EQ("after", processor_.packets()[1].payload);
+}
+
+TEST_F(QuicIoUringPacketReaderTest, WriterSendsPackets) {
+  if (!supported_) {
+    return;
+  }
+  writer_ = std::make_unique<QuicIoUringBatchWriter>(
+      &event_loop_, client_fd_, kDefaultIoUringMaxSendsInFlight);
+  EXPECT_TRUE(writer_->IsBatchMode());
+
+  const size_t kNumPackets = 100;
+  size_t bytes_written = 0;
+  for (size_t i = 0; i < kNumPackets; ++i) {
+    const std::string payload = "packet " + std::to_string(i);
+    QuicPacketBuffer buffer = writer_->GetNextWriteLocation(
+        client_address_.host(), server_address_);
+    const char* data = payload.data();
+    // Alternate between copying and writing in place.
+    if (i % 2 == 0) {
+      ASSERT_NE(nullptr, buffer.buffer);
+      memcpy(buffer.buffer, payload.data(), payload.size());
+      data = buffer.buffer;
+    }
+    WriteResult result =
+        writer_->WritePacket(data, payload.size(), client_address_.host(),
+                             server_address_, nullptr);
+    ASSERT_EQ(WRITE_STATUS_OK, result.status);
+    bytes_written += payload.size();
+  }
+  WriteResult result = writer_->Flush();
+  EXPECT_EQ(WRITE_STATUS_OK, result.status);
+  EXPECT_EQ(bytes_written, static_cast<size_t>(result.bytes_written));
+  EXPECT_EQ(kNumPackets, writer_->num_sends_in_flight());
+
+  RunUntilReceived(kNumPackets);
+  ASSERT_EQ(kNumPackets, processor_.packets().size());
+  for (size_t i = 0; i < kNumPackets; ++i) {
+    const ReceivedPacket& packet = processor_.packets()[i];
+    EXPECT_EQ("packet " + std::to_string(i), packet.payload);
+    EXPECT_EQ(client_address_, packet.peer_address);
+  }
+  EXPECT_EQ(0u, writer_->num_sends_in_flight());
+  EXPECT_EQ(0u, writer_->num_send_errors());
+}
+
+TEST_F(QuicIoUringPacketReaderTest, WriterBlocksWhenAllSlotsAreBusy) {
+  if (!supported_) {
+    return;
+  }
+  writer_ = std::make_unique<QuicIoUringBatchWriter>(&event_loop_, client_fd_,
+                                                     /*max_sends_in_flight=*/2);
+  CountingBlockedWriter blocked_writer;
+  writer_->set_blocked_writer(&blocked_writer);
+
+  const std::string payload = "payload";
+  for (int i = 0; i < 2; ++i) {
+    EXPECT_EQ(WRITE_STATUS_OK,
+              writer_
+                  ->WritePacket(payload.data(), payload.size(),
+                                client_address_.host(), server_address_,
+                                nullptr)
+                  .status);
+  }
+  EXPECT_FALSE(writer_->IsWriteBlocked());
+  EXPECT_EQ(nullptr, writer_
+                         ->GetNextWriteLocation(client_address_.host(),
+                                                server_address_)
+                         .buffer);
+  EXPECT_EQ(WRITE_STATUS_BLOCKED,
+            writer_
+                ->WritePacket(payload.data(), payload.size(),
+                              client_address_.host(), server_address_, nullptr)
+                .status);
+  EXPECT_TRUE(writer_->IsWriteBlocked());
+
+  RunUntilReceived(2);
+  EXPECT_EQ(2u, processor_.packets().size());
+  EXPECT_FALSE(writer_->IsWriteBlocked());
+  EXPECT_EQ(1, blocked_writer.num_can_write());
+  EXPECT_EQ(WRITE_STATUS_OK,
+            writer_
+                ->WritePacket(payload.data(), payload.size(),
+                              client_address_.host(), server_address_, nullptr)
+                .status);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace quic
@@ -0,0 +1,204 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/third_party/quiche/src/quic/core/io_uring/quic_io_uring.h"
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <time.h>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "net/third_party/quiche/src/quic/core/quic_constants.h"
+#include "net/third_party/quiche/src/quic/core/quic_udp_socket.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_logging.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_socket_address.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_test.h"
+
+namespace quic {
+namespace test {
+namespace {
+
+const QuicTime::Delta kTimeout = QuicTime::Delta::FromSeconds(5);
+
+class QuicIoUringTest : public QuicTest {
+ protected:
+  // Returns false, and the test should be skipped, if io_uring is not
+  // supported.
+  bool InitializeRing(uint32_t num_entries) {
+    if (!ring_.Initialize(num_entries, /*completion_queue_multiplier=*/4)) {
+      QUIC_LOG(WARNING) << "io_uring is not supported, skipping test.";
+      return false;
+    }
+    return true;
+  }
+
+  std::vector<io_uring_cqe> WaitForCompletions(size_t num_completions) {
+    std::vector<io_uring_cqe> completions;
+    while (completions.size() < num_completions) {
+      EXPECT_LE(0, ring_.SubmitAndWait(1, kTimeout));
+      const size_t num_visited = ring_.ForEachCompletion(
+          [&completions](const io_uring_cqe& cqe) {
+            completions.push_back(cqe);
+          });
+      if (num_visited == 0) {
+        ADD_FAILURE() << "Timed out waiting for completions.";
+        break;
+      }
+    }
+    return completions;
+  }
+
+  QuicIoUring ring_;
+};
+
+TEST_F(QuicIoUringTest, Nop) {
+  if (!InitializeRing(8)) {
+    return;
+  }
+  io_uring_sqe* sqe = ring_.GetSqe();
+  ASSERT_NE(nullptr, sqe);
+  sqe->opcode = IORING_OP_NOP;
+  sqe->user_data = 42;
+  EXPECT_EQ(1u, ring_.pending_submissions());
+
+  std::vector<io_uring_cqe> completions = WaitForCompletions(1);
+  ASSERT_EQ(1u, completions.size());
+  EXPECT_EQ(42u, completions[0].user_data);
+  EXPECT_EQ(0, completions[0].res);
+  EXPECT_EQ(0u, ring_.pending_submissions());
+}
+
+TEST_F(QuicIoUringTest, SubmissionQueueFull) {
+  if (!InitializeRing(4)) {
+    return;
+  }
+  for (int i = 0; i < 4; ++i) {
+    io_uring_sqe* sqe = ring_.GetSqe();
+    ASSERT_NE(nullptr, sqe);
+    sqe->opcode = IORING_OP_NOP;
+    sqe->user_data = i;
+  }
+  EXPECT_EQ(nullptr, ring_.GetSqe());
+
+  EXPECT_EQ(4, ring_.Submit());
+  io_uring_sqe* sqe = ring_.GetSqe();
+  ASSERT_NE(nullptr, sqe);
+  sqe->opcode = IORING_OP_NOP;
+  sqe->user_data = 4;
+
+  std::vector<io_uring_cqe> completions = WaitForCompletions(5);
+  ASSERT_EQ(5u, completions.size());
+  for (size_t i = 0; i < completions.size(); ++i) {
+    EXPECT_EQ(i, completions[i].user_data);
+  }
+}
+
+TEST_F(QuicIoUringTest, WaitTimesOut) {
+  if (!InitializeRing(4)) {
+    return;
+  }
+  const QuicTime::Delta timeout = QuicTime::Delta::FromMilliseconds(20);
+  timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  EXPECT_EQ(0, ring_.SubmitAndWait(1, timeout));
+  timespec end;
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  const int64_t elapsed_us = (end.tv_sec - start.tv_sec) * 1000000 +
+                             (end.tv_nsec - start.tv_nsec) / 1000;
+  EXPECT_LE(timeout.ToMicroseconds(), elapsed_us);
+  EXPECT_EQ(0u, ring_.ForEachCompletion([](const io_uring_cqe&) {}));
+}
+
+TEST_F(QuicIoUringTest, MultishotReceiveIntoBufferRing) {
+  if (!InitializeRing(8)) {
+    return;
+  }
+  QuicIoUringBufferRing buffer_ring;
+  if (!buffer_ring.Initialize(&ring_, /*group_id=*/7, /*num_buffers=*/4,
+                              /*buffer_size=*/2048)) {
+    QUIC_LOG(WARNING) << "Buffer rings are not supported, skipping test.";
+    return;
+  }
+
+  QuicUdpSocketApi api;
+  QuicUdpSocketFd server_fd = api.Create(AF_INET, kDefaultSocketReceiveBuffer,
+                                         kDefaultSocketReceiveBuffer);
+  ASSERT_NE(kQuicInvalidSocketFd, server_fd);
+  QuicUdpSocketFd client_fd = api.Create(AF_INET, kDefaultSocketReceiveBuffer,
+                                         kDefaultSocketReceiveBuffer);
+  ASSERT_NE(kQuicInvalidSocketFd, client_fd);
+  ASSERT_TRUE(api.Bind(server_fd, QuicSocketAddress(QuicIpAddress::Loopback4(),
+                                                    /*port=*/0)));
+  QuicSocketAddress server_address;
+  ASSERT_EQ(0, server_address.FromSocket(server_fd));
+
+  msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_namelen = sizeof(sockaddr_storage);
+  io_uring_sqe* sqe = ring_.GetSqe();
+  ASSERT_NE(nullptr, sqe);
+  sqe->opcode = IORING_OP_RECVMSG;
+  sqe->fd = server_fd;
+  sqe->addr = reinterpret_cast<uint64_t>(&msg);
+  sqe->len = 1;
+  sqe->ioprio = IORING_RECV_MULTISHOT;
+  sqe->flags = IOSQE_BUFFER_SELECT;
+  sqe->buf_group = 7;
+  sqe->user_data = 1;
+  ASSERT_EQ(1, ring_.Submit());
+
+  // More packets than buffers, recycling them as they come in.
+  const int kNumPackets = 10;
+  const sockaddr_storage raw_server_address = server_address.generic_address();
+  for (int i = 0; i < kNumPackets; ++i) {
+    const std::string payload = "packet " + std::to_string(i);
+    ASSERT_EQ(static_cast<ssize_t>(payload.size()),
+              sendto(client_fd, payload.data(), payload.size(), 0,
+                     reinterpret_cast<const sockaddr*>(&raw_server_address),
+                     sizeof(sockaddr_in)));
+    std::vector<io_uring_cqe> completions = WaitForCompletions(1);
+    ASSERT_EQ(1u, completions.size());
+    const io_uring_cqe& cqe = completions[0];
+    ASSERT_LT(0, cqe.res) << strerror(-cqe.res);
+    EXPECT_TRUE(cqe.flags & IORING_CQE_F_MORE);
+    ASSERT_TRUE(cqe.flags & IORING_CQE_F_BUFFER);
+    const uint16_t buffer_id = cqe.flags >> IORING_CQE_BUFFER_SHIFT;
+    const char* buffer = buffer_ring.GetBuffer(buffer_id);
+    const io_uring_recvmsg_out* out =
+        reinterpret_cast<const io_uring_recvmsg_out*>(buffer);
+    EXPECT_EQ(payload.size(), out->payloadlen);
+    const char* received = buffer + sizeof(*out) + msg.msg_namelen;
+    EXPECT_EQ(payload, std::string(received, out->payloadlen));
+    buffer_ring.Recycle(buffer_id);
+    buffer_ring.Publish();
+  }
+
+  // Cancel the receive before the buffer ring goes away.
+  sqe = ring_.GetSqe();
+  ASSERT_NE(nullptr, sqe);
+  sqe->opcode = IORING_OP_ASYNC_CANCEL;
+  sqe->addr = 1;
+  sqe->user_data = 2;
+  std::vector<io_uring_cqe> completions = WaitForCompletions(2);
+  ASSERT_EQ(2u, completions.size());
+  for (const io_uring_cqe& cqe : completions) {
+    if (cqe.user_data == 1) {
+      EXPECT_EQ(-ECANCELED, cqe.res);
+      EXPECT_FALSE(cqe.flags & IORING_CQE_F_MORE);
+    } else {
+      EXPECT_EQ(2u, cqe.user_data);
+      EXPECT_EQ(0, cqe.res);
+    }
+  }
+
+  api.Destroy(client_fd);
+  api.Destroy(server_fd);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace quic
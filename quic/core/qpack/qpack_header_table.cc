@@ -11,9 +11,10 @@
 namespace quic {
 
 QpackHeaderTable::QpackHeaderTable()
-    : static_entries_(ObtainQpackStaticTable().GetStaticEntries()),
-      static_index_(ObtainQpackStaticTable().GetStaticIndex()),
-      static_name_index_(ObtainQpackStaticTable().GetStaticNameIndex()),
+    : static_table_(ObtainQpackStaticTable()),
+      static_entries_(static_table_.GetStaticEntries()),
+      static_index_(static_table_.GetStaticIndex()),
+      static_name_index_(static_table_.GetStaticNameIndex()),
       dynamic_table_size_(0),
       dynamic_table_capacity_(0),
       maximum_dynamic_table_capacity_(0),
@@ -55,19 +56,19 @@ QpackHeaderTable::MatchType QpackHeaderTable::FindHeaderField(
     quiche::QuicheStringPiece value,
     bool* is_static,
     uint64_t* index) const {
-  QpackEntry query(name, value);
-
   // Look for exact match in static table.
-  auto index_it = static_index_.find(&query);
-  if (index_it != static_index_.end()) {
-    DCHECK((*index_it)->IsStatic());
-    *index = (*index_it)->InsertionIndex();
+  const QpackEntry* static_entry =
+      static_table_.GetByNameAndValue(name, value);
+  if (static_entry != nullptr) {
+    DCHECK(static_entry->IsStatic());
+    *index = static_entry->InsertionIndex();
     *is_static = true;
     return MatchType::kNameAndValue;
   }
 
   // Look for exact match in dynamic table.
-  index_it = dynamic_index_.find(&query);
+  QpackEntry query(name, value);
+  auto index_it = dynamic_index_.find(&query);
   if (index_it != dynamic_index_.end()) {
     DCHECK(!(*index_it)->IsStatic());
     *index = (*index_it)->InsertionIndex();
@@ -76,16 +77,16 @@ QpackHeaderTable::MatchType QpackHeaderTable::FindHeaderField(
   }
 
   // Look for name match in static table.
-  auto name_index_it = static_name_index_.find(name);
-  if (name_index_it != static_name_index_.end()) {
-    DCHECK(name_index_it->second->IsStatic());
-    *index = name_index_it->second->InsertionIndex();
+  static_entry = static_table_.GetByName(name);
+  if (static_entry != nullptr) {
+    DCHECK(static_entry->IsStatic());
+    *index = static_entry->InsertionIndex();
     *is_static = true;
     return MatchType::kName;
   }
 
   // Look for name match in dynamic table.
-  name_index_it = dynamic_name_index_.find(name);
+  auto name_index_it = dynamic_name_index_.find(name);
   if (name_index_it != dynamic_name_index_.end()) {
     DCHECK(!name_index_it->second->IsStatic());
     *index = name_index_it->second->InsertionIndex();
@@ -155,8 +155,11 @@ class QUIC_EXPORT_PRIVATE QpackHeaderTable {
 
   // Static Table
 
-  // |static_entries_|, |static_index_|, |static_name_index_| are owned by
-  // QpackStaticTable singleton.
+  // |static_table_|, |static_entries_|, |static_index_|, |static_name_index_|
+  // are owned by QpackStaticTable singleton.
+
+  // Looks up static entries by name, or by name and value.
+  const spdy::HpackStaticTable& static_table_;
 
   // Tracks QpackEntries by index.
   const EntryTable& static_entries_;
@@ -39,6 +39,23 @@ TEST(QpackStaticTableTest, Initialize) {
   EXPECT_EQ(names.size(), static_name_index.size());
 }
 
+TEST(QpackStaticTableTest, Lookup) {
+  const QpackStaticTable& table = ObtainQpackStaticTable();
+
+  for (const auto& entry : table.GetStaticEntries()) {
+    EXPECT_EQ(&entry, table.GetByNameAndValue(entry.name(), entry.value()));
+    const auto* by_name = table.GetByName(entry.name());
+    ASSERT_NE(nullptr, by_name);
+    EXPECT_EQ(entry.name(), by_name->name());
+    EXPECT_LE(by_name->InsertionIndex(), entry.InsertionIndex());
+  }
+
+  EXPECT_EQ(24u, table.GetByName(":status")->InsertionIndex());
+  EXPECT_EQ(nullptr, table.GetByName(":foo"));
+  EXPECT_EQ(nullptr, table.GetByNameAndValue(":status", "201"));
+  EXPECT_EQ(nullptr, table.GetByNameAndValue("content-type", "text/xml"));
+}
+
 // Test that ObtainQpackStaticTable returns the same instance every time.
 TEST(QpackStaticTableTest, IsSingleton) {
   const QpackStaticTable* static_table_one = &ObtainQpackStaticTable();
@@ -2070,6 +2070,7 @@ void QuicConnection::ProcessUdpPacket(const QuicSocketAddress& self_address,
   }
   last_size_ = packet.length();
   current_packet_data_ = packet.data();
+  current_receive_buffer_ = packet.receive_buffer();
 
   last_packet_destination_address_ = self_address;
   last_packet_source_address_ = peer_address;
@@ -2119,6 +2120,7 @@ void QuicConnection::ProcessUdpPacket(const QuicSocketAddress& self_address,
                   << "Unable to process packet.  Last packet processed: "
                   << last_header_.packet_number;
     current_packet_data_ = nullptr;
+    current_receive_buffer_.reset();
     is_current_packet_connectivity_probing_ = false;
 
     MaybeProcessCoalescedPackets();
@@ -2147,6 +2149,7 @@ void QuicConnection::ProcessUdpPacket(const QuicSocketAddress& self_address,
   MaybeSendInResponseToPacket();
   SetPingAlarm();
   current_packet_data_ = nullptr;
+  current_receive_buffer_.reset();
   is_current_packet_connectivity_probing_ = false;
 }
 
@@ -3210,7 +3213,18 @@ void QuicConnection::QueueUndecryptablePacket(
     }
   }
   QUIC_DVLOG(1) << ENDPOINT << "Queueing undecryptable packet.";
-  undecryptable_packets_.emplace_back(packet, decryption_level);
+  undecryptable_packets_.emplace_back(CloneCurrentPacketData(packet),
+                                      decryption_level);
+}
+
+std::unique_ptr<QuicEncryptedPacket> QuicConnection::CloneCurrentPacketData(
+    const QuicEncryptedPacket& packet) const {
+  if (current_receive_buffer_ &&
+      current_receive_buffer_->Contains(packet.data(), packet.length())) {
+    return std::make_unique<QuicEncryptedPacket>(
+        packet.data(), packet.length(), current_receive_buffer_);
+  }
+  return packet.Clone();
 }
 
 void QuicConnection::MaybeProcessUndecryptablePackets() {
@@ -3312,7 +3326,7 @@ void QuicConnection::MaybeProcessUndecryptablePackets() {
 
 void QuicConnection::QueueCoalescedPacket(const QuicEncryptedPacket& packet) {
   QUIC_DVLOG(1) << ENDPOINT << "Queueing coalesced packet.";
-  received_coalesced_packets_.push_back(packet.Clone());
+  received_coalesced_packets_.push_back(CloneCurrentPacketData(packet));
   ++stats_.num_coalesced_packets_received;
 }
 
@@ -366,6 +366,12 @@ class QUIC_EXPORT_PRIVATE QuicConnectionHelperInterface {
 
   // Returns a QuicBufferAllocator to be used for stream send buffers.
   virtual QuicBufferAllocator* GetStreamSendBufferAllocator() = 0;
+
+  // Returns a QuicBufferAllocator to be used for the blocks of stream receive
+  // buffers, or nullptr to allocate them with new.
+  virtual QuicBufferAllocator* GetStreamReceiveBufferAllocator() {
+    return nullptr;
+  }
 };
 
 class QUIC_EXPORT_PRIVATE QuicConnection
@@ -1096,9 +1102,9 @@ class QUIC_EXPORT_PRIVATE QuicConnection
   // UndecrytablePacket comprises a undecryptable packet and the its encryption
   // level.
   struct QUIC_EXPORT_PRIVATE UndecryptablePacket {
-    UndecryptablePacket(const QuicEncryptedPacket& packet,
+    UndecryptablePacket(std::unique_ptr<QuicEncryptedPacket> packet,
                         EncryptionLevel encryption_level)
-        : packet(packet.Clone()),
+        : packet(std::move(packet)),
           encryption_level(encryption_level),
           processed(false) {}
 
@@ -1162,6 +1168,11 @@ class QUIC_EXPORT_PRIVATE QuicConnection
   void QueueUndecryptablePacket(const QuicEncryptedPacket& packet,
                                 EncryptionLevel decryption_level);
 
+  // Clones |packet| for queueing. If it is part of the UDP packet currently
+  // being processed, the clone shares that packet's receive buffer.
+  std::unique_ptr<QuicEncryptedPacket> CloneCurrentPacketData(
+      const QuicEncryptedPacket& packet) const;
+
   // Sends any packets which are a response to the last packet, including both
   // acks and pending writes if an ack opened the congestion window.
   void MaybeSendInResponseToPacket();
@@ -1389,6 +1400,8 @@ class QUIC_EXPORT_PRIVATE QuicConnection
   // TODO(rch): remove this when b/27221014 is fixed.
   const char* current_packet_data_;  // UDP payload of packet currently being
                                      // parsed or nullptr.
+  // Receive buffer holding |current_packet_data_|, if it is pooled.
+  QuicReceiveBufferReference current_receive_buffer_;
   EncryptionLevel last_decrypted_packet_level_;
   QuicPacketHeader last_header_;
   bool should_last_packet_instigate_acks_;
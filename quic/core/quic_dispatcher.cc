@@ -346,6 +346,10 @@ void QuicDispatcher::ProcessPacket(const QuicSocketAddress& self_address,
                 << " bytes:" << std::endl
                 << quiche::QuicheTextUtils::HexDump(quiche::QuicheStringPiece(
                        packet.data(), packet.length()));
+  if (packet_classifier_ != nullptr &&
+      MaybeDispatchClassifiedPacket(self_address, peer_address, packet)) {
+    return;
+  }
   ReceivedPacketInfo packet_info(self_address, peer_address, packet);
   std::string detailed_error;
   bool retry_token_present;
@@ -404,6 +408,47 @@ void QuicDispatcher::ProcessPacket(const QuicSocketAddress& self_address,
   ProcessHeader(&packet_info);
 }
 
+bool QuicDispatcher::MaybeDispatchClassifiedPacket(
+    const QuicSocketAddress& self_address,
+    const QuicSocketAddress& peer_address,
+    const QuicReceivedPacket& packet) {
+  const QuicTime now = helper_->GetClock()->ApproximateNow();
+  QuicConnectionId server_connection_id;
+  switch (packet_classifier_->Classify(peer_address, packet,
+                                      expected_server_connection_id_length_,
+                                      now, &server_connection_id)) {
+    case QuicPacketClassifier::DROP:
+      QUIC_CODE_COUNT(quic_dispatcher_classifier_dropped_packet);
+      return true;
+    case QuicPacketClassifier::PROCESS_FULL_HEADER:
+      return false;
+    case QuicPacketClassifier::MAYBE_KNOWN_CONNECTION_ID:
+      break;
+  }
+
+  // Short header packets carry no version, so their connection ID has never
+  // been replaced.
+  auto it = session_map_.find(server_connection_id);
+  if (it != session_map_.end()) {
+    DCHECK(!buffered_packets_.HasBufferedPackets(server_connection_id));
+    it->second->ProcessUdpPacket(self_address, peer_address, packet);
+    return true;
+  }
+  if (time_wait_list_manager_->IsConnectionIdInTimeWait(server_connection_id)) {
+    time_wait_list_manager_->ProcessPacket(
+        self_address, peer_address, server_connection_id,
+        IETF_QUIC_SHORT_HEADER_PACKET, GetPerPacketContext());
+    return true;
+  }
+  // A false positive of the filter. The full path does not limit short header
+  // packets, so limit it here.
+  if (!packet_classifier_->AllowUnknownPacket(peer_address.host(), now)) {
+    QUIC_CODE_COUNT(quic_dispatcher_classifier_rate_limited_packet);
+    return true;
+  }
+  return false;
+}
+
 QuicConnectionId QuicDispatcher::MaybeReplaceServerConnectionId(
     const QuicConnectionId& server_connection_id,
     const ParsedQuicVersion& version) const {
@@ -553,7 +598,17 @@ bool QuicDispatcher::MaybeDispatchPacket(
     return true;
   }
 
-  // The packet has an unknown connection ID.
+  // The packet has an unknown connection ID. Short header packets have
+  // already been limited by MaybeDispatchClassifiedPacket().
+  if (packet_classifier_ != nullptr &&
+      packet_info.form != IETF_QUIC_SHORT_HEADER_PACKET &&
+      !packet_classifier_->AllowUnknownPacket(
+          packet_info.peer_address.host(),
+          helper_->GetClock()->ApproximateNow())) {
+    QUIC_CODE_COUNT(quic_dispatcher_classifier_rate_limited_packet);
+    return true;
+  }
+
   if (!accept_new_connections_ && packet_info.version_flag) {
     // If not accepting new connections, reject packets with version which can
     // potentially result in new connection creation. But if the packet doesn't
@@ -776,6 +831,9 @@ void QuicDispatcher::CleanUpSession(SessionMap::iterator it,
           // |action| argument is not used by this call to
           // StatelesslyTerminateConnection().
           action);
+      if (packet_classifier_ != nullptr) {
+        packet_classifier_->RemoveConnectionId(it->first);
+      }
       session_map_.erase(it);
       return;
     }
@@ -784,9 +842,20 @@ void QuicDispatcher::CleanUpSession(SessionMap::iterator it,
   time_wait_list_manager_->AddConnectionIdToTimeWait(
       it->first, VersionHasIetfInvariantHeader(connection->transport_version()),
       action, connection->termination_packets());
+  if (packet_classifier_ != nullptr) {
+    packet_classifier_->RemoveConnectionId(it->first);
+  }
   session_map_.erase(it);
 }
 
+void QuicDispatcher::EnablePacketClassifier(
+    const QuicPacketClassifier::Config& config) {
+  DCHECK(session_map_.empty());
+  DCHECK(time_wait_list_manager_ == nullptr ||
+         time_wait_list_manager_->num_connections() == 0);
+  packet_classifier_ = std::make_unique<QuicPacketClassifier>(config);
+}
+
 void QuicDispatcher::StartAcceptingNewConnections() {
   accept_new_connections_ = true;
 }
@@ -915,6 +984,16 @@ void QuicDispatcher::OnConnectionAddedToTimeWaitList(
     QuicConnectionId server_connection_id) {
   QUIC_DLOG(INFO) << "Connection " << server_connection_id
                   << " added to time wait list.";
+  if (packet_classifier_ != nullptr) {
+    packet_classifier_->AddConnectionId(server_connection_id);
+  }
+}
+
+void QuicDispatcher::OnConnectionRemovedFromTimeWaitList(
+    QuicConnectionId server_connection_id) {
+  if (packet_classifier_ != nullptr) {
+    packet_classifier_->RemoveConnectionId(server_connection_id);
+  }
 }
 
 void QuicDispatcher::StatelesslyTerminateConnection(
@@ -1021,6 +1100,9 @@ void QuicDispatcher::ProcessBufferedChlos(size_t max_connections_to_create) {
     QUIC_BUG_IF(!insertion_result.second)
         << "Tried to add a session to session_map with existing connection id: "
         << server_connection_id;
+    if (insertion_result.second && packet_classifier_ != nullptr) {
+      packet_classifier_->AddConnectionId(server_connection_id);
+    }
     DeliverPacketsToSession(packets, insertion_result.first->second.get());
   }
 }
@@ -1122,6 +1204,9 @@ void QuicDispatcher::ProcessChlo(const std::vector<std::string>& alpns,
   QUIC_BUG_IF(!insertion_result.second)
       << "Tried to add a session to session_map with existing connection id: "
       << packet_info->destination_connection_id;
+  if (insertion_result.second && packet_classifier_ != nullptr) {
+    packet_classifier_->AddConnectionId(packet_info->destination_connection_id);
+  }
   QuicSession* session_ptr = insertion_result.first->second.get();
   std::list<BufferedPacket> packets =
       buffered_packets_.DeliverPackets(packet_info->destination_connection_id)
@@ -18,6 +18,7 @@
 #include "net/third_party/quiche/src/quic/core/quic_buffered_packet_store.h"
 #include "net/third_party/quiche/src/quic/core/quic_connection.h"
 #include "net/third_party/quiche/src/quic/core/quic_crypto_server_stream_base.h"
+#include "net/third_party/quiche/src/quic/core/quic_packet_classifier.h"
 #include "net/third_party/quiche/src/quic/core/quic_packets.h"
 #include "net/third_party/quiche/src/quic/core/quic_process_packet_interface.h"
 #include "net/third_party/quiche/src/quic/core/quic_session.h"
@@ -103,6 +104,11 @@ class QUIC_NO_EXPORT QuicDispatcher
   void OnConnectionAddedToTimeWaitList(
       QuicConnectionId server_connection_id) override;
 
+  // QuicTimeWaitListManager::Visitor interface implementation
+  // Called whenever a connection expires from the time-wait list.
+  void OnConnectionRemovedFromTimeWaitList(
+      QuicConnectionId server_connection_id) override;
+
   using SessionMap = QuicHashMap<QuicConnectionId,
                                  std::unique_ptr<QuicSession>,
                                  QuicConnectionIdHash>;
@@ -135,6 +141,19 @@ class QUIC_NO_EXPORT QuicDispatcher
 
   bool accept_new_connections() const { return accept_new_connections_; }
 
+  // Classifies each received packet with a QuicPacketClassifier before its
+  // public header is parsed. Short header packets for sessions and time wait
+  // connection IDs are then dispatched directly, and packets which miss both
+  // the session map and the time wait list may be dropped by a per source
+  // address rate limit; for short header packets, before they are parsed.
+  // Packets which skip the full path do not reach OnFailedToDispatchPacket().
+  // Must be called before any session is created.
+  void EnablePacketClassifier(const QuicPacketClassifier::Config& config);
+
+  const QuicPacketClassifier* packet_classifier() const {
+    return packet_classifier_.get();
+  }
+
  protected:
   virtual std::unique_ptr<QuicSession> CreateQuicSession(
       QuicConnectionId server_connection_id,
@@ -327,6 +346,13 @@ class QUIC_NO_EXPORT QuicDispatcher
   // ProcessValidatedPacketWithUnknownConnectionId.
   void ProcessHeader(ReceivedPacketInfo* packet_info);
 
+  // Dispatches |packet| if |packet_classifier_| finds that it belongs to a
+  // session or a connection in time wait state, or drops it. Returns false if
+  // the packet needs to go through the full path.
+  bool MaybeDispatchClassifiedPacket(const QuicSocketAddress& self_address,
+                                     const QuicSocketAddress& peer_address,
+                                     const QuicReceivedPacket& packet);
+
   // Deliver |packets| to |session| for further processing.
   void DeliverPacketsToSession(
       const std::list<QuicBufferedPacketStore::BufferedPacket>& packets,
@@ -407,6 +433,10 @@ class QUIC_NO_EXPORT QuicDispatcher
   // If true, change expected_server_connection_id_length_ to be the received
   // destination connection ID length of all IETF long headers.
   bool should_update_expected_server_connection_id_length_;
+
+  // If set, classifies packets before their public header is parsed. Tracks
+  // the connection IDs of |session_map_| and of the time wait list.
+  std::unique_ptr<QuicPacketClassifier> packet_classifier_;
 };
 
 }  // namespace quic
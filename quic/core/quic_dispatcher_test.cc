@@ -872,6 +872,104 @@ TEST_P(QuicDispatcherTestAllVersions, TimeWaitListManager) {
   ProcessPacket(client_address, connection_id, true, "data");
 }
 
+TEST_P(QuicDispatcherTestAllVersions, PacketClassifierDispatchesKnownPackets) {
+  dispatcher_->EnablePacketClassifier(QuicPacketClassifier::Config());
+  CreateTimeWaitListManager();
+
+  // Create a new session.
+  QuicSocketAddress client_address(QuicIpAddress::Loopback4(), 1);
+  QuicConnectionId connection_id = TestConnectionId(1);
+  EXPECT_CALL(*dispatcher_, CreateQuicSession(connection_id, client_address,
+                                              Eq(ExpectedAlpn()), _))
+      .WillOnce(Return(ByMove(CreateSession(
+          dispatcher_.get(), config_, connection_id, client_address,
+          &mock_helper_, &mock_alarm_factory_, &crypto_config_,
+          QuicDispatcherPeer::GetCache(dispatcher_.get()), &session1_))));
+  EXPECT_CALL(*reinterpret_cast<MockQuicConnection*>(session1_->connection()),
+              ProcessUdpPacket(_, _, _))
+      .Times(2)
+      .WillRepeatedly(
+          WithArg<2>(Invoke([this](const QuicEncryptedPacket& packet) {
+            ValidatePacket(TestConnectionId(1), packet);
+          })));
+  EXPECT_CALL(*dispatcher_,
+              ShouldCreateOrBufferPacketForConnection(
+                  ReceivedPacketInfoConnectionIdEquals(TestConnectionId(1))));
+  ProcessFirstFlight(client_address, connection_id);
+  EXPECT_TRUE(
+      dispatcher_->packet_classifier()->MayContainConnectionId(connection_id));
+  ProcessPacket(client_address, connection_id, false, "data");
+
+  // Once the connection is closed, its packets go to the time wait list.
+  session1_->connection()->CloseConnection(
+      QUIC_INVALID_VERSION, "Closed by test.",
+      ConnectionCloseBehavior::SILENT_CLOSE);
+  EXPECT_TRUE(time_wait_list_manager_->IsConnectionIdInTimeWait(connection_id));
+  EXPECT_TRUE(
+      dispatcher_->packet_classifier()->MayContainConnectionId(connection_id));
+  EXPECT_CALL(*time_wait_list_manager_,
+              ProcessPacket(_, _, connection_id, _, _))
+      .Times(1);
+  ProcessPacket(client_address, connection_id, false, "data");
+}
+
+TEST_P(QuicDispatcherTestAllVersions, PacketClassifierRateLimitsUnknownPackets) {
+  QuicPacketClassifier::Config config;
+  config.unknown_packets_per_second = 1;
+  config.unknown_packets_burst = 2;
+  dispatcher_->EnablePacketClassifier(config);
+  CreateTimeWaitListManager();
+
+  // Only the first two packets from the same source elicit a reset.
+  QuicSocketAddress client_address(QuicIpAddress::Loopback4(), 1);
+  EXPECT_CALL(*dispatcher_, CreateQuicSession(_, _, _, _)).Times(0);
+  EXPECT_CALL(*time_wait_list_manager_, SendPublicReset(_, _, _, _, _))
+      .Times(2);
+  for (uint64_t i = 1; i <= 5; ++i) {
+    ProcessPacket(client_address, TestConnectionId(i), false, "data");
+  }
+  EXPECT_EQ(
+      3u, dispatcher_->packet_classifier()->num_rate_limited_packets_dropped());
+}
+
+TEST_P(QuicDispatcherTestAllVersions,
+       PacketClassifierDoesNotRateLimitPacketsOfSessions) {
+  QuicPacketClassifier::Config config;
+  config.unknown_packets_per_second = 1;
+  config.unknown_packets_burst = 1;
+  dispatcher_->EnablePacketClassifier(config);
+  CreateTimeWaitListManager();
+
+  // The first flight uses up the only token of the source.
+  QuicSocketAddress client_address(QuicIpAddress::Loopback4(), 1);
+  QuicConnectionId connection_id = TestConnectionId(1);
+  EXPECT_CALL(*dispatcher_, CreateQuicSession(connection_id, client_address,
+                                              Eq(ExpectedAlpn()), _))
+      .WillOnce(Return(ByMove(CreateSession(
+          dispatcher_.get(), config_, connection_id, client_address,
+          &mock_helper_, &mock_alarm_factory_, &crypto_config_,
+          QuicDispatcherPeer::GetCache(dispatcher_.get()), &session1_))));
+  EXPECT_CALL(*reinterpret_cast<MockQuicConnection*>(session1_->connection()),
+              ProcessUdpPacket(_, _, _))
+      .Times(4)
+      .WillRepeatedly(
+          WithArg<2>(Invoke([this](const QuicEncryptedPacket& packet) {
+            ValidatePacket(TestConnectionId(1), packet);
+          })));
+  EXPECT_CALL(*dispatcher_,
+              ShouldCreateOrBufferPacketForConnection(
+                  ReceivedPacketInfoConnectionIdEquals(TestConnectionId(1))));
+  ProcessFirstFlight(client_address, connection_id);
+
+  // Packets with a version, which go through the full path, still reach the
+  // session.
+  for (int i = 0; i < 3; ++i) {
+    ProcessPacket(client_address, connection_id, true, "data");
+  }
+  EXPECT_EQ(
+      0u, dispatcher_->packet_classifier()->num_rate_limited_packets_dropped());
+}
+
 TEST_P(QuicDispatcherTestAllVersions, NoVersionPacketToTimeWaitListManager) {
   CreateTimeWaitListManager();
 
@@ -66,12 +66,87 @@ class QuicEpollAlarm : public QuicAlarm {
 
 }  // namespace
 
+QuicEpollTimingWheel::QuicEpollTimingWheel(QuicEpollServer* eps,
+                                           QuicTime::Delta granularity)
+    : epoll_server_(eps),
+      wheel_(granularity,
+             QuicTime::Zero() + QuicTime::Delta::FromMicroseconds(
+                                    eps->ApproximateNowInUsec())),
+      wakeup_alarm_(this),
+      wakeup_time_(QuicTime::Infinite()) {}
+
+QuicEpollTimingWheel::~QuicEpollTimingWheel() = default;
+
+void QuicEpollTimingWheel::Schedule(QuicTimingWheel::Timer* timer,
+                                    QuicTime deadline) {
+  if (wheel_.empty()) {
+    // Bring an idle wheel up to date, so that |timer| lands in a low level.
+    wheel_.AdvanceTo(Now());
+  }
+  wheel_.Schedule(timer, deadline);
+  MaybeRegisterWakeup(wheel_.ExpiryTime(timer));
+}
+
+void QuicEpollTimingWheel::Cancel(QuicTimingWheel::Timer* timer) {
+  wheel_.Cancel(timer);
+  if (wheel_.empty() && wakeup_alarm_.registered()) {
+    wakeup_alarm_.UnregisterIfRegistered();
+    wakeup_time_ = QuicTime::Infinite();
+  }
+}
+
+QuicTime QuicEpollTimingWheel::Now() const {
+  return QuicTime::Zero() + QuicTime::Delta::FromMicroseconds(
+                                epoll_server_->ApproximateNowInUsec());
+}
+
+void QuicEpollTimingWheel::OnWakeup() {
+  wakeup_time_ = QuicTime::Infinite();
+  wheel_.AdvanceTo(Now());
+  // Timers scheduled by expiring alarms have already registered a wakeup,
+  // but cascades may need an earlier one.
+  const QuicTime next_wakeup = wheel_.NextWakeupTime();
+  if (next_wakeup != QuicTime::Infinite()) {
+    MaybeRegisterWakeup(next_wakeup);
+  }
+}
+
+void QuicEpollTimingWheel::MaybeRegisterWakeup(QuicTime time) {
+  if (time >= wakeup_time_) {
+    return;
+  }
+  wakeup_time_ = time;
+  const int64_t wakeup_time_us = (time - QuicTime::Zero()).ToMicroseconds();
+  if (wakeup_alarm_.registered()) {
+    wakeup_alarm_.ReregisterAlarm(wakeup_time_us);
+  } else {
+    epoll_server_->RegisterAlarm(wakeup_time_us, &wakeup_alarm_);
+  }
+}
+
+QuicEpollTimingWheel::WakeupAlarm::int64_epoll
+QuicEpollTimingWheel::WakeupAlarm::OnAlarm() {
+  QuicEpollAlarmBase::OnAlarm();
+  timing_wheel_->OnWakeup();
+  // OnWakeup will take care of registering the alarm, if needed.
+  return 0;
+}
+
 QuicEpollAlarmFactory::QuicEpollAlarmFactory(QuicEpollServer* epoll_server)
-    : epoll_server_(epoll_server) {}
+    : epoll_server_(epoll_server), timing_wheel_(nullptr) {}
+
+QuicEpollAlarmFactory::QuicEpollAlarmFactory(
+    QuicEpollServer* epoll_server,
+    QuicEpollTimingWheel* timing_wheel)
+    : epoll_server_(epoll_server), timing_wheel_(timing_wheel) {}
 
 QuicEpollAlarmFactory::~QuicEpollAlarmFactory() = default;
 
 QuicAlarm* QuicEpollAlarmFactory::CreateAlarm(QuicAlarm::Delegate* delegate) {
+  if (timing_wheel_ != nullptr) {
+    return new QuicTimingWheelAlarm(
+        timing_wheel_, QuicArenaScopedPtr<QuicAlarm::Delegate>(delegate));
+  }
   return new QuicEpollAlarm(epoll_server_,
                             QuicArenaScopedPtr<QuicAlarm::Delegate>(delegate));
 }
@@ -79,6 +154,14 @@ QuicAlarm* QuicEpollAlarmFactory::CreateAlarm(QuicAlarm::Delegate* delegate) {
 QuicArenaScopedPtr<QuicAlarm> QuicEpollAlarmFactory::CreateAlarm(
     QuicArenaScopedPtr<QuicAlarm::Delegate> delegate,
     QuicConnectionArena* arena) {
+  if (timing_wheel_ != nullptr) {
+    if (arena != nullptr) {
+      return arena->New<QuicTimingWheelAlarm>(timing_wheel_,
+                                              std::move(delegate));
+    }
+    return QuicArenaScopedPtr<QuicAlarm>(
+        new QuicTimingWheelAlarm(timing_wheel_, std::move(delegate)));
+  }
   if (arena != nullptr) {
     return arena->New<QuicEpollAlarm>(epoll_server_, std::move(delegate));
   }
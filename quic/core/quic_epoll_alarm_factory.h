@@ -8,14 +8,68 @@
 #include "net/third_party/quiche/src/quic/core/quic_alarm.h"
 #include "net/third_party/quiche/src/quic/core/quic_alarm_factory.h"
 #include "net/third_party/quiche/src/quic/core/quic_one_block_arena.h"
+#include "net/third_party/quiche/src/quic/core/quic_timing_wheel.h"
+#include "net/third_party/quiche/src/quic/core/quic_timing_wheel_alarm.h"
 #include "net/third_party/quiche/src/quic/platform/api/quic_epoll.h"
 
 namespace quic {
 
+// Drives a QuicTimingWheel from a QuicEpollServer. Only one epoll alarm, set to
+// fire no later than the earliest timer in the wheel, is registered with the
+// epoll server, so that setting, updating and cancelling the alarms of a
+// QuicEpollAlarmFactory using this wheel are O(1).
+class QUIC_EXPORT_PRIVATE QuicEpollTimingWheel
+    : public QuicTimingWheelScheduler {
+ public:
+  QuicEpollTimingWheel(QuicEpollServer* eps, QuicTime::Delta granularity);
+  QuicEpollTimingWheel(const QuicEpollTimingWheel&) = delete;
+  QuicEpollTimingWheel& operator=(const QuicEpollTimingWheel&) = delete;
+  ~QuicEpollTimingWheel() override;
+
+  // QuicTimingWheelScheduler interface.
+  void Schedule(QuicTimingWheel::Timer* timer, QuicTime deadline) override;
+  void Cancel(QuicTimingWheel::Timer* timer) override;
+
+  const QuicTimingWheel& wheel() const { return wheel_; }
+
+ private:
+  class WakeupAlarm : public QuicEpollAlarmBase {
+   public:
+    using int64_epoll = decltype(QuicEpollAlarmBase().OnAlarm());
+
+    explicit WakeupAlarm(QuicEpollTimingWheel* timing_wheel)
+        : timing_wheel_(timing_wheel) {}
+
+    int64_epoll OnAlarm() override;
+
+   private:
+    QuicEpollTimingWheel* timing_wheel_;
+  };
+
+  QuicTime Now() const;
+
+  // Expires due timers and registers the next wakeup.
+  void OnWakeup();
+
+  // Makes sure the epoll server wakes the wheel up no later than |time|.
+  void MaybeRegisterWakeup(QuicTime time);
+
+  QuicEpollServer* epoll_server_;  // Not owned.
+  QuicTimingWheel wheel_;
+  WakeupAlarm wakeup_alarm_;
+  // The time |wakeup_alarm_| is registered for, or QuicTime::Infinite().
+  QuicTime wakeup_time_;
+};
+
 // Creates alarms that use the supplied EpollServer for timing and firing.
 class QUIC_EXPORT_PRIVATE QuicEpollAlarmFactory : public QuicAlarmFactory {
  public:
   explicit QuicEpollAlarmFactory(QuicEpollServer* eps);
+  // Alarms created by this factory are kept in |timing_wheel| rather than
+  // being registered with |eps| one by one. |timing_wheel| must outlive the
+  // alarms.
+  QuicEpollAlarmFactory(QuicEpollServer* eps,
+                        QuicEpollTimingWheel* timing_wheel);
   QuicEpollAlarmFactory(const QuicEpollAlarmFactory&) = delete;
   QuicEpollAlarmFactory& operator=(const QuicEpollAlarmFactory&) = delete;
   ~QuicEpollAlarmFactory() override;
@@ -27,7 +81,8 @@ class QUIC_EXPORT_PRIVATE QuicEpollAlarmFactory : public QuicAlarmFactory {
       QuicConnectionArena* arena) override;
 
  private:
-  QuicEpollServer* epoll_server_;  // Not owned.
+  QuicEpollServer* epoll_server_;       // Not owned.
+  QuicEpollTimingWheel* timing_wheel_;  // Not owned, may be nullptr.
 };
 
 }  // namespace quic
@@ -4,6 +4,8 @@
 
 #include "net/third_party/quiche/src/quic/core/quic_epoll_alarm_factory.h"
 
+#include <vector>
+
 #include "net/third_party/quiche/src/quic/platform/api/quic_epoll_test_tools.h"
 #include "net/third_party/quiche/src/quic/platform/api/quic_test.h"
 #include "net/quic/platform/impl/quic_epoll_clock.h"
@@ -136,6 +138,120 @@ TEST_P(QuicEpollAlarmFactoryTest, CreateAlarmAndUpdate) {
   EXPECT_FALSE(alarm->IsSet());
 }
 
+// The boolean parameter denotes whether or not to use an arena.
+class QuicEpollTimingWheelAlarmTest : public QuicTestWithParam<bool> {
+ protected:
+  QuicEpollTimingWheelAlarmTest()
+      : clock_(&epoll_server_),
+        timing_wheel_(&epoll_server_, QuicTime::Delta::FromMicroseconds(1)),
+        alarm_factory_(&epoll_server_, &timing_wheel_) {}
+
+  QuicConnectionArena* GetArenaParam() {
+    return GetParam() ? &arena_ : nullptr;
+  }
+
+  QuicFakeEpollServer epoll_server_;
+  const QuicEpollClock clock_;
+  QuicEpollTimingWheel timing_wheel_;
+  QuicEpollAlarmFactory alarm_factory_;
+  QuicConnectionArena arena_;
+};
+
+INSTANTIATE_TEST_SUITE_P(UseArena,
+                         QuicEpollTimingWheelAlarmTest,
+                         ::testing::ValuesIn({true, false}),
+                         ::testing::PrintToStringParamName());
+
+TEST_P(QuicEpollTimingWheelAlarmTest, CreateAlarm) {
+  QuicArenaScopedPtr<TestDelegate> delegate =
+      QuicArenaScopedPtr<TestDelegate>(new TestDelegate());
+  TestDelegate* unowned_delegate = delegate.get();
+  QuicArenaScopedPtr<QuicAlarm> alarm(
+      alarm_factory_.CreateAlarm(std::move(delegate), GetArenaParam()));
+
+  QuicTime start = clock_.Now();
+  QuicTime::Delta delta = QuicTime::Delta::FromMicroseconds(10);
+  alarm->Set(start + delta);
+  EXPECT_EQ(1u, timing_wheel_.wheel().size());
+
+  epoll_server_.AdvanceByExactlyAndCallCallbacks(
+      (delta - QuicTime::Delta::FromMicroseconds(1)).ToMicroseconds());
+  EXPECT_FALSE(unowned_delegate->fired());
+
+  epoll_server_.AdvanceByAndWaitForEventsAndExecuteCallbacks(1);
+  EXPECT_EQ(start + delta, clock_.Now());
+  EXPECT_TRUE(unowned_delegate->fired());
+  EXPECT_TRUE(timing_wheel_.wheel().empty());
+}
+
+TEST_P(QuicEpollTimingWheelAlarmTest, CreateAlarmAndCancel) {
+  QuicArenaScopedPtr<TestDelegate> delegate =
+      QuicArenaScopedPtr<TestDelegate>(new TestDelegate());
+  TestDelegate* unowned_delegate = delegate.get();
+  QuicArenaScopedPtr<QuicAlarm> alarm(
+      alarm_factory_.CreateAlarm(std::move(delegate), GetArenaParam()));
+
+  QuicTime start = clock_.Now();
+  QuicTime::Delta delta = QuicTime::Delta::FromMicroseconds(1);
+  alarm->Set(start + delta);
+  alarm->Cancel();
+  EXPECT_TRUE(timing_wheel_.wheel().empty());
+
+  epoll_server_.AdvanceByExactlyAndCallCallbacks(delta.ToMicroseconds());
+  EXPECT_EQ(start + delta, clock_.Now());
+  EXPECT_FALSE(unowned_delegate->fired());
+}
+
+TEST_P(QuicEpollTimingWheelAlarmTest, CreateAlarmAndUpdate) {
+  QuicArenaScopedPtr<TestDelegate> delegate =
+      QuicArenaScopedPtr<TestDelegate>(new TestDelegate());
+  TestDelegate* unowned_delegate = delegate.get();
+  QuicArenaScopedPtr<QuicAlarm> alarm(
+      alarm_factory_.CreateAlarm(std::move(delegate), GetArenaParam()));
+
+  QuicTime start = clock_.Now();
+  // Far enough out to start in a higher level of the wheel.
+  QuicTime::Delta delta = QuicTime::Delta::FromMilliseconds(100);
+  alarm->Set(start + delta);
+  QuicTime::Delta new_delta = QuicTime::Delta::FromMicroseconds(3);
+  alarm->Update(start + new_delta, QuicTime::Delta::FromMicroseconds(1));
+
+  epoll_server_.AdvanceByAndWaitForEventsAndExecuteCallbacks(
+      new_delta.ToMicroseconds());
+  EXPECT_EQ(start + new_delta, clock_.Now());
+  EXPECT_TRUE(unowned_delegate->fired());
+
+  // Set it again far out, and make sure it fires on time after cascading.
+  alarm->Set(start + delta);
+  epoll_server_.AdvanceByExactlyAndCallCallbacks(
+      (delta - new_delta).ToMicroseconds() - 1);
+  EXPECT_TRUE(alarm->IsSet());
+  epoll_server_.AdvanceByExactlyAndCallCallbacks(1);
+  EXPECT_FALSE(alarm->IsSet());
+}
+
+TEST_P(QuicEpollTimingWheelAlarmTest, ManyAlarms) {
+  const size_t kNumAlarms = 100;
+  std::vector<TestDelegate*> delegates;
+  std::vector<QuicArenaScopedPtr<QuicAlarm>> alarms;
+  QuicTime start = clock_.Now();
+  for (size_t i = 0; i < kNumAlarms; ++i) {
+    QuicArenaScopedPtr<TestDelegate> delegate =
+        QuicArenaScopedPtr<TestDelegate>(new TestDelegate());
+    delegates.push_back(delegate.get());
+    alarms.push_back(alarm_factory_.CreateAlarm(std::move(delegate), nullptr));
+    alarms.back()->Set(start + QuicTime::Delta::FromMilliseconds(i + 1));
+  }
+
+  for (size_t i = 0; i < kNumAlarms; ++i) {
+    epoll_server_.AdvanceByExactlyAndCallCallbacks(1000);
+    for (size_t j = 0; j < kNumAlarms; ++j) {
+      EXPECT_EQ(j <= i, delegates[j]->fired()) << i << " " << j;
+    }
+  }
+  EXPECT_TRUE(timing_wheel_.wheel().empty());
+}
+
 }  // namespace
 }  // namespace test
 }  // namespace quic
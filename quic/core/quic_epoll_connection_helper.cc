@@ -8,14 +8,27 @@
 #include <sys/socket.h>
 
 #include "net/third_party/quiche/src/quic/core/crypto/quic_random.h"
+#include "net/third_party/quiche/src/quic/core/quic_stream_sequencer_buffer.h"
 
 namespace quic {
 
+namespace {
+
+// Bounds on the number of free receive buffer blocks kept for reuse.
+const size_t kMinFreeReceiveBlocks = 64;
+const size_t kMaxFreeReceiveBlocks = 1024;
+
+}  // namespace
+
 QuicEpollConnectionHelper::QuicEpollConnectionHelper(
     QuicEpollServer* epoll_server,
     QuicAllocator type)
     : clock_(epoll_server),
       random_generator_(QuicRandom::GetInstance()),
+      stream_receive_buffer_allocator_(
+          sizeof(QuicStreamSequencerBuffer::BufferBlock),
+          kMinFreeReceiveBlocks,
+          kMaxFreeReceiveBlocks),
       allocator_type_(type) {}
 
 QuicEpollConnectionHelper::~QuicEpollConnectionHelper() = default;
@@ -37,4 +50,12 @@ QuicBufferAllocator* QuicEpollConnectionHelper::GetStreamSendBufferAllocator() {
   }
 }
 
+QuicBufferAllocator*
+QuicEpollConnectionHelper::GetStreamReceiveBufferAllocator() {
+  if (allocator_type_ == QuicAllocator::BUFFER_POOL) {
+    return &stream_receive_buffer_allocator_;
+  }
+  return nullptr;
+}
+
 }  // namespace quic
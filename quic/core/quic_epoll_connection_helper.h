@@ -15,6 +15,7 @@
 #include "net/third_party/quiche/src/quic/core/quic_default_packet_writer.h"
 #include "net/third_party/quiche/src/quic/core/quic_packet_writer.h"
 #include "net/third_party/quiche/src/quic/core/quic_packets.h"
+#include "net/third_party/quiche/src/quic/core/quic_pooled_buffer_allocator.h"
 #include "net/third_party/quiche/src/quic/core/quic_simple_buffer_allocator.h"
 #include "net/third_party/quiche/src/quic/core/quic_time.h"
 #include "net/third_party/quiche/src/quic/platform/api/quic_epoll.h"
@@ -40,6 +41,7 @@ class QUIC_EXPORT_PRIVATE QuicEpollConnectionHelper
   const QuicClock* GetClock() const override;
   QuicRandom* GetRandomGenerator() override;
   QuicBufferAllocator* GetStreamSendBufferAllocator() override;
+  QuicBufferAllocator* GetStreamReceiveBufferAllocator() override;
 
  private:
   const QuicEpollClock clock_;
@@ -48,6 +50,9 @@ class QUIC_EXPORT_PRIVATE QuicEpollConnectionHelper
   // Allocator for stream send buffers.
   QuicStreamBufferAllocator stream_buffer_allocator_;
   SimpleBufferAllocator simple_buffer_allocator_;
+  // Allocator for stream receive buffer blocks, shared by all connections
+  // using this helper. Only used with QuicAllocator::BUFFER_POOL.
+  QuicPooledBufferAllocator stream_receive_buffer_allocator_;
   QuicAllocator allocator_type_;
 };
 
@@ -0,0 +1,57 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/third_party/quiche/src/quic/core/quic_file_region_data_source.h"
+
+#include <errno.h>
+#include <unistd.h>
+
+#include "net/third_party/quiche/src/quic/core/quic_data_writer.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_logging.h"
+
+namespace quic {
+
+QuicFileRegionDataSource::QuicFileRegionDataSource(int fd,
+                                                   QuicByteCount file_offset,
+                                                   QuicByteCount length)
+    : fd_(fd), file_offset_(file_offset), length_(length) {
+  DCHECK_LE(0, fd_);
+}
+
+QuicFileRegionDataSource::~QuicFileRegionDataSource() {
+  close(fd_);
+}
+
+QuicByteCount QuicFileRegionDataSource::length() const {
+  return length_;
+}
+
+bool QuicFileRegionDataSource::WriteData(QuicByteCount offset,
+                                         QuicByteCount data_length,
+                                         QuicDataWriter* writer) {
+  DCHECK_LE(offset + data_length, length_);
+  if (writer->remaining() < data_length) {
+    return false;
+  }
+  char* dest = writer->data() + writer->length();
+  QuicByteCount bytes_read = 0;
+  while (bytes_read < data_length) {
+    const ssize_t rv = pread(fd_, dest + bytes_read, data_length - bytes_read,
+                             file_offset_ + offset + bytes_read);
+    if (rv < 0 && errno == EINTR) {
+      continue;
+    }
+    if (rv <= 0) {
+      QUIC_LOG(ERROR) << "Failed to read " << data_length - bytes_read
+                      << " bytes at file offset "
+                      << file_offset_ + offset + bytes_read
+                      << ", rv: " << rv << ", errno: " << errno;
+      return false;
+    }
+    bytes_read += rv;
+  }
+  return writer->Seek(data_length);
+}
+
+}  // namespace quic
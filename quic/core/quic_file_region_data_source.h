@@ -0,0 +1,44 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef QUICHE_QUIC_CORE_QUIC_FILE_REGION_DATA_SOURCE_H_
+#define QUICHE_QUIC_CORE_QUIC_FILE_REGION_DATA_SOURCE_H_
+
+#include "net/third_party/quiche/src/quic/core/quic_stream_send_buffer.h"
+#include "net/third_party/quiche/src/quic/core/quic_types.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_export.h"
+
+namespace quic {
+
+// Stream data stored in [file_offset, file_offset + length) of a file. Bytes
+// are read with pread(2) straight into the packet being serialized, so a
+// stream sending a large file does not hold a copy of it in the send buffer.
+class QUIC_EXPORT_PRIVATE QuicFileRegionDataSource
+    : public QuicStreamDataSource {
+ public:
+  // Takes ownership of |fd|, which must be open for reading, and closes it
+  // when destroyed.
+  QuicFileRegionDataSource(int fd,
+                           QuicByteCount file_offset,
+                           QuicByteCount length);
+  QuicFileRegionDataSource(const QuicFileRegionDataSource&) = delete;
+  QuicFileRegionDataSource& operator=(const QuicFileRegionDataSource&) =
+      delete;
+  ~QuicFileRegionDataSource() override;
+
+  // QuicStreamDataSource
+  QuicByteCount length() const override;
+  bool WriteData(QuicByteCount offset,
+                 QuicByteCount data_length,
+                 QuicDataWriter* writer) override;
+
+ private:
+  const int fd_;
+  const QuicByteCount file_offset_;
+  const QuicByteCount length_;
+};
+
+}  // namespace quic
+
+#endif  // QUICHE_QUIC_CORE_QUIC_FILE_REGION_DATA_SOURCE_H_
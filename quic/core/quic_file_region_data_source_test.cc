@@ -0,0 +1,86 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/third_party/quiche/src/quic/core/quic_file_region_data_source.h"
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include <string>
+
+#include "net/third_party/quiche/src/quic/core/quic_data_writer.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_test.h"
+
+namespace quic {
+namespace test {
+namespace {
+
+class QuicFileRegionDataSourceTest : public QuicTest {
+ protected:
+  // Returns a descriptor of an unlinked temporary file holding |contents|.
+  int CreateFile(const std::string& contents) {
+    FILE* file = tmpfile();
+    EXPECT_NE(nullptr, file);
+    EXPECT_EQ(contents.size(),
+              fwrite(contents.data(), 1, contents.size(), file));
+    fflush(file);
+    int fd = dup(fileno(file));
+    fclose(file);
+    return fd;
+  }
+};
+
+TEST_F(QuicFileRegionDataSourceTest, WriteData) {
+  const std::string contents = "0123456789abcdefghij";
+  QuicFileRegionDataSource source(CreateFile(contents), /*file_offset=*/5,
+                                  /*length=*/10);
+  EXPECT_EQ(10u, source.length());
+
+  char buf[20];
+  QuicDataWriter writer(sizeof(buf), buf);
+  ASSERT_TRUE(writer.WriteUInt8('x'));
+  ASSERT_TRUE(source.WriteData(2, 6, &writer));
+  EXPECT_EQ(7u, writer.length());
+  EXPECT_EQ("x789abc", std::string(buf, writer.length()));
+
+  // Reading the same bytes again, as for a retransmission, gives the same
+  // data.
+  ASSERT_TRUE(source.WriteData(0, 10, &writer));
+  EXPECT_EQ("x789abc56789abcde", std::string(buf, writer.length()));
+}
+
+TEST_F(QuicFileRegionDataSourceTest, DoesNotFit) {
+  QuicFileRegionDataSource source(CreateFile("0123456789"), 0, 10);
+  char buf[5];
+  QuicDataWriter writer(sizeof(buf), buf);
+  EXPECT_FALSE(source.WriteData(0, 10, &writer));
+  EXPECT_EQ(0u, writer.length());
+}
+
+TEST_F(QuicFileRegionDataSourceTest, FileTooShort) {
+  QuicFileRegionDataSource source(CreateFile("0123"), 0, 10);
+  char buf[10];
+  QuicDataWriter writer(sizeof(buf), buf);
+  EXPECT_FALSE(source.WriteData(0, 10, &writer));
+}
+
+TEST_F(QuicFileRegionDataSourceTest, FileTruncated) {
+  int fd = CreateFile("0123456789");
+  QuicFileRegionDataSource source(fd, 0, 10);
+  char buf[10];
+  QuicDataWriter writer(sizeof(buf), buf);
+  ASSERT_TRUE(source.WriteData(0, 10, &writer));
+
+  // Data which is no longer in the file cannot be written again, and the
+  // writer is left untouched.
+  ASSERT_EQ(0, ftruncate(fd, 4));
+  QuicDataWriter writer2(sizeof(buf), buf);
+  EXPECT_FALSE(source.WriteData(2, 6, &writer2));
+  EXPECT_EQ(0u, writer2.length());
+  EXPECT_TRUE(source.WriteData(0, 4, &writer2));
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace quic
@@ -4316,24 +4316,20 @@ bool QuicFramer::ApplyHeaderProtection(EncryptionLevel level,
                                        char* buffer,
                                        size_t buffer_len,
                                        size_t ad_len) {
-  QuicDataReader buffer_reader(buffer, buffer_len);
-  QuicDataWriter buffer_writer(buffer_len, buffer);
   // The sample starts 4 bytes after the start of the packet number.
-  if (ad_len < last_written_packet_number_length_) {
+  if (ad_len < last_written_packet_number_length_ || ad_len == 0) {
     return false;
   }
   size_t pn_offset = ad_len - last_written_packet_number_length_;
   // Sample the ciphertext and generate the mask to use for header protection.
   size_t sample_offset = pn_offset + 4;
-  QuicDataReader sample_reader(buffer, buffer_len);
-  quiche::QuicheStringPiece sample;
-  if (!sample_reader.Seek(sample_offset) ||
-      !sample_reader.ReadStringPiece(&sample, kHPSampleLen)) {
+  if (sample_offset > buffer_len || buffer_len - sample_offset < kHPSampleLen) {
     QUIC_BUG << "Not enough bytes to sample: sample_offset " << sample_offset
              << ", sample len: " << kHPSampleLen
              << ", buffer len: " << buffer_len;
     return false;
   }
+  quiche::QuicheStringPiece sample(buffer + sample_offset, kHPSampleLen);
 
   if (encrypter_[level] == nullptr) {
     QUIC_BUG
@@ -4343,19 +4339,16 @@ bool QuicFramer::ApplyHeaderProtection(EncryptionLevel level,
     return false;
   }
 
-  std::string mask = encrypter_[level]->GenerateHeaderProtectionMask(sample);
-  if (mask.empty()) {
+  // The mask is applied in place, so protecting a packet does not allocate.
+  char mask[QuicEncrypter::kHeaderProtectionMaskLength];
+  if (!encrypter_[level]->WriteHeaderProtectionMask(sample, mask)) {
     QUIC_BUG << "Unable to generate header protection mask.";
     return false;
   }
-  QuicDataReader mask_reader(mask.data(), mask.size());
 
   // Apply the mask to the 4 or 5 least significant bits of the first byte.
   uint8_t bitmask = 0x1f;
-  uint8_t type_byte;
-  if (!buffer_reader.ReadUInt8(&type_byte)) {
-    return false;
-  }
+  const uint8_t type_byte = static_cast<uint8_t>(buffer[0]);
   QuicLongHeaderType header_type;
   if (IsLongHeader(type_byte)) {
     bitmask = 0x0f;
@@ -4363,11 +4356,7 @@ bool QuicFramer::ApplyHeaderProtection(EncryptionLevel level,
       return false;
     }
   }
-  uint8_t mask_byte;
-  if (!mask_reader.ReadUInt8(&mask_byte) ||
-      !buffer_writer.WriteUInt8(type_byte ^ (mask_byte & bitmask))) {
-    return false;
-  }
+  buffer[0] = static_cast<char>(type_byte ^ (mask[0] & bitmask));
 
   // Adjust |pn_offset| to account for the diversification nonce.
   if (IsLongHeader(type_byte) && header_type == ZERO_RTT_PROTECTED &&
@@ -4379,21 +4368,15 @@ bool QuicFramer::ApplyHeaderProtection(EncryptionLevel level,
     }
     pn_offset -= kDiversificationNonceSize;
   }
-  // Advance the reader and writer to the packet number. Both the reader and
-  // writer have each read/written one byte.
-  if (!buffer_writer.Seek(pn_offset - 1) ||
-      !buffer_reader.Seek(pn_offset - 1)) {
+  // Apply the rest of the mask to the packet number.
+  DCHECK_LE(last_written_packet_number_length_,
+            QuicEncrypter::kHeaderProtectionMaskLength - 1);
+  if (pn_offset == 0 ||
+      pn_offset + last_written_packet_number_length_ > buffer_len) {
     return false;
   }
-  // Apply the rest of the mask to the packet number.
   for (size_t i = 0; i < last_written_packet_number_length_; ++i) {
-    uint8_t buffer_byte;
-    uint8_t mask_byte;
-    if (!mask_reader.ReadUInt8(&mask_byte) ||
-        !buffer_reader.ReadUInt8(&buffer_byte) ||
-        !buffer_writer.WriteUInt8(buffer_byte ^ mask_byte)) {
-      return false;
-    }
+    buffer[pn_offset + i] ^= mask[1 + i];
   }
   return true;
 }
@@ -4438,12 +4421,12 @@ bool QuicFramer::RemoveHeaderProtection(QuicDataReader* reader,
       return false;
     }
   }
-  std::string mask = decrypter->GenerateHeaderProtectionMask(&sample_reader);
-  QuicDataReader mask_reader(mask.data(), mask.size());
-  if (mask.empty()) {
+  char mask[QuicDecrypter::kHeaderProtectionMaskLength];
+  if (!decrypter->WriteHeaderProtectionMask(&sample_reader, mask)) {
     QUIC_DVLOG(1) << "Failed to compute mask";
     return false;
   }
+  QuicDataReader mask_reader(mask, sizeof(mask));
 
   // Unmask the rest of the type byte.
   uint8_t bitmask = 0x1f;
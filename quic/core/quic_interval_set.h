@@ -32,7 +32,13 @@
 // comparison operators (<, <=, ==, !=, >=, >). These requirements are inherited
 // from value_type.
 //
-// QuicIntervalSet has constant-time move operations.
+// The intervals are stored in a sorted vector with inline room for a couple
+// of entries. Data which arrives mostly in order keeps these sets at one or
+// two intervals, so they usually need no heap allocation at all, and lookups
+// are binary searches over contiguous memory. Inserting into or erasing from
+// the middle of the vector is linear though, so once a set holds more than
+// kMaxVectorSize intervals, e.g. under heavy reordering, they are moved to a
+// std::set. They move back to the vector when fewer than kMinTreeSize remain.
 //
 //
 // Examples:
@@ -53,6 +59,7 @@
 #include <stddef.h>
 #include <algorithm>
 #include <initializer_list>
+#include <iterator>
 #include <set>
 #include <utility>
 #include <vector>
@@ -60,6 +67,7 @@
 #include <string>
 
 #include "net/third_party/quiche/src/quic/core/quic_interval.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_containers.h"
 #include "net/third_party/quiche/src/quic/platform/api/quic_logging.h"
 
 namespace quic {
@@ -73,12 +81,80 @@ class QUIC_NO_EXPORT QuicIntervalSet {
   struct QUIC_NO_EXPORT IntervalLess {
     bool operator()(const value_type& a, const value_type& b) const;
   };
-  // TODO(wub): Switch to absl::btree_set when it is available in Chromium.
-  typedef std::set<value_type, IntervalLess> Set;
+  // Intervals sorted by IntervalLess. Most sets hold one or two intervals.
+  typedef QuicInlinedVector<value_type, 2> Container;
+  // Holds the intervals instead of Container when there are many of them.
+  typedef std::set<value_type, IntervalLess> Tree;
+
+  // The number of intervals above which they are moved to a Tree, and below
+  // which they are moved back to a Container. The gap between the two keeps
+  // a set hovering around the threshold from moving back and forth.
+  static const size_t kMaxVectorSize = 64;
+  static const size_t kMinTreeSize = 16;
 
  public:
-  typedef typename Set::const_iterator const_iterator;
-  typedef typename Set::const_reverse_iterator const_reverse_iterator;
+  // Iterates over the intervals in whichever container holds them.
+  class QUIC_NO_EXPORT const_iterator {
+   public:
+    typedef std::bidirectional_iterator_tag iterator_category;
+    typedef QuicInterval<T> value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const value_type* pointer;
+    typedef const value_type& reference;
+
+    const_iterator() : vector_it_(), tree_it_(), in_tree_(false) {}
+
+    reference operator*() const { return in_tree_ ? *tree_it_ : *vector_it_; }
+    pointer operator->() const { return &**this; }
+
+    const_iterator& operator++() {
+      if (in_tree_) {
+        ++tree_it_;
+      } else {
+        ++vector_it_;
+      }
+      return *this;
+    }
+    const_iterator operator++(int) {
+      const_iterator result = *this;
+      ++*this;
+      return result;
+    }
+    const_iterator& operator--() {
+      if (in_tree_) {
+        --tree_it_;
+      } else {
+        --vector_it_;
+      }
+      return *this;
+    }
+    const_iterator operator--(int) {
+      const_iterator result = *this;
+      --*this;
+      return result;
+    }
+
+    friend bool operator==(const const_iterator& a, const const_iterator& b) {
+      return a.in_tree_ ? a.tree_it_ == b.tree_it_
+                        : a.vector_it_ == b.vector_it_;
+    }
+    friend bool operator!=(const const_iterator& a, const const_iterator& b) {
+      return !(a == b);
+    }
+
+   private:
+    friend class QuicIntervalSet;
+
+    explicit const_iterator(typename Container::const_iterator it)
+        : vector_it_(it), in_tree_(false) {}
+    explicit const_iterator(typename Tree::const_iterator it)
+        : tree_it_(it), in_tree_(true) {}
+
+    typename Container::const_iterator vector_it_;
+    typename Tree::const_iterator tree_it_;
+    bool in_tree_;
+  };
+  typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
 
   // Instantiates an empty QuicIntervalSet.
   QuicIntervalSet() {}
@@ -95,10 +171,13 @@ class QUIC_NO_EXPORT QuicIntervalSet {
   QuicIntervalSet(std::initializer_list<value_type> il) { assign(il); }
 
   // Clears this QuicIntervalSet.
-  void Clear() { intervals_.clear(); }
+  void Clear() {
+    intervals_.clear();
+    tree_.clear();
+  }
 
   // Returns the number of disjoint intervals contained in this QuicIntervalSet.
-  size_t Size() const { return intervals_.size(); }
+  size_t Size() const { return InTree() ? tree_.size() : intervals_.size(); }
 
   // Returns the smallest interval that contains all intervals in this
   // QuicIntervalSet, or the empty interval if the set is empty.
@@ -120,17 +199,17 @@ class QUIC_NO_EXPORT QuicIntervalSet {
       return;
     }
 
-    const_reverse_iterator last_interval = intervals_.rbegin();
+    const value_type& last_interval = *rbegin();
 
-    // If interval.min() is outside of [last_interval->min, last_interval->max],
-    // we can not simply extend last_interval->max.
-    if (interval.min() < last_interval->min() ||
-        interval.min() > last_interval->max()) {
+    // If interval.min() is outside of [last_interval.min, last_interval.max],
+    // we can not simply extend last_interval.max.
+    if (interval.min() < last_interval.min() ||
+        interval.min() > last_interval.max()) {
       Add(interval);
       return;
     }
 
-    if (interval.max() <= last_interval->max()) {
+    if (interval.max() <= last_interval.max()) {
       // interval is fully contained by last_interval.
       return;
     }
@@ -141,7 +220,7 @@ class QUIC_NO_EXPORT QuicIntervalSet {
     // ordering requirements. But we know setting the max of the last interval
     // is safe w.r.t set ordering and other invariants of QuicIntervalSet, so we
     // force an in-place update for performance.
-    const_cast<value_type*>(&(*last_interval))->SetMax(interval.max());
+    const_cast<value_type&>(last_interval).SetMax(interval.max());
   }
 
   // Same semantics as Add(const T&, const T&), but optimized for the case where
@@ -157,6 +236,11 @@ class QUIC_NO_EXPORT QuicIntervalSet {
   // REQUIRES: !Empty()
   void PopFront() {
     DCHECK(!Empty());
+    if (InTree()) {
+      tree_.erase(tree_.begin());
+      MaybeMoveToVector();
+      return;
+    }
     intervals_.erase(intervals_.begin());
   }
 
@@ -167,37 +251,31 @@ class QUIC_NO_EXPORT QuicIntervalSet {
   //    min of that interval is raised to |value|.
   // Returns true if some intervals are trimmed.
   bool TrimLessThan(const T& value) {
-    // Number of intervals that are fully or partially trimmed.
-    size_t num_intervals_trimmed = 0;
-
-    while (!intervals_.empty()) {
-      const_iterator first_interval = intervals_.begin();
-      if (first_interval->min() >= value) {
-        break;
-      }
-
-      ++num_intervals_trimmed;
-
-      if (first_interval->max() <= value) {
-        // a) Trim the entire interval.
-        intervals_.erase(first_interval);
-        continue;
-      }
+    if (InTree()) {
+      return TrimTreeLessThan(value);
+    }
 
-      // b) Trim a prefix of the interval.
-      //
-      // Set does not allow in-place updates due to the potential of violating
-      // its ordering requirements. But increasing the min of the first interval
-      // will not break the ordering, hence the const_cast.
-      const_cast<value_type*>(&(*first_interval))->SetMin(value);
-      break;
+    // a) Trim the intervals which lie entirely below |value|, all at once.
+    typename Container::iterator first_kept = std::partition_point(
+        intervals_.begin(), intervals_.end(),
+        [&value](const value_type& interval) {
+          return interval.max() <= value;
+        });
+    bool trimmed = first_kept != intervals_.begin();
+    intervals_.erase(intervals_.begin(), first_kept);
+
+    // b) Trim a prefix of the first remaining interval. Increasing its min
+    // does not break the ordering.
+    if (!intervals_.empty() && intervals_.front().min() < value) {
+      intervals_.front().SetMin(value);
+      trimmed = true;
     }
 
-    return num_intervals_trimmed != 0;
+    return trimmed;
   }
 
   // Returns true if this QuicIntervalSet is empty.
-  bool Empty() const { return intervals_.empty(); }
+  bool Empty() const { return intervals_.empty() && tree_.empty(); }
 
   // Returns true if any interval in this QuicIntervalSet contains the indicated
   // value.
@@ -315,16 +393,26 @@ class QUIC_NO_EXPORT QuicIntervalSet {
   // e.max() < f.min() (because the entries are ordered, pairwise-disjoint, and
   // non-adjacent). Modifications to this QuicIntervalSet invalidate these
   // iterators.
-  const_iterator begin() const { return intervals_.begin(); }
+  const_iterator begin() const {
+    return InTree() ? const_iterator(tree_.begin())
+                    : const_iterator(intervals_.begin());
+  }
 
   // QuicIntervalSet's end() iterator.
-  const_iterator end() const { return intervals_.end(); }
+  const_iterator end() const {
+    return InTree() ? const_iterator(tree_.end())
+                    : const_iterator(intervals_.end());
+  }
 
   // QuicIntervalSet's rbegin() and rend() iterators. Iterator invalidation
   // semantics are the same as those for begin() / end().
-  const_reverse_iterator rbegin() const { return intervals_.rbegin(); }
+  const_reverse_iterator rbegin() const {
+    return const_reverse_iterator(end());
+  }
 
-  const_reverse_iterator rend() const { return intervals_.rend(); }
+  const_reverse_iterator rend() const {
+    return const_reverse_iterator(begin());
+  }
 
   template <typename Iter>
   void assign(Iter first, Iter last) {
@@ -351,7 +439,10 @@ class QUIC_NO_EXPORT QuicIntervalSet {
   }
 
   // Swap this QuicIntervalSet with *other. This is a constant-time operation.
-  void Swap(QuicIntervalSet<T>* other) { intervals_.swap(other->intervals_); }
+  void Swap(QuicIntervalSet<T>* other) {
+    intervals_.swap(other->intervals_);
+    tree_.swap(other->tree_);
+  }
 
   friend bool operator==(const QuicIntervalSet& a, const QuicIntervalSet& b) {
     return a.Size() == b.Size() &&
@@ -370,9 +461,49 @@ class QUIC_NO_EXPORT QuicIntervalSet {
     }
   };
 
+  // Returns true if the intervals are held in tree_ rather than intervals_.
+  bool InTree() const { return !tree_.empty(); }
+
+  // Moves the intervals to tree_ if there are too many of them for
+  // intervals_, or back to intervals_ if few enough remain in tree_.
+  void MaybeMoveToTree();
+  void MaybeMoveToVector();
+
+  // Replaces the intervals with |intervals|, which must be valid, and leaves
+  // |intervals| empty.
+  void ReplaceIntervals(Container* intervals);
+
+  // Counterparts of Add(), Difference() and TrimLessThan() for intervals held
+  // in tree_.
+  void AddToTree(const value_type& interval);
+  void DifferenceFromTree(const value_type& interval);
+  bool TrimTreeLessThan(const T& value);
+
   // Removes overlapping ranges and coalesces adjacent intervals as needed.
-  void Compact(const typename Set::iterator& begin,
-               const typename Set::iterator& end);
+  void Compact(typename Container::iterator begin,
+               typename Container::iterator end);
+  void Compact(const typename Tree::iterator& begin,
+               const typename Tree::iterator& end);
+
+  // Returns the first interval which is not less than |interval| according to
+  // IntervalLess.
+  const_iterator LowerBoundInterval(const value_type& interval) const {
+    if (InTree()) {
+      return const_iterator(tree_.lower_bound(interval));
+    }
+    return const_iterator(std::lower_bound(
+        intervals_.begin(), intervals_.end(), interval, IntervalLess()));
+  }
+
+  // Returns the first interval which is greater than |interval| according to
+  // IntervalLess.
+  const_iterator UpperBoundInterval(const value_type& interval) const {
+    if (InTree()) {
+      return const_iterator(tree_.upper_bound(interval));
+    }
+    return const_iterator(std::upper_bound(
+        intervals_.begin(), intervals_.end(), interval, IntervalLess()));
+  }
 
   // Returns true if this set is valid (i.e. all intervals in it are non-empty,
   // non-adjacent, and mutually disjoint). Currently this is used as an
@@ -386,44 +517,20 @@ class QUIC_NO_EXPORT QuicIntervalSet {
   // Finds the first interval that potentially intersects 'interval'.
   const_iterator FindIntersectionCandidate(const value_type& interval) const;
 
-  // Helper for Intersection() and Difference(): Finds the next pair of
-  // intervals from 'x' and 'y' that intersect. 'mine' is an iterator
-  // over x->intervals_. 'theirs' is an iterator over y.intervals_. 'mine'
-  // and 'theirs' are advanced until an intersecting pair is found.
-  // Non-intersecting intervals (aka "holes") from x->intervals_ can be
-  // optionally erased by "on_hole".
-  template <typename X, typename Func>
-  static bool FindNextIntersectingPairImpl(X* x,
-                                           const QuicIntervalSet& y,
-                                           const_iterator* mine,
-                                           const_iterator* theirs,
-                                           Func on_hole);
-
-  // The variant of the above method that doesn't mutate this QuicIntervalSet.
+  // Helper for Intersects(): Finds the next pair of intervals from *this and
+  // 'other' that intersect. 'mine' is an iterator over *this. 'theirs' is an
+  // iterator over 'other'. 'mine' and 'theirs' are advanced until an
+  // intersecting pair is found.
   bool FindNextIntersectingPair(const QuicIntervalSet& other,
                                 const_iterator* mine,
-                                const_iterator* theirs) const {
-    return FindNextIntersectingPairImpl(
-        this, other, mine, theirs,
-        [](const QuicIntervalSet*, const_iterator, const_iterator) {});
-  }
-
-  // The variant of the above method that mutates this QuicIntervalSet by
-  // erasing holes.
-  bool FindNextIntersectingPairAndEraseHoles(const QuicIntervalSet& other,
-                                             const_iterator* mine,
-                                             const_iterator* theirs) {
-    return FindNextIntersectingPairImpl(
-        this, other, mine, theirs,
-        [](QuicIntervalSet* x, const_iterator from, const_iterator to) {
-          x->intervals_.erase(from, to);
-        });
-  }
+                                const_iterator* theirs) const;
 
   // The representation for the intervals. The intervals in this set are
   // non-empty, pairwise-disjoint, non-adjacent and ordered in ascending order
-  // by min().
-  Set intervals_;
+  // by min(). They are held in intervals_ unless there are many of them, in
+  // which case they are held in tree_. At most one of the two is non-empty.
+  Container intervals_;
+  Tree tree_;
 };
 
 template <typename T>
@@ -448,9 +555,9 @@ template <typename T>
 typename QuicIntervalSet<T>::value_type QuicIntervalSet<T>::SpanningInterval()
     const {
   value_type result;
-  if (!intervals_.empty()) {
-    result.SetMin(intervals_.begin()->min());
-    result.SetMax(intervals_.rbegin()->max());
+  if (!Empty()) {
+    result.SetMin(begin()->min());
+    result.SetMax(rbegin()->max());
   }
   return result;
 }
@@ -459,22 +566,47 @@ template <typename T>
 void QuicIntervalSet<T>::Add(const value_type& interval) {
   if (interval.Empty())
     return;
-  std::pair<typename Set::iterator, bool> ins = intervals_.insert(interval);
-  if (!ins.second) {
+  if (InTree()) {
+    AddToTree(interval);
+    return;
+  }
+  typename Container::iterator it = std::lower_bound(
+      intervals_.begin(), intervals_.end(), interval, IntervalLess());
+  if (it != intervals_.end() && NonemptyIntervalEq()(*it, interval)) {
     // This interval already exists.
     return;
   }
+  it = intervals_.insert(it, interval);
   // Determine the minimal range that will have to be compacted.  We know that
   // the QuicIntervalSet was valid before the addition of the interval, so only
   // need to start with the interval itself (although Compact takes an open
   // range so begin needs to be the interval to the left).  We don't know how
   // many ranges this interval may cover, so we need to find the appropriate
   // interval to end with on the right.
-  typename Set::iterator begin = ins.first;
+  typename Container::iterator begin = it;
   if (begin != intervals_.begin())
     --begin;
   const value_type target_end(interval.max(), interval.max());
-  const typename Set::iterator end = intervals_.upper_bound(target_end);
+  const typename Container::iterator end =
+      std::upper_bound(it, intervals_.end(), target_end, IntervalLess());
+  Compact(begin, end);
+  MaybeMoveToTree();
+}
+
+template <typename T>
+void QuicIntervalSet<T>::AddToTree(const value_type& interval) {
+  std::pair<typename Tree::iterator, bool> ins = tree_.insert(interval);
+  if (!ins.second) {
+    // This interval already exists.
+    return;
+  }
+  // As in Add(), only the range from the interval to the left of the new one
+  // up to the last interval it reaches needs to be compacted.
+  typename Tree::iterator begin = ins.first;
+  if (begin != tree_.begin())
+    --begin;
+  const value_type target_end(interval.max(), interval.max());
+  const typename Tree::iterator end = tree_.upper_bound(target_end);
   Compact(begin, end);
 }
 
@@ -482,8 +614,8 @@ template <typename T>
 bool QuicIntervalSet<T>::Contains(const T& value) const {
   value_type tmp(value, value);
   // Find the first interval with min() > value, then move back one step
-  const_iterator it = intervals_.upper_bound(tmp);
-  if (it == intervals_.begin())
+  const_iterator it = UpperBoundInterval(tmp);
+  if (it == begin())
     return false;
   --it;
   return it->Contains(value);
@@ -492,8 +624,8 @@ bool QuicIntervalSet<T>::Contains(const T& value) const {
 template <typename T>
 bool QuicIntervalSet<T>::Contains(const value_type& interval) const {
   // Find the first interval with min() > value, then move back one step.
-  const_iterator it = intervals_.upper_bound(interval);
-  if (it == intervals_.begin())
+  const_iterator it = UpperBoundInterval(interval);
+  if (it == begin())
     return false;
   --it;
   return it->Contains(interval);
@@ -521,7 +653,7 @@ bool QuicIntervalSet<T>::Contains(const QuicIntervalSet<T>& other) const {
 // largest min() having min() <= value.
 //
 // Determining the candidate interval takes a couple of steps. First, since the
-// underlying std::set stores intervals, not values, we need to create a "probe
+// underlying container stores intervals, not values, we need to create a "probe
 // interval" suitable for use as a search key. The probe interval used is
 // [value, value). Now we can restate the problem as finding the largest
 // interval in the QuicIntervalSet that is <= the probe interval.
@@ -554,27 +686,27 @@ bool QuicIntervalSet<T>::Contains(const QuicIntervalSet<T>& other) const {
 // is larger than any non-empty interval with the same min(). The comparator
 // used by this library is careful to induce this ordering.
 //
-// Another detail involves the choice of which std::set method to use to try to
-// find the candidate interval. The most appropriate entry point is
-// set::upper_bound(), which finds the smallest interval which is > the probe
-// interval. The semantics of upper_bound() are slightly different from what we
-// want (namely, to find the largest interval which is <= the probe interval)
-// but they are close enough; the interval found by upper_bound() will always be
-// one step past the interval we are looking for (if it exists) or at begin()
-// (if it does not). Getting to the proper interval is a simple matter of
-// decrementing the iterator.
+// Another detail involves the choice of which search to use to try to find the
+// candidate interval. The most appropriate one is std::upper_bound(), which
+// finds the smallest interval which is > the probe interval. The semantics of
+// upper_bound() are slightly different from what we want (namely, to find the
+// largest interval which is <= the probe interval) but they are close enough;
+// the interval found by upper_bound() will always be one step past the
+// interval we are looking for (if it exists) or at begin() (if it does not).
+// Getting to the proper interval is a simple matter of decrementing the
+// iterator.
 template <typename T>
 typename QuicIntervalSet<T>::const_iterator QuicIntervalSet<T>::Find(
     const T& value) const {
   value_type tmp(value, value);
-  const_iterator it = intervals_.upper_bound(tmp);
-  if (it == intervals_.begin())
-    return intervals_.end();
+  const_iterator it = UpperBoundInterval(tmp);
+  if (it == begin())
+    return end();
   --it;
   if (it->Contains(value))
     return it;
   else
-    return intervals_.end();
+    return end();
 }
 
 // This method finds the interval that Contains() the interval "probe", if such
@@ -612,37 +744,37 @@ typename QuicIntervalSet<T>::const_iterator QuicIntervalSet<T>::Find(
 // same min(), the wider one goes before the narrower one. The comparator used
 // by this library is careful to induce this ordering.
 //
-// Another detail involves the choice of which std::set method to use to try to
-// find the candidate interval. The most appropriate entry point is
-// set::upper_bound(), which finds the smallest interval which is > the probe
-// interval. The semantics of upper_bound() are slightly different from what we
-// want (namely, to find the largest interval which is <= the probe interval)
-// but they are close enough; the interval found by upper_bound() will always be
-// one step past the interval we are looking for (if it exists) or at begin()
-// (if it does not). Getting to the proper interval is a simple matter of
-// decrementing the iterator.
+// Another detail involves the choice of which search to use to try to find the
+// candidate interval. The most appropriate one is std::upper_bound(), which
+// finds the smallest interval which is > the probe interval. The semantics of
+// upper_bound() are slightly different from what we want (namely, to find the
+// largest interval which is <= the probe interval) but they are close enough;
+// the interval found by upper_bound() will always be one step past the
+// interval we are looking for (if it exists) or at begin() (if it does not).
+// Getting to the proper interval is a simple matter of decrementing the
+// iterator.
 template <typename T>
 typename QuicIntervalSet<T>::const_iterator QuicIntervalSet<T>::Find(
     const value_type& probe) const {
-  const_iterator it = intervals_.upper_bound(probe);
-  if (it == intervals_.begin())
-    return intervals_.end();
+  const_iterator it = UpperBoundInterval(probe);
+  if (it == begin())
+    return end();
   --it;
   if (it->Contains(probe))
     return it;
   else
-    return intervals_.end();
+    return end();
 }
 
 template <typename T>
 typename QuicIntervalSet<T>::const_iterator QuicIntervalSet<T>::LowerBound(
     const T& value) const {
-  const_iterator it = intervals_.lower_bound(value_type(value, value));
-  if (it == intervals_.begin()) {
+  const_iterator it = LowerBoundInterval(value_type(value, value));
+  if (it == begin()) {
     return it;
   }
 
-  // The previous intervals_.lower_bound() checking is essentially based on
+  // The previous LowerBoundInterval() checking is essentially based on
   // interval.min(), so we need to check whether the `value` is contained in
   // the previous interval.
   --it;
@@ -656,7 +788,7 @@ typename QuicIntervalSet<T>::const_iterator QuicIntervalSet<T>::LowerBound(
 template <typename T>
 typename QuicIntervalSet<T>::const_iterator QuicIntervalSet<T>::UpperBound(
     const T& value) const {
-  return intervals_.upper_bound(value_type(value, value));
+  return UpperBoundInterval(value_type(value, value));
 }
 
 template <typename T>
@@ -665,10 +797,10 @@ bool QuicIntervalSet<T>::IsDisjoint(const value_type& interval) const {
     return true;
   value_type tmp(interval.min(), interval.min());
   // Find the first interval with min() > interval.min()
-  const_iterator it = intervals_.upper_bound(tmp);
-  if (it != intervals_.end() && interval.max() > it->min())
+  const_iterator it = UpperBoundInterval(tmp);
+  if (it != end() && interval.max() > it->min())
     return false;
-  if (it == intervals_.begin())
+  if (it == begin())
     return true;
   --it;
   return it->max() <= interval.min();
@@ -676,65 +808,77 @@ bool QuicIntervalSet<T>::IsDisjoint(const value_type& interval) const {
 
 template <typename T>
 void QuicIntervalSet<T>::Union(const QuicIntervalSet& other) {
-  intervals_.insert(other.begin(), other.end());
+  if (&other == this || other.Empty()) {
+    return;
+  }
+  if (InTree()) {
+    for (const value_type& interval : other) {
+      AddToTree(interval);
+    }
+    return;
+  }
+  if (Empty() || other.begin()->min() > intervals_.back().max()) {
+    // |other| lies entirely after *this, so its intervals can be appended.
+    intervals_.insert(intervals_.end(), other.begin(), other.end());
+    MaybeMoveToTree();
+    return;
+  }
+  const size_t old_size = intervals_.size();
+  intervals_.insert(intervals_.end(), other.begin(), other.end());
+  std::inplace_merge(intervals_.begin(), intervals_.begin() + old_size,
+                     intervals_.end(), IntervalLess());
   Compact(intervals_.begin(), intervals_.end());
+  MaybeMoveToTree();
 }
 
 template <typename T>
 typename QuicIntervalSet<T>::const_iterator
 QuicIntervalSet<T>::FindIntersectionCandidate(
     const QuicIntervalSet& other) const {
-  return FindIntersectionCandidate(*other.intervals_.begin());
+  return FindIntersectionCandidate(*other.begin());
 }
 
 template <typename T>
 typename QuicIntervalSet<T>::const_iterator
 QuicIntervalSet<T>::FindIntersectionCandidate(
     const value_type& interval) const {
-  // Use upper_bound to efficiently find the first interval in intervals_
+  // Use UpperBoundInterval to efficiently find the first interval in this set
   // where min() is greater than interval.min().  If the result
-  // isn't the beginning of intervals_ then move backwards one interval since
+  // isn't the beginning of this set then move backwards one interval since
   // the interval before it is the first candidate where max() may be
   // greater than interval.min().
   // In other words, no interval before that can possibly intersect with any
-  // of other.intervals_.
-  const_iterator mine = intervals_.upper_bound(interval);
-  if (mine != intervals_.begin()) {
+  // of the intervals of other.
+  const_iterator mine = UpperBoundInterval(interval);
+  if (mine != begin()) {
     --mine;
   }
   return mine;
 }
 
 template <typename T>
-template <typename X, typename Func>
-bool QuicIntervalSet<T>::FindNextIntersectingPairImpl(X* x,
-                                                      const QuicIntervalSet& y,
-                                                      const_iterator* mine,
-                                                      const_iterator* theirs,
-                                                      Func on_hole) {
-  CHECK(x != nullptr);
-  if ((*mine == x->intervals_.end()) || (*theirs == y.intervals_.end())) {
+bool QuicIntervalSet<T>::FindNextIntersectingPair(
+    const QuicIntervalSet& other,
+    const_iterator* mine,
+    const_iterator* theirs) const {
+  if ((*mine == end()) || (*theirs == other.end())) {
     return false;
   }
   while (!(**mine).Intersects(**theirs)) {
-    const_iterator erase_first = *mine;
     // Skip over intervals in 'mine' that don't reach 'theirs'.
-    while (*mine != x->intervals_.end() && (**mine).max() <= (**theirs).min()) {
+    while (*mine != end() && (**mine).max() <= (**theirs).min()) {
       ++(*mine);
     }
-    on_hole(x, erase_first, *mine);
-    // We're done if the end of intervals_ is reached.
-    if (*mine == x->intervals_.end()) {
+    // We're done if the end of this set is reached.
+    if (*mine == end()) {
       return false;
     }
     // Skip over intervals 'theirs' that don't reach 'mine'.
-    while (*theirs != y.intervals_.end() &&
-           (**theirs).max() <= (**mine).min()) {
+    while (*theirs != other.end() && (**theirs).max() <= (**mine).min()) {
       ++(*theirs);
     }
-    // If the end of other.intervals_ is reached, we're done.
-    if (*theirs == y.intervals_.end()) {
-      on_hole(x, *mine, x->intervals_.end());
+    // If the end of other is reached, we're done.
+    if (*theirs == other.end()) {
       return false;
     }
   }
@@ -744,38 +888,30 @@ bool QuicIntervalSet<T>::FindNextIntersectingPairImpl(X* x,
 template <typename T>
 void QuicIntervalSet<T>::Intersection(const QuicIntervalSet& other) {
   if (!SpanningInterval().Intersects(other.SpanningInterval())) {
-    intervals_.clear();
+    Clear();
     return;
   }
 
+  // Intervals before these candidates cannot intersect the other set.
   const_iterator mine = FindIntersectionCandidate(other);
-  // Remove any intervals that cannot possibly intersect with other.intervals_.
-  intervals_.erase(intervals_.begin(), mine);
   const_iterator theirs = other.FindIntersectionCandidate(*this);
 
-  while (FindNextIntersectingPairAndEraseHoles(other, &mine, &theirs)) {
-    // OK, *mine and *theirs intersect.  Now, we find the largest
-    // span of intervals in other (starting at theirs) - say [a..b]
-    // - that intersect *mine, and we replace *mine with (*mine
-    // intersect x) for all x in [a..b] Note that subsequent
-    // intervals in this can't intersect any intervals in [a..b) --
-    // they may only intersect b or subsequent intervals in other.
-    value_type i(*mine);
-    intervals_.erase(mine);
-    mine = intervals_.end();
-    value_type intersection;
-    while (theirs != other.intervals_.end() &&
-           i.Intersects(*theirs, &intersection)) {
-      std::pair<typename Set::iterator, bool> ins =
-          intervals_.insert(intersection);
-      DCHECK(ins.second);
-      mine = ins.first;
+  // Walk both sets in step, collecting the pairwise intersections in order.
+  Container result;
+  value_type intersection;
+  while (mine != end() && theirs != other.end()) {
+    if (mine->Intersects(*theirs, &intersection)) {
+      result.push_back(intersection);
+    }
+    // Whichever interval ends later may still intersect the next interval of
+    // the other set.
+    if (mine->max() < theirs->max()) {
+      ++mine;
+    } else {
       ++theirs;
     }
-    DCHECK(mine != intervals_.end());
-    --theirs;
-    ++mine;
   }
+  ReplaceIntervals(&result);
   DCHECK(Valid());
 }
 
@@ -786,7 +922,7 @@ bool QuicIntervalSet<T>::Intersects(const QuicIntervalSet& other) const {
   }
 
   const_iterator mine = FindIntersectionCandidate(other);
-  if (mine == intervals_.end()) {
+  if (mine == end()) {
     return false;
   }
   const_iterator theirs = other.FindIntersectionCandidate(*mine);
@@ -799,7 +935,74 @@ void QuicIntervalSet<T>::Difference(const value_type& interval) {
   if (!SpanningInterval().Intersects(interval)) {
     return;
   }
-  Difference(QuicIntervalSet<T>(interval));
+  if (InTree()) {
+    DifferenceFromTree(interval);
+    return;
+  }
+
+  // [first, last) are the intervals which overlap |interval|.
+  typename Container::iterator first = std::partition_point(
+      intervals_.begin(), intervals_.end(),
+      [&interval](const value_type& i) { return i.max() <= interval.min(); });
+  typename Container::iterator last = std::partition_point(
+      first, intervals_.end(),
+      [&interval](const value_type& i) { return i.min() < interval.max(); });
+  if (first == last) {
+    return;
+  }
+
+  // At most the parts of the first and last overlapping intervals which stick
+  // out of |interval| survive.
+  const value_type lo(first->min(), interval.min());
+  const value_type hi(interval.max(), std::prev(last)->max());
+  if (!lo.Empty() && !hi.Empty() && std::next(first) == last) {
+    // |interval| splits a single interval in two.
+    *first = hi;
+    intervals_.insert(first, lo);
+    MaybeMoveToTree();
+    return;
+  }
+  if (!lo.Empty()) {
+    *first = lo;
+    ++first;
+  }
+  if (!hi.Empty()) {
+    --last;
+    *last = hi;
+  }
+  intervals_.erase(first, last);
+  DCHECK(Valid());
+}
+
+template <typename T>
+void QuicIntervalSet<T>::DifferenceFromTree(const value_type& interval) {
+  // [first, last) are the intervals which overlap |interval|.
+  typename Tree::iterator first =
+      tree_.upper_bound(value_type(interval.min(), interval.min()));
+  if (first != tree_.begin() && std::prev(first)->max() > interval.min()) {
+    --first;
+  }
+  typename Tree::iterator last = first;
+  while (last != tree_.end() && last->min() < interval.max()) {
+    ++last;
+  }
+  if (first == last) {
+    return;
+  }
+
+  // At most the parts of the first and last overlapping intervals which stick
+  // out of |interval| survive.
+  const value_type lo(first->min(), interval.min());
+  const value_type hi(interval.max(), std::prev(last)->max());
+  typename Tree::iterator hint = tree_.erase(first, last);
+  if (!hi.Empty()) {
+    hint = tree_.insert(hint, hi);
+  }
+  if (!lo.Empty()) {
+    tree_.insert(hint, lo);
+  }
+  MaybeMoveToVector();
+  DCHECK(Valid());
 }
 
 template <typename T>
@@ -812,37 +1015,49 @@ void QuicIntervalSet<T>::Difference(const QuicIntervalSet& other) {
   if (!SpanningInterval().Intersects(other.SpanningInterval())) {
     return;
   }
-
-  const_iterator mine = FindIntersectionCandidate(other);
-  // If no interval in mine reaches the first interval of theirs then we're
-  // done.
-  if (mine == intervals_.end()) {
+  if (&other == this) {
+    Clear();
     return;
   }
+  if (InTree() || other.Size() == 1) {
+    // Cut the intervals of |other| out one by one, without visiting the
+    // intervals they do not overlap.
+    for (const value_type& interval : other) {
+      Difference(interval);
+    }
+    return;
+  }
+
+  const_iterator mine = FindIntersectionCandidate(other);
   const_iterator theirs = other.FindIntersectionCandidate(*this);
 
-  while (FindNextIntersectingPair(other, &mine, &theirs)) {
-    // At this point *mine and *theirs overlap.  Remove mine from
-    // intervals_ and replace it with the possibly two intervals that are
-    // the difference between mine and theirs.
-    value_type i(*mine);
-    intervals_.erase(mine++);
-    value_type lo;
-    value_type hi;
-    i.Difference(*theirs, &lo, &hi);
-
-    if (!lo.Empty()) {
-      // We have a low end.  This can't intersect anything else.
-      std::pair<typename Set::iterator, bool> ins = intervals_.insert(lo);
-      DCHECK(ins.second);
+  // Intervals before |mine| are unaffected. Each later interval is cut by
+  // the intervals of |other| which overlap it, and the remaining pieces are
+  // appended in order.
+  Container result(begin(), mine);
+  for (; mine != end(); ++mine) {
+    T min = mine->min();
+    while (theirs != other.end() && theirs->min() < mine->max()) {
+      if (theirs->max() <= min) {
+        ++theirs;
+        continue;
+      }
+      if (min < theirs->min()) {
+        result.push_back(value_type(min, theirs->min()));
+      }
+      if (theirs->max() >= mine->max()) {
+        // The rest of *mine is covered. *theirs may overlap the next interval.
+        min = mine->max();
+        break;
+      }
+      min = theirs->max();
+      ++theirs;
     }
-
-    if (!hi.Empty()) {
-      std::pair<typename Set::iterator, bool> ins = intervals_.insert(hi);
-      DCHECK(ins.second);
-      mine = ins.first;
+    if (min < mine->max()) {
+      result.push_back(value_type(min, mine->max()));
     }
   }
+  ReplaceIntervals(&result);
   DCHECK(Valid());
 }
 
@@ -850,7 +1065,7 @@ template <typename T>
 void QuicIntervalSet<T>::Complement(const T& min, const T& max) {
   QuicIntervalSet<T> span(min, max);
   span.Difference(*this);
-  intervals_.swap(span.intervals_);
+  Swap(&span);
 }
 
 template <typename T>
@@ -875,13 +1090,33 @@ std::string QuicIntervalSet<T>::ToString() const {
 // QuicIntervalSet does exactly what is needed, ordering first by ascending
 // min(), then by descending max().
 template <typename T>
-void QuicIntervalSet<T>::Compact(const typename Set::iterator& begin,
-                                 const typename Set::iterator& end) {
+void QuicIntervalSet<T>::Compact(typename Container::iterator begin,
+                                 typename Container::iterator end) {
+  if (begin == end)
+    return;
+  // Merge each interval into |prev| when they overlap or touch, and otherwise
+  // move it down to follow |prev|. Merging never lowers prev->min(), so the
+  // intervals stay sorted.
+  typename Container::iterator prev = begin;
+  for (typename Container::iterator it = std::next(begin); it != end; ++it) {
+    if (prev->max() >= it->min()) {
+      // Overlapping / coalesced range; merge the two intervals.
+      prev->SetMax(std::max(prev->max(), it->max()));
+    } else {
+      *++prev = *it;
+    }
+  }
+  intervals_.erase(std::next(prev), end);
+}
+
+template <typename T>
+void QuicIntervalSet<T>::Compact(const typename Tree::iterator& begin,
+                                 const typename Tree::iterator& end) {
   if (begin == end)
     return;
-  typename Set::iterator next = begin;
-  typename Set::iterator prev = begin;
-  typename Set::iterator it = begin;
+  typename Tree::iterator next = begin;
+  typename Tree::iterator prev = begin;
+  typename Tree::iterator it = begin;
   ++it;
   ++next;
   while (it != end) {
@@ -891,9 +1126,9 @@ void QuicIntervalSet<T>::Compact(const typename Set::iterator& begin,
       T min = prev->min();
       T max = std::max(prev->max(), it->max());
       value_type i(min, max);
-      intervals_.erase(prev);
-      intervals_.erase(it);
-      std::pair<typename Set::iterator, bool> ins = intervals_.insert(i);
+      tree_.erase(prev);
+      tree_.erase(it);
+      std::pair<typename Tree::iterator, bool> ins = tree_.insert(i);
       DCHECK(ins.second);
       prev = ins.first;
     } else {
@@ -903,6 +1138,70 @@ void QuicIntervalSet<T>::Compact(const typename Set::iterator& begin,
   }
 }
 
+template <typename T>
+bool QuicIntervalSet<T>::TrimTreeLessThan(const T& value) {
+  // Number of intervals that are fully or partially trimmed.
+  size_t num_intervals_trimmed = 0;
+
+  while (!tree_.empty()) {
+    typename Tree::iterator first_interval = tree_.begin();
+    if (first_interval->min() >= value) {
+      break;
+    }
+
+    ++num_intervals_trimmed;
+
+    if (first_interval->max() <= value) {
+      // a) Trim the entire interval.
+      tree_.erase(first_interval);
+      continue;
+    }
+
+    // b) Trim a prefix of the interval.
+    //
+    // Set does not allow in-place updates due to the potential of violating
+    // its ordering requirements. But increasing the min of the first interval
+    // will not break the ordering, hence the const_cast.
+    const_cast<value_type*>(&(*first_interval))->SetMin(value);
+    break;
+  }
+
+  MaybeMoveToVector();
+  return num_intervals_trimmed != 0;
+}
+
+template <typename T>
+void QuicIntervalSet<T>::MaybeMoveToTree() {
+  if (intervals_.size() <= kMaxVectorSize) {
+    return;
+  }
+  DCHECK(tree_.empty());
+  // The intervals are sorted, so each one goes right before end().
+  for (const value_type& interval : intervals_) {
+    tree_.insert(tree_.end(), interval);
+  }
+  // Also release the heap storage of intervals_.
+  Container().swap(intervals_);
+}
+
+template <typename T>
+void QuicIntervalSet<T>::MaybeMoveToVector() {
+  if (tree_.empty() || tree_.size() >= kMinTreeSize) {
+    return;
+  }
+  DCHECK(intervals_.empty());
+  intervals_.assign(tree_.begin(), tree_.end());
+  tree_.clear();
+}
+
+template <typename T>
+void QuicIntervalSet<T>::ReplaceIntervals(Container* intervals) {
+  tree_.clear();
+  intervals_.swap(*intervals);
+  intervals->clear();
+  MaybeMoveToTree();
+}
+
 template <typename T>
 bool QuicIntervalSet<T>::Valid() const {
   const_iterator prev = end();
@@ -832,6 +832,196 @@ TEST(QuicIntervalSetMultipleCompactionTest, RightCovering) {
   EXPECT_TRUE(Check(iset, 1, 0, 450));
 }
 
+// Returns the intervals of consecutive values marked in |reference|.
+static std::vector<QuicInterval<int>> ReferenceIntervals(
+    const std::vector<bool>& reference) {
+  std::vector<QuicInterval<int>> intervals;
+  for (int i = 0; i < static_cast<int>(reference.size()); ++i) {
+    if (!reference[i]) {
+      continue;
+    }
+    if (!intervals.empty() && intervals.back().max() == i) {
+      intervals.back().SetMax(i + 1);
+    } else {
+      intervals.push_back(QuicInterval<int>(i, i + 1));
+    }
+  }
+  return intervals;
+}
+
+TEST(QuicIntervalSetOrderingTest, InOrder) {
+  QuicIntervalSet<int> iset;
+  for (int i = 0; i < 1000; i += 10) {
+    iset.Add(i, i + 10);
+    EXPECT_TRUE(Check(iset, 1, 0, i + 10));
+  }
+  iset.TrimLessThan(995);
+  EXPECT_TRUE(Check(iset, 1, 995, 1000));
+}
+
+TEST(QuicIntervalSetOrderingTest, Reordered) {
+  // Chunks arrive in a fixed permutation of their natural order, as if
+  // heavily reordered, and are removed again in another permutation.
+  const int kNumChunks = 100;
+  const int kChunkSize = 10;
+  QuicIntervalSet<int> iset;
+  std::vector<bool> reference(kNumChunks * kChunkSize, false);
+  for (int i = 0; i < kNumChunks; ++i) {
+    const int chunk = (i * 37) % kNumChunks;
+    iset.Add(chunk * kChunkSize, (chunk + 1) * kChunkSize);
+    std::fill(reference.begin() + chunk * kChunkSize,
+              reference.begin() + (chunk + 1) * kChunkSize, true);
+    EXPECT_THAT(iset, ElementsAreArray(ReferenceIntervals(reference)));
+  }
+  EXPECT_TRUE(Check(iset, 1, 0, kNumChunks * kChunkSize));
+
+  for (int i = 0; i < kNumChunks; ++i) {
+    const int chunk = (i * 53) % kNumChunks;
+    // Remove a range straddling two chunks.
+    const int min = chunk * kChunkSize + kChunkSize / 2;
+    const int max = std::min(min + kChunkSize, kNumChunks * kChunkSize);
+    iset.Difference(min, max);
+    std::fill(reference.begin() + min, reference.begin() + max, false);
+    EXPECT_THAT(iset, ElementsAreArray(ReferenceIntervals(reference)));
+  }
+}
+
+TEST(QuicIntervalSetOrderingTest, ManyDisjointIntervals) {
+  // Enough disjoint intervals to move them out of the vector, inserted from
+  // the back so that every insertion lands at the front, and then removed
+  // from the middle outwards until they move back.
+  const int kNumIntervals = 10000;
+  QuicIntervalSet<int> iset;
+  for (int i = kNumIntervals - 1; i >= 0; --i) {
+    iset.Add(2 * i, 2 * i + 1);
+  }
+  ASSERT_EQ(static_cast<size_t>(kNumIntervals), iset.Size());
+  EXPECT_EQ(QuicInterval<int>(0, 1), *iset.begin());
+  EXPECT_EQ(QuicInterval<int>(2 * kNumIntervals - 2, 2 * kNumIntervals - 1),
+            *iset.rbegin());
+  for (int i = 0; i < kNumIntervals; i += 997) {
+    EXPECT_TRUE(iset.Contains(2 * i));
+    EXPECT_FALSE(iset.Contains(2 * i + 1));
+    EXPECT_EQ(QuicInterval<int>(2 * i, 2 * i + 1), *iset.Find(2 * i));
+    EXPECT_EQ(iset.end(), iset.Find(2 * i + 1));
+  }
+
+  for (int i = 1; i <= 100; ++i) {
+    const int radius = kNumIntervals * i / 100;
+    iset.Difference(kNumIntervals - radius, kNumIntervals + radius);
+    EXPECT_EQ(static_cast<size_t>(kNumIntervals - radius), iset.Size());
+  }
+  EXPECT_TRUE(iset.Empty());
+}
+
+TEST(QuicIntervalSetOrderingTest, MixedOperations) {
+  // Random operations keep the number of intervals moving back and forth
+  // across the point where they switch containers. The results are checked
+  // against a bitmap after every operation.
+  const int kNumValues = 2000;
+  QuicIntervalSet<int> iset;
+  std::vector<bool> reference(kNumValues, false);
+  uint32_t random = 1;
+  auto next_random = [&random](int limit) {
+    random = random * 1103515245 + 12345;
+    return static_cast<int>((random >> 8) % limit);
+  };
+  for (int i = 0; i < 5000; ++i) {
+    const int min = next_random(kNumValues);
+    const int max = std::min(kNumValues, min + 1 + next_random(8));
+    switch (next_random(8)) {
+      case 0:
+      case 1:
+      case 2:
+        iset.Add(min, max);
+        std::fill(reference.begin() + min, reference.begin() + max, true);
+        break;
+      case 3:
+        iset.Difference(min, max);
+        std::fill(reference.begin() + min, reference.begin() + max, false);
+        break;
+      case 4: {
+        QuicIntervalSet<int> other;
+        for (int j = min; j < max; j += 2) {
+          other.Add(j, j + 1);
+        }
+        iset.Difference(other);
+        for (int j = min; j < max; j += 2) {
+          reference[j] = false;
+        }
+        break;
+      }
+      case 5:
+        if (!iset.Empty() && iset.rbegin()->max() < kNumValues) {
+          const int last = iset.rbegin()->max();
+          iset.AddOptimizedForAppend(last, last + 1);
+          reference[last] = true;
+        }
+        break;
+      case 6:
+        if (next_random(50) == 0) {
+          iset.TrimLessThan(min);
+          std::fill(reference.begin(), reference.begin() + min, false);
+        }
+        break;
+      case 7:
+        if (iset.Size() > 1) {
+          const QuicInterval<int> first = *iset.begin();
+          iset.PopFront();
+          std::fill(reference.begin() + first.min(),
+                    reference.begin() + first.max(), false);
+        }
+        break;
+    }
+    ASSERT_THAT(iset, ElementsAreArray(ReferenceIntervals(reference)));
+    EXPECT_EQ(reference[min], iset.Contains(min));
+    EXPECT_EQ(reference[min], iset.Find(min) != iset.end());
+  }
+
+  // Copies, unions and intersections of large sets.
+  QuicIntervalSet<int> copy = iset;
+  EXPECT_EQ(iset, copy);
+  copy.Complement(0, kNumValues);
+  EXPECT_FALSE(copy.Intersects(iset));
+  copy.Union(iset);
+  EXPECT_TRUE(Check(copy, 1, 0, kNumValues));
+  copy.Intersection(iset);
+  EXPECT_EQ(iset, copy);
+}
+
+TEST(QuicIntervalSetOrderingTest, Adversarial) {
+  // Every other value arrives first, leaving the maximum number of holes,
+  // which are then filled from the back.
+  const int kNumValues = 1000;
+  QuicIntervalSet<int> iset;
+  std::vector<bool> reference(kNumValues, false);
+  for (int i = 0; i < kNumValues; i += 2) {
+    iset.Add(i, i + 1);
+    reference[i] = true;
+  }
+  EXPECT_EQ(static_cast<size_t>(kNumValues / 2), iset.Size());
+  EXPECT_THAT(iset, ElementsAreArray(ReferenceIntervals(reference)));
+
+  QuicIntervalSet<int> holes(0, kNumValues);
+  holes.Difference(iset);
+  EXPECT_EQ(static_cast<size_t>(kNumValues / 2), holes.Size());
+  EXPECT_FALSE(holes.Intersects(iset));
+
+  for (int i = kNumValues - 1; i > 0; i -= 2) {
+    iset.Add(i, i + 1);
+    reference[i] = true;
+    if (i % 100 == 1) {
+      EXPECT_THAT(iset, ElementsAreArray(ReferenceIntervals(reference)));
+    }
+  }
+  EXPECT_TRUE(Check(iset, 1, 0, kNumValues));
+
+  iset.Union(holes);
+  EXPECT_TRUE(Check(iset, 1, 0, kNumValues));
+  iset.Intersection(holes);
+  EXPECT_EQ(holes, iset);
+}
+
 // Helper method for testing and verifying the results of a one-interval
 // completement case.
 static bool CheckOneComplement(int add_min,
@@ -0,0 +1,128 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/third_party/quiche/src/quic/core/quic_latency_histogram.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "net/third_party/quiche/src/quic/platform/api/quic_logging.h"
+#include "net/third_party/quiche/src/common/platform/api/quiche_str_cat.h"
+
+namespace quic {
+
+namespace {
+
+// Each power of two from 32us up is split into 2^kSubBucketBits buckets.
+const size_t kSubBucketBits = 4;
+const size_t kNumSubBuckets = 1 << kSubBucketBits;
+// Values below 2 * kNumSubBuckets have a bucket each. Above that, there are
+// kNumSubBuckets buckets for each of the remaining powers of two.
+const size_t kNumBuckets =
+    2 * kNumSubBuckets +
+    (std::numeric_limits<uint64_t>::digits - kSubBucketBits - 1) *
+        kNumSubBuckets;
+
+}  // namespace
+
+QuicLatencyHistogram::QuicLatencyHistogram()
+    : buckets_(kNumBuckets, 0),
+      count_(0),
+      sum_us_(0),
+      min_us_(std::numeric_limits<uint64_t>::max()),
+      max_us_(0) {}
+
+// static
+size_t QuicLatencyHistogram::BucketIndex(uint64_t microseconds) {
+  if (microseconds < kNumSubBuckets) {
+    return microseconds;
+  }
+  // |exponent| is the position of the highest set bit, at least
+  // kSubBucketBits. The kSubBucketBits bits below it pick the sub-bucket.
+  size_t exponent = kSubBucketBits;
+  while ((microseconds >> exponent) > 1) {
+    ++exponent;
+  }
+  const size_t sub_bucket =
+      (microseconds >> (exponent - kSubBucketBits)) & (kNumSubBuckets - 1);
+  return (exponent - kSubBucketBits + 1) * kNumSubBuckets + sub_bucket;
+}
+
+// static
+uint64_t QuicLatencyHistogram::BucketUpperBound(size_t index) {
+  if (index < kNumSubBuckets) {
+    return index;
+  }
+  const size_t exponent = index / kNumSubBuckets + kSubBucketBits - 1;
+  const size_t sub_bucket = index % kNumSubBuckets;
+  const size_t width_bits = exponent - kSubBucketBits;
+  const uint64_t lower_bound =
+      static_cast<uint64_t>(kNumSubBuckets + sub_bucket) << width_bits;
+  return lower_bound + ((uint64_t{1} << width_bits) - 1);
+}
+
+void QuicLatencyHistogram::Add(QuicTime::Delta latency) {
+  const uint64_t microseconds =
+      std::max<int64_t>(latency.ToMicroseconds(), 0);
+  DCHECK_LT(BucketIndex(microseconds), buckets_.size());
+  ++buckets_[BucketIndex(microseconds)];
+  ++count_;
+  sum_us_ += microseconds;
+  min_us_ = std::min(min_us_, microseconds);
+  max_us_ = std::max(max_us_, microseconds);
+}
+
+void QuicLatencyHistogram::Merge(const QuicLatencyHistogram& other) {
+  for (size_t i = 0; i < buckets_.size(); ++i) {
+    buckets_[i] += other.buckets_[i];
+  }
+  count_ += other.count_;
+  sum_us_ += other.sum_us_;
+  min_us_ = std::min(min_us_, other.min_us_);
+  max_us_ = std::max(max_us_, other.max_us_);
+}
+
+QuicTime::Delta QuicLatencyHistogram::min() const {
+  return QuicTime::Delta::FromMicroseconds(count_ == 0 ? 0 : min_us_);
+}
+
+QuicTime::Delta QuicLatencyHistogram::max() const {
+  return QuicTime::Delta::FromMicroseconds(max_us_);
+}
+
+QuicTime::Delta QuicLatencyHistogram::Mean() const {
+  return QuicTime::Delta::FromMicroseconds(count_ == 0 ? 0 : sum_us_ / count_);
+}
+
+QuicTime::Delta QuicLatencyHistogram::Percentile(double percentile) const {
+  if (count_ == 0) {
+    return QuicTime::Delta::Zero();
+  }
+  percentile = std::min(std::max(percentile, 0.0), 100.0);
+  // The rank of the latency at |percentile|, counting from 1.
+  const uint64_t rank = std::max<uint64_t>(
+      1, static_cast<uint64_t>(std::ceil(percentile / 100 * count_)));
+  uint64_t seen = 0;
+  for (size_t i = 0; i < buckets_.size(); ++i) {
+    seen += buckets_[i];
+    if (seen >= rank) {
+      return QuicTime::Delta::FromMicroseconds(
+          std::min(BucketUpperBound(i), max_us_));
+    }
+  }
+  return max();
+}
+
+std::string QuicLatencyHistogram::ToString() const {
+  return quiche::QuicheStrCat(
+      "count: ", count_, ", mean: ", Mean().ToDebuggingValue(),
+      ", p50: ", Percentile(50).ToDebuggingValue(),
+      ", p90: ", Percentile(90).ToDebuggingValue(),
+      ", p99: ", Percentile(99).ToDebuggingValue(),
+      ", p99.9: ", Percentile(99.9).ToDebuggingValue(),
+      ", max: ", max().ToDebuggingValue());
+}
+
+}  // namespace quic
@@ -0,0 +1,61 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef QUICHE_QUIC_CORE_QUIC_LATENCY_HISTOGRAM_H_
+#define QUICHE_QUIC_CORE_QUIC_LATENCY_HISTOGRAM_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "net/third_party/quiche/src/quic/core/quic_time.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_export.h"
+
+namespace quic {
+
+// Records a distribution of latencies with microsecond resolution. Buckets are
+// 1us wide below 32us, and above that each power of two is split into 16
+// buckets, so percentiles are accurate to within 1/16 of their value whatever
+// their magnitude. Histograms of different threads can be merged.
+class QUIC_EXPORT_PRIVATE QuicLatencyHistogram {
+ public:
+  QuicLatencyHistogram();
+
+  // Records |latency|. Negative latencies are recorded as zero.
+  void Add(QuicTime::Delta latency);
+
+  // Adds the latencies recorded by |other| to this histogram.
+  void Merge(const QuicLatencyHistogram& other);
+
+  uint64_t count() const { return count_; }
+
+  // The smallest, largest and mean recorded latency, or zero if nothing has
+  // been recorded.
+  QuicTime::Delta min() const;
+  QuicTime::Delta max() const;
+  QuicTime::Delta Mean() const;
+
+  // Returns an upper bound of the |percentile|th percentile (in [0, 100]) of
+  // the recorded latencies, which is never more than max().
+  QuicTime::Delta Percentile(double percentile) const;
+
+  // Returns the count, mean, median, 90th, 99th and 99.9th percentiles and
+  // the maximum on one line.
+  std::string ToString() const;
+
+ private:
+  static size_t BucketIndex(uint64_t microseconds);
+  static uint64_t BucketUpperBound(size_t index);
+
+  std::vector<uint64_t> buckets_;
+  uint64_t count_;
+  uint64_t sum_us_;
+  uint64_t min_us_;
+  uint64_t max_us_;
+};
+
+}  // namespace quic
+
+#endif  // QUICHE_QUIC_CORE_QUIC_LATENCY_HISTOGRAM_H_
@@ -0,0 +1,96 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/third_party/quiche/src/quic/core/quic_latency_histogram.h"
+
+#include <cstdint>
+
+#include "net/third_party/quiche/src/quic/platform/api/quic_test.h"
+
+namespace quic {
+namespace test {
+namespace {
+
+QuicTime::Delta Us(int64_t microseconds) {
+  return QuicTime::Delta::FromMicroseconds(microseconds);
+}
+
+class QuicLatencyHistogramTest : public QuicTest {};
+
+TEST_F(QuicLatencyHistogramTest, Empty) {
+  QuicLatencyHistogram histogram;
+  EXPECT_EQ(0u, histogram.count());
+  EXPECT_EQ(Us(0), histogram.min());
+  EXPECT_EQ(Us(0), histogram.max());
+  EXPECT_EQ(Us(0), histogram.Mean());
+  EXPECT_EQ(Us(0), histogram.Percentile(50));
+}
+
+TEST_F(QuicLatencyHistogramTest, SmallValuesAreExact) {
+  QuicLatencyHistogram histogram;
+  for (int64_t i = 1; i <= 20; ++i) {
+    histogram.Add(Us(i));
+  }
+  EXPECT_EQ(20u, histogram.count());
+  EXPECT_EQ(Us(1), histogram.min());
+  EXPECT_EQ(Us(20), histogram.max());
+  EXPECT_EQ(Us(10), histogram.Mean());
+  EXPECT_EQ(Us(1), histogram.Percentile(0));
+  EXPECT_EQ(Us(10), histogram.Percentile(50));
+  EXPECT_EQ(Us(18), histogram.Percentile(90));
+  EXPECT_EQ(Us(20), histogram.Percentile(100));
+}
+
+TEST_F(QuicLatencyHistogramTest, LargeValuesAreWithinOneSixteenth) {
+  const int64_t kValues[] = {100,       1000,          12345,
+                             999999,    7654321,       123456789,
+                             987654321, 1000000000000, int64_t{1} << 62};
+  for (int64_t value : kValues) {
+    QuicLatencyHistogram histogram;
+    histogram.Add(Us(1));
+    histogram.Add(Us(value));
+    histogram.Add(Us(value + 1000000));
+    const int64_t median = histogram.Percentile(50).ToMicroseconds();
+    EXPECT_LE(value, median);
+    EXPECT_LE(median - value, value / 16) << value;
+  }
+}
+
+TEST_F(QuicLatencyHistogramTest, PercentileNeverExceedsMax) {
+  QuicLatencyHistogram histogram;
+  histogram.Add(Us(1000));
+  EXPECT_EQ(Us(1000), histogram.Percentile(99.9));
+}
+
+TEST_F(QuicLatencyHistogramTest, NegativeLatenciesAreZero) {
+  QuicLatencyHistogram histogram;
+  histogram.Add(Us(-5));
+  EXPECT_EQ(1u, histogram.count());
+  EXPECT_EQ(Us(0), histogram.max());
+}
+
+TEST_F(QuicLatencyHistogramTest, Merge) {
+  QuicLatencyHistogram a;
+  QuicLatencyHistogram b;
+  for (int64_t i = 1; i <= 10; ++i) {
+    a.Add(Us(i));
+    b.Add(Us(i + 10));
+  }
+  a.Merge(b);
+  EXPECT_EQ(20u, a.count());
+  EXPECT_EQ(Us(1), a.min());
+  EXPECT_EQ(Us(20), a.max());
+  EXPECT_EQ(Us(10), a.Percentile(50));
+
+  QuicLatencyHistogram empty;
+  a.Merge(empty);
+  EXPECT_EQ(Us(1), a.min());
+  empty.Merge(a);
+  EXPECT_EQ(Us(1), empty.min());
+  EXPECT_EQ(20u, empty.count());
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace quic
@@ -0,0 +1,153 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/third_party/quiche/src/quic/core/quic_packet_classifier.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "net/third_party/quiche/src/quic/core/quic_constants.h"
+#include "net/third_party/quiche/src/quic/core/quic_utils.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_logging.h"
+#include "net/third_party/quiche/src/common/platform/api/quiche_string_piece.h"
+
+namespace quic {
+
+namespace {
+
+const uint8_t kMaxCounter = std::numeric_limits<uint8_t>::max();
+
+}  // namespace
+
+QuicPacketClassifier::QuicPacketClassifier(const Config& config)
+    : counters_(size_t{1} << config.filter_size_log2, 0),
+      counter_mask_((size_t{1} << config.filter_size_log2) - 1),
+      token_period_(QuicTime::Delta::Zero()),
+      burst_period_(QuicTime::Delta::Zero()),
+      num_malformed_packets_dropped_(0),
+      num_rate_limited_packets_dropped_(0) {
+  DCHECK_GT(config.filter_size_log2, 0);
+  DCHECK_LT(config.filter_size_log2, 32);
+  if (config.unknown_packets_per_second > 0) {
+    DCHECK_GT(config.unknown_packets_burst, 0);
+    DCHECK_GT(config.num_source_buckets, 0u);
+    token_period_ = QuicTime::Delta::FromMicroseconds(std::max<int64_t>(
+        1, static_cast<int64_t>(kNumMicrosPerSecond) /
+               config.unknown_packets_per_second));
+    burst_period_ = token_period_ * config.unknown_packets_burst;
+    source_buckets_.assign(config.num_source_buckets, QuicTime::Zero());
+  }
+}
+
+QuicPacketClassifier::~QuicPacketClassifier() = default;
+
+QuicPacketClassifier::Verdict QuicPacketClassifier::Classify(
+    const QuicSocketAddress& peer_address,
+    const QuicReceivedPacket& packet,
+    uint8_t expected_server_connection_id_length,
+    QuicTime now,
+    QuicConnectionId* destination_connection_id) {
+  // Port zero is only allowed for unidirectional UDP, so is disallowed by QUIC.
+  if (packet.length() == 0 || peer_address.port() == 0) {
+    ++num_malformed_packets_dropped_;
+    return DROP;
+  }
+  const uint8_t first_byte = static_cast<uint8_t>(packet.data()[0]);
+  if (QuicUtils::IsIetfPacketShortHeader(first_byte)) {
+    if (packet.length() < 1u + expected_server_connection_id_length) {
+      // The full path would fail to read the destination connection ID.
+      ++num_malformed_packets_dropped_;
+      return DROP;
+    }
+    *destination_connection_id = QuicConnectionId(
+        packet.data() + 1, expected_server_connection_id_length);
+    if (MayContainConnectionId(*destination_connection_id)) {
+      return MAYBE_KNOWN_CONNECTION_ID;
+    }
+    // The connection ID is certainly unknown, so the packet is limited before
+    // anyone pays for parsing it.
+    if (!AllowUnknownPacket(peer_address.host(), now)) {
+      return DROP;
+    }
+  }
+  return PROCESS_FULL_HEADER;
+}
+
+void QuicPacketClassifier::AddConnectionId(QuicConnectionId connection_id) {
+  size_t index1;
+  size_t index2;
+  GetCounterIndices(connection_id, &index1, &index2);
+  if (counters_[index1] < kMaxCounter) {
+    ++counters_[index1];
+  }
+  if (counters_[index2] < kMaxCounter) {
+    ++counters_[index2];
+  }
+}
+
+void QuicPacketClassifier::RemoveConnectionId(QuicConnectionId connection_id) {
+  size_t index1;
+  size_t index2;
+  GetCounterIndices(connection_id, &index1, &index2);
+  DCHECK_LT(0u, counters_[index1]);
+  DCHECK_LT(0u, counters_[index2]);
+  if (counters_[index1] > 0 && counters_[index1] < kMaxCounter) {
+    --counters_[index1];
+  }
+  if (counters_[index2] > 0 && counters_[index2] < kMaxCounter) {
+    --counters_[index2];
+  }
+}
+
+bool QuicPacketClassifier::MayContainConnectionId(
+    QuicConnectionId connection_id) const {
+  size_t index1;
+  size_t index2;
+  GetCounterIndices(connection_id, &index1, &index2);
+  return counters_[index1] != 0 && counters_[index2] != 0;
+}
+
+void QuicPacketClassifier::GetCounterIndices(QuicConnectionId connection_id,
+                                             size_t* index1,
+                                             size_t* index2) const {
+  const uint64_t hash = connection_id.Hash();
+  *index1 = hash & counter_mask_;
+  // Derive the second index from the bits the first one does not use.
+  *index2 = ((hash * UINT64_C(0x9e3779b97f4a7c15)) >> 32) & counter_mask_;
+}
+
+bool QuicPacketClassifier::AllowUnknownPacket(const QuicIpAddress& peer_address,
+                                              QuicTime now) {
+  if (source_buckets_.empty()) {
+    return true;
+  }
+  QuicTime& full_time = source_buckets_[GetSourceBucketIndex(peer_address)];
+  if (full_time < now) {
+    full_time = now;
+  }
+  if (full_time - now + token_period_ > burst_period_) {
+    ++num_rate_limited_packets_dropped_;
+    return false;
+  }
+  full_time = full_time + token_period_;
+  return true;
+}
+
+size_t QuicPacketClassifier::GetSourceBucketIndex(
+    const QuicIpAddress& peer_address) const {
+  uint64_t hash = 0;
+  if (peer_address.IsIPv4()) {
+    const in_addr address = peer_address.GetIPv4();
+    hash = QuicUtils::FNV1a_64_Hash(quiche::QuicheStringPiece(
+        reinterpret_cast<const char*>(&address), sizeof(address)));
+  } else if (peer_address.IsIPv6()) {
+    // Hosts commonly get a whole /64, so only the prefix identifies them.
+    const in6_addr address = peer_address.GetIPv6();
+    hash = QuicUtils::FNV1a_64_Hash(
+        quiche::QuicheStringPiece(reinterpret_cast<const char*>(&address), 8));
+  }
+  return hash % source_buckets_.size();
+}
+
+}  // namespace quic
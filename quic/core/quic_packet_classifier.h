@@ -0,0 +1,138 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef QUICHE_QUIC_CORE_QUIC_PACKET_CLASSIFIER_H_
+#define QUICHE_QUIC_CORE_QUIC_PACKET_CLASSIFIER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "net/third_party/quiche/src/quic/core/quic_connection_id.h"
+#include "net/third_party/quiche/src/quic/core/quic_packets.h"
+#include "net/third_party/quiche/src/quic/core/quic_time.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_export.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_ip_address.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_socket_address.h"
+
+namespace quic {
+
+// Decides the fate of a received packet from its first bytes, before the
+// dispatcher parses its public header.
+//
+// IETF short header packets carry no version and make up nearly all traffic
+// of established connections. Their destination connection ID is read at its
+// expected length and checked against a counting filter of the connection IDs
+// of sessions and of connections in time wait state, so only packets which
+// may belong to one of them are looked up.
+//
+// The filter has no false negatives, and short header packets cannot create
+// connections, so a short header packet which misses the filter can at most
+// elicit a stateless reset. Such packets are subject to AllowUnknownPacket()
+// right away, before the dispatcher parses them, which optionally limits them
+// with a token bucket per source address.
+//
+// All other packets go through the full dispatcher path. Long header and gQUIC
+// packets may still belong to a session, so the dispatcher only consults
+// AllowUnknownPacket() once such a packet has missed both the session map and
+// the time wait list.
+class QUIC_EXPORT_PRIVATE QuicPacketClassifier {
+ public:
+  struct QUIC_EXPORT_PRIVATE Config {
+    // The connection ID filter has 2^|filter_size_log2| one byte counters. It
+    // should have several counters per session and time wait entry to keep
+    // false positives rare.
+    int filter_size_log2 = 20;
+    // Rate and burst of the packets accepted from each source address whose
+    // connection ID is neither in the session map nor in time wait state. A
+    // rate of 0 disables the limit.
+    int64_t unknown_packets_per_second = 0;
+    int unknown_packets_burst = 64;
+    // Number of token buckets. Source addresses hash into buckets, so
+    // addresses sharing a bucket share its rate. IPv6 addresses are limited
+    // by their /64 prefix.
+    size_t num_source_buckets = 4096;
+  };
+
+  enum Verdict {
+    // Drop the packet without further processing.
+    DROP = 0,
+    // The packet is an IETF short header packet whose destination connection
+    // ID may belong to a session or to a connection in time wait state.
+    MAYBE_KNOWN_CONNECTION_ID,
+    // The packet has to go through the full dispatcher path. Short header
+    // packets only get this verdict once they have passed
+    // AllowUnknownPacket().
+    PROCESS_FULL_HEADER,
+  };
+
+  explicit QuicPacketClassifier(const Config& config);
+  QuicPacketClassifier(const QuicPacketClassifier&) = delete;
+  QuicPacketClassifier& operator=(const QuicPacketClassifier&) = delete;
+  ~QuicPacketClassifier();
+
+  // Classifies |packet| received from |peer_address| at |now|. For short
+  // header packets, the destination connection ID is read at
+  // |expected_server_connection_id_length| and populated in
+  // |destination_connection_id| when MAYBE_KNOWN_CONNECTION_ID is returned.
+  Verdict Classify(const QuicSocketAddress& peer_address,
+                   const QuicReceivedPacket& packet,
+                   uint8_t expected_server_connection_id_length,
+                   QuicTime now,
+                   QuicConnectionId* destination_connection_id);
+
+  // Returns true if a packet whose connection ID is neither in the session
+  // map nor in time wait state may be processed when received from
+  // |peer_address| at |now|, and consumes a token if so.
+  bool AllowUnknownPacket(const QuicIpAddress& peer_address, QuicTime now);
+
+  // Adds |connection_id| to the filter. Connection IDs may be added more than
+  // once, and each addition must be matched by a removal.
+  void AddConnectionId(QuicConnectionId connection_id);
+
+  // Removes one addition of |connection_id| from the filter.
+  void RemoveConnectionId(QuicConnectionId connection_id);
+
+  // Returns false if |connection_id| has certainly not been added.
+  bool MayContainConnectionId(QuicConnectionId connection_id) const;
+
+  // Number of packets dropped because they were too short to hold a header.
+  uint64_t num_malformed_packets_dropped() const {
+    return num_malformed_packets_dropped_;
+  }
+
+  // Number of packets dropped by the per source address rate limit.
+  uint64_t num_rate_limited_packets_dropped() const {
+    return num_rate_limited_packets_dropped_;
+  }
+
+ private:
+  // Populates the indices of the two filter counters of |connection_id|.
+  void GetCounterIndices(QuicConnectionId connection_id,
+                         size_t* index1,
+                         size_t* index2) const;
+
+  // Returns the token bucket of |peer_address|.
+  size_t GetSourceBucketIndex(const QuicIpAddress& peer_address) const;
+
+  // Counting filter. A counter which reaches its maximum stays there, since
+  // the number of additions it stands for is no longer known.
+  std::vector<uint8_t> counters_;
+  size_t counter_mask_;
+
+  // Token buckets kept as the time at which each bucket will be full again,
+  // which makes a bucket a single QuicTime. Each allowed packet pushes that
+  // time ahead by |token_period_|, and a packet is allowed only if this leaves
+  // it no more than |burst_period_| ahead of now.
+  std::vector<QuicTime> source_buckets_;
+  QuicTime::Delta token_period_;
+  QuicTime::Delta burst_period_;
+
+  uint64_t num_malformed_packets_dropped_;
+  uint64_t num_rate_limited_packets_dropped_;
+};
+
+}  // namespace quic
+
+#endif  // QUICHE_QUIC_CORE_QUIC_PACKET_CLASSIFIER_H_
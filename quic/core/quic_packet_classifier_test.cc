@@ -0,0 +1,151 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/third_party/quiche/src/quic/core/quic_packet_classifier.h"
+
+#include <string>
+
+#include "net/third_party/quiche/src/quic/platform/api/quic_test.h"
+#include "net/third_party/quiche/src/quic/test_tools/quic_test_utils.h"
+
+namespace quic {
+namespace test {
+namespace {
+
+// First bytes of an IETF short header packet and of an IETF long header
+// packet.
+const char kShortHeaderByte = 0x43;
+const char kLongHeaderByte = static_cast<char>(0xc3);
+
+class QuicPacketClassifierTest : public QuicTest {
+ protected:
+  QuicPacketClassifierTest()
+      : peer_address_(QuicIpAddress::Loopback4(), 443),
+        now_(QuicTime::Zero() + QuicTime::Delta::FromSeconds(1)) {
+    config_.filter_size_log2 = 10;
+  }
+
+  // Returns a packet starting with |first_byte| followed by |connection_id|
+  // and some payload.
+  std::string PacketFor(char first_byte, QuicConnectionId connection_id) {
+    return std::string(1, first_byte) +
+           std::string(connection_id.data(), connection_id.length()) +
+           std::string(20, 'p');
+  }
+
+  QuicPacketClassifier::Verdict Classify(QuicPacketClassifier* classifier,
+                                         const std::string& data) {
+    QuicReceivedPacket packet(data.data(), data.length(), now_);
+    return classifier->Classify(peer_address_, packet,
+                                kQuicDefaultConnectionIdLength, now_,
+                                &connection_id_);
+  }
+
+  QuicPacketClassifier::Config config_;
+  QuicSocketAddress peer_address_;
+  QuicTime now_;
+  QuicConnectionId connection_id_;
+};
+
+TEST_F(QuicPacketClassifierTest, ShortHeaderPackets) {
+  QuicPacketClassifier classifier(config_);
+  EXPECT_EQ(QuicPacketClassifier::PROCESS_FULL_HEADER,
+            Classify(&classifier,
+                     PacketFor(kShortHeaderByte, TestConnectionId(1))));
+
+  classifier.AddConnectionId(TestConnectionId(1));
+  EXPECT_EQ(QuicPacketClassifier::MAYBE_KNOWN_CONNECTION_ID,
+            Classify(&classifier,
+                     PacketFor(kShortHeaderByte, TestConnectionId(1))));
+  EXPECT_EQ(TestConnectionId(1), connection_id_);
+
+  // Long header packets always go through the full path.
+  EXPECT_EQ(QuicPacketClassifier::PROCESS_FULL_HEADER,
+            Classify(&classifier,
+                     PacketFor(kLongHeaderByte, TestConnectionId(1))));
+
+  // Short header packets too short to hold a connection ID are dropped.
+  EXPECT_EQ(QuicPacketClassifier::DROP,
+            Classify(&classifier, std::string(5, kShortHeaderByte)));
+  EXPECT_EQ(1u, classifier.num_malformed_packets_dropped());
+}
+
+TEST_F(QuicPacketClassifierTest, CountingFilter) {
+  QuicPacketClassifier classifier(config_);
+  classifier.AddConnectionId(TestConnectionId(1));
+  classifier.AddConnectionId(TestConnectionId(1));
+  classifier.AddConnectionId(TestConnectionId(2));
+  EXPECT_TRUE(classifier.MayContainConnectionId(TestConnectionId(1)));
+  EXPECT_TRUE(classifier.MayContainConnectionId(TestConnectionId(2)));
+
+  classifier.RemoveConnectionId(TestConnectionId(1));
+  EXPECT_TRUE(classifier.MayContainConnectionId(TestConnectionId(1)));
+  classifier.RemoveConnectionId(TestConnectionId(1));
+  classifier.RemoveConnectionId(TestConnectionId(2));
+  EXPECT_FALSE(classifier.MayContainConnectionId(TestConnectionId(1)));
+  EXPECT_FALSE(classifier.MayContainConnectionId(TestConnectionId(2)));
+}
+
+TEST_F(QuicPacketClassifierTest, RateLimitsUnknownPackets) {
+  config_.unknown_packets_per_second = 10;
+  config_.unknown_packets_burst = 3;
+  QuicPacketClassifier classifier(config_);
+
+  const QuicIpAddress source = QuicIpAddress::Loopback4();
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_TRUE(classifier.AllowUnknownPacket(source, now_));
+  }
+  EXPECT_FALSE(classifier.AllowUnknownPacket(source, now_));
+  EXPECT_EQ(1u, classifier.num_rate_limited_packets_dropped());
+
+  // Packets from other sources are not limited.
+  EXPECT_TRUE(classifier.AllowUnknownPacket(QuicIpAddress::Loopback6(), now_));
+
+  // The bucket refills at the configured rate.
+  now_ = now_ + QuicTime::Delta::FromMilliseconds(100);
+  EXPECT_TRUE(classifier.AllowUnknownPacket(source, now_));
+  EXPECT_FALSE(classifier.AllowUnknownPacket(source, now_));
+}
+
+TEST_F(QuicPacketClassifierTest, ClassifyRateLimitsUnknownShortHeaders) {
+  config_.unknown_packets_per_second = 10;
+  config_.unknown_packets_burst = 1;
+  QuicPacketClassifier classifier(config_);
+  classifier.AddConnectionId(TestConnectionId(1));
+
+  // Whether a long header packet belongs to a connection is only known to the
+  // dispatcher, and short header packets which hit the filter may belong to
+  // one, so Classify() leaves them alone.
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_EQ(QuicPacketClassifier::PROCESS_FULL_HEADER,
+              Classify(&classifier,
+                       PacketFor(kLongHeaderByte, TestConnectionId(2))));
+    EXPECT_EQ(QuicPacketClassifier::MAYBE_KNOWN_CONNECTION_ID,
+              Classify(&classifier,
+                       PacketFor(kShortHeaderByte, TestConnectionId(1))));
+  }
+  EXPECT_EQ(0u, classifier.num_rate_limited_packets_dropped());
+
+  // Short header packets which miss the filter are certainly unknown.
+  EXPECT_EQ(QuicPacketClassifier::PROCESS_FULL_HEADER,
+            Classify(&classifier,
+                     PacketFor(kShortHeaderByte, TestConnectionId(2))));
+  EXPECT_EQ(QuicPacketClassifier::DROP,
+            Classify(&classifier,
+                     PacketFor(kShortHeaderByte, TestConnectionId(3))));
+  EXPECT_EQ(1u, classifier.num_rate_limited_packets_dropped());
+  EXPECT_EQ(0u, classifier.num_malformed_packets_dropped());
+}
+
+TEST_F(QuicPacketClassifierTest, DropsPacketsFromPortZero) {
+  QuicPacketClassifier classifier(config_);
+  peer_address_ = QuicSocketAddress(QuicIpAddress::Loopback4(), 0);
+  EXPECT_EQ(QuicPacketClassifier::DROP,
+            Classify(&classifier,
+                     PacketFor(kLongHeaderByte, TestConnectionId(1))));
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace quic
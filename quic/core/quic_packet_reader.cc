@@ -4,6 +4,8 @@
 
 #include "net/third_party/quiche/src/quic/core/quic_packet_reader.h"
 
+#include <algorithm>
+
 #include "net/third_party/quiche/src/quic/core/quic_packets.h"
 #include "net/third_party/quiche/src/quic/core/quic_process_packet_interface.h"
 #include "net/third_party/quiche/src/quic/platform/api/quic_bug_tracker.h"
@@ -17,22 +19,52 @@
 
 namespace quic {
 
+namespace {
+
+// Number of unreferenced buffers the pool keeps around for reuse, as a
+// multiple of the number of buffers needed for one read.
+const size_t kFreeReceiveBuffersPerReadBuffer = 4;
+
+}  // namespace
+
 QuicPacketReader::QuicPacketReader()
-    : read_buffers_(kNumPacketsPerReadMmsgCall),
-      read_results_(kNumPacketsPerReadMmsgCall) {
-  DCHECK_EQ(read_buffers_.size(), read_results_.size());
-  for (size_t i = 0; i < read_results_.size(); ++i) {
-    read_results_[i].packet_buffer.buffer = read_buffers_[i].packet_buffer;
-    read_results_[i].packet_buffer.buffer_len =
-        sizeof(read_buffers_[i].packet_buffer);
+    : udp_gro_enabled_(false),
+      buffer_pool_(std::make_unique<QuicReceiveBufferPool>(
+          kMaxIncomingPacketSize,
+          kDefaultUdpPacketControlBufferSize,
+          kFreeReceiveBuffersPerReadBuffer * kNumPacketsPerReadMmsgCall)),
+      read_buffers_(kNumPacketsPerReadMmsgCall),
+      read_results_(kNumPacketsPerReadMmsgCall) {}
+
+QuicPacketReader::~QuicPacketReader() = default;
 
-    read_results_[i].control_buffer.buffer = read_buffers_[i].control_buffer;
-    read_results_[i].control_buffer.buffer_len =
-        sizeof(read_buffers_[i].control_buffer);
+void QuicPacketReader::EnableUdpGro() {
+  if (udp_gro_enabled()) {
+    return;
   }
+  udp_gro_enabled_ = true;
+  // Buffers from the old pool which are still referenced outlive it.
+  read_buffers_.clear();
+  buffer_pool_ = std::make_unique<QuicReceiveBufferPool>(
+      kMaxUdpGroPacketSize, kDefaultUdpPacketControlBufferSize,
+      kFreeReceiveBuffersPerReadBuffer * kNumGroBuffersPerReadMmsgCall);
+  read_buffers_.resize(kNumGroBuffersPerReadMmsgCall);
+  read_results_.resize(kNumGroBuffersPerReadMmsgCall);
 }
 
-QuicPacketReader::~QuicPacketReader() = default;
+void QuicPacketReader::PrepareReadBuffers() {
+  DCHECK_EQ(read_buffers_.size(), read_results_.size());
+  for (size_t i = 0; i < read_results_.size(); ++i) {
+    QuicReceiveBufferReference& buffer = read_buffers_[i];
+    if (!buffer || buffer->ref_count() > 1) {
+      buffer = buffer_pool_->Acquire();
+    }
+    read_results_[i].Reset(buffer->packet_buffer_size());
+    read_results_[i].packet_buffer.buffer = buffer->packet_buffer();
+    read_results_[i].control_buffer.buffer = buffer->control_buffer();
+    read_results_[i].control_buffer.buffer_len = buffer->control_buffer_size();
+  }
+}
 
 bool QuicPacketReader::ReadAndDispatchPackets(
     int fd,
@@ -41,10 +73,7 @@ bool QuicPacketReader::ReadAndDispatchPackets(
     ProcessPacketInterface* processor,
     QuicPacketCount* /*packets_dropped*/) {
   // Reset all read_results for reuse.
-  for (size_t i = 0; i < read_results_.size(); ++i) {
-    read_results_[i].Reset(
-        /*packet_buffer_length=*/sizeof(read_buffers_[i].packet_buffer));
-  }
+  PrepareReadBuffers();
 
   // Use clock.Now() as the packet receipt time, the time between packet
   // arriving at the host and now is considered part of the network delay.
@@ -57,7 +86,8 @@ bool QuicPacketReader::ReadAndDispatchPackets(
                 QuicUdpPacketInfoBit::V4_SELF_IP,
                 QuicUdpPacketInfoBit::V6_SELF_IP,
                 QuicUdpPacketInfoBit::RECV_TIMESTAMP, QuicUdpPacketInfoBit::TTL,
-                QuicUdpPacketInfoBit::GOOGLE_PACKET_HEADER),
+                QuicUdpPacketInfoBit::GOOGLE_PACKET_HEADER,
+                QuicUdpPacketInfoBit::GRO_SEGMENT_SIZE),
       &read_results_);
   for (size_t i = 0; i < packets_read; ++i) {
     auto& result = read_results_[i];
@@ -97,17 +127,34 @@ bool QuicPacketReader::ReadAndDispatchPackets(
       QUIC_CODE_COUNT(quic_packet_reader_no_google_packet_header);
     }
 
-    QuicReceivedPacket packet(
-        result.packet_buffer.buffer, result.packet_buffer.buffer_len, now,
-        /*owns_buffer=*/false, ttl, has_ttl, headers, headers_length,
-        /*owns_header_buffer=*/false);
+    // Without UDP GRO, or if the kernel did not coalesce anything, the buffer
+    // holds exactly one packet.
+    const size_t buffer_length = result.packet_buffer.buffer_len;
+    size_t segment_size = buffer_length;
+    if (result.packet_info.HasValue(QuicUdpPacketInfoBit::GRO_SEGMENT_SIZE) &&
+        result.packet_info.gro_segment_size() > 0) {
+      segment_size = result.packet_info.gro_segment_size();
+      QUIC_CODE_COUNT(quic_packet_reader_gro_buffer_read);
+    }
 
+    // A GRO buffer is far larger than the packets it holds, so retaining one
+    // to keep a single packet would pin more memory than copying it.
+    QuicReceiveBufferReference receive_buffer;
+    if (!udp_gro_enabled()) {
+      receive_buffer = read_buffers_[i];
+    }
     QuicSocketAddress self_address(self_ip, port);
-    processor->ProcessPacket(self_address, peer_address, packet);
+    for (size_t offset = 0; offset < buffer_length; offset += segment_size) {
+      QuicReceivedPacket packet(result.packet_buffer.buffer + offset,
+                                std::min(segment_size, buffer_length - offset),
+                                now, ttl, has_ttl, headers, headers_length,
+                                receive_buffer);
+      processor->ProcessPacket(self_address, peer_address, packet);
+    }
   }
 
   // We may not have read all of the packets available on the socket.
-  return packets_read == kNumPacketsPerReadMmsgCall;
+  return packets_read == read_results_.size();
 }
 
 // static
@@ -7,11 +7,14 @@
 #ifndef QUICHE_QUIC_CORE_QUIC_PACKET_READER_H_
 #define QUICHE_QUIC_CORE_QUIC_PACKET_READER_H_
 
+#include <memory>
+#include <vector>
+
 #include "net/third_party/quiche/src/quic/core/quic_clock.h"
 #include "net/third_party/quiche/src/quic/core/quic_packets.h"
 #include "net/third_party/quiche/src/quic/core/quic_process_packet_interface.h"
+#include "net/third_party/quiche/src/quic/core/quic_receive_buffer_pool.h"
 #include "net/third_party/quiche/src/quic/core/quic_udp_socket.h"
-#include "net/third_party/quiche/src/quic/platform/api/quic_aligned.h"
 #include "net/third_party/quiche/src/quic/platform/api/quic_flags.h"
 #include "net/third_party/quiche/src/quic/platform/api/quic_socket_address.h"
 
@@ -20,6 +23,10 @@ namespace quic {
 // Read in larger batches to minimize recvmmsg overhead.
 const int kNumPacketsPerReadMmsgCall = 16;
 
+// Number of coalesced buffers to read per recvmmsg call when UDP GRO is
+// enabled. Each buffer may hold dozens of packets.
+const int kNumGroBuffersPerReadMmsgCall = 4;
+
 class QUIC_EXPORT_PRIVATE QuicPacketReader {
  public:
   QuicPacketReader();
@@ -41,7 +48,19 @@ class QUIC_EXPORT_PRIVATE QuicPacketReader {
                                       ProcessPacketInterface* processor,
                                       QuicPacketCount* packets_dropped);
 
- private:
+  // Switches the reader to read coalesced UDP GRO buffers, which are split
+  // into individual packets before being passed to the
+  // ProcessPacketInterface. The sockets passed to ReadAndDispatchPackets
+  // should have been set up with QuicUdpSocketApi::EnableUdpGro.
+  void EnableUdpGro();
+
+  bool udp_gro_enabled() const { return udp_gro_enabled_; }
+
+  // The pool which packets are read into. Dispatched packets refer to their
+  // receive buffer, so one which is retained, for instance by
+  // QuicReceivedPacket::Clone(), takes a reference instead of a copy.
+  const QuicReceiveBufferPool& buffer_pool() const { return *buffer_pool_; }
+
   // Return the self ip from |packet_info|.
   // For dual stack sockets, |packet_info| may contain both a v4 and a v6 ip, in
   // that case, |prefer_v6_ip| is used to determine which one is used as the
@@ -50,15 +69,16 @@ class QUIC_EXPORT_PRIVATE QuicPacketReader {
       const QuicUdpPacketInfo& packet_info,
       bool prefer_v6_ip);
 
-  struct QUIC_EXPORT_PRIVATE ReadBuffer {
-    QUIC_CACHELINE_ALIGNED char
-        control_buffer[kDefaultUdpPacketControlBufferSize];  // For ancillary
-                                                             // data.
-    QUIC_CACHELINE_ALIGNED char packet_buffer[kMaxIncomingPacketSize];
-  };
+ private:
+  // Points |read_results_| at buffers from |buffer_pool_|, replacing any
+  // which are still referenced by packets from the previous read.
+  void PrepareReadBuffers();
 
   QuicUdpSocketApi socket_api_;
-  std::vector<ReadBuffer> read_buffers_;
+  bool udp_gro_enabled_;
+  std::unique_ptr<QuicReceiveBufferPool> buffer_pool_;
+  // The buffer backing each of |read_results_|.
+  std::vector<QuicReceiveBufferReference> read_buffers_;
   QuicUdpSocketApi::ReadPacketResults read_results_;
 };
 
@@ -338,7 +338,19 @@ QuicEncryptedPacket::QuicEncryptedPacket(const char* buffer,
 QuicEncryptedPacket::QuicEncryptedPacket(quiche::QuicheStringPiece data)
     : QuicData(data) {}
 
+QuicEncryptedPacket::QuicEncryptedPacket(
+    const char* buffer,
+    size_t length,
+    QuicReceiveBufferReference receive_buffer)
+    : QuicData(buffer, length), receive_buffer_(std::move(receive_buffer)) {
+  DCHECK(!receive_buffer_ || receive_buffer_->Contains(buffer, length));
+}
+
 std::unique_ptr<QuicEncryptedPacket> QuicEncryptedPacket::Clone() const {
+  if (receive_buffer_) {
+    return std::make_unique<QuicEncryptedPacket>(this->data(), this->length(),
+                                                 receive_buffer_);
+  }
   char* buffer = new char[this->length()];
   memcpy(buffer, this->data(), this->length());
   return std::make_unique<QuicEncryptedPacket>(buffer, this->length(), true);
@@ -400,6 +412,25 @@ QuicReceivedPacket::QuicReceivedPacket(const char* buffer,
       headers_length_(headers_length),
       owns_header_buffer_(owns_header_buffer) {}
 
+QuicReceivedPacket::QuicReceivedPacket(
+    const char* buffer,
+    size_t length,
+    QuicTime receipt_time,
+    int ttl,
+    bool ttl_valid,
+    char* packet_headers,
+    size_t headers_length,
+    QuicReceiveBufferReference receive_buffer)
+    : QuicEncryptedPacket(buffer, length, std::move(receive_buffer)),
+      receipt_time_(receipt_time),
+      ttl_(ttl_valid ? ttl : -1),
+      packet_headers_(packet_headers),
+      headers_length_(headers_length),
+      owns_header_buffer_(false) {
+  DCHECK(packet_headers == nullptr || !this->receive_buffer() ||
+         this->receive_buffer()->Contains(packet_headers, headers_length));
+}
+
 QuicReceivedPacket::~QuicReceivedPacket() {
   if (owns_header_buffer_) {
     delete[] static_cast<char*>(packet_headers_);
@@ -407,6 +438,15 @@ QuicReceivedPacket::~QuicReceivedPacket() {
 }
 
 std::unique_ptr<QuicReceivedPacket> QuicReceivedPacket::Clone() const {
+  if (receive_buffer()) {
+    return std::make_unique<QuicReceivedPacket>(
+        this->data(), this->length(), receipt_time(), ttl(), ttl() >= 0,
+        this->packet_headers(), this->headers_length(), receive_buffer());
+  }
+  return CopyToHeap();
+}
+
+std::unique_ptr<QuicReceivedPacket> QuicReceivedPacket::CopyToHeap() const {
   char* buffer = new char[this->length()];
   memcpy(buffer, this->data(), this->length());
   if (this->packet_headers()) {
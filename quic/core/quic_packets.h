@@ -19,6 +19,7 @@
 #include "net/third_party/quiche/src/quic/core/quic_bandwidth.h"
 #include "net/third_party/quiche/src/quic/core/quic_constants.h"
 #include "net/third_party/quiche/src/quic/core/quic_error_codes.h"
+#include "net/third_party/quiche/src/quic/core/quic_receive_buffer_pool.h"
 #include "net/third_party/quiche/src/quic/core/quic_time.h"
 #include "net/third_party/quiche/src/quic/core/quic_types.h"
 #include "net/third_party/quiche/src/quic/core/quic_versions.h"
@@ -280,13 +281,24 @@ class QUIC_EXPORT_PRIVATE QuicEncryptedPacket : public QuicData {
   // Creates a QuicEncryptedPacket from a quiche::QuicheStringPiece.
   // Does not own the buffer.
   QuicEncryptedPacket(quiche::QuicheStringPiece data);
+  // Creates a QuicEncryptedPacket from a buffer and length which lie within
+  // |receive_buffer|, holding a reference to it.
+  QuicEncryptedPacket(const char* buffer,
+                      size_t length,
+                      QuicReceiveBufferReference receive_buffer);
 
   QuicEncryptedPacket(const QuicEncryptedPacket&) = delete;
   QuicEncryptedPacket& operator=(const QuicEncryptedPacket&) = delete;
 
-  // Clones the packet into a new packet which owns the buffer.
+  // Clones the packet into a new packet which owns the buffer. If the packet
+  // refers to a receive buffer, the clone shares it instead of copying.
   std::unique_ptr<QuicEncryptedPacket> Clone() const;
 
+  // The pooled buffer holding the packet, if any.
+  const QuicReceiveBufferReference& receive_buffer() const {
+    return receive_buffer_;
+  }
+
   // By default, gtest prints the raw bytes of an object. The bool data
   // member (in the base class QuicData) causes this object to have padding
   // bytes, which causes the default gtest object printer to read
@@ -294,6 +306,9 @@ class QUIC_EXPORT_PRIVATE QuicEncryptedPacket : public QuicData {
   QUIC_EXPORT_PRIVATE friend std::ostream& operator<<(
       std::ostream& os,
       const QuicEncryptedPacket& s);
+
+ private:
+  QuicReceiveBufferReference receive_buffer_;
 };
 
 // A received encrypted QUIC packet, with a recorded time of receipt.
@@ -319,13 +334,30 @@ class QUIC_EXPORT_PRIVATE QuicReceivedPacket : public QuicEncryptedPacket {
                      char* packet_headers,
                      size_t headers_length,
                      bool owns_header_buffer);
+  // Creates a packet whose data and headers lie within |receive_buffer|,
+  // holding a reference to it.
+  QuicReceivedPacket(const char* buffer,
+                     size_t length,
+                     QuicTime receipt_time,
+                     int ttl,
+                     bool ttl_valid,
+                     char* packet_headers,
+                     size_t headers_length,
+                     QuicReceiveBufferReference receive_buffer);
   ~QuicReceivedPacket();
   QuicReceivedPacket(const QuicReceivedPacket&) = delete;
   QuicReceivedPacket& operator=(const QuicReceivedPacket&) = delete;
 
-  // Clones the packet into a new packet which owns the buffer.
+  // Clones the packet into a new packet which owns the buffer. If the packet
+  // refers to a receive buffer, the clone shares it instead of copying. Since
+  // receive buffers are not thread-safe, such a clone must stay on the thread
+  // which read the packet.
   std::unique_ptr<QuicReceivedPacket> Clone() const;
 
+  // Like Clone(), but always copies the packet and its headers onto the heap,
+  // so that the copy may be handed to another thread.
+  std::unique_ptr<QuicReceivedPacket> CopyToHeap() const;
+
   // Returns the time at which the packet was received.
   QuicTime receipt_time() const { return receipt_time_; }
 
@@ -108,6 +108,76 @@ TEST_F(QuicPacketsTest, CopySerializedPacket) {
   EXPECT_EQ(1000u, copy2->encrypted_length);
 }
 
+TEST_F(QuicPacketsTest, CloneSharesReceiveBuffer) {
+  QuicReceiveBufferPool pool(/*packet_buffer_size=*/100,
+                             /*control_buffer_size=*/20,
+                             /*max_free_buffers=*/1);
+  QuicReceiveBufferReference buffer = pool.Acquire();
+  memcpy(buffer->packet_buffer(), "packet", 6);
+  memcpy(buffer->control_buffer(), "headers", 7);
+  QuicTime receipt_time = QuicTime::Zero() + QuicTime::Delta::FromSeconds(1);
+  std::unique_ptr<QuicReceivedPacket> clone;
+  {
+    QuicReceivedPacket packet(buffer->packet_buffer(), 6, receipt_time,
+                              /*ttl=*/5, /*ttl_valid=*/true,
+                              buffer->control_buffer(), 7, buffer);
+    buffer.reset();
+    EXPECT_EQ(1, packet.receive_buffer()->ref_count());
+    clone = packet.Clone();
+    EXPECT_EQ(packet.data(), clone->data());
+    EXPECT_EQ(packet.packet_headers(), clone->packet_headers());
+    EXPECT_EQ(2, packet.receive_buffer()->ref_count());
+  }
+  EXPECT_EQ(1, clone->receive_buffer()->ref_count());
+  EXPECT_EQ("packet", clone->AsStringPiece());
+  EXPECT_EQ(receipt_time, clone->receipt_time());
+  EXPECT_EQ(5, clone->ttl());
+  EXPECT_EQ(7, clone->headers_length());
+
+  std::unique_ptr<QuicEncryptedPacket> encrypted_clone =
+      static_cast<const QuicEncryptedPacket&>(*clone).Clone();
+  EXPECT_EQ(clone->data(), encrypted_clone->data());
+  EXPECT_EQ(2, clone->receive_buffer()->ref_count());
+
+  EXPECT_EQ(1u, pool.num_buffers_in_use());
+  clone.reset();
+  encrypted_clone.reset();
+  EXPECT_EQ(0u, pool.num_buffers_in_use());
+  EXPECT_EQ(1u, pool.num_free_buffers());
+}
+
+TEST_F(QuicPacketsTest, CloneCopiesWithoutReceiveBuffer) {
+  const char data[] = "packet";
+  QuicReceivedPacket packet(data, 6, QuicTime::Zero());
+  std::unique_ptr<QuicReceivedPacket> clone = packet.Clone();
+  EXPECT_NE(packet.data(), clone->data());
+  EXPECT_EQ("packet", clone->AsStringPiece());
+  EXPECT_FALSE(clone->receive_buffer());
+}
+
+TEST_F(QuicPacketsTest, CopyToHeapDoesNotShareReceiveBuffer) {
+  QuicReceiveBufferPool pool(/*packet_buffer_size=*/100,
+                             /*control_buffer_size=*/20,
+                             /*max_free_buffers=*/1);
+  QuicReceiveBufferReference buffer = pool.Acquire();
+  memcpy(buffer->packet_buffer(), "packet", 6);
+  memcpy(buffer->control_buffer(), "headers", 7);
+  QuicReceivedPacket packet(buffer->packet_buffer(), 6, QuicTime::Zero(),
+                            /*ttl=*/5, /*ttl_valid=*/true,
+                            buffer->control_buffer(), 7, buffer);
+  buffer.reset();
+
+  std::unique_ptr<QuicReceivedPacket> copy = packet.CopyToHeap();
+  EXPECT_EQ(1, packet.receive_buffer()->ref_count());
+  EXPECT_FALSE(copy->receive_buffer());
+  EXPECT_NE(packet.data(), copy->data());
+  EXPECT_EQ("packet", copy->AsStringPiece());
+  EXPECT_NE(packet.packet_headers(), copy->packet_headers());
+  EXPECT_EQ("headers", quiche::QuicheStringPiece(copy->packet_headers(),
+                                                 copy->headers_length()));
+  EXPECT_EQ(5, copy->ttl());
+}
+
 }  // namespace
 }  // namespace test
 }  // namespace quic
@@ -0,0 +1,103 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/third_party/quiche/src/quic/core/quic_pooled_buffer_allocator.h"
+
+#include <cstring>
+
+#include "net/third_party/quiche/src/quic/platform/api/quic_logging.h"
+
+namespace quic {
+
+namespace {
+
+// Each buffer is preceded by a header which records its size, so that Delete()
+// knows whether the buffer can go back to the pool. The header keeps the
+// returned buffer aligned like one returned by operator new.
+const size_t kHeaderSize = alignof(std::max_align_t);
+static_assert(kHeaderSize >= sizeof(size_t), "Header too small for a size_t");
+
+char* AllocateWithHeader(size_t size) {
+  char* allocation = new char[kHeaderSize + size];
+  memcpy(allocation, &size, sizeof(size));
+  return allocation + kHeaderSize;
+}
+
+size_t GetSize(const char* buffer) {
+  size_t size;
+  memcpy(&size, buffer - kHeaderSize, sizeof(size));
+  return size;
+}
+
+void FreeWithHeader(char* buffer) {
+  delete[](buffer - kHeaderSize);
+}
+
+}  // namespace
+
+QuicPooledBufferAllocator::QuicPooledBufferAllocator(size_t buffer_size,
+                                                     size_t min_free_buffers,
+                                                     size_t max_free_buffers)
+    : buffer_size_(buffer_size),
+      min_free_buffers_(min_free_buffers),
+      max_free_buffers_(max_free_buffers) {
+  DCHECK_LE(min_free_buffers_, max_free_buffers_);
+}
+
+QuicPooledBufferAllocator::~QuicPooledBufferAllocator() {
+  TrimFreeBuffers(0);
+}
+
+char* QuicPooledBufferAllocator::New(size_t size) {
+  if (size == buffer_size_ && !free_buffers_.empty()) {
+    char* buffer = free_buffers_.back();
+    free_buffers_.pop_back();
+    return buffer;
+  }
+  return AllocateWithHeader(size);
+}
+
+char* QuicPooledBufferAllocator::New(size_t size, bool flag_enable) {
+  if (flag_enable) {
+    return New(size);
+  }
+  // Bypass the free list, but keep the header which Delete() reads.
+  return AllocateWithHeader(size);
+}
+
+void QuicPooledBufferAllocator::Delete(char* buffer) {
+  if (buffer == nullptr) {
+    return;
+  }
+  if (GetSize(buffer) != buffer_size_) {
+    FreeWithHeader(buffer);
+    return;
+  }
+  if (free_buffers_.size() >= max_free_buffers_) {
+    QUIC_DVLOG(1) << "Trimming pool of " << free_buffers_.size()
+                  << " free buffers to " << min_free_buffers_;
+    TrimFreeBuffers(min_free_buffers_);
+    if (free_buffers_.size() >= max_free_buffers_) {
+      FreeWithHeader(buffer);
+      return;
+    }
+  }
+  free_buffers_.push_back(buffer);
+}
+
+void QuicPooledBufferAllocator::MarkAllocatorIdle() {
+  TrimFreeBuffers(0);
+}
+
+void QuicPooledBufferAllocator::TrimFreeBuffers(size_t num_buffers) {
+  while (free_buffers_.size() > num_buffers) {
+    FreeWithHeader(free_buffers_.back());
+    free_buffers_.pop_back();
+  }
+  if (num_buffers == 0) {
+    free_buffers_.shrink_to_fit();
+  }
+}
+
+}  // namespace quic
@@ -0,0 +1,60 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef QUICHE_QUIC_CORE_QUIC_POOLED_BUFFER_ALLOCATOR_H_
+#define QUICHE_QUIC_CORE_QUIC_POOLED_BUFFER_ALLOCATOR_H_
+
+#include <cstddef>
+#include <vector>
+
+#include "net/third_party/quiche/src/quic/core/quic_buffer_allocator.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_export.h"
+
+namespace quic {
+
+// A QuicBufferAllocator which keeps deleted buffers of one size on a free list
+// and hands them out again, so that many streams allocating and releasing
+// same-sized blocks reuse memory instead of going to the heap each time.
+// Buffers of any other size are allocated and freed directly.
+//
+// The free list grows up to |max_free_buffers|. A Delete() which would grow it
+// further frees buffers until |min_free_buffers| remain. MarkAllocatorIdle()
+// frees all pooled buffers.
+//
+// Not thread-safe. Use one allocator per thread, e.g. one per connection
+// helper.
+class QUIC_EXPORT_PRIVATE QuicPooledBufferAllocator
+    : public QuicBufferAllocator {
+ public:
+  QuicPooledBufferAllocator(size_t buffer_size,
+                            size_t min_free_buffers,
+                            size_t max_free_buffers);
+  QuicPooledBufferAllocator(const QuicPooledBufferAllocator&) = delete;
+  QuicPooledBufferAllocator& operator=(const QuicPooledBufferAllocator&) =
+      delete;
+  ~QuicPooledBufferAllocator() override;
+
+  // QuicBufferAllocator
+  char* New(size_t size) override;
+  char* New(size_t size, bool flag_enable) override;
+  void Delete(char* buffer) override;
+  void MarkAllocatorIdle() override;
+
+  // Frees pooled buffers until at most |num_buffers| remain.
+  void TrimFreeBuffers(size_t num_buffers);
+
+  size_t buffer_size() const { return buffer_size_; }
+  size_t num_free_buffers() const { return free_buffers_.size(); }
+
+ private:
+  const size_t buffer_size_;
+  const size_t min_free_buffers_;
+  const size_t max_free_buffers_;
+  // Buffers of |buffer_size_| bytes which are ready to be handed out.
+  std::vector<char*> free_buffers_;
+};
+
+}  // namespace quic
+
+#endif  // QUICHE_QUIC_CORE_QUIC_POOLED_BUFFER_ALLOCATOR_H_
@@ -0,0 +1,89 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/third_party/quiche/src/quic/core/quic_pooled_buffer_allocator.h"
+
+#include <cstring>
+
+#include "net/third_party/quiche/src/quic/platform/api/quic_test.h"
+
+namespace quic {
+namespace {
+
+class QuicPooledBufferAllocatorTest : public QuicTest {};
+
+TEST_F(QuicPooledBufferAllocatorTest, ReusesBuffers) {
+  QuicPooledBufferAllocator alloc(/*buffer_size=*/1024,
+                                  /*min_free_buffers=*/1,
+                                  /*max_free_buffers=*/4);
+  char* buf = alloc.New(1024);
+  ASSERT_NE(nullptr, buf);
+  memset(buf, 'a', 1024);
+  alloc.Delete(buf);
+  EXPECT_EQ(1u, alloc.num_free_buffers());
+
+  EXPECT_EQ(buf, alloc.New(1024));
+  EXPECT_EQ(0u, alloc.num_free_buffers());
+  alloc.Delete(buf);
+}
+
+TEST_F(QuicPooledBufferAllocatorTest, OtherSizesAreNotPooled) {
+  QuicPooledBufferAllocator alloc(1024, 1, 4);
+  char* buf = alloc.New(100);
+  ASSERT_NE(nullptr, buf);
+  alloc.Delete(buf);
+  EXPECT_EQ(0u, alloc.num_free_buffers());
+
+}
+
+TEST_F(QuicPooledBufferAllocatorTest, FlagDisabledBypassesFreeList) {
+  QuicPooledBufferAllocator alloc(1024, 1, 4);
+  char* pooled = alloc.New(1024);
+  alloc.Delete(pooled);
+  EXPECT_EQ(1u, alloc.num_free_buffers());
+
+  // The free buffer is not handed out, but the new one can still be deleted
+  // through the allocator.
+  char* unpooled = alloc.New(1024, /*flag_enable=*/false);
+  ASSERT_NE(nullptr, unpooled);
+  EXPECT_NE(pooled, unpooled);
+  EXPECT_EQ(1u, alloc.num_free_buffers());
+  memset(unpooled, 'a', 1024);
+  alloc.Delete(unpooled);
+  EXPECT_EQ(2u, alloc.num_free_buffers());
+
+  char* small = alloc.New(100, /*flag_enable=*/false);
+  alloc.Delete(small);
+  EXPECT_EQ(2u, alloc.num_free_buffers());
+}
+
+TEST_F(QuicPooledBufferAllocatorTest, TrimsToLowWatermark) {
+  QuicPooledBufferAllocator alloc(1024, /*min_free_buffers=*/1,
+                                  /*max_free_buffers=*/3);
+  char* bufs[4];
+  for (char*& buf : bufs) {
+    buf = alloc.New(1024);
+  }
+  alloc.Delete(bufs[0]);
+  alloc.Delete(bufs[1]);
+  alloc.Delete(bufs[2]);
+  EXPECT_EQ(3u, alloc.num_free_buffers());
+
+  // The pool is at its high watermark, so it is trimmed before |bufs[3]| is
+  // added.
+  alloc.Delete(bufs[3]);
+  EXPECT_EQ(2u, alloc.num_free_buffers());
+
+  alloc.MarkAllocatorIdle();
+  EXPECT_EQ(0u, alloc.num_free_buffers());
+}
+
+TEST_F(QuicPooledBufferAllocatorTest, DeleteNull) {
+  QuicPooledBufferAllocator alloc(1024, 1, 4);
+  alloc.Delete(nullptr);
+  EXPECT_EQ(0u, alloc.num_free_buffers());
+}
+
+}  // namespace
+}  // namespace quic
@@ -0,0 +1,203 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/third_party/quiche/src/quic/core/quic_receive_buffer_pool.h"
+
+#include <algorithm>
+#include <functional>
+
+#include "net/third_party/quiche/src/quic/platform/api/quic_logging.h"
+
+namespace quic {
+
+struct QuicReceiveBuffer::PoolState {
+  PoolState(size_t packet_buffer_size,
+            size_t control_buffer_size,
+            size_t max_free_buffers)
+      : packet_buffer_size(packet_buffer_size),
+        control_buffer_size(control_buffer_size),
+        max_free_buffers(max_free_buffers),
+        pool_destroyed(false),
+        num_buffers_in_use(0),
+        peak_buffers_in_use(0),
+        num_buffers_allocated(0),
+        num_acquisitions(0) {}
+
+  ~PoolState() {
+    for (QuicReceiveBuffer* buffer : free_buffers) {
+      delete buffer;
+    }
+  }
+
+  const size_t packet_buffer_size;
+  const size_t control_buffer_size;
+  const size_t max_free_buffers;
+  // Once set, released buffers are freed and the last one deletes the state.
+  bool pool_destroyed;
+  std::vector<QuicReceiveBuffer*> free_buffers;
+
+  size_t num_buffers_in_use;
+  size_t peak_buffers_in_use;
+  uint64_t num_buffers_allocated;
+  uint64_t num_acquisitions;
+};
+
+QuicReceiveBuffer::QuicReceiveBuffer(PoolState* pool_state,
+                                     size_t packet_buffer_size,
+                                     size_t control_buffer_size)
+    : pool_state_(pool_state),
+      packet_buffer_size_(packet_buffer_size),
+      control_buffer_size_(control_buffer_size),
+      storage_(new char[control_buffer_size + packet_buffer_size]),
+      ref_count_(0) {}
+
+QuicReceiveBuffer::~QuicReceiveBuffer() {
+  DCHECK_EQ(0, ref_count_);
+}
+
+bool QuicReceiveBuffer::Contains(const char* data, size_t length) const {
+  const char* begin = storage_.get();
+  const char* end = begin + control_buffer_size_ + packet_buffer_size_;
+  // std::less_equal gives a total order even for unrelated pointers.
+  return std::less_equal<const char*>()(begin, data) &&
+         std::less_equal<const char*>()(data + length, end);
+}
+
+void QuicReceiveBuffer::Release() {
+  DCHECK_LT(0, ref_count_);
+  if (--ref_count_ > 0) {
+    return;
+  }
+  PoolState* state = pool_state_;
+  --state->num_buffers_in_use;
+  if (state->pool_destroyed) {
+    delete this;
+    if (state->num_buffers_in_use == 0) {
+      delete state;
+    }
+    return;
+  }
+  if (state->free_buffers.size() < state->max_free_buffers) {
+    state->free_buffers.push_back(this);
+    return;
+  }
+  delete this;
+}
+
+QuicReceiveBufferReference::QuicReceiveBufferReference(
+    const QuicReceiveBufferReference& other)
+    : buffer_(other.buffer_) {
+  if (buffer_ != nullptr) {
+    buffer_->AddReference();
+  }
+}
+
+QuicReceiveBufferReference::QuicReceiveBufferReference(
+    QuicReceiveBufferReference&& other)
+    : buffer_(other.buffer_) {
+  other.buffer_ = nullptr;
+}
+
+QuicReceiveBufferReference& QuicReceiveBufferReference::operator=(
+    const QuicReceiveBufferReference& other) {
+  QuicReceiveBuffer* buffer = other.buffer_;
+  if (buffer != nullptr) {
+    buffer->AddReference();
+  }
+  reset();
+  buffer_ = buffer;
+  return *this;
+}
+
+QuicReceiveBufferReference& QuicReceiveBufferReference::operator=(
+    QuicReceiveBufferReference&& other) {
+  if (this != &other) {
+    reset();
+    buffer_ = other.buffer_;
+    other.buffer_ = nullptr;
+  }
+  return *this;
+}
+
+QuicReceiveBufferReference::~QuicReceiveBufferReference() {
+  reset();
+}
+
+void QuicReceiveBufferReference::reset() {
+  if (buffer_ != nullptr) {
+    QuicReceiveBuffer* buffer = buffer_;
+    buffer_ = nullptr;
+    buffer->Release();
+  }
+}
+
+QuicReceiveBufferPool::QuicReceiveBufferPool(size_t packet_buffer_size,
+                                             size_t control_buffer_size,
+                                             size_t max_free_buffers)
+    : state_(new QuicReceiveBuffer::PoolState(packet_buffer_size,
+                                              control_buffer_size,
+                                              max_free_buffers)) {}
+
+QuicReceiveBufferPool::~QuicReceiveBufferPool() {
+  if (state_->num_buffers_in_use == 0) {
+    delete state_;
+    return;
+  }
+  QUIC_DVLOG(1) << state_->num_buffers_in_use
+                << " receive buffers outlive their pool.";
+  for (QuicReceiveBuffer* buffer : state_->free_buffers) {
+    delete buffer;
+  }
+  state_->free_buffers.clear();
+  state_->pool_destroyed = true;
+}
+
+QuicReceiveBufferReference QuicReceiveBufferPool::Acquire() {
+  ++state_->num_acquisitions;
+  QuicReceiveBuffer* buffer;
+  if (!state_->free_buffers.empty()) {
+    buffer = state_->free_buffers.back();
+    state_->free_buffers.pop_back();
+  } else {
+    buffer = new QuicReceiveBuffer(state_, state_->packet_buffer_size,
+                                   state_->control_buffer_size);
+    ++state_->num_buffers_allocated;
+  }
+  DCHECK_EQ(0, buffer->ref_count());
+  buffer->AddReference();
+  ++state_->num_buffers_in_use;
+  state_->peak_buffers_in_use =
+      std::max(state_->peak_buffers_in_use, state_->num_buffers_in_use);
+  return QuicReceiveBufferReference(buffer);
+}
+
+size_t QuicReceiveBufferPool::packet_buffer_size() const {
+  return state_->packet_buffer_size;
+}
+
+size_t QuicReceiveBufferPool::control_buffer_size() const {
+  return state_->control_buffer_size;
+}
+
+size_t QuicReceiveBufferPool::num_buffers_in_use() const {
+  return state_->num_buffers_in_use;
+}
+
+size_t QuicReceiveBufferPool::peak_buffers_in_use() const {
+  return state_->peak_buffers_in_use;
+}
+
+size_t QuicReceiveBufferPool::num_free_buffers() const {
+  return state_->free_buffers.size();
+}
+
+uint64_t QuicReceiveBufferPool::num_buffers_allocated() const {
+  return state_->num_buffers_allocated;
+}
+
+uint64_t QuicReceiveBufferPool::num_acquisitions() const {
+  return state_->num_acquisitions;
+}
+
+}  // namespace quic
@@ -0,0 +1,139 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Pooled, reference counted buffers for reading packets from the network. A
+// packet which must outlive the read that produced it, such as a buffered CHLO
+// or an undecryptable packet, keeps a reference to its receive buffer instead
+// of copying the packet onto the heap.
+
+#ifndef QUICHE_QUIC_CORE_QUIC_RECEIVE_BUFFER_POOL_H_
+#define QUICHE_QUIC_CORE_QUIC_RECEIVE_BUFFER_POOL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "net/third_party/quiche/src/quic/platform/api/quic_export.h"
+
+namespace quic {
+
+class QuicReceiveBufferReference;
+
+// A buffer for one read from a socket, made up of a packet area and a control
+// area for ancillary data. Buffers are handed out by QuicReceiveBufferPool and
+// go back to it once the last QuicReceiveBufferReference to them is dropped.
+// Not thread-safe.
+class QUIC_EXPORT_PRIVATE QuicReceiveBuffer {
+ public:
+  QuicReceiveBuffer(const QuicReceiveBuffer&) = delete;
+  QuicReceiveBuffer& operator=(const QuicReceiveBuffer&) = delete;
+
+  char* packet_buffer() { return storage_.get() + control_buffer_size_; }
+  size_t packet_buffer_size() const { return packet_buffer_size_; }
+
+  char* control_buffer() { return storage_.get(); }
+  size_t control_buffer_size() const { return control_buffer_size_; }
+
+  // Returns true if the |length| bytes at |data| lie within this buffer.
+  bool Contains(const char* data, size_t length) const;
+
+  // Number of QuicReceiveBufferReferences to this buffer.
+  int ref_count() const { return ref_count_; }
+
+ private:
+  friend class QuicReceiveBufferPool;
+  friend class QuicReceiveBufferReference;
+
+  struct PoolState;
+
+  QuicReceiveBuffer(PoolState* pool_state,
+                    size_t packet_buffer_size,
+                    size_t control_buffer_size);
+  ~QuicReceiveBuffer();
+
+  void AddReference() { ++ref_count_; }
+  // Returns the buffer to its pool if this was the last reference.
+  void Release();
+
+  PoolState* const pool_state_;
+  const size_t packet_buffer_size_;
+  const size_t control_buffer_size_;
+  // The control buffer followed by the packet buffer.
+  std::unique_ptr<char[]> storage_;
+  int ref_count_;
+};
+
+// A counted reference to a QuicReceiveBuffer, with shared_ptr-like semantics.
+class QUIC_EXPORT_PRIVATE QuicReceiveBufferReference {
+ public:
+  QuicReceiveBufferReference() : buffer_(nullptr) {}
+  QuicReceiveBufferReference(std::nullptr_t)  // NOLINT
+      : buffer_(nullptr) {}
+  QuicReceiveBufferReference(const QuicReceiveBufferReference& other);
+  QuicReceiveBufferReference(QuicReceiveBufferReference&& other);
+  QuicReceiveBufferReference& operator=(
+      const QuicReceiveBufferReference& other);
+  QuicReceiveBufferReference& operator=(QuicReceiveBufferReference&& other);
+  ~QuicReceiveBufferReference();
+
+  QuicReceiveBuffer* get() const { return buffer_; }
+  QuicReceiveBuffer& operator*() const { return *buffer_; }
+  QuicReceiveBuffer* operator->() const { return buffer_; }
+  explicit operator bool() const { return buffer_ != nullptr; }
+
+  // Drops the reference, if any.
+  void reset();
+
+ private:
+  friend class QuicReceiveBufferPool;
+
+  // Adopts the initial reference to a newly acquired |buffer|.
+  explicit QuicReceiveBufferReference(QuicReceiveBuffer* buffer)
+      : buffer_(buffer) {}
+
+  QuicReceiveBuffer* buffer_;
+};
+
+// Hands out QuicReceiveBuffers of a fixed size, recycling those which are no
+// longer referenced. Buffers may outlive the pool, in which case they are
+// freed when their last reference is dropped. Not thread-safe.
+class QUIC_EXPORT_PRIVATE QuicReceiveBufferPool {
+ public:
+  // Up to |max_free_buffers| unreferenced buffers are kept for reuse, the
+  // rest are freed.
+  QuicReceiveBufferPool(size_t packet_buffer_size,
+                        size_t control_buffer_size,
+                        size_t max_free_buffers);
+  QuicReceiveBufferPool(const QuicReceiveBufferPool&) = delete;
+  QuicReceiveBufferPool& operator=(const QuicReceiveBufferPool&) = delete;
+  ~QuicReceiveBufferPool();
+
+  // Returns a buffer with a single reference, reusing a free one if
+  // possible.
+  QuicReceiveBufferReference Acquire();
+
+  size_t packet_buffer_size() const;
+  size_t control_buffer_size() const;
+
+  // Occupancy statistics.
+  // Number of buffers which are currently referenced.
+  size_t num_buffers_in_use() const;
+  // Highest value of num_buffers_in_use() over the lifetime of the pool.
+  size_t peak_buffers_in_use() const;
+  // Number of unreferenced buffers kept for reuse.
+  size_t num_free_buffers() const;
+  // Total number of buffers allocated from the heap.
+  uint64_t num_buffers_allocated() const;
+  // Total number of calls to Acquire().
+  uint64_t num_acquisitions() const;
+
+ private:
+  // Shared with the buffers, so that they can outlive the pool.
+  QuicReceiveBuffer::PoolState* state_;
+};
+
+}  // namespace quic
+
+#endif  // QUICHE_QUIC_CORE_QUIC_RECEIVE_BUFFER_POOL_H_
@@ -0,0 +1,133 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/third_party/quiche/src/quic/core/quic_receive_buffer_pool.h"
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "net/third_party/quiche/src/quic/platform/api/quic_test.h"
+
+namespace quic {
+namespace test {
+namespace {
+
+const size_t kPacketBufferSize = 1500;
+const size_t kControlBufferSize = 512;
+
+class QuicReceiveBufferPoolTest : public QuicTest {
+ protected:
+  QuicReceiveBufferPoolTest()
+      : pool_(kPacketBufferSize, kControlBufferSize, /*max_free_buffers=*/2) {}
+
+  QuicReceiveBufferPool pool_;
+};
+
+TEST_F(QuicReceiveBufferPoolTest, Acquire) {
+  QuicReceiveBufferReference buffer = pool_.Acquire();
+  ASSERT_TRUE(buffer);
+  EXPECT_EQ(1, buffer->ref_count());
+  EXPECT_EQ(kPacketBufferSize, buffer->packet_buffer_size());
+  EXPECT_EQ(kControlBufferSize, buffer->control_buffer_size());
+  EXPECT_NE(nullptr, buffer->packet_buffer());
+  EXPECT_NE(nullptr, buffer->control_buffer());
+
+  EXPECT_EQ(1u, pool_.num_buffers_in_use());
+  EXPECT_EQ(1u, pool_.peak_buffers_in_use());
+  EXPECT_EQ(0u, pool_.num_free_buffers());
+  EXPECT_EQ(1u, pool_.num_buffers_allocated());
+  EXPECT_EQ(1u, pool_.num_acquisitions());
+}
+
+TEST_F(QuicReceiveBufferPoolTest, Contains) {
+  QuicReceiveBufferReference buffer = pool_.Acquire();
+  EXPECT_TRUE(buffer->Contains(buffer->packet_buffer(), kPacketBufferSize));
+  EXPECT_TRUE(buffer->Contains(buffer->control_buffer(), kControlBufferSize));
+  EXPECT_TRUE(buffer->Contains(buffer->packet_buffer() + 10, 100));
+  EXPECT_FALSE(
+      buffer->Contains(buffer->packet_buffer(), kPacketBufferSize + 1));
+  char other[10];
+  EXPECT_FALSE(buffer->Contains(other, sizeof(other)));
+}
+
+TEST_F(QuicReceiveBufferPoolTest, ReferenceCounting) {
+  QuicReceiveBufferReference buffer = pool_.Acquire();
+  QuicReceiveBuffer* raw_buffer = buffer.get();
+
+  QuicReceiveBufferReference copy(buffer);
+  EXPECT_EQ(2, raw_buffer->ref_count());
+  QuicReceiveBufferReference assigned;
+  assigned = copy;
+  EXPECT_EQ(3, raw_buffer->ref_count());
+  // Self assignment does not change the count.
+  assigned = assigned;
+  EXPECT_EQ(3, raw_buffer->ref_count());
+
+  QuicReceiveBufferReference moved(std::move(copy));
+  EXPECT_FALSE(copy);
+  EXPECT_EQ(3, raw_buffer->ref_count());
+  QuicReceiveBufferReference move_assigned;
+  move_assigned = std::move(moved);
+  EXPECT_FALSE(moved);
+  EXPECT_EQ(3, raw_buffer->ref_count());
+
+  buffer.reset();
+  assigned = nullptr;
+  EXPECT_EQ(1, raw_buffer->ref_count());
+  EXPECT_EQ(1u, pool_.num_buffers_in_use());
+  move_assigned.reset();
+  EXPECT_EQ(0u, pool_.num_buffers_in_use());
+  EXPECT_EQ(1u, pool_.num_free_buffers());
+}
+
+TEST_F(QuicReceiveBufferPoolTest, ReusesFreeBuffers) {
+  QuicReceiveBuffer* raw_buffer;
+  {
+    QuicReceiveBufferReference buffer = pool_.Acquire();
+    raw_buffer = buffer.get();
+  }
+  EXPECT_EQ(1u, pool_.num_free_buffers());
+
+  QuicReceiveBufferReference buffer = pool_.Acquire();
+  EXPECT_EQ(raw_buffer, buffer.get());
+  EXPECT_EQ(1, buffer->ref_count());
+  EXPECT_EQ(0u, pool_.num_free_buffers());
+  EXPECT_EQ(1u, pool_.num_buffers_allocated());
+  EXPECT_EQ(2u, pool_.num_acquisitions());
+}
+
+TEST_F(QuicReceiveBufferPoolTest, LimitsFreeBuffers) {
+  std::vector<QuicReceiveBufferReference> buffers;
+  for (int i = 0; i < 4; ++i) {
+    buffers.push_back(pool_.Acquire());
+  }
+  EXPECT_EQ(4u, pool_.num_buffers_in_use());
+  EXPECT_EQ(4u, pool_.peak_buffers_in_use());
+  EXPECT_EQ(4u, pool_.num_buffers_allocated());
+
+  buffers.clear();
+  EXPECT_EQ(0u, pool_.num_buffers_in_use());
+  EXPECT_EQ(4u, pool_.peak_buffers_in_use());
+  EXPECT_EQ(2u, pool_.num_free_buffers());
+}
+
+TEST_F(QuicReceiveBufferPoolTest, BuffersOutliveThePool) {
+  auto pool = std::make_unique<QuicReceiveBufferPool>(
+      kPacketBufferSize, kControlBufferSize, /*max_free_buffers=*/2);
+  QuicReceiveBufferReference first = pool->Acquire();
+  QuicReceiveBufferReference second = pool->Acquire();
+  pool->Acquire();
+  EXPECT_EQ(1u, pool->num_free_buffers());
+
+  pool.reset();
+  first->packet_buffer()[0] = 'a';
+  first.reset();
+  second->packet_buffer()[0] = 'b';
+  second.reset();
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace quic
@@ -0,0 +1,52 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/third_party/quiche/src/quic/core/quic_received_slice.h"
+
+#include <utility>
+
+#include "net/third_party/quiche/src/quic/platform/api/quic_logging.h"
+
+namespace quic {
+
+QuicReceivedSlice::QuicReceivedSlice()
+    : buffer_(nullptr, QuicBufferDeleter(nullptr)),
+      data_(nullptr),
+      length_(0) {}
+
+QuicReceivedSlice::QuicReceivedSlice(QuicUniqueBufferPtr buffer,
+                                     const char* data,
+                                     size_t length)
+    : buffer_(std::move(buffer)), data_(data), length_(length) {
+  DCHECK(buffer_ != nullptr || length_ == 0);
+}
+
+QuicReceivedSlice::QuicReceivedSlice(QuicReceivedSlice&& other)
+    : buffer_(std::move(other.buffer_)),
+      data_(other.data_),
+      length_(other.length_) {
+  other.data_ = nullptr;
+  other.length_ = 0;
+}
+
+QuicReceivedSlice& QuicReceivedSlice::operator=(QuicReceivedSlice&& other) {
+  if (this != &other) {
+    buffer_ = std::move(other.buffer_);
+    data_ = other.data_;
+    length_ = other.length_;
+    other.data_ = nullptr;
+    other.length_ = 0;
+  }
+  return *this;
+}
+
+QuicReceivedSlice::~QuicReceivedSlice() = default;
+
+void QuicReceivedSlice::Reset() {
+  buffer_.reset();
+  data_ = nullptr;
+  length_ = 0;
+}
+
+}  // namespace quic
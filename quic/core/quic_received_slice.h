@@ -0,0 +1,59 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef QUICHE_QUIC_CORE_QUIC_RECEIVED_SLICE_H_
+#define QUICHE_QUIC_CORE_QUIC_RECEIVED_SLICE_H_
+
+#include <cstddef>
+
+#include "net/third_party/quiche/src/quic/core/quic_buffer_allocator.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_export.h"
+#include "net/third_party/quiche/src/common/platform/api/quiche_string_piece.h"
+
+namespace quic {
+
+// A piece of received stream data which has been consumed from the stream and
+// handed to the application. It owns the buffer it points into, usually a
+// whole block taken out of the stream's QuicStreamSequencerBuffer, and the
+// buffer is returned to its allocator when the slice is reset or destroyed.
+// This is the receive side counterpart of QuicMemSlice.
+//
+// The allocator the buffer came from must outlive the slice.
+class QUIC_EXPORT_PRIVATE QuicReceivedSlice {
+ public:
+  // Constructs an empty slice.
+  QuicReceivedSlice();
+
+  // Constructs a slice of |length| bytes at |data|, which points into
+  // |buffer|.
+  QuicReceivedSlice(QuicUniqueBufferPtr buffer,
+                    const char* data,
+                    size_t length);
+
+  QuicReceivedSlice(const QuicReceivedSlice&) = delete;
+  QuicReceivedSlice& operator=(const QuicReceivedSlice&) = delete;
+  QuicReceivedSlice(QuicReceivedSlice&& other);
+  QuicReceivedSlice& operator=(QuicReceivedSlice&& other);
+  ~QuicReceivedSlice();
+
+  // Frees the underlying buffer and empties the slice.
+  void Reset();
+
+  const char* data() const { return data_; }
+  size_t length() const { return length_; }
+  bool empty() const { return length_ == 0; }
+
+  quiche::QuicheStringPiece AsStringPiece() const {
+    return quiche::QuicheStringPiece(data_, length_);
+  }
+
+ private:
+  QuicUniqueBufferPtr buffer_;
+  const char* data_;
+  size_t length_;
+};
+
+}  // namespace quic
+
+#endif  // QUICHE_QUIC_CORE_QUIC_RECEIVED_SLICE_H_
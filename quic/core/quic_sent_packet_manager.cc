@@ -1370,11 +1370,15 @@ void QuicSentPacketManager::OnAckRange(QuicPacketNumber start,
 void QuicSentPacketManager::OnAckTimestamp(QuicPacketNumber packet_number,
                                            QuicTime timestamp) {
   last_ack_frame_.received_packet_times.push_back({packet_number, timestamp});
-  for (AckedPacket& packet : packets_acked_) {
-    if (packet.packet_number == packet_number) {
-      packet.receive_timestamp = timestamp;
-      return;
-    }
+  // packets_acked_ is in descending order until OnAckFrameEnd, so a stretch
+  // ack with many timestamps does not need a linear scan per timestamp.
+  auto it = std::lower_bound(
+      packets_acked_.begin(), packets_acked_.end(), packet_number,
+      [](const AckedPacket& packet, QuicPacketNumber number) {
+        return packet.packet_number > number;
+      });
+  if (it != packets_acked_.end() && it->packet_number == packet_number) {
+    it->receive_timestamp = timestamp;
   }
 }
 
@@ -1385,6 +1389,16 @@ AckResult QuicSentPacketManager::OnAckFrameEnd(
   QuicByteCount prior_bytes_in_flight = unacked_packets_.bytes_in_flight();
   // Reverse packets_acked_ so that it is in ascending order.
   std::reverse(packets_acked_.begin(), packets_acked_.end());
+  // Newly acked packets are added to last_ack_frame_ one contiguous range at
+  // a time rather than one packet at a time.
+  QuicPacketNumber pending_range_start;
+  QuicPacketNumber pending_range_end;
+  auto add_pending_range = [this, &pending_range_start, &pending_range_end]() {
+    if (pending_range_start.IsInitialized()) {
+      last_ack_frame_.packets.AddRange(pending_range_start, pending_range_end);
+      pending_range_start.Clear();
+    }
+  };
   for (AckedPacket& acked_packet : packets_acked_) {
     QuicTransmissionInfo* info =
         unacked_packets_.GetMutableTransmissionInfo(acked_packet.packet_number);
@@ -1401,6 +1415,7 @@ AckResult QuicSentPacketManager::OnAckFrameEnd(
                       << acked_packet.packet_number << " with state: "
                       << QuicUtils::SentPacketStateToString(info->state);
         if (supports_multiple_packet_number_spaces()) {
+          add_pending_range();
           if (info->state == NEVER_SENT) {
             return UNSENT_PACKETS_ACKED;
           }
@@ -1418,9 +1433,17 @@ AckResult QuicSentPacketManager::OnAckFrameEnd(
     if (supports_multiple_packet_number_spaces() &&
         QuicUtils::GetPacketNumberSpace(ack_decrypted_level) !=
             packet_number_space) {
+      add_pending_range();
       return PACKETS_ACKED_IN_WRONG_PACKET_NUMBER_SPACE;
     }
-    last_ack_frame_.packets.Add(acked_packet.packet_number);
+    if (pending_range_start.IsInitialized() &&
+        pending_range_end != acked_packet.packet_number) {
+      add_pending_range();
+    }
+    if (!pending_range_start.IsInitialized()) {
+      pending_range_start = acked_packet.packet_number;
+    }
+    pending_range_end = acked_packet.packet_number + 1;
     if (info->encryption_level == ENCRYPTION_FORWARD_SECURE) {
       one_rtt_packet_acked_ = true;
     }
@@ -1443,6 +1466,7 @@ AckResult QuicSentPacketManager::OnAckFrameEnd(
                       last_ack_frame_.ack_delay_time,
                       acked_packet.receive_timestamp);
   }
+  add_pending_range();
   const bool acked_new_packet = !packets_acked_.empty();
   PostProcessNewlyAckedPackets(ack_packet_number, ack_decrypted_level,
                                last_ack_frame_, ack_receive_time, rtt_updated_,
@@ -383,6 +383,53 @@ TEST_F(QuicSentPacketManagerTest, RetransmitThenAck) {
   VerifyRetransmittablePackets(nullptr, 0);
 }
 
+TEST_F(QuicSentPacketManagerTest, AckMultipleRangesWithTimestamps) {
+  for (uint64_t i = 1; i <= 5; ++i) {
+    SendDataPacket(i);
+  }
+
+  // Ack 1, 2, 4 and 5, with timestamps for 1 and 5 and for unacked packet 3.
+  const QuicTime timestamp1 = clock_.Now();
+  clock_.AdvanceTime(QuicTime::Delta::FromMilliseconds(10));
+  const QuicTime timestamp5 = clock_.Now();
+  EXPECT_CALL(*send_algorithm_, OnCongestionEvent(true, _, _, _, IsEmpty()))
+      .WillOnce(Invoke([timestamp1, timestamp5](
+                           bool /*rtt_updated*/,
+                           QuicByteCount /*prior_in_flight*/,
+                           QuicTime /*event_time*/,
+                           const AckedPacketVector& acked_packets,
+                           const LostPacketVector& /*lost_packets*/) {
+        ASSERT_EQ(4u, acked_packets.size());
+        EXPECT_EQ(QuicPacketNumber(1), acked_packets[0].packet_number);
+        EXPECT_EQ(timestamp1, acked_packets[0].receive_timestamp);
+        EXPECT_EQ(QuicTime::Zero(), acked_packets[1].receive_timestamp);
+        EXPECT_EQ(QuicPacketNumber(5), acked_packets[3].packet_number);
+        EXPECT_EQ(timestamp5, acked_packets[3].receive_timestamp);
+      }));
+  EXPECT_CALL(*network_change_visitor_, OnCongestionChange());
+  manager_.OnAckFrameStart(QuicPacketNumber(5), QuicTime::Delta::Infinite(),
+                           clock_.Now());
+  manager_.OnAckRange(QuicPacketNumber(4), QuicPacketNumber(6));
+  manager_.OnAckRange(QuicPacketNumber(1), QuicPacketNumber(3));
+  manager_.OnAckTimestamp(QuicPacketNumber(5), timestamp5);
+  manager_.OnAckTimestamp(QuicPacketNumber(3), timestamp5);
+  manager_.OnAckTimestamp(QuicPacketNumber(1), timestamp1);
+  EXPECT_EQ(PACKETS_NEWLY_ACKED,
+            manager_.OnAckFrameEnd(clock_.Now(), QuicPacketNumber(1),
+                                   ENCRYPTION_INITIAL));
+
+  // Acking all packets only newly acks packet 3.
+  uint64_t acked[] = {3};
+  ExpectAcksAndLosses(false, acked, QUICHE_ARRAYSIZE(acked), nullptr, 0);
+  manager_.OnAckFrameStart(QuicPacketNumber(5), QuicTime::Delta::Infinite(),
+                           clock_.Now());
+  manager_.OnAckRange(QuicPacketNumber(1), QuicPacketNumber(6));
+  EXPECT_EQ(PACKETS_NEWLY_ACKED,
+            manager_.OnAckFrameEnd(clock_.Now(), QuicPacketNumber(2),
+                                   ENCRYPTION_INITIAL));
+  VerifyUnackedPackets(nullptr, 0);
+}
+
 TEST_F(QuicSentPacketManagerTest, RetransmitThenAckBeforeSend) {
   SendDataPacket(1);
   EXPECT_CALL(notifier_, RetransmitFrames(_, _))
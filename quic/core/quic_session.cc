@@ -45,6 +45,18 @@ class ClosedStreamsCleanUpDelegate : public QuicAlarm::Delegate {
   QuicSession* session_;
 };
 
+class ResetStreamsDelegate : public QuicAlarm::Delegate {
+ public:
+  explicit ResetStreamsDelegate(QuicSession* session) : session_(session) {}
+  ResetStreamsDelegate(const ResetStreamsDelegate&) = delete;
+  ResetStreamsDelegate& operator=(const ResetStreamsDelegate&) = delete;
+
+  void OnAlarm() override { session_->ResetStreamsPendingReset(); }
+
+ private:
+  QuicSession* session_;
+};
+
 }  // namespace
 
 #define ENDPOINT \
@@ -94,6 +106,7 @@ QuicSession::QuicSession(
       last_message_id_(0),
       datagram_queue_(this),
       closed_streams_clean_up_alarm_(nullptr),
+      reset_streams_alarm_(nullptr),
       supported_versions_(supported_versions),
       use_http2_priority_write_scheduler_(false),
       is_configured_(false),
@@ -104,6 +117,9 @@ QuicSession::QuicSession(
   closed_streams_clean_up_alarm_ =
       QuicWrapUnique<QuicAlarm>(connection_->alarm_factory()->CreateAlarm(
           new ClosedStreamsCleanUpDelegate(this)));
+  reset_streams_alarm_ =
+      QuicWrapUnique<QuicAlarm>(connection_->alarm_factory()->CreateAlarm(
+          new ResetStreamsDelegate(this)));
   if (perspective() == Perspective::IS_SERVER &&
       connection_->version().handshake_protocol == PROTOCOL_TLS1_3) {
     config_.SetStatelessResetTokenToSend(GetStatelessResetToken());
@@ -417,6 +433,8 @@ void QuicSession::OnConnectionClosed(const QuicConnectionCloseFrame& frame,
   }
 
   closed_streams_clean_up_alarm_->Cancel();
+  streams_pending_reset_.clear();
+  reset_streams_alarm_->Cancel();
 
   if (visitor_) {
     visitor_->OnConnectionClosed(connection_->connection_id(),
@@ -757,6 +775,28 @@ void QuicSession::SendRstStream(QuicStreamId id,
   }
 }
 
+void QuicSession::ResetStreamAfterWrite(QuicStreamId id,
+                                        QuicRstStreamErrorCode error) {
+  streams_pending_reset_.insert(std::make_pair(id, error));
+  if (!reset_streams_alarm_->IsSet()) {
+    reset_streams_alarm_->Set(connection_->clock()->ApproximateNow());
+  }
+}
+
+void QuicSession::ResetStreamsPendingReset() {
+  QuicLinkedHashMap<QuicStreamId, QuicRstStreamErrorCode> streams;
+  streams.swap(streams_pending_reset_);
+  for (const auto& it : streams) {
+    QuicStream* stream = GetStream(it.first);
+    if (stream == nullptr || stream->rst_sent()) {
+      continue;
+    }
+    QUIC_DLOG(INFO) << ENDPOINT << "Resetting stream " << it.first
+                    << " with error " << it.second;
+    ResetStream(it.first, it.second);
+  }
+}
+
 void QuicSession::ResetStream(QuicStreamId id, QuicRstStreamErrorCode error) {
   QuicStream* stream = GetStream(id);
   if (stream != nullptr && stream->is_static()) {
@@ -213,6 +213,10 @@ class QUIC_EXPORT_PRIVATE QuicSession
   // |id| does not exist, just send RST_STREAM (and STOP_SENDING).
   virtual void ResetStream(QuicStreamId id, QuicRstStreamErrorCode error);
 
+  // Called by stream |id| while its data is being serialized into a packet.
+  // Resets the stream with |error| once the current write has finished.
+  void ResetStreamAfterWrite(QuicStreamId id, QuicRstStreamErrorCode error);
+
   // Called when the session wants to go away and not accept any new streams.
   virtual void SendGoAway(QuicErrorCode error_code, const std::string& reason);
 
@@ -410,6 +414,9 @@ class QUIC_EXPORT_PRIVATE QuicSession
   // Clean up closed_streams_.
   void CleanUpClosedStreams();
 
+  // Resets streams passed to ResetStreamAfterWrite.
+  void ResetStreamsPendingReset();
+
   const ParsedQuicVersionVector& supported_versions() const {
     return supported_versions_;
   }
@@ -801,6 +808,12 @@ class QUIC_EXPORT_PRIVATE QuicSession
   // Clean up closed_streams_ when this alarm fires.
   std::unique_ptr<QuicAlarm> closed_streams_clean_up_alarm_;
 
+  // Streams to be reset, and the error to reset them with, when
+  // reset_streams_alarm_ fires.
+  QuicLinkedHashMap<QuicStreamId, QuicRstStreamErrorCode>
+      streams_pending_reset_;
+  std::unique_ptr<QuicAlarm> reset_streams_alarm_;
+
   // Supported version list used by the crypto handshake only. Please note, this
   // list may be a superset of the connection framer's supported versions.
   ParsedQuicVersionVector supported_versions_;
@@ -4,6 +4,9 @@
 
 #include "net/third_party/quiche/src/quic/core/quic_session.h"
 
+#include <stdio.h>
+#include <unistd.h>
+
 #include <cstdint>
 #include <set>
 #include <string>
@@ -17,6 +20,7 @@
 #include "net/third_party/quiche/src/quic/core/quic_crypto_stream.h"
 #include "net/third_party/quiche/src/quic/core/quic_data_writer.h"
 #include "net/third_party/quiche/src/quic/core/quic_error_codes.h"
+#include "net/third_party/quiche/src/quic/core/quic_file_region_data_source.h"
 #include "net/third_party/quiche/src/quic/core/quic_packets.h"
 #include "net/third_party/quiche/src/quic/core/quic_stream.h"
 #include "net/third_party/quiche/src/quic/core/quic_utils.h"
@@ -2578,6 +2582,37 @@ TEST_P(QuicSessionTestServer, CleanUpClosedStreamsAlarm) {
   EXPECT_TRUE(session_.closed_streams()->empty());
 }
 
+TEST_P(QuicSessionTestServer, ResetStreamWithTruncatedFile) {
+  session_.set_writev_consumes_all_data(true);
+  TestStream* stream = session_.CreateOutgoingBidirectionalStream();
+
+  // The file is shorter than the region the data source claims to serve.
+  FILE* file = tmpfile();
+  ASSERT_NE(nullptr, file);
+  ASSERT_EQ(4u, fwrite("0123", 1, 4, file));
+  fflush(file);
+  stream->WriteDataSource(std::make_unique<QuicFileRegionDataSource>(
+                              dup(fileno(file)), /*file_offset=*/0,
+                              /*length=*/10),
+                          /*fin=*/true);
+  fclose(file);
+
+  // Serializing the stream data does not fail, but schedules a reset.
+  char buf[100];
+  QuicDataWriter writer(sizeof(buf), buf, quiche::NETWORK_BYTE_ORDER);
+  EXPECT_TRUE(stream->WriteStreamData(0, 10, &writer));
+  EXPECT_EQ(10u, writer.length());
+  EXPECT_FALSE(stream->rst_sent());
+  EXPECT_TRUE(QuicSessionPeer::GetResetStreamsAlarm(&session_)->IsSet());
+
+  EXPECT_CALL(*connection_, SendControlFrame(_))
+      .WillRepeatedly(Invoke(&ClearControlFrame));
+  EXPECT_CALL(*connection_,
+              OnStreamReset(stream->id(), QUIC_STREAM_CANCELLED));
+  alarm_factory_.FireAlarm(QuicSessionPeer::GetResetStreamsAlarm(&session_));
+  EXPECT_TRUE(stream->rst_sent());
+}
+
 TEST_P(QuicSessionTestServer, WriteUnidirectionalStream) {
   session_.set_writev_consumes_all_data(true);
   TestStream* stream4 = new TestStream(GetNthServerInitiatedUnidirectionalId(1),
@@ -6,6 +6,7 @@
 
 #include <limits>
 #include <string>
+#include <utility>
 
 #include "net/third_party/quiche/src/quic/core/quic_error_codes.h"
 #include "net/third_party/quiche/src/quic/core/quic_flow_controller.h"
@@ -127,7 +128,10 @@ PendingStream::PendingStream(QuicStreamId id, QuicSession* session)
                        kStreamReceiveWindowLimit,
                        session_->flow_controller()->auto_tune_receive_window(),
                        session_->flow_controller()),
-      sequencer_(this) {}
+      sequencer_(this) {
+  sequencer_.set_block_allocator(
+      session->connection()->helper()->GetStreamReceiveBufferAllocator());
+}
 
 void PendingStream::OnDataAvailable() {
   // Data should be kept in the sequencer so that
@@ -316,7 +320,10 @@ QuicStream::QuicStream(QuicStreamId id,
                  0,
                  false,
                  FlowController(id, session, type),
-                 session->flow_controller()) {}
+                 session->flow_controller()) {
+  sequencer_.set_block_allocator(
+      session->connection()->helper()->GetStreamReceiveBufferAllocator());
+}
 
 QuicStream::QuicStream(QuicStreamId id,
                        QuicSession* session,
@@ -756,6 +763,58 @@ QuicConsumedData QuicStream::WriteMemSlices(QuicMemSliceSpan span, bool fin) {
   return consumed_data;
 }
 
+QuicConsumedData QuicStream::WriteDataSource(
+    std::unique_ptr<QuicStreamDataSource> data_source,
+    bool fin) {
+  QuicConsumedData consumed_data(0, false);
+  if (data_source == nullptr || data_source->length() == 0) {
+    QUIC_BUG << "Empty data source";
+    return consumed_data;
+  }
+
+  if (fin_buffered_) {
+    QUIC_BUG << "Fin already buffered";
+    return consumed_data;
+  }
+
+  if (write_side_closed_) {
+    QUIC_DLOG(ERROR) << ENDPOINT << "Stream " << id()
+                     << " attempting to write when the write side is closed";
+    if (type_ == READ_UNIDIRECTIONAL) {
+      OnUnrecoverableError(QUIC_TRY_TO_WRITE_DATA_ON_READ_UNIDIRECTIONAL_STREAM,
+                           "Try to send data on read unidirectional stream");
+    }
+    return consumed_data;
+  }
+
+  if (!CanWriteNewData()) {
+    return consumed_data;
+  }
+
+  bool had_buffered_data = HasBufferedData();
+  QuicStreamOffset offset = send_buffer_.stream_offset();
+  consumed_data.bytes_consumed = data_source->length();
+  consumed_data.fin_consumed = fin;
+  send_buffer_.SaveDataSource(std::move(data_source));
+  if (offset > send_buffer_.stream_offset() ||
+      kMaxStreamLength < send_buffer_.stream_offset()) {
+    QUIC_BUG << "Write too many data via stream " << id_;
+    OnUnrecoverableError(
+        QUIC_STREAM_LENGTH_OVERFLOW,
+        quiche::QuicheStrCat("Write too many data via stream ", id_));
+    return consumed_data;
+  }
+  OnDataBuffered(offset, consumed_data.bytes_consumed, nullptr);
+  fin_buffered_ = fin;
+
+  if (!had_buffered_data) {
+    // Write data if there is no buffered data before.
+    WriteBufferedData();
+  }
+
+  return consumed_data;
+}
+
 bool QuicStream::HasPendingRetransmission() const {
   return send_buffer_.HasPendingRetransmission() || fin_lost_;
 }
@@ -1072,7 +1131,14 @@ bool QuicStream::WriteStreamData(QuicStreamOffset offset,
   DCHECK_LT(0u, data_length);
   QUIC_DVLOG(2) << ENDPOINT << "Write stream " << id_ << " data from offset "
                 << offset << " length " << data_length;
-  return send_buffer_.WriteStreamData(offset, data_length, writer);
+  if (!send_buffer_.WriteStreamData(offset, data_length, writer)) {
+    return false;
+  }
+  if (send_buffer_.data_source_failed() && !rst_sent_) {
+    // A packet is being serialized, so the stream cannot be reset right away.
+    session_->ResetStreamAfterWrite(id_, QUIC_STREAM_CANCELLED);
+  }
+  return true;
 }
 
 void QuicStream::WriteBufferedData() {
@@ -20,6 +20,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <list>
+#include <memory>
 #include <string>
 
 #include "net/third_party/quiche/src/quic/core/quic_flow_controller.h"
@@ -321,6 +322,12 @@ class QUIC_EXPORT_PRIVATE QuicStream
   // that data copy is avoided.
   QuicConsumedData WriteMemSlices(QuicMemSliceSpan span, bool fin);
 
+  // Same as WriteMemSlices except data is read from |data_source| only when
+  // it is framed into a packet. All of |data_source| is buffered or none is.
+  QuicConsumedData WriteDataSource(
+      std::unique_ptr<QuicStreamDataSource> data_source,
+      bool fin);
+
   // Returns true if any stream data is lost (including fin) and needs to be
   // retransmitted.
   virtual bool HasPendingRetransmission() const;
@@ -19,7 +19,7 @@ namespace {
 
 struct CompareOffset {
   bool operator()(const BufferedSlice& slice, QuicStreamOffset offset) const {
-    return slice.offset + slice.slice.length() < offset;
+    return slice.offset + slice.length() < offset;
   }
 };
 
@@ -28,6 +28,10 @@ struct CompareOffset {
 BufferedSlice::BufferedSlice(QuicMemSlice mem_slice, QuicStreamOffset offset)
     : slice(std::move(mem_slice)), offset(offset) {}
 
+BufferedSlice::BufferedSlice(std::unique_ptr<QuicStreamDataSource> data_source,
+                             QuicStreamOffset offset)
+    : data_source(std::move(data_source)), offset(offset) {}
+
 BufferedSlice::BufferedSlice(BufferedSlice&& other) = default;
 
 BufferedSlice& BufferedSlice::operator=(BufferedSlice&& other) = default;
@@ -35,10 +39,32 @@ BufferedSlice& BufferedSlice::operator=(BufferedSlice&& other) = default;
 BufferedSlice::~BufferedSlice() {}
 
 QuicInterval<std::size_t> BufferedSlice::interval() const {
-  const std::size_t length = slice.length();
+  const std::size_t length = this->length();
   return QuicInterval<std::size_t>(offset, offset + length);
 }
 
+QuicByteCount BufferedSlice::length() const {
+  if (data_source != nullptr) {
+    return data_source->length();
+  }
+  return slice.length();
+}
+
+void BufferedSlice::Reset() {
+  slice.Reset();
+  data_source.reset();
+}
+
+bool BufferedSlice::WriteData(QuicByteCount offset,
+                              QuicByteCount data_length,
+                              QuicDataWriter* writer) const {
+  DCHECK_LE(offset + data_length, length());
+  if (data_source != nullptr) {
+    return data_source->WriteData(offset, data_length, writer);
+  }
+  return writer->WriteBytes(slice.data() + offset, data_length);
+}
+
 bool StreamPendingRetransmission::operator==(
     const StreamPendingRetransmission& other) const {
   return offset == other.offset && length == other.length;
@@ -50,7 +76,8 @@ QuicStreamSendBuffer::QuicStreamSendBuffer(QuicBufferAllocator* allocator)
       allocator_(allocator),
       stream_bytes_written_(0),
       stream_bytes_outstanding_(0),
-      write_index_(-1) {}
+      write_index_(-1),
+      data_source_failed_(false) {}
 
 QuicStreamSendBuffer::~QuicStreamSendBuffer() {}
 
@@ -80,22 +107,38 @@ void QuicStreamSendBuffer::SaveMemSlice(QuicMemSlice slice) {
     QUIC_BUG << "Try to save empty MemSlice to send buffer.";
     return;
   }
-  size_t length = slice.length();
+  SaveBufferedSlice(BufferedSlice(std::move(slice), stream_offset_));
+}
+
+QuicByteCount QuicStreamSendBuffer::SaveMemSliceSpan(QuicMemSliceSpan span) {
+  return span.ConsumeAll(
+      [&](QuicMemSlice slice) { SaveMemSlice(std::move(slice)); });
+}
+
+QuicByteCount QuicStreamSendBuffer::SaveDataSource(
+    std::unique_ptr<QuicStreamDataSource> data_source) {
+  const QuicByteCount length = data_source->length();
+  QUIC_DVLOG(2) << "Save data source offset " << stream_offset_ << " length "
+                << length;
+  if (length == 0) {
+    QUIC_BUG << "Try to save empty data source to send buffer.";
+    return 0;
+  }
+  SaveBufferedSlice(BufferedSlice(std::move(data_source), stream_offset_));
+  return length;
+}
+
+void QuicStreamSendBuffer::SaveBufferedSlice(BufferedSlice bs) {
+  const QuicByteCount length = bs.length();
   // Need to start the offsets at the right interval.
   if (interval_deque_.Empty()) {
     const QuicStreamOffset end = stream_offset_ + length;
     current_end_offset_ = std::max(current_end_offset_, end);
   }
-  BufferedSlice bs = BufferedSlice(std::move(slice), stream_offset_);
   interval_deque_.PushBack(std::move(bs));
   stream_offset_ += length;
 }
 
-QuicByteCount QuicStreamSendBuffer::SaveMemSliceSpan(QuicMemSliceSpan span) {
-  return span.ConsumeAll(
-      [&](QuicMemSlice slice) { SaveMemSlice(std::move(slice)); });
-}
-
 void QuicStreamSendBuffer::OnStreamDataConsumed(size_t bytes_consumed) {
   stream_bytes_written_ += bytes_consumed;
   stream_bytes_outstanding_ += bytes_consumed;
@@ -118,17 +161,30 @@ bool QuicStreamSendBuffer::WriteStreamData(QuicStreamOffset offset,
 
     QuicByteCount slice_offset = offset - slice_it->offset;
     QuicByteCount available_bytes_in_slice =
-        slice_it->slice.length() - slice_offset;
+        slice_it->length() - slice_offset;
     QuicByteCount copy_length = std::min(data_length, available_bytes_in_slice);
-    if (!writer->WriteBytes(slice_it->slice.data() + slice_offset,
-                            copy_length)) {
-      QUIC_BUG << "Writer fails to write.";
-      return false;
+    if (!slice_it->WriteData(slice_offset, copy_length, writer)) {
+      if (slice_it->data_source == nullptr ||
+          writer->remaining() < copy_length) {
+        QUIC_BUG << "Writer fails to write.";
+        return false;
+      }
+      // The data source cannot produce its bytes, e.g. because the file behind
+      // it got truncated or could not be read. The frame being serialized
+      // already accounts for them, so write zeros in their place rather than
+      // failing the whole packet. The stream gets reset by its owner.
+      QUIC_DLOG(ERROR) << "Data source fails to write " << copy_length
+                       << " bytes at stream offset " << offset;
+      QUIC_CODE_COUNT(quic_stream_data_source_failed);
+      data_source_failed_ = true;
+      if (!writer->WritePaddingBytes(copy_length)) {
+        QUIC_BUG << "Writer fails to write.";
+        return false;
+      }
     }
     offset += copy_length;
     data_length -= copy_length;
-    const QuicStreamOffset new_end =
-        slice_it->offset + slice_it->slice.length();
+    const QuicStreamOffset new_end = slice_it->offset + slice_it->length();
     current_end_offset_ = std::max(current_end_offset_, new_end);
   }
   return data_length == 0;
@@ -227,7 +283,7 @@ StreamPendingRetransmission QuicStreamSendBuffer::NextPendingRetransmission()
 bool QuicStreamSendBuffer::FreeMemSlices(QuicStreamOffset start,
                                          QuicStreamOffset end) {
   auto it = interval_deque_.DataBegin();
-  if (it == interval_deque_.DataEnd() || it->slice.empty()) {
+  if (it == interval_deque_.DataEnd() || it->empty()) {
     QUIC_BUG << "Trying to ack stream data [" << start << ", " << end << "), "
              << (it == interval_deque_.DataEnd()
                      ? "and there is no outstanding data."
@@ -239,7 +295,7 @@ bool QuicStreamSendBuffer::FreeMemSlices(QuicStreamOffset start,
     it = std::lower_bound(interval_deque_.DataBegin(),
                           interval_deque_.DataEnd(), start, CompareOffset());
   }
-  if (it == interval_deque_.DataEnd() || it->slice.empty()) {
+  if (it == interval_deque_.DataEnd() || it->empty()) {
     QUIC_BUG << "Offset " << start << " with iterator offset: " << it->offset
              << (it == interval_deque_.DataEnd() ? " does not exist."
                                                  : " has already been acked.");
@@ -249,9 +305,9 @@ bool QuicStreamSendBuffer::FreeMemSlices(QuicStreamOffset start,
     if (it->offset >= end) {
       break;
     }
-    if (!it->slice.empty() &&
-        bytes_acked_.Contains(it->offset, it->offset + it->slice.length())) {
-      it->slice.Reset();
+    if (!it->empty() &&
+        bytes_acked_.Contains(it->offset, it->offset + it->length())) {
+      it->Reset();
     }
   }
   return true;
@@ -259,12 +315,12 @@ bool QuicStreamSendBuffer::FreeMemSlices(QuicStreamOffset start,
 
 void QuicStreamSendBuffer::CleanUpBufferedSlices() {
   while (!interval_deque_.Empty() &&
-         interval_deque_.DataBegin()->slice.empty()) {
+         interval_deque_.DataBegin()->empty()) {
     QUIC_BUG_IF(interval_deque_.DataBegin()->offset > current_end_offset_)
         << "Fail to pop front from interval_deque_. Front element contained "
            "a slice whose data has not all be written. Front offset "
         << interval_deque_.DataBegin()->offset << " length "
-        << interval_deque_.DataBegin()->slice.length();
+        << interval_deque_.DataBegin()->length();
     interval_deque_.PopFront();
   }
 }
@@ -5,6 +5,8 @@
 #ifndef QUICHE_QUIC_CORE_QUIC_STREAM_SEND_BUFFER_H_
 #define QUICHE_QUIC_CORE_QUIC_STREAM_SEND_BUFFER_H_
 
+#include <memory>
+
 #include "net/third_party/quiche/src/quic/core/frames/quic_stream_frame.h"
 #include "net/third_party/quiche/src/quic/core/quic_circular_deque.h"
 #include "net/third_party/quiche/src/quic/core/quic_interval_deque.h"
@@ -23,12 +25,33 @@ class QuicStreamPeer;
 
 class QuicDataWriter;
 
+// Supplies stream data which the send buffer does not hold in memory, such as
+// a region of a file. The send buffer asks for bytes only when they are
+// framed, again for each retransmission, and destroys the source once all of
+// its data is acked.
+class QUIC_EXPORT_PRIVATE QuicStreamDataSource {
+ public:
+  virtual ~QuicStreamDataSource() {}
+
+  // Number of bytes supplied by this source. Must not change.
+  virtual QuicByteCount length() const = 0;
+
+  // Appends |data_length| bytes starting at |offset| within this source to
+  // |writer|. Returns false without advancing |writer| if the data does not
+  // fit or cannot be produced.
+  virtual bool WriteData(QuicByteCount offset,
+                         QuicByteCount data_length,
+                         QuicDataWriter* writer) = 0;
+};
+
 // BufferedSlice comprises information of a piece of stream data stored in
-// contiguous memory space. Please note, BufferedSlice is constructed when
-// stream data is saved in send buffer and is removed when stream data is fully
-// acked. It is move-only.
+// contiguous memory space, or supplied by a QuicStreamDataSource. Please note,
+// BufferedSlice is constructed when stream data is saved in send buffer and is
+// removed when stream data is fully acked. It is move-only.
 struct QUIC_EXPORT_PRIVATE BufferedSlice {
   BufferedSlice(QuicMemSlice mem_slice, QuicStreamOffset offset);
+  BufferedSlice(std::unique_ptr<QuicStreamDataSource> data_source,
+                QuicStreamOffset offset);
   BufferedSlice(BufferedSlice&& other);
   BufferedSlice& operator=(BufferedSlice&& other);
 
@@ -39,8 +62,24 @@ struct QUIC_EXPORT_PRIVATE BufferedSlice {
   // Return an interval representing the offset and length.
   QuicInterval<std::size_t> interval() const;
 
-  // Stream data of this data slice.
+  // Number of bytes of stream data in this slice. Zero once the data has been
+  // released.
+  QuicByteCount length() const;
+  bool empty() const { return length() == 0; }
+
+  // Releases the stream data of this slice.
+  void Reset();
+
+  // Appends |data_length| bytes starting at |offset| within this slice to
+  // |writer|.
+  bool WriteData(QuicByteCount offset,
+                 QuicByteCount data_length,
+                 QuicDataWriter* writer) const;
+
+  // Stream data of this data slice, if it is held in memory.
   QuicMemSlice slice;
+  // Supplier of the stream data of this data slice otherwise.
+  std::unique_ptr<QuicStreamDataSource> data_source;
   // Location of this data slice in the stream.
   QuicStreamOffset offset;
 };
@@ -81,10 +120,17 @@ class QUIC_EXPORT_PRIVATE QuicStreamSendBuffer {
   // Save all slices in |span| to send buffer. Return total bytes saved.
   QuicByteCount SaveMemSliceSpan(QuicMemSliceSpan span);
 
+  // Save data supplied by |data_source| to send buffer. The data is read from
+  // |data_source| only when it is written. Returns the number of bytes saved.
+  QuicByteCount SaveDataSource(
+      std::unique_ptr<QuicStreamDataSource> data_source);
+
   // Called when |bytes_consumed| bytes has been consumed by the stream.
   void OnStreamDataConsumed(size_t bytes_consumed);
 
-  // Write |data_length| of data starts at |offset|.
+  // Write |data_length| of data starts at |offset|. If a data source fails to
+  // produce its part of the data, zeros are written instead and
+  // data_source_failed() becomes true; this is not reported as a failure.
   bool WriteStreamData(QuicStreamOffset offset,
                        QuicByteCount data_length,
                        QuicDataWriter* writer);
@@ -133,6 +179,8 @@ class QUIC_EXPORT_PRIVATE QuicStreamSendBuffer {
     return pending_retransmissions_;
   }
 
+  bool data_source_failed() const { return data_source_failed_; }
+
  private:
   friend class test::QuicStreamSendBufferPeer;
   friend class test::QuicStreamPeer;
@@ -142,6 +190,9 @@ class QUIC_EXPORT_PRIVATE QuicStreamSendBuffer {
   // not exist or has been acked.
   bool FreeMemSlices(QuicStreamOffset start, QuicStreamOffset end);
 
+  // Appends |bs| to the send buffer.
+  void SaveBufferedSlice(BufferedSlice bs);
+
   // Cleanup empty slices in order from buffered_slices_.
   void CleanUpBufferedSlices();
 
@@ -170,6 +221,9 @@ class QUIC_EXPORT_PRIVATE QuicStreamSendBuffer {
   // Index of slice which contains data waiting to be written for the first
   // time. -1 if send buffer is empty or all data has been written.
   int32_t write_index_;
+
+  // True if a data source failed to produce its data.
+  bool data_source_failed_;
 };
 
 }  // namespace quic
@@ -4,7 +4,9 @@
 
 #include "net/third_party/quiche/src/quic/core/quic_stream_send_buffer.h"
 
+#include <memory>
 #include <string>
+#include <utility>
 
 #include "net/third_party/quiche/src/quic/core/quic_data_writer.h"
 #include "net/third_party/quiche/src/quic/core/quic_simple_buffer_allocator.h"
@@ -350,6 +352,92 @@ TEST_F(QuicStreamSendBufferTest, SaveEmptyMemSliceSpan) {
   EXPECT_EQ(10u, send_buffer.size());
 }
 
+// Supplies |data| and records when it is destroyed.
+class TestDataSource : public QuicStreamDataSource {
+ public:
+  TestDataSource(std::string data, bool* destroyed)
+      : data_(std::move(data)), destroyed_(destroyed) {}
+  ~TestDataSource() override { *destroyed_ = true; }
+
+  QuicByteCount length() const override { return data_.length(); }
+  bool WriteData(QuicByteCount offset,
+                 QuicByteCount data_length,
+                 QuicDataWriter* writer) override {
+    return writer->WriteBytes(data_.data() + offset, data_length);
+  }
+
+ private:
+  const std::string data_;
+  bool* destroyed_;
+};
+
+TEST_F(QuicStreamSendBufferTest, SaveDataSource) {
+  bool destroyed = false;
+  std::string source_data = std::string(100, 'e') + std::string(100, 'f');
+  EXPECT_EQ(200u, send_buffer_.SaveDataSource(
+                      std::make_unique<TestDataSource>(source_data,
+                                                       &destroyed)));
+  EXPECT_EQ(5u, send_buffer_.size());
+  EXPECT_EQ(4040u, send_buffer_.stream_offset());
+
+  // Write across the boundary between memory and data source slices.
+  char buf[4100];
+  QuicDataWriter writer(4100, buf, quiche::HOST_BYTE_ORDER);
+  ASSERT_TRUE(send_buffer_.WriteStreamData(0, 4040, &writer));
+  send_buffer_.OnStreamDataConsumed(4040);
+  EXPECT_EQ(std::string(768, 'd') + source_data,
+            std::string(buf + 3072, 968));
+
+  // Retransmissions read from the data source again.
+  QuicDataWriter writer2(4100, buf, quiche::HOST_BYTE_ORDER);
+  ASSERT_TRUE(send_buffer_.WriteStreamData(3940, 50, &writer2));
+  EXPECT_EQ(std::string(50, 'e'), std::string(buf, 50));
+
+  // The data source is destroyed once all of its data is acked.
+  QuicByteCount newly_acked_length;
+  EXPECT_TRUE(send_buffer_.OnStreamDataAcked(3840, 150, &newly_acked_length));
+  EXPECT_FALSE(destroyed);
+  EXPECT_TRUE(send_buffer_.OnStreamDataAcked(3990, 50, &newly_acked_length));
+  EXPECT_TRUE(destroyed);
+}
+
+// Supplies |length| bytes which can never be read.
+class FailingDataSource : public QuicStreamDataSource {
+ public:
+  explicit FailingDataSource(QuicByteCount length) : length_(length) {}
+
+  QuicByteCount length() const override { return length_; }
+  bool WriteData(QuicByteCount /*offset*/,
+                 QuicByteCount /*data_length*/,
+                 QuicDataWriter* /*writer*/) override {
+    return false;
+  }
+
+ private:
+  const QuicByteCount length_;
+};
+
+TEST_F(QuicStreamSendBufferTest, DataSourceFails) {
+  EXPECT_EQ(100u, send_buffer_.SaveDataSource(
+                      std::make_unique<FailingDataSource>(100)));
+  EXPECT_FALSE(send_buffer_.data_source_failed());
+
+  // Bytes of the failing data source are written as zeros, without failing
+  // the write.
+  char buf[4100];
+  QuicDataWriter writer(4100, buf, quiche::HOST_BYTE_ORDER);
+  ASSERT_TRUE(send_buffer_.WriteStreamData(0, 3940, &writer));
+  EXPECT_TRUE(send_buffer_.data_source_failed());
+  EXPECT_EQ(3940u, writer.length());
+  EXPECT_EQ(std::string(40, 'd') + std::string(100, '\0'),
+            std::string(buf + 3800, 140));
+
+  // Running out of space in the writer is still a bug.
+  QuicDataWriter writer2(50, buf, quiche::HOST_BYTE_ORDER);
+  EXPECT_QUIC_BUG(send_buffer_.WriteStreamData(3840, 100, &writer2),
+                  "Writer fails to write.");
+}
+
 }  // namespace
 }  // namespace test
 }  // namespace quic
@@ -229,6 +229,16 @@ void QuicStreamSequencer::MarkConsumed(size_t num_bytes_consumed) {
   stream_->AddBytesConsumed(num_bytes_consumed);
 }
 
+bool QuicStreamSequencer::ReadSlice(size_t max_length,
+                                    QuicReceivedSlice* slice) {
+  DCHECK(!blocked_);
+  if (!buffered_frames_.ReadSlice(max_length, slice)) {
+    return false;
+  }
+  stream_->AddBytesConsumed(slice->length());
+  return true;
+}
+
 void QuicStreamSequencer::SetBlockedUntilFlush() {
   blocked_ = true;
 }
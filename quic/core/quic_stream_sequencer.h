@@ -93,6 +93,11 @@ class QUIC_EXPORT_PRIVATE QuicStreamSequencer {
   // to do zero-copy reads.
   void MarkConsumed(size_t num_bytes);
 
+  // Consumes up to |max_length| bytes of the next readable region and moves
+  // them into |slice|, which owns them from then on.  Returns false if there is
+  // nothing to read.
+  bool ReadSlice(size_t max_length, QuicReceivedSlice* slice);
+
   // Appends all of the readable data to |buffer| and marks all of the appended
   // data as consumed.
   void Read(std::string* buffer);
@@ -125,6 +130,12 @@ class QUIC_EXPORT_PRIVATE QuicStreamSequencer {
   // Free the memory of underlying buffer when no bytes remain in it.
   void ReleaseBufferIfEmpty();
 
+  // Sets the allocator for the blocks of the underlying buffer. Must be called
+  // before any data is buffered.
+  void set_block_allocator(QuicBufferAllocator* allocator) {
+    buffered_frames_.set_block_allocator(allocator);
+  }
+
   // Number of bytes in the buffer right now.
   size_t NumBytesBuffered() const;
 
@@ -4,10 +4,14 @@
 
 #include "net/third_party/quiche/src/quic/core/quic_stream_sequencer_buffer.h"
 
+#include <algorithm>
+#include <cstring>
 #include <string>
+#include <utility>
 
 #include "net/third_party/quiche/src/quic/core/quic_constants.h"
 #include "net/third_party/quiche/src/quic/core/quic_interval.h"
+#include "net/third_party/quiche/src/quic/core/quic_simple_buffer_allocator.h"
 #include "net/third_party/quiche/src/quic/platform/api/quic_bug_tracker.h"
 #include "net/third_party/quiche/src/quic/platform/api/quic_flag_utils.h"
 #include "net/third_party/quiche/src/quic/platform/api/quic_flags.h"
@@ -28,13 +32,21 @@ size_t CalculateBlockCount(size_t max_capacity_bytes) {
 // arrives.
 const size_t kMaxNumDataIntervalsAllowed = 2 * kMaxPacketGap;
 
+// Allocates blocks for buffers which have no block allocator set.
+QuicBufferAllocator* DefaultBlockAllocator() {
+  static SimpleBufferAllocator* allocator = new SimpleBufferAllocator();
+  return allocator;
+}
+
 }  // namespace
 
 QuicStreamSequencerBuffer::QuicStreamSequencerBuffer(size_t max_capacity_bytes)
     : max_buffer_capacity_bytes_(max_capacity_bytes),
       blocks_count_(CalculateBlockCount(max_capacity_bytes)),
       total_bytes_read_(0),
-      blocks_(nullptr) {
+      blocks_(nullptr),
+      block_allocator_(DefaultBlockAllocator()),
+      retired_block_(nullptr) {
   Clear();
 }
 
@@ -55,12 +67,25 @@ void QuicStreamSequencerBuffer::Clear() {
   bytes_received_.Add(0, total_bytes_read_);
 }
 
+void QuicStreamSequencerBuffer::set_block_allocator(
+    QuicBufferAllocator* allocator) {
+  DCHECK(blocks_ == nullptr);
+  block_allocator_ =
+      allocator != nullptr ? allocator : DefaultBlockAllocator();
+}
+
 bool QuicStreamSequencerBuffer::RetireBlock(size_t index) {
   if (blocks_[index] == nullptr) {
     QUIC_BUG << "Try to retire block twice";
     return false;
   }
-  delete blocks_[index];
+  if (retired_block_ != nullptr) {
+    DCHECK(*retired_block_ == nullptr);
+    *retired_block_ = QuicUniqueBufferPtr(blocks_[index]->buffer,
+                                          QuicBufferDeleter(block_allocator_));
+  } else {
+    block_allocator_->Delete(blocks_[index]->buffer);
+  }
   blocks_[index] = nullptr;
   QUIC_DVLOG(1) << "Retired block with index: " << index;
   return true;
@@ -182,9 +207,9 @@ bool QuicStreamSequencerBuffer::CopyStreamData(QuicStreamOffset offset,
       return false;
     }
     if (blocks_[write_block_num] == nullptr) {
-      // TODO(danzh): Investigate if using a freelist would improve performance.
       // Same as RetireBlock().
-      blocks_[write_block_num] = new BufferBlock();
+      blocks_[write_block_num] = reinterpret_cast<BufferBlock*>(
+          block_allocator_->New(sizeof(BufferBlock)));
     }
 
     const size_t bytes_to_copy =
@@ -388,6 +413,35 @@ bool QuicStreamSequencerBuffer::MarkConsumed(size_t bytes_consumed) {
   return true;
 }
 
+bool QuicStreamSequencerBuffer::ReadSlice(size_t max_length,
+                                          QuicReceivedSlice* slice) {
+  iovec iov;
+  if (max_length == 0 || !GetReadableRegion(&iov)) {
+    return false;
+  }
+  // The first readable region never extends past the end of its block.
+  const size_t bytes_to_read = std::min<size_t>(max_length, iov.iov_len);
+  const char* data = static_cast<const char*>(iov.iov_base);
+
+  QuicUniqueBufferPtr retired_block(nullptr, QuicBufferDeleter(nullptr));
+  retired_block_ = &retired_block;
+  const bool consumed = MarkConsumed(bytes_to_read);
+  retired_block_ = nullptr;
+  DCHECK(consumed);
+
+  if (retired_block != nullptr) {
+    // The block held nothing else, so hand it over as is.
+    *slice = QuicReceivedSlice(std::move(retired_block), data, bytes_to_read);
+    return true;
+  }
+  // The block is still in use, so |data| is still valid.
+  QuicUniqueBufferPtr copy = MakeUniqueBuffer(block_allocator_, bytes_to_read);
+  memcpy(copy.get(), data, bytes_to_read);
+  const char* copy_data = copy.get();
+  *slice = QuicReceivedSlice(std::move(copy), copy_data, bytes_to_read);
+  return true;
+}
+
 size_t QuicStreamSequencerBuffer::FlushBufferedFrames() {
   size_t prev_total_bytes_read = total_bytes_read_;
   total_bytes_read_ = NextExpectedByte();
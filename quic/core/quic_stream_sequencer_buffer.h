@@ -64,8 +64,10 @@
 #include <memory>
 #include <string>
 
+#include "net/third_party/quiche/src/quic/core/quic_buffer_allocator.h"
 #include "net/third_party/quiche/src/quic/core/quic_interval_set.h"
 #include "net/third_party/quiche/src/quic/core/quic_packets.h"
+#include "net/third_party/quiche/src/quic/core/quic_received_slice.h"
 #include "net/third_party/quiche/src/quic/core/quic_types.h"
 #include "net/third_party/quiche/src/quic/platform/api/quic_export.h"
 #include "net/third_party/quiche/src/quic/platform/api/quic_iovec.h"
@@ -100,6 +102,11 @@ class QUIC_EXPORT_PRIVATE QuicStreamSequencerBuffer {
   // Free the space used to buffer data.
   void Clear();
 
+  // Sets the allocator which blocks are allocated from and returned to. If
+  // null, blocks are allocated with new[], which is the default. Must be called
+  // before any data is buffered.
+  void set_block_allocator(QuicBufferAllocator* allocator);
+
   // Returns true if there is nothing to read in this buffer.
   bool Empty() const;
 
@@ -143,6 +150,13 @@ class QUIC_EXPORT_PRIVATE QuicStreamSequencerBuffer {
   // Pre-requisite: bytes_consumed <= available bytes to read.
   bool MarkConsumed(size_t bytes_consumed);
 
+  // Consumes up to |max_length| bytes of the next readable region, without
+  // going past the end of its block, and moves them into |slice|. If no other
+  // buffered data shares the block, |slice| takes ownership of the block and
+  // nothing is copied. Otherwise the bytes are copied into a buffer from the
+  // block allocator. Returns false if there is nothing to read.
+  bool ReadSlice(size_t max_length, QuicReceivedSlice* slice);
+
   // Deletes and records as consumed any buffered data and clear the buffer.
   // (To be called only after sequencer's StopReading has been called.)
   size_t FlushBufferedFrames();
@@ -229,6 +243,13 @@ class QUIC_EXPORT_PRIVATE QuicStreamSequencerBuffer {
   // Number of bytes in buffer.
   size_t num_bytes_buffered_;
 
+  // Allocator for blocks. Unowned.
+  QuicBufferAllocator* block_allocator_;
+
+  // If not null, RetireBlock() moves the retired block here instead of
+  // freeing it. Only set during ReadSlice().
+  QuicUniqueBufferPtr* retired_block_;
+
   // Currently received data.
   QuicIntervalSet<QuicStreamOffset> bytes_received_;
 };
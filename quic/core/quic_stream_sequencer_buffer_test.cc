@@ -11,6 +11,7 @@
 #include <string>
 #include <utility>
 
+#include "net/third_party/quiche/src/quic/core/quic_pooled_buffer_allocator.h"
 #include "net/third_party/quiche/src/quic/platform/api/quic_logging.h"
 #include "net/third_party/quiche/src/quic/platform/api/quic_test.h"
 #include "net/third_party/quiche/src/quic/test_tools/quic_stream_sequencer_buffer_peer.h"
@@ -326,6 +327,73 @@ TEST_F(QuicStreamSequencerBufferTest, Readv100Bytes) {
   EXPECT_TRUE(helper_->CheckBufferInvariants());
 }
 
+TEST_F(QuicStreamSequencerBufferTest, BlockAllocator) {
+  QuicPooledBufferAllocator allocator(sizeof(BufferBlock),
+                                      /*min_free_buffers=*/1,
+                                      /*max_free_buffers=*/4);
+  buffer_->set_block_allocator(&allocator);
+  std::string source(100, 'a');
+  EXPECT_THAT(buffer_->OnStreamData(0, source, &written_, &error_details_),
+              IsQuicNoError());
+  BufferBlock* block_ptr = helper_->GetBlock(0);
+  ASSERT_NE(nullptr, block_ptr);
+  EXPECT_EQ(0u, allocator.num_free_buffers());
+
+  // Reading out the data returns the block to the allocator.
+  char dest[100];
+  iovec iov{dest, sizeof(dest)};
+  size_t read;
+  EXPECT_THAT(buffer_->Readv(&iov, 1, &read, &error_details_),
+              IsQuicNoError());
+  EXPECT_EQ(source, quiche::QuicheStringPiece(dest, read));
+  EXPECT_EQ(nullptr, helper_->GetBlock(0));
+  EXPECT_EQ(1u, allocator.num_free_buffers());
+
+  // The next block reuses it.
+  EXPECT_THAT(buffer_->OnStreamData(100, source, &written_, &error_details_),
+              IsQuicNoError());
+  EXPECT_EQ(block_ptr, helper_->GetBlock(0));
+  EXPECT_EQ(0u, allocator.num_free_buffers());
+  buffer_->Clear();
+  EXPECT_EQ(1u, allocator.num_free_buffers());
+  EXPECT_TRUE(helper_->CheckBufferInvariants());
+}
+
+TEST_F(QuicStreamSequencerBufferTest, ReadSlice) {
+  std::string source(100, 'a');
+  EXPECT_THAT(buffer_->OnStreamData(0, source, &written_, &error_details_),
+              IsQuicNoError());
+  BufferBlock* block_ptr = helper_->GetBlock(0);
+  // Data after a gap in the same block keeps the block in the buffer, so the
+  // slice gets a copy.
+  EXPECT_THAT(buffer_->OnStreamData(200, source, &written_, &error_details_),
+              IsQuicNoError());
+
+  QuicReceivedSlice slice;
+  ASSERT_TRUE(buffer_->ReadSlice(40, &slice));
+  EXPECT_EQ(source.substr(0, 40), slice.AsStringPiece());
+  EXPECT_NE(block_ptr->buffer, slice.data());
+  ASSERT_TRUE(buffer_->ReadSlice(1000, &slice));
+  EXPECT_EQ(source.substr(40), slice.AsStringPiece());
+  EXPECT_EQ(block_ptr, helper_->GetBlock(0));
+  EXPECT_FALSE(buffer_->ReadSlice(1000, &slice));
+
+  // Once the gap is filled and all data is read, the slice takes over the
+  // block without copying.
+  EXPECT_THAT(buffer_->OnStreamData(100, source, &written_, &error_details_),
+              IsQuicNoError());
+  ASSERT_TRUE(buffer_->ReadSlice(1000, &slice));
+  EXPECT_EQ(std::string(200, 'a'), slice.AsStringPiece());
+  EXPECT_EQ(block_ptr->buffer + 100, slice.data());
+  EXPECT_EQ(nullptr, helper_->GetBlock(0));
+  EXPECT_EQ(300u, buffer_->BytesConsumed());
+  EXPECT_TRUE(helper_->CheckBufferInvariants());
+
+  // The block stays valid after the buffer is gone.
+  buffer_.reset();
+  EXPECT_EQ(std::string(200, 'a'), slice.AsStringPiece());
+}
+
 TEST_F(QuicStreamSequencerBufferTest, ReadvAcrossBlocks) {
   std::string source(kBlockSizeBytes + 50, 'a');
   // Write 1st block to full and extand 50 bytes to next block.
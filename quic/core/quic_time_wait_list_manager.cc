@@ -20,7 +20,6 @@
 #include "net/third_party/quiche/src/quic/platform/api/quic_flag_utils.h"
 #include "net/third_party/quiche/src/quic/platform/api/quic_flags.h"
 #include "net/third_party/quiche/src/quic/platform/api/quic_logging.h"
-#include "net/third_party/quiche/src/quic/platform/api/quic_map_util.h"
 #include "net/third_party/quiche/src/quic/platform/api/quic_socket_address.h"
 #include "net/third_party/quiche/src/common/platform/api/quiche_string_piece.h"
 #include "net/third_party/quiche/src/common/platform/api/quiche_text_utils.h"
@@ -74,23 +73,28 @@ void QuicTimeWaitListManager::AddConnectionIdToTimeWait(
   DCHECK(action != SEND_TERMINATION_PACKETS || termination_packets != nullptr);
   DCHECK(action != DO_NOTHING || ietf_quic);
   int num_packets = 0;
-  auto it = connection_id_map_.find(connection_id);
-  const bool new_connection_id = it == connection_id_map_.end();
+  const QuicTimeWaitTable::Entry* entry =
+      connection_id_table_.Find(connection_id);
+  const bool new_connection_id = entry == nullptr;
   if (!new_connection_id) {  // Replace record if it is reinserted.
-    num_packets = it->second.num_packets;
-    connection_id_map_.erase(it);
+    num_packets = entry->num_packets;
+    connection_id_table_.Remove(connection_id);
   }
   TrimTimeWaitListIfNeeded();
   int64_t max_connections =
       GetQuicFlag(FLAGS_quic_time_wait_list_max_connections);
-  DCHECK(connection_id_map_.empty() ||
+  DCHECK(connection_id_table_.empty() ||
          num_connections() < static_cast<size_t>(max_connections));
-  ConnectionIdData data(num_packets, ietf_quic, clock_->ApproximateNow(),
-                        action);
   if (termination_packets != nullptr) {
-    data.termination_packets.swap(*termination_packets);
+    // The table keeps its own copies, so the packets are released here.
+    connection_id_table_.Add(connection_id, clock_->ApproximateNow(),
+                             num_packets, action, ietf_quic,
+                             *termination_packets);
+    termination_packets->clear();
+  } else {
+    connection_id_table_.Add(connection_id, clock_->ApproximateNow(),
+                             num_packets, action, ietf_quic, {});
   }
-  connection_id_map_.emplace(std::make_pair(connection_id, std::move(data)));
   if (new_connection_id) {
     visitor_->OnConnectionAddedToTimeWaitList(connection_id);
   }
@@ -98,7 +102,7 @@ void QuicTimeWaitListManager::AddConnectionIdToTimeWait(
 
 bool QuicTimeWaitListManager::IsConnectionIdInTimeWait(
     QuicConnectionId connection_id) const {
-  return QuicContainsKey(connection_id_map_, connection_id);
+  return connection_id_table_.Contains(connection_id);
 }
 
 void QuicTimeWaitListManager::OnBlockedWriterCanWrite() {
@@ -121,10 +125,10 @@ void QuicTimeWaitListManager::ProcessPacket(
   DCHECK(IsConnectionIdInTimeWait(connection_id));
   // TODO(satyamshekhar): Think about handling packets from different peer
   // addresses.
-  auto it = connection_id_map_.find(connection_id);
-  DCHECK(it != connection_id_map_.end());
+  QuicTimeWaitTable::Entry* connection_data =
+      connection_id_table_.Find(connection_id);
+  DCHECK(connection_data != nullptr);
   // Increment the received packet count.
-  ConnectionIdData* connection_data = &it->second;
   ++(connection_data->num_packets);
 
   if (!ShouldSendResponse(connection_data->num_packets)) {
@@ -136,12 +140,12 @@ void QuicTimeWaitListManager::ProcessPacket(
   QUIC_DLOG(INFO) << "Processing " << connection_id << " in time wait state: "
                   << "header format=" << header_format
                   << " ietf=" << connection_data->ietf_quic
-                  << ", action=" << connection_data->action
+                  << ", action=" << static_cast<int>(connection_data->action)
                   << ", number termination packets="
-                  << connection_data->termination_packets.size();
-  switch (connection_data->action) {
+                  << static_cast<int>(connection_data->num_termination_packets);
+  switch (static_cast<TimeWaitAction>(connection_data->action)) {
     case SEND_TERMINATION_PACKETS:
-      if (connection_data->termination_packets.empty()) {
+      if (connection_data->num_termination_packets == 0) {
         QUIC_BUG << "There are no termination packets.";
         return;
       }
@@ -167,23 +171,17 @@ void QuicTimeWaitListManager::ProcessPacket(
           break;
       }
 
-      for (const auto& packet : connection_data->termination_packets) {
-        SendOrQueuePacket(std::make_unique<QueuedPacket>(
-                              self_address, peer_address, packet->Clone()),
-                          packet_context.get());
-      }
+      SendTerminationPackets(*connection_data, self_address, peer_address,
+                             packet_context.get());
       return;
 
     case SEND_CONNECTION_CLOSE_PACKETS:
-      if (connection_data->termination_packets.empty()) {
+      if (connection_data->num_termination_packets == 0) {
         QUIC_BUG << "There are no termination packets.";
         return;
       }
-      for (const auto& packet : connection_data->termination_packets) {
-        SendOrQueuePacket(std::make_unique<QueuedPacket>(
-                              self_address, peer_address, packet->Clone()),
-                          packet_context.get());
-      }
+      SendTerminationPackets(*connection_data, self_address, peer_address,
+                             packet_context.get());
       return;
 
     case SEND_STATELESS_RESET:
@@ -199,6 +197,23 @@ void QuicTimeWaitListManager::ProcessPacket(
   }
 }
 
+void QuicTimeWaitListManager::SendTerminationPackets(
+    const QuicTimeWaitTable::Entry& connection_data,
+    const QuicSocketAddress& self_address,
+    const QuicSocketAddress& peer_address,
+    const QuicPerPacketContext* packet_context) {
+  for (size_t i = 0; i < connection_data.num_termination_packets; ++i) {
+    quiche::QuicheStringPiece packet =
+        connection_id_table_.TerminationPacket(connection_data, i);
+    // Queued packets may outlive the entry, so each gets its own copy.
+    SendOrQueuePacket(
+        std::make_unique<QueuedPacket>(
+            self_address, peer_address,
+            QuicEncryptedPacket(packet.data(), packet.length()).Clone()),
+        packet_context);
+  }
+}
+
 void QuicTimeWaitListManager::SendVersionNegotiationPacket(
     QuicConnectionId server_connection_id,
     QuicConnectionId client_connection_id,
@@ -333,9 +348,8 @@ bool QuicTimeWaitListManager::WriteToWire(QueuedPacket* queued_packet) {
 
 void QuicTimeWaitListManager::SetConnectionIdCleanUpAlarm() {
   QuicTime::Delta next_alarm_interval = QuicTime::Delta::Zero();
-  if (!connection_id_map_.empty()) {
-    QuicTime oldest_connection_id =
-        connection_id_map_.begin()->second.time_added;
+  if (!connection_id_table_.empty()) {
+    QuicTime oldest_connection_id = connection_id_table_.Oldest()->time_added;
     QuicTime now = clock_->ApproximateNow();
     if (now - oldest_connection_id < time_wait_period_) {
       next_alarm_interval = oldest_connection_id + time_wait_period_ - now;
@@ -354,19 +368,21 @@ void QuicTimeWaitListManager::SetConnectionIdCleanUpAlarm() {
 
 bool QuicTimeWaitListManager::MaybeExpireOldestConnection(
     QuicTime expiration_time) {
-  if (connection_id_map_.empty()) {
+  const QuicTimeWaitTable::Entry* oldest = connection_id_table_.Oldest();
+  if (oldest == nullptr) {
     return false;
   }
-  auto it = connection_id_map_.begin();
-  QuicTime oldest_connection_id_time = it->second.time_added;
+  QuicTime oldest_connection_id_time = oldest->time_added;
   if (oldest_connection_id_time > expiration_time) {
     // Too recent, don't retire.
     return false;
   }
   // This connection_id has lived its age, retire it now.
-  QUIC_DLOG(INFO) << "Connection " << it->first
+  const QuicConnectionId connection_id = oldest->connection_id;
+  QUIC_DLOG(INFO) << "Connection " << connection_id
                   << " expired from time wait list";
-  connection_id_map_.erase(it);
+  connection_id_table_.RemoveOldest();
+  visitor_->OnConnectionRemovedFromTimeWaitList(connection_id);
   return true;
 }
 
@@ -386,27 +402,12 @@ void QuicTimeWaitListManager::TrimTimeWaitListIfNeeded() {
   if (kMaxConnections < 0) {
     return;
   }
-  while (!connection_id_map_.empty() &&
+  while (!connection_id_table_.empty() &&
          num_connections() >= static_cast<size_t>(kMaxConnections)) {
     MaybeExpireOldestConnection(QuicTime::Infinite());
   }
 }
 
-QuicTimeWaitListManager::ConnectionIdData::ConnectionIdData(
-    int num_packets,
-    bool ietf_quic,
-    QuicTime time_added,
-    TimeWaitAction action)
-    : num_packets(num_packets),
-      ietf_quic(ietf_quic),
-      time_added(time_added),
-      action(action) {}
-
-QuicTimeWaitListManager::ConnectionIdData::ConnectionIdData(
-    ConnectionIdData&& other) = default;
-
-QuicTimeWaitListManager::ConnectionIdData::~ConnectionIdData() = default;
-
 QuicUint128 QuicTimeWaitListManager::GetStatelessResetToken(
     QuicConnectionId connection_id) const {
   return QuicUtils::GenerateStatelessResetToken(connection_id);
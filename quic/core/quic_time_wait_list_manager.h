@@ -16,6 +16,7 @@
 #include "net/third_party/quiche/src/quic/core/quic_packet_writer.h"
 #include "net/third_party/quiche/src/quic/core/quic_packets.h"
 #include "net/third_party/quiche/src/quic/core/quic_session.h"
+#include "net/third_party/quiche/src/quic/core/quic_time_wait_table.h"
 #include "net/third_party/quiche/src/quic/platform/api/quic_containers.h"
 #include "net/third_party/quiche/src/quic/platform/api/quic_flags.h"
 
@@ -58,6 +59,10 @@ class QUIC_NO_EXPORT QuicTimeWaitListManager
     // Called after the given connection is added to the time-wait list.
     virtual void OnConnectionAddedToTimeWaitList(
         QuicConnectionId connection_id) = 0;
+
+    // Called after the given connection expires from the time-wait list.
+    virtual void OnConnectionRemovedFromTimeWaitList(
+        QuicConnectionId connection_id) = 0;
   };
 
   // writer - the entity that writes to the socket. (Owned by the caller)
@@ -119,7 +124,7 @@ class QUIC_NO_EXPORT QuicTimeWaitListManager
   void TrimTimeWaitListIfNeeded();
 
   // The number of connections on the time-wait list.
-  size_t num_connections() const { return connection_id_map_.size(); }
+  size_t num_connections() const { return connection_id_table_.size(); }
 
   // Sends a version negotiation packet for |server_connection_id| and
   // |client_connection_id| announcing support for |supported_versions| to
@@ -208,6 +213,12 @@ class QUIC_NO_EXPORT QuicTimeWaitListManager
   // number of received packets.
   bool ShouldSendResponse(int received_packet_count);
 
+  // Sends or queues copies of the termination packets of |connection_data|.
+  void SendTerminationPackets(const QuicTimeWaitTable::Entry& connection_data,
+                              const QuicSocketAddress& self_address,
+                              const QuicSocketAddress& peer_address,
+                              const QuicPerPacketContext* packet_context);
+
   // Sends the packet out. Returns true if the packet was successfully consumed.
   // If the writer got blocked and did not buffer the packet, we'll need to keep
   // the packet and retry sending. In case of all other errors we drop the
@@ -220,43 +231,20 @@ class QUIC_NO_EXPORT QuicTimeWaitListManager
   // Removes the oldest connection from the time-wait list if it was added prior
   // to "expiration_time".  To unconditionally remove the oldest connection, use
   // a QuicTime::Delta:Infinity().  This function modifies the
-  // connection_id_map_.  If you plan to call this function in a loop, any
-  // iterators that you hold before the call to this function may be invalid
+  // connection_id_table_.  If you plan to call this function in a loop, any
+  // entries that you hold before the call to this function may be invalid
   // afterward.  Returns true if the oldest connection was expired.  Returns
-  // false if the map is empty or the oldest connection has not expired.
+  // false if the table is empty or the oldest connection has not expired.
   bool MaybeExpireOldestConnection(QuicTime expiration_time);
 
   std::unique_ptr<QuicEncryptedPacket> BuildIetfStatelessResetPacket(
       QuicConnectionId connection_id);
 
-  // A map from a recently closed connection_id to the number of packets
-  // received after the termination of the connection bound to the
-  // connection_id.
-  struct QUIC_NO_EXPORT ConnectionIdData {
-    ConnectionIdData(int num_packets,
-                     bool ietf_quic,
-                     QuicTime time_added,
-                     TimeWaitAction action);
-
-    ConnectionIdData(const ConnectionIdData& other) = delete;
-    ConnectionIdData(ConnectionIdData&& other);
-
-    ~ConnectionIdData();
-
-    int num_packets;
-    bool ietf_quic;
-    QuicTime time_added;
-    // These packets may contain CONNECTION_CLOSE frames, or SREJ messages.
-    std::vector<std::unique_ptr<QuicEncryptedPacket>> termination_packets;
-    TimeWaitAction action;
-  };
-
-  // QuicLinkedHashMap allows lookup by ConnectionId and traversal in add order.
-  typedef QuicLinkedHashMap<QuicConnectionId,
-                            ConnectionIdData,
-                            QuicConnectionIdHash>
-      ConnectionIdMap;
-  ConnectionIdMap connection_id_map_;
+  // Maps a recently closed connection_id to the number of packets received
+  // after the termination of the connection bound to the connection_id, and
+  // to the termination packets to respond with, which may contain
+  // CONNECTION_CLOSE frames, or SREJ messages. Allows traversal in add order.
+  QuicTimeWaitTable connection_id_table_;
 
   // Pending termination packets that need to be sent out to the peer when we
   // are given a chance to write by the dispatcher.
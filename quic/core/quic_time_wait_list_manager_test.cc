@@ -26,6 +26,7 @@
 #include "net/third_party/quiche/src/quic/test_tools/quic_time_wait_list_manager_peer.h"
 
 using testing::_;
+using testing::AnyNumber;
 using testing::Args;
 using testing::Assign;
 using testing::DoAll;
@@ -141,6 +142,8 @@ class QuicTimeWaitListManagerTest : public QuicTest {
   void SetUp() override {
     EXPECT_CALL(writer_, IsWriteBlocked())
         .WillRepeatedly(ReturnPointee(&writer_is_blocked_));
+    EXPECT_CALL(visitor_, OnConnectionRemovedFromTimeWaitList(_))
+        .Times(AnyNumber());
   }
 
   void AddConnectionId(QuicConnectionId connection_id,
@@ -430,6 +433,8 @@ TEST_F(QuicTimeWaitListManagerTest, CleanUpOldConnectionIds) {
   // interval.
   QuicTime next_alarm_time = clock_.Now() + time_wait_period - offset;
   EXPECT_CALL(alarm_factory_, OnAlarmSet(_, next_alarm_time));
+  EXPECT_CALL(visitor_, OnConnectionRemovedFromTimeWaitList(_))
+      .Times(kOldConnectionIdCount);
 
   time_wait_list_manager_.CleanUpOldConnectionIds();
   for (uint64_t conn_id = 1; conn_id <= kConnectionIdCount; ++conn_id) {
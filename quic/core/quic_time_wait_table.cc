@@ -0,0 +1,290 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/third_party/quiche/src/quic/core/quic_time_wait_table.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+#include "net/third_party/quiche/src/quic/platform/api/quic_bug_tracker.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_logging.h"
+
+namespace quic {
+
+namespace {
+
+const size_t kMinIndexCapacity = 16;
+
+// Size of a slab block. Blocks holding the packets of a single entry may be
+// larger.
+const size_t kSlabBlockSize = 64 * 1024;
+
+// Prefixed to each termination packet in the slab.
+using PacketLength = uint16_t;
+
+}  // namespace
+
+QuicTimeWaitTable::QuicTimeWaitTable()
+    : ring_begin_(0),
+      slots_(kMinIndexCapacity, Slot{0, 0}),
+      size_(0),
+      slab_begin_(0),
+      spare_block_{nullptr, 0, 0, 0} {}
+
+QuicTimeWaitTable::~QuicTimeWaitTable() = default;
+
+// static
+uint32_t QuicTimeWaitTable::HashConnectionId(QuicConnectionId connection_id) {
+  // The top bit tells occupied slots from empty ones. The index never grows
+  // large enough for it to affect which slot an entry goes into.
+  return static_cast<uint32_t>(connection_id.Hash()) | 0x80000000u;
+}
+
+void QuicTimeWaitTable::Add(
+    QuicConnectionId connection_id,
+    QuicTime time_added,
+    int num_packets,
+    uint8_t action,
+    bool ietf_quic,
+    const std::vector<std::unique_ptr<QuicEncryptedPacket>>&
+        termination_packets) {
+  if ((size_ + 1) * 4 > slots_.size() * 3) {
+    Rehash(slots_.size() * 2);
+  }
+  const uint32_t hash = HashConnectionId(connection_id);
+  const size_t slot_index = FindSlot(connection_id, hash);
+  if (slots_[slot_index].hash != 0) {
+    QUIC_BUG << "Connection ID " << connection_id
+             << " is already in time wait state.";
+    return;
+  }
+
+  const uint32_t position =
+      ring_begin_ + static_cast<uint32_t>(ring_.size());
+  ring_.emplace_back();
+  Entry& entry = ring_.back();
+  entry.connection_id = connection_id;
+  entry.time_added = time_added;
+  entry.num_packets = num_packets;
+  entry.action = action;
+  entry.ietf_quic = ietf_quic;
+  entry.live = true;
+  StorePackets(termination_packets, &entry);
+
+  slots_[slot_index] = Slot{position, hash};
+  ++size_;
+}
+
+QuicTimeWaitTable::Entry* QuicTimeWaitTable::Find(
+    QuicConnectionId connection_id) {
+  const Slot& slot =
+      slots_[FindSlot(connection_id, HashConnectionId(connection_id))];
+  if (slot.hash == 0) {
+    return nullptr;
+  }
+  return &EntryAt(slot.position);
+}
+
+const QuicTimeWaitTable::Entry* QuicTimeWaitTable::Find(
+    QuicConnectionId connection_id) const {
+  const Slot& slot =
+      slots_[FindSlot(connection_id, HashConnectionId(connection_id))];
+  if (slot.hash == 0) {
+    return nullptr;
+  }
+  return &EntryAt(slot.position);
+}
+
+bool QuicTimeWaitTable::Remove(QuicConnectionId connection_id) {
+  const size_t slot_index =
+      FindSlot(connection_id, HashConnectionId(connection_id));
+  if (slots_[slot_index].hash == 0) {
+    return false;
+  }
+  EntryAt(slots_[slot_index].position).live = false;
+  EraseSlot(slot_index);
+  --size_;
+  PopRemovedEntries();
+  return true;
+}
+
+const QuicTimeWaitTable::Entry* QuicTimeWaitTable::Oldest() const {
+  if (ring_.empty()) {
+    return nullptr;
+  }
+  DCHECK(ring_.front().live);
+  return &ring_.front();
+}
+
+void QuicTimeWaitTable::RemoveOldest() {
+  DCHECK(!ring_.empty());
+  const bool removed = Remove(ring_.front().connection_id);
+  DCHECK(removed);
+}
+
+quiche::QuicheStringPiece QuicTimeWaitTable::TerminationPacket(
+    const Entry& entry,
+    size_t index) const {
+  DCHECK_LT(index, entry.num_termination_packets);
+  const SlabBlock& block =
+      slab_[static_cast<uint32_t>(entry.packets_block - slab_begin_)];
+  const char* data = block.data.get() + entry.packets_offset;
+  PacketLength length;
+  for (size_t i = 0;; ++i) {
+    memcpy(&length, data, sizeof(length));
+    data += sizeof(length);
+    if (i == index) {
+      return quiche::QuicheStringPiece(data, length);
+    }
+    data += length;
+  }
+}
+
+size_t QuicTimeWaitTable::MemoryUsage() const {
+  size_t usage = slots_.capacity() * sizeof(Slot) +
+                 ring_.capacity() * sizeof(Entry) +
+                 slab_.capacity() * sizeof(SlabBlock) + spare_block_.size;
+  for (const SlabBlock& block : slab_) {
+    usage += block.size;
+  }
+  return usage;
+}
+
+size_t QuicTimeWaitTable::FindSlot(QuicConnectionId connection_id,
+                                   uint32_t hash) const {
+  const size_t mask = slots_.size() - 1;
+  for (size_t i = hash & mask;; i = (i + 1) & mask) {
+    const Slot& slot = slots_[i];
+    if (slot.hash == 0 ||
+        (slot.hash == hash &&
+         EntryAt(slot.position).connection_id == connection_id)) {
+      return i;
+    }
+  }
+}
+
+void QuicTimeWaitTable::EraseSlot(size_t slot_index) {
+  // Backward shift deletion: move later slots of the same probe sequence into
+  // the hole, so that lookups never need tombstones.
+  const size_t mask = slots_.size() - 1;
+  size_t hole = slot_index;
+  for (size_t i = (hole + 1) & mask; slots_[i].hash != 0; i = (i + 1) & mask) {
+    const size_t home = slots_[i].hash & mask;
+    // Slot i may fill the hole if its home is not after the hole, cyclically.
+    if (((i - home) & mask) >= ((i - hole) & mask)) {
+      slots_[hole] = slots_[i];
+      hole = i;
+    }
+  }
+  slots_[hole] = Slot{0, 0};
+
+  if (slots_.size() > kMinIndexCapacity && size_ * 8 < slots_.size()) {
+    Rehash(slots_.size() / 2);
+  }
+}
+
+void QuicTimeWaitTable::Rehash(size_t capacity) {
+  DCHECK_GE(capacity, kMinIndexCapacity);
+  DCHECK_LT(capacity, static_cast<size_t>(std::numeric_limits<int32_t>::max()));
+  std::vector<Slot> old_slots(capacity, Slot{0, 0});
+  old_slots.swap(slots_);
+  const size_t mask = capacity - 1;
+  for (const Slot& slot : old_slots) {
+    if (slot.hash == 0) {
+      continue;
+    }
+    size_t i = slot.hash & mask;
+    while (slots_[i].hash != 0) {
+      i = (i + 1) & mask;
+    }
+    slots_[i] = slot;
+  }
+}
+
+void QuicTimeWaitTable::StorePackets(
+    const std::vector<std::unique_ptr<QuicEncryptedPacket>>&
+        termination_packets,
+    Entry* entry) {
+  size_t num_bytes = 0;
+  size_t num_packets = 0;
+  for (const auto& packet : termination_packets) {
+    if (packet->length() > std::numeric_limits<PacketLength>::max() ||
+        num_packets == std::numeric_limits<uint8_t>::max()) {
+      QUIC_BUG << "Dropping termination packet of " << packet->length()
+               << " bytes.";
+      break;
+    }
+    num_bytes += sizeof(PacketLength) + packet->length();
+    ++num_packets;
+  }
+  entry->num_termination_packets = num_packets;
+  if (num_packets == 0) {
+    return;
+  }
+
+  if (slab_.empty() || slab_.back().size - slab_.back().used < num_bytes) {
+    SlabBlock block{nullptr, 0, 0, 0};
+    if (num_bytes <= kSlabBlockSize && spare_block_.data != nullptr) {
+      block = std::move(spare_block_);
+      spare_block_ = SlabBlock{nullptr, 0, 0, 0};
+    } else {
+      block.size = std::max(kSlabBlockSize, num_bytes);
+      block.data.reset(new char[block.size]);
+    }
+    slab_.push_back(std::move(block));
+  }
+  SlabBlock& block = slab_.back();
+  entry->packets_block = slab_begin_ + static_cast<uint32_t>(slab_.size() - 1);
+  entry->packets_offset = static_cast<uint32_t>(block.used);
+  ++block.num_entries;
+
+  char* data = block.data.get() + block.used;
+  for (size_t i = 0; i < num_packets; ++i) {
+    const QuicEncryptedPacket& packet = *termination_packets[i];
+    const PacketLength length = static_cast<PacketLength>(packet.length());
+    memcpy(data, &length, sizeof(length));
+    data += sizeof(length);
+    memcpy(data, packet.data(), length);
+    data += length;
+  }
+  block.used += num_bytes;
+}
+
+void QuicTimeWaitTable::ReleasePackets(const Entry& entry) {
+  if (entry.num_termination_packets == 0) {
+    return;
+  }
+  // Entries leave the ring in the order they were added, which is the order
+  // their packets were stored in, so blocks empty out from the front.
+  SlabBlock& block =
+      slab_[static_cast<uint32_t>(entry.packets_block - slab_begin_)];
+  DCHECK_LT(0u, block.num_entries);
+  --block.num_entries;
+  while (!slab_.empty() && slab_.front().num_entries == 0) {
+    if (slab_.size() == 1) {
+      // Keep the last block to store further packets in.
+      slab_.front().used = 0;
+      break;
+    }
+    if (spare_block_.data == nullptr &&
+        slab_.front().size == kSlabBlockSize) {
+      spare_block_ = std::move(slab_.front());
+      spare_block_.used = 0;
+    }
+    slab_.pop_front();
+    ++slab_begin_;
+  }
+}
+
+void QuicTimeWaitTable::PopRemovedEntries() {
+  while (!ring_.empty() && !ring_.front().live) {
+    ReleasePackets(ring_.front());
+    ring_.pop_front();
+    ++ring_begin_;
+  }
+}
+
+}  // namespace quic
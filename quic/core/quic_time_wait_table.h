@@ -0,0 +1,170 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef QUICHE_QUIC_CORE_QUIC_TIME_WAIT_TABLE_H_
+#define QUICHE_QUIC_CORE_QUIC_TIME_WAIT_TABLE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "net/third_party/quiche/src/quic/core/quic_circular_deque.h"
+#include "net/third_party/quiche/src/quic/core/quic_connection_id.h"
+#include "net/third_party/quiche/src/quic/core/quic_packets.h"
+#include "net/third_party/quiche/src/quic/core/quic_time.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_export.h"
+#include "net/third_party/quiche/src/common/platform/api/quiche_string_piece.h"
+
+namespace quic {
+
+// A compact table of connection IDs in time wait state, ordered by the time
+// they were added.
+//
+// Entries live in a ring in the order they were added, and are looked up
+// through an open addressing (linear probing) index of ring positions.
+// Termination packets are copied into a slab of large blocks which are
+// allocated and released in the same order as the entries, so that adding an
+// entry costs no per packet allocations and the oldest entry can be removed
+// in O(1).
+class QUIC_EXPORT_PRIVATE QuicTimeWaitTable {
+ public:
+  struct QUIC_EXPORT_PRIVATE Entry {
+    QuicConnectionId connection_id;
+    QuicTime time_added = QuicTime::Zero();
+    // Number of packets received for this connection ID in time wait state.
+    int num_packets = 0;
+    // The QuicTimeWaitListManager::TimeWaitAction of this connection ID.
+    uint8_t action = 0;
+    bool ietf_quic = false;
+    uint8_t num_termination_packets = 0;
+
+   private:
+    friend class QuicTimeWaitTable;
+
+    // False once the entry has been removed from the index.
+    bool live = false;
+    // Termination packets are stored back to back in slab block
+    // |packets_block|, each prefixed with a uint16_t length.
+    uint32_t packets_block = 0;
+    uint32_t packets_offset = 0;
+  };
+
+  QuicTimeWaitTable();
+  QuicTimeWaitTable(const QuicTimeWaitTable&) = delete;
+  QuicTimeWaitTable& operator=(const QuicTimeWaitTable&) = delete;
+  ~QuicTimeWaitTable();
+
+  // Adds |connection_id|, which must not be in the table, as the newest entry
+  // and copies |termination_packets| into the table.
+  void Add(QuicConnectionId connection_id,
+           QuicTime time_added,
+           int num_packets,
+           uint8_t action,
+           bool ietf_quic,
+           const std::vector<std::unique_ptr<QuicEncryptedPacket>>&
+               termination_packets);
+
+  // Returns the entry for |connection_id|, or nullptr if there is none. The
+  // entry stays valid until the table is next modified.
+  Entry* Find(QuicConnectionId connection_id);
+  const Entry* Find(QuicConnectionId connection_id) const;
+
+  bool Contains(QuicConnectionId connection_id) const {
+    return Find(connection_id) != nullptr;
+  }
+
+  // Removes the entry for |connection_id|. Returns false if there is none.
+  bool Remove(QuicConnectionId connection_id);
+
+  // Returns the entry which was added first, or nullptr if the table is
+  // empty.
+  const Entry* Oldest() const;
+
+  // Removes the entry which was added first. The table must not be empty.
+  void RemoveOldest();
+
+  // Returns termination packet |index| of |entry|.
+  quiche::QuicheStringPiece TerminationPacket(const Entry& entry,
+                                              size_t index) const;
+
+  // Number of connection IDs in the table.
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  // Approximate number of bytes allocated by the table.
+  size_t MemoryUsage() const;
+
+ private:
+  // An index slot refers to the entry at ring position |position|. |hash| is
+  // the hash of the entry's connection ID, which always has its top bit set,
+  // or 0 if the slot is empty.
+  struct QUIC_EXPORT_PRIVATE Slot {
+    uint32_t position;
+    uint32_t hash;
+  };
+
+  struct QUIC_EXPORT_PRIVATE SlabBlock {
+    std::unique_ptr<char[]> data;
+    size_t size;
+    size_t used;
+    // Number of entries, live or not, with packets in this block.
+    size_t num_entries;
+  };
+
+  static uint32_t HashConnectionId(QuicConnectionId connection_id);
+
+  Entry& EntryAt(uint32_t position) {
+    return ring_[static_cast<uint32_t>(position - ring_begin_)];
+  }
+  const Entry& EntryAt(uint32_t position) const {
+    return ring_[static_cast<uint32_t>(position - ring_begin_)];
+  }
+
+  // Returns the index of the slot referring to |connection_id|, or of the
+  // empty slot where it would be inserted.
+  size_t FindSlot(QuicConnectionId connection_id, uint32_t hash) const;
+
+  // Empties slot |slot_index| without breaking the probe sequence of the
+  // slots after it.
+  void EraseSlot(size_t slot_index);
+
+  // Rebuilds the index with |capacity| slots.
+  void Rehash(size_t capacity);
+
+  // Copies |termination_packets| into the slab, and records where in
+  // |entry|.
+  void StorePackets(const std::vector<std::unique_ptr<QuicEncryptedPacket>>&
+                        termination_packets,
+                    Entry* entry);
+
+  // Releases the packets of |entry|, which is about to leave the ring.
+  void ReleasePackets(const Entry& entry);
+
+  // Pops removed entries off the front of the ring.
+  void PopRemovedEntries();
+
+  // Entries in the order they were added. Removed entries stay in the ring,
+  // with |live| unset, until they reach its front, so the front entry is
+  // always live.
+  QuicCircularDeque<Entry> ring_;
+  // Ring position of ring_.front(). Positions keep increasing, wrapping
+  // around at 2^32, as entries are added.
+  uint32_t ring_begin_;
+
+  // Open addressing index, with a power of two number of slots.
+  std::vector<Slot> slots_;
+  size_t size_;
+
+  // Slab blocks, oldest first. The block with sequence number n is
+  // slab_[n - slab_begin_].
+  QuicCircularDeque<SlabBlock> slab_;
+  uint32_t slab_begin_;
+  // A released block kept to avoid reallocating one.
+  SlabBlock spare_block_;
+};
+
+}  // namespace quic
+
+#endif  // QUICHE_QUIC_CORE_QUIC_TIME_WAIT_TABLE_H_
@@ -0,0 +1,174 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/third_party/quiche/src/quic/core/quic_time_wait_table.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "net/third_party/quiche/src/quic/platform/api/quic_test.h"
+#include "net/third_party/quiche/src/quic/test_tools/quic_test_utils.h"
+
+namespace quic {
+namespace test {
+namespace {
+
+class QuicTimeWaitTableTest : public QuicTest {
+ protected:
+  QuicTime TimeAt(int64_t milliseconds) {
+    return QuicTime::Zero() + QuicTime::Delta::FromMilliseconds(milliseconds);
+  }
+
+  // Returns a single termination packet filled with |length| bytes of
+  // |content|.
+  std::vector<std::unique_ptr<QuicEncryptedPacket>> Packets(size_t length,
+                                                            char content) {
+    buffers_.push_back(std::string(length, content));
+    std::vector<std::unique_ptr<QuicEncryptedPacket>> packets;
+    packets.push_back(std::make_unique<QuicEncryptedPacket>(
+        buffers_.back().data(), buffers_.back().length()));
+    return packets;
+  }
+
+  void AddConnectionId(uint64_t connection_id_number, int64_t milliseconds) {
+    table_.Add(TestConnectionId(connection_id_number), TimeAt(milliseconds),
+               /*num_packets=*/0, /*action=*/0, /*ietf_quic=*/true,
+               Packets(100, 'a'));
+  }
+
+  std::vector<std::string> buffers_;
+  QuicTimeWaitTable table_;
+};
+
+TEST_F(QuicTimeWaitTableTest, AddAndFind) {
+  EXPECT_TRUE(table_.empty());
+  EXPECT_EQ(nullptr, table_.Oldest());
+  EXPECT_EQ(nullptr, table_.Find(TestConnectionId(1)));
+
+  table_.Add(TestConnectionId(1), TimeAt(1), /*num_packets=*/3,
+             /*action=*/2, /*ietf_quic=*/false, {});
+  EXPECT_EQ(1u, table_.size());
+  EXPECT_TRUE(table_.Contains(TestConnectionId(1)));
+  EXPECT_FALSE(table_.Contains(TestConnectionId(2)));
+
+  QuicTimeWaitTable::Entry* entry = table_.Find(TestConnectionId(1));
+  ASSERT_NE(nullptr, entry);
+  EXPECT_EQ(TestConnectionId(1), entry->connection_id);
+  EXPECT_EQ(TimeAt(1), entry->time_added);
+  EXPECT_EQ(3, entry->num_packets);
+  EXPECT_EQ(2u, entry->action);
+  EXPECT_FALSE(entry->ietf_quic);
+  EXPECT_EQ(0u, entry->num_termination_packets);
+
+  ++entry->num_packets;
+  EXPECT_EQ(4, table_.Find(TestConnectionId(1))->num_packets);
+}
+
+TEST_F(QuicTimeWaitTableTest, TerminationPackets) {
+  std::vector<std::unique_ptr<QuicEncryptedPacket>> packets =
+      Packets(1200, 'a');
+  packets.push_back(std::move(Packets(30, 'b')[0]));
+  table_.Add(TestConnectionId(1), TimeAt(1), 0, 0, true, packets);
+  table_.Add(TestConnectionId(2), TimeAt(2), 0, 0, true, Packets(40, 'c'));
+
+  const QuicTimeWaitTable::Entry* entry = table_.Find(TestConnectionId(1));
+  ASSERT_EQ(2u, entry->num_termination_packets);
+  EXPECT_EQ(std::string(1200, 'a'), table_.TerminationPacket(*entry, 0));
+  EXPECT_EQ(std::string(30, 'b'), table_.TerminationPacket(*entry, 1));
+
+  entry = table_.Find(TestConnectionId(2));
+  ASSERT_EQ(1u, entry->num_termination_packets);
+  EXPECT_EQ(std::string(40, 'c'), table_.TerminationPacket(*entry, 0));
+
+  // Packets larger than a slab block are stored in a block of their own.
+  packets.clear();
+  for (int i = 0; i < 60; ++i) {
+    packets.push_back(std::move(Packets(1400, 'd' + i % 10)[0]));
+  }
+  table_.Add(TestConnectionId(3), TimeAt(3), 0, 0, true, packets);
+  entry = table_.Find(TestConnectionId(3));
+  ASSERT_EQ(60u, entry->num_termination_packets);
+  for (int i = 0; i < 60; ++i) {
+    EXPECT_EQ(std::string(1400, 'd' + i % 10),
+              table_.TerminationPacket(*entry, i));
+  }
+}
+
+TEST_F(QuicTimeWaitTableTest, OldestFirst) {
+  for (uint64_t i = 1; i <= 3; ++i) {
+    AddConnectionId(i, i);
+  }
+  EXPECT_EQ(TestConnectionId(1), table_.Oldest()->connection_id);
+
+  // A removed entry no longer counts as the oldest.
+  EXPECT_TRUE(table_.Remove(TestConnectionId(1)));
+  EXPECT_FALSE(table_.Remove(TestConnectionId(1)));
+  EXPECT_EQ(TestConnectionId(2), table_.Oldest()->connection_id);
+
+  // Removing and adding an entry again makes it the newest.
+  EXPECT_TRUE(table_.Remove(TestConnectionId(2)));
+  AddConnectionId(2, 4);
+  EXPECT_EQ(TestConnectionId(3), table_.Oldest()->connection_id);
+  EXPECT_EQ(2u, table_.size());
+
+  table_.RemoveOldest();
+  EXPECT_EQ(TestConnectionId(2), table_.Oldest()->connection_id);
+  EXPECT_EQ(TimeAt(4), table_.Oldest()->time_added);
+  table_.RemoveOldest();
+  EXPECT_TRUE(table_.empty());
+  EXPECT_EQ(nullptr, table_.Oldest());
+}
+
+TEST_F(QuicTimeWaitTableTest, RemoveFromMiddle) {
+  // Removing entries in any order keeps the others reachable.
+  const uint64_t kNumConnectionIds = 1000;
+  for (uint64_t i = 0; i < kNumConnectionIds; ++i) {
+    AddConnectionId(i, i);
+  }
+  for (uint64_t i = 0; i < kNumConnectionIds; i += 3) {
+    EXPECT_TRUE(table_.Remove(TestConnectionId(i)));
+  }
+  for (uint64_t i = 0; i < kNumConnectionIds; ++i) {
+    EXPECT_EQ(i % 3 != 0, table_.Contains(TestConnectionId(i))) << i;
+  }
+  EXPECT_EQ(TestConnectionId(1), table_.Oldest()->connection_id);
+  EXPECT_EQ(std::string(100, 'a'),
+            table_.TerminationPacket(*table_.Find(TestConnectionId(500)), 0));
+}
+
+TEST_F(QuicTimeWaitTableTest, LongConnectionIds) {
+  const char kLongId[] = "0123456789abcdefghij";
+  QuicConnectionId long_id(kLongId, 20);
+  table_.Add(long_id, TimeAt(1), 0, 0, true, {});
+  EXPECT_TRUE(table_.Contains(long_id));
+  EXPECT_FALSE(table_.Contains(QuicConnectionId(kLongId, 19)));
+  EXPECT_EQ(long_id, table_.Oldest()->connection_id);
+}
+
+TEST_F(QuicTimeWaitTableTest, MemoryIsReused) {
+  // Expiring the oldest entry as each new one is added keeps the table from
+  // growing.
+  const uint64_t kNumConnectionIds = 1000;
+  for (uint64_t i = 0; i < kNumConnectionIds; ++i) {
+    AddConnectionId(i, i);
+  }
+  const size_t memory_usage = table_.MemoryUsage();
+  for (uint64_t i = kNumConnectionIds; i < 20 * kNumConnectionIds; ++i) {
+    table_.RemoveOldest();
+    AddConnectionId(i, i);
+  }
+  EXPECT_EQ(kNumConnectionIds, table_.size());
+  EXPECT_GE(memory_usage * 2, table_.MemoryUsage());
+
+  // Once emptied, the table releases most of its memory.
+  while (!table_.empty()) {
+    table_.RemoveOldest();
+  }
+  EXPECT_GT(memory_usage, table_.MemoryUsage());
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace quic
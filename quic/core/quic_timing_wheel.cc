@@ -0,0 +1,304 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/third_party/quiche/src/quic/core/quic_timing_wheel.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "net/third_party/quiche/src/quic/platform/api/quic_bug_tracker.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_logging.h"
+
+namespace quic {
+
+const int QuicTimingWheel::kBitsPerLevel;
+const size_t QuicTimingWheel::kSlotsPerLevel;
+const int QuicTimingWheel::kNumLevels;
+const int32_t QuicTimingWheel::kOverflowLevel;
+const int32_t QuicTimingWheel::kExpiringLevel;
+const size_t QuicTimingWheel::kBitmapWords;
+
+QuicTimingWheel::Timer::~Timer() {
+  DCHECK(!scheduled()) << "Timer destroyed while scheduled.";
+}
+
+QuicTimingWheel::QuicTimingWheel(QuicTime::Delta granularity, QuicTime now)
+    : granularity_(granularity),
+      granularity_us_(std::max<int64_t>(1, granularity.ToMicroseconds())),
+      current_tick_(0),
+      size_(0) {
+  const int64_t now_us = (now - QuicTime::Zero()).ToMicroseconds();
+  current_tick_ = now_us > 0 ? now_us / granularity_us_ : 0;
+  memset(level_size_, 0, sizeof(level_size_));
+  memset(occupied_, 0, sizeof(occupied_));
+}
+
+QuicTimingWheel::~QuicTimingWheel() {
+  // Detach any timers still in the wheel so that they can be destroyed.
+  for (int level = 0; level < kNumLevels; ++level) {
+    for (size_t slot = 0; slot < kSlotsPerLevel; ++slot) {
+      TimerList* list = &slots_[level][slot];
+      while (!list->empty()) {
+        Unlink(list->next_);
+      }
+    }
+  }
+  while (!overflow_.empty()) {
+    Unlink(overflow_.next_);
+  }
+}
+
+void QuicTimingWheel::Schedule(Timer* timer, QuicTime deadline) {
+  DCHECK(!timer->scheduled());
+  uint64_t tick = ToTick(deadline);
+  if (tick <= current_tick_) {
+    tick = current_tick_ + 1;
+  }
+  timer->expiry_tick_ = tick;
+  Insert(timer);
+  ++size_;
+}
+
+void QuicTimingWheel::Cancel(Timer* timer) {
+  if (!timer->scheduled()) {
+    return;
+  }
+  Remove(timer);
+}
+
+void QuicTimingWheel::Reschedule(Timer* timer, QuicTime deadline) {
+  Cancel(timer);
+  Schedule(timer, deadline);
+}
+
+void QuicTimingWheel::AdvanceTo(QuicTime now) {
+  const int64_t now_us = (now - QuicTime::Zero()).ToMicroseconds();
+  const uint64_t now_tick = now_us > 0 ? now_us / granularity_us_ : 0;
+
+  while (current_tick_ < now_tick) {
+    // Skip over blocks of ticks in which nothing can happen.
+    int first_non_empty_level = 0;
+    while (first_non_empty_level < kNumLevels &&
+           level_size_[first_non_empty_level] == 0) {
+      ++first_non_empty_level;
+    }
+    if (first_non_empty_level > 0) {
+      const int shift = first_non_empty_level * kBitsPerLevel;
+      const uint64_t next_block = ((current_tick_ >> shift) + 1) << shift;
+      if (next_block > now_tick) {
+        current_tick_ = now_tick;
+        break;
+      }
+      current_tick_ = next_block - 1;
+    }
+
+    ++current_tick_;
+
+    // Entering a new block of a level brings the timers of the matching slot
+    // within range of the levels below. Cascade from the top down.
+    if (SlotIndex(current_tick_, 0) == 0) {
+      int new_block_levels = 1;
+      while (new_block_levels < kNumLevels &&
+             SlotIndex(current_tick_, new_block_levels) == 0) {
+        ++new_block_levels;
+      }
+      if (new_block_levels == kNumLevels) {
+        CascadeOverflow();
+        --new_block_levels;
+      }
+      for (int level = new_block_levels; level >= 1; --level) {
+        Cascade(level, SlotIndex(current_tick_, level));
+      }
+    }
+
+    ExpireSlot(SlotIndex(current_tick_, 0));
+  }
+}
+
+QuicTime QuicTimingWheel::NextWakeupTime() const {
+  if (size_ == 0) {
+    return QuicTime::Infinite();
+  }
+  for (int level = 0; level < kNumLevels; ++level) {
+    if (level_size_[level] == 0) {
+      continue;
+    }
+    const size_t slot =
+        NextOccupiedSlot(level, SlotIndex(current_tick_, level));
+    if (slot == kSlotsPerLevel) {
+      QUIC_BUG << "Level " << level << " has " << level_size_[level]
+               << " timers but no occupied slot.";
+      continue;
+    }
+    // For level 0 this is the expiry tick, for higher levels the first tick
+    // of the block at which the slot is cascaded.
+    const int shift = level * kBitsPerLevel;
+    const int block_shift = shift + kBitsPerLevel;
+    const uint64_t tick = ((current_tick_ >> block_shift) << block_shift) |
+                          (static_cast<uint64_t>(slot) << shift);
+    return FromTick(tick);
+  }
+  if (!overflow_.empty()) {
+    const int top_shift = kNumLevels * kBitsPerLevel;
+    return FromTick(((current_tick_ >> top_shift) + 1) << top_shift);
+  }
+  // Only timers which are being expired right now are left.
+  return FromTick(current_tick_ + 1);
+}
+
+QuicTime QuicTimingWheel::ExpiryTime(const Timer* timer) const {
+  DCHECK(timer->scheduled());
+  return FromTick(timer->expiry_tick_);
+}
+
+uint64_t QuicTimingWheel::ToTick(QuicTime deadline) const {
+  const int64_t deadline_us = (deadline - QuicTime::Zero()).ToMicroseconds();
+  if (deadline_us <= 0) {
+    return 0;
+  }
+  return (deadline_us + granularity_us_ - 1) / granularity_us_;
+}
+
+QuicTime QuicTimingWheel::FromTick(uint64_t tick) const {
+  return QuicTime::Zero() +
+         QuicTime::Delta::FromMicroseconds(tick * granularity_us_);
+}
+
+void QuicTimingWheel::Insert(Timer* timer) {
+  const uint64_t tick = timer->expiry_tick_;
+  DCHECK_GE(tick, current_tick_);
+  const uint64_t diff = tick ^ current_tick_;
+  for (int level = 0; level < kNumLevels; ++level) {
+    if ((diff >> ((level + 1) * kBitsPerLevel)) == 0) {
+      const size_t slot = SlotIndex(tick, level);
+      timer->level_ = level;
+      Link(&slots_[level][slot], timer);
+      SetSlotBit(level, slot);
+      ++level_size_[level];
+      return;
+    }
+  }
+  timer->level_ = kOverflowLevel;
+  Link(&overflow_, timer);
+}
+
+void QuicTimingWheel::Remove(Timer* timer) {
+  const int32_t level = timer->level_;
+  Unlink(timer);
+  if (level < kNumLevels) {
+    --level_size_[level];
+    const size_t slot = SlotIndex(timer->expiry_tick_, level);
+    if (slots_[level][slot].empty()) {
+      ClearSlotBit(level, slot);
+    }
+  }
+  --size_;
+}
+
+// static
+void QuicTimingWheel::Link(TimerList* list, Timer* timer) {
+  timer->prev_ = list->prev_;
+  timer->next_ = list;
+  list->prev_->next_ = timer;
+  list->prev_ = timer;
+}
+
+// static
+void QuicTimingWheel::Unlink(Timer* timer) {
+  timer->prev_->next_ = timer->next_;
+  timer->next_->prev_ = timer->prev_;
+  timer->prev_ = nullptr;
+  timer->next_ = nullptr;
+}
+
+// static
+void QuicTimingWheel::Splice(TimerList* list, TimerList* destination) {
+  if (list->empty()) {
+    return;
+  }
+  Timer* first = list->next_;
+  Timer* last = list->prev_;
+  first->prev_ = destination->prev_;
+  destination->prev_->next_ = first;
+  last->next_ = destination;
+  destination->prev_ = last;
+  list->prev_ = list->next_ = list;
+}
+
+void QuicTimingWheel::Cascade(int level, size_t slot) {
+  TimerList* list = &slots_[level][slot];
+  if (list->empty()) {
+    return;
+  }
+  TimerList pending;
+  Splice(list, &pending);
+  ClearSlotBit(level, slot);
+  while (!pending.empty()) {
+    Timer* timer = pending.next_;
+    Unlink(timer);
+    --level_size_[level];
+    Insert(timer);
+  }
+}
+
+void QuicTimingWheel::CascadeOverflow() {
+  TimerList pending;
+  Splice(&overflow_, &pending);
+  while (!pending.empty()) {
+    Timer* timer = pending.next_;
+    Unlink(timer);
+    Insert(timer);
+  }
+}
+
+void QuicTimingWheel::ExpireSlot(size_t slot) {
+  TimerList* list = &slots_[0][slot];
+  if (list->empty()) {
+    return;
+  }
+  // Move the timers out of the wheel first, so that OnTimerExpired() can
+  // freely schedule and cancel timers, including the ones about to expire.
+  TimerList expiring;
+  Splice(list, &expiring);
+  ClearSlotBit(0, slot);
+  for (Timer* timer = expiring.next_; timer != &expiring;
+       timer = timer->next_) {
+    DCHECK_EQ(current_tick_, timer->expiry_tick_);
+    timer->level_ = kExpiringLevel;
+    --level_size_[0];
+  }
+  while (!expiring.empty()) {
+    Timer* timer = expiring.next_;
+    Unlink(timer);
+    --size_;
+    timer->OnTimerExpired();
+  }
+}
+
+void QuicTimingWheel::SetSlotBit(int level, size_t slot) {
+  occupied_[level][slot / 64] |= uint64_t{1} << (slot % 64);
+}
+
+void QuicTimingWheel::ClearSlotBit(int level, size_t slot) {
+  occupied_[level][slot / 64] &= ~(uint64_t{1} << (slot % 64));
+}
+
+size_t QuicTimingWheel::NextOccupiedSlot(int level, size_t slot) const {
+  size_t next = slot + 1;
+  while (next < kSlotsPerLevel) {
+    uint64_t bits = occupied_[level][next / 64] >> (next % 64);
+    if (bits == 0) {
+      next = (next / 64 + 1) * 64;
+      continue;
+    }
+    while ((bits & 1) == 0) {
+      bits >>= 1;
+      ++next;
+    }
+    return next;
+  }
+  return kSlotsPerLevel;
+}
+
+}  // namespace quic
@@ -0,0 +1,165 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef QUICHE_QUIC_CORE_QUIC_TIMING_WHEEL_H_
+#define QUICHE_QUIC_CORE_QUIC_TIMING_WHEEL_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "net/third_party/quiche/src/quic/core/quic_time.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_export.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_logging.h"
+
+namespace quic {
+
+// A hierarchical timing wheel. Scheduling and cancelling a timer are O(1) and
+// never allocate; timers are stored in intrusive lists. Time is divided into
+// ticks of |granularity|, and a timer fires during the first AdvanceTo() call
+// whose |now| is at or past the end of the tick containing its deadline, so
+// timers never fire early but may fire up to |granularity| late.
+//
+// The wheel has kNumLevels levels of kSlotsPerLevel slots each. Level 0 holds
+// timers expiring within the current block of kSlotsPerLevel ticks, level 1
+// those expiring within the current block of kSlotsPerLevel^2 ticks, and so
+// on. When time enters a new block of a level, the timers in the matching slot
+// are cascaded down to lower levels. Timers beyond the range of the top level
+// are kept in an overflow list which is re-examined whenever the top level
+// wraps around.
+class QUIC_EXPORT_PRIVATE QuicTimingWheel {
+ public:
+  // A node in the wheel. Subclasses are notified through OnTimerExpired().
+  class QUIC_EXPORT_PRIVATE Timer {
+   public:
+    Timer() = default;
+    Timer(const Timer&) = delete;
+    Timer& operator=(const Timer&) = delete;
+    // The timer must not be scheduled when it is destroyed.
+    virtual ~Timer();
+
+    // Called by AdvanceTo() when the timer expires. The timer has already been
+    // removed from the wheel and may be rescheduled or destroyed.
+    virtual void OnTimerExpired() = 0;
+
+    bool scheduled() const { return next_ != nullptr; }
+
+   private:
+    friend class QuicTimingWheel;
+
+    Timer* prev_ = nullptr;
+    Timer* next_ = nullptr;
+    // The tick at which this timer expires.
+    uint64_t expiry_tick_ = 0;
+    // The level this timer is stored in, kOverflowLevel or kExpiringLevel.
+    int32_t level_ = 0;
+  };
+
+  static const int kBitsPerLevel = 8;
+  static const size_t kSlotsPerLevel = 1u << kBitsPerLevel;
+  static const int kNumLevels = 4;
+
+  // |now| is the current time, ticks are counted from there on.
+  QuicTimingWheel(QuicTime::Delta granularity, QuicTime now);
+  QuicTimingWheel(const QuicTimingWheel&) = delete;
+  QuicTimingWheel& operator=(const QuicTimingWheel&) = delete;
+  ~QuicTimingWheel();
+
+  // Schedules |timer| to expire at |deadline|. |timer| must not be scheduled.
+  // A |deadline| in the past expires on the next AdvanceTo().
+  void Schedule(Timer* timer, QuicTime deadline);
+
+  // Removes |timer| from the wheel. No-op if |timer| is not scheduled.
+  void Cancel(Timer* timer);
+
+  // Moves |timer| to |deadline|, whether or not it is scheduled.
+  void Reschedule(Timer* timer, QuicTime deadline);
+
+  // Expires all timers whose deadline is at or before |now|. Timers may be
+  // scheduled and cancelled from within OnTimerExpired(); a timer scheduled
+  // for the past from there expires one tick after the current one.
+  void AdvanceTo(QuicTime now);
+
+  // Returns the earliest time at which AdvanceTo() has work to do: either
+  // timers to expire or timers to cascade to a lower level. Returns
+  // QuicTime::Infinite() if the wheel is empty.
+  QuicTime NextWakeupTime() const;
+
+  // Returns the time |timer| will expire at, rounded up to the granularity.
+  QuicTime ExpiryTime(const Timer* timer) const;
+
+  size_t size() const { return size_; }
+
+  bool empty() const { return size_ == 0; }
+
+  QuicTime::Delta granularity() const { return granularity_; }
+
+ private:
+  // Sentinel of a circular intrusive list.
+  class TimerList : public Timer {
+   public:
+    TimerList() { prev_ = next_ = this; }
+    // Must be empty when destroyed.
+    ~TimerList() override {
+      DCHECK(empty());
+      prev_ = next_ = nullptr;
+    }
+    void OnTimerExpired() override {}
+
+    bool empty() const { return next_ == this; }
+  };
+
+  static const int32_t kOverflowLevel = kNumLevels;
+  // Timers moved to the list of timers expiring during AdvanceTo().
+  static const int32_t kExpiringLevel = kNumLevels + 1;
+  static const size_t kBitmapWords = kSlotsPerLevel / 64;
+
+  // Converts deadlines to ticks, rounding up.
+  uint64_t ToTick(QuicTime deadline) const;
+  QuicTime FromTick(uint64_t tick) const;
+
+  // Puts |timer| into the right slot for its expiry tick.
+  void Insert(Timer* timer);
+  // Unlinks |timer| from whatever list it is in, and updates bookkeeping.
+  void Remove(Timer* timer);
+
+  static void Link(TimerList* list, Timer* timer);
+  static void Unlink(Timer* timer);
+
+  // Moves all timers in |list| to |destination|.
+  static void Splice(TimerList* list, TimerList* destination);
+
+  // Re-inserts all timers of slot |slot| in level |level|.
+  void Cascade(int level, size_t slot);
+  // Re-inserts all overflow timers.
+  void CascadeOverflow();
+  // Expires all timers in level 0, slot |slot|.
+  void ExpireSlot(size_t slot);
+
+  void SetSlotBit(int level, size_t slot);
+  void ClearSlotBit(int level, size_t slot);
+  // Returns the first occupied slot in |level| after |slot|, or
+  // kSlotsPerLevel if there is none.
+  size_t NextOccupiedSlot(int level, size_t slot) const;
+
+  static size_t SlotIndex(uint64_t tick, int level) {
+    return (tick >> (level * kBitsPerLevel)) & (kSlotsPerLevel - 1);
+  }
+
+  const QuicTime::Delta granularity_;
+  const int64_t granularity_us_;
+  // All timers expiring at or before this tick have expired.
+  uint64_t current_tick_;
+  // Number of timers in the wheel, including overflow.
+  size_t size_;
+  // Number of timers in each level.
+  size_t level_size_[kNumLevels];
+  TimerList slots_[kNumLevels][kSlotsPerLevel];
+  // Bit set for each non-empty slot.
+  uint64_t occupied_[kNumLevels][kBitmapWords];
+  TimerList overflow_;
+};
+
+}  // namespace quic
+
+#endif  // QUICHE_QUIC_CORE_QUIC_TIMING_WHEEL_H_
@@ -0,0 +1,38 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/third_party/quiche/src/quic/core/quic_timing_wheel_alarm.h"
+
+#include <utility>
+
+#include "net/third_party/quiche/src/quic/platform/api/quic_logging.h"
+
+namespace quic {
+
+QuicTimingWheelAlarm::QuicTimingWheelAlarm(
+    QuicTimingWheelScheduler* scheduler,
+    QuicArenaScopedPtr<QuicAlarm::Delegate> delegate)
+    : QuicAlarm(std::move(delegate)), scheduler_(scheduler), timer_(this) {}
+
+QuicTimingWheelAlarm::~QuicTimingWheelAlarm() {
+  scheduler_->Cancel(&timer_);
+}
+
+void QuicTimingWheelAlarm::SetImpl() {
+  DCHECK(deadline().IsInitialized());
+  scheduler_->Schedule(&timer_, deadline());
+}
+
+void QuicTimingWheelAlarm::CancelImpl() {
+  DCHECK(!deadline().IsInitialized());
+  scheduler_->Cancel(&timer_);
+}
+
+void QuicTimingWheelAlarm::UpdateImpl() {
+  DCHECK(deadline().IsInitialized());
+  scheduler_->Cancel(&timer_);
+  scheduler_->Schedule(&timer_, deadline());
+}
+
+}  // namespace quic
@@ -0,0 +1,60 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef QUICHE_QUIC_CORE_QUIC_TIMING_WHEEL_ALARM_H_
+#define QUICHE_QUIC_CORE_QUIC_TIMING_WHEEL_ALARM_H_
+
+#include "net/third_party/quiche/src/quic/core/quic_alarm.h"
+#include "net/third_party/quiche/src/quic/core/quic_arena_scoped_ptr.h"
+#include "net/third_party/quiche/src/quic/core/quic_time.h"
+#include "net/third_party/quiche/src/quic/core/quic_timing_wheel.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_export.h"
+
+namespace quic {
+
+// Owner of a QuicTimingWheel which makes sure that the wheel is advanced once
+// its timers are due, e.g. by bounding the wait of an event loop.
+class QUIC_EXPORT_PRIVATE QuicTimingWheelScheduler {
+ public:
+  virtual ~QuicTimingWheelScheduler() {}
+
+  // Schedules |timer| to expire at |deadline|. |timer| must not be scheduled.
+  virtual void Schedule(QuicTimingWheel::Timer* timer, QuicTime deadline) = 0;
+
+  // Cancels |timer|. No-op if |timer| is not scheduled.
+  virtual void Cancel(QuicTimingWheel::Timer* timer) = 0;
+};
+
+// An alarm which is kept in the timing wheel of a QuicTimingWheelScheduler,
+// so that setting, updating and cancelling it are O(1).
+class QUIC_EXPORT_PRIVATE QuicTimingWheelAlarm : public QuicAlarm {
+ public:
+  // |scheduler| must outlive the alarm.
+  QuicTimingWheelAlarm(QuicTimingWheelScheduler* scheduler,
+                       QuicArenaScopedPtr<QuicAlarm::Delegate> delegate);
+  ~QuicTimingWheelAlarm() override;
+
+ protected:
+  void SetImpl() override;
+  void CancelImpl() override;
+  void UpdateImpl() override;
+
+ private:
+  class Timer : public QuicTimingWheel::Timer {
+   public:
+    explicit Timer(QuicTimingWheelAlarm* alarm) : alarm_(alarm) {}
+
+    void OnTimerExpired() override { alarm_->Fire(); }
+
+   private:
+    QuicTimingWheelAlarm* alarm_;
+  };
+
+  QuicTimingWheelScheduler* scheduler_;  // Not owned.
+  Timer timer_;
+};
+
+}  // namespace quic
+
+#endif  // QUICHE_QUIC_CORE_QUIC_TIMING_WHEEL_ALARM_H_
@@ -0,0 +1,100 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/third_party/quiche/src/quic/core/quic_timing_wheel_alarm.h"
+
+#include <memory>
+
+#include "net/third_party/quiche/src/quic/platform/api/quic_test.h"
+
+namespace quic {
+namespace test {
+namespace {
+
+class TestDelegate : public QuicAlarm::Delegate {
+ public:
+  void OnAlarm() override { ++num_fired_; }
+
+  int num_fired() const { return num_fired_; }
+
+ private:
+  int num_fired_ = 0;
+};
+
+// Schedules timers straight into a wheel which the test advances.
+class TestScheduler : public QuicTimingWheelScheduler {
+ public:
+  TestScheduler()
+      : wheel_(QuicTime::Delta::FromMilliseconds(1), QuicTime::Zero()) {}
+
+  void Schedule(QuicTimingWheel::Timer* timer, QuicTime deadline) override {
+    wheel_.Schedule(timer, deadline);
+  }
+
+  void Cancel(QuicTimingWheel::Timer* timer) override { wheel_.Cancel(timer); }
+
+  QuicTimingWheel* wheel() { return &wheel_; }
+
+ private:
+  QuicTimingWheel wheel_;
+};
+
+class QuicTimingWheelAlarmTest : public QuicTest {
+ protected:
+  QuicTimingWheelAlarmTest()
+      : delegate_(new TestDelegate),
+        alarm_(&scheduler_,
+               QuicArenaScopedPtr<QuicAlarm::Delegate>(delegate_)) {}
+
+  QuicTime At(int64_t milliseconds) {
+    return QuicTime::Zero() + QuicTime::Delta::FromMilliseconds(milliseconds);
+  }
+
+  TestScheduler scheduler_;
+  TestDelegate* delegate_;  // Owned by |alarm_|.
+  QuicTimingWheelAlarm alarm_;
+};
+
+TEST_F(QuicTimingWheelAlarmTest, SetAndFire) {
+  alarm_.Set(At(10));
+  EXPECT_EQ(1u, scheduler_.wheel()->size());
+
+  scheduler_.wheel()->AdvanceTo(At(9));
+  EXPECT_EQ(0, delegate_->num_fired());
+  scheduler_.wheel()->AdvanceTo(At(10));
+  EXPECT_EQ(1, delegate_->num_fired());
+  EXPECT_FALSE(alarm_.IsSet());
+  EXPECT_TRUE(scheduler_.wheel()->empty());
+}
+
+TEST_F(QuicTimingWheelAlarmTest, Cancel) {
+  alarm_.Set(At(10));
+  alarm_.Cancel();
+  EXPECT_TRUE(scheduler_.wheel()->empty());
+  scheduler_.wheel()->AdvanceTo(At(20));
+  EXPECT_EQ(0, delegate_->num_fired());
+}
+
+TEST_F(QuicTimingWheelAlarmTest, Update) {
+  alarm_.Set(At(10));
+  alarm_.Update(At(30), QuicTime::Delta::Zero());
+  EXPECT_EQ(1u, scheduler_.wheel()->size());
+  scheduler_.wheel()->AdvanceTo(At(20));
+  EXPECT_EQ(0, delegate_->num_fired());
+  scheduler_.wheel()->AdvanceTo(At(30));
+  EXPECT_EQ(1, delegate_->num_fired());
+}
+
+TEST_F(QuicTimingWheelAlarmTest, DestroyedWhileSet) {
+  TestDelegate* delegate = new TestDelegate;
+  auto alarm = std::make_unique<QuicTimingWheelAlarm>(
+      &scheduler_, QuicArenaScopedPtr<QuicAlarm::Delegate>(delegate));
+  alarm->Set(At(10));
+  alarm.reset();
+  EXPECT_TRUE(scheduler_.wheel()->empty());
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace quic
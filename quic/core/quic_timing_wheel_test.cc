@@ -0,0 +1,220 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/third_party/quiche/src/quic/core/quic_timing_wheel.h"
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "net/third_party/quiche/src/quic/platform/api/quic_test.h"
+
+namespace quic {
+namespace test {
+namespace {
+
+class TestTimer : public QuicTimingWheel::Timer {
+ public:
+  explicit TestTimer(std::vector<TestTimer*>* expired) : expired_(expired) {}
+
+  void OnTimerExpired() override {
+    expired_->push_back(this);
+    if (on_expired_) {
+      on_expired_();
+    }
+  }
+
+  void set_on_expired(std::function<void()> on_expired) {
+    on_expired_ = std::move(on_expired);
+  }
+
+ private:
+  std::vector<TestTimer*>* expired_;
+  std::function<void()> on_expired_;
+};
+
+class QuicTimingWheelTest : public QuicTest {
+ protected:
+  QuicTimingWheelTest()
+      : start_(QuicTime::Zero() + QuicTime::Delta::FromSeconds(1000)),
+        wheel_(QuicTime::Delta::FromMilliseconds(1), start_) {}
+
+  QuicTime Ms(int64_t ms) const {
+    return start_ + QuicTime::Delta::FromMilliseconds(ms);
+  }
+
+  QuicTime start_;
+  QuicTimingWheel wheel_;
+  std::vector<TestTimer*> expired_;
+};
+
+TEST_F(QuicTimingWheelTest, ScheduleAndExpire) {
+  TestTimer timer(&expired_);
+  wheel_.Schedule(&timer, Ms(10));
+  EXPECT_TRUE(timer.scheduled());
+  EXPECT_EQ(1u, wheel_.size());
+  EXPECT_EQ(Ms(10), wheel_.ExpiryTime(&timer));
+  EXPECT_EQ(Ms(10), wheel_.NextWakeupTime());
+
+  wheel_.AdvanceTo(Ms(9));
+  EXPECT_TRUE(expired_.empty());
+  wheel_.AdvanceTo(Ms(10));
+  ASSERT_EQ(1u, expired_.size());
+  EXPECT_EQ(&timer, expired_[0]);
+  EXPECT_FALSE(timer.scheduled());
+  EXPECT_TRUE(wheel_.empty());
+  EXPECT_EQ(QuicTime::Infinite(), wheel_.NextWakeupTime());
+}
+
+TEST_F(QuicTimingWheelTest, DeadlineRoundedUp) {
+  TestTimer timer(&expired_);
+  wheel_.Schedule(&timer, Ms(10) + QuicTime::Delta::FromMicroseconds(1));
+  EXPECT_EQ(Ms(11), wheel_.ExpiryTime(&timer));
+
+  wheel_.AdvanceTo(Ms(10) + QuicTime::Delta::FromMicroseconds(999));
+  EXPECT_TRUE(expired_.empty());
+  wheel_.AdvanceTo(Ms(11));
+  EXPECT_EQ(1u, expired_.size());
+}
+
+TEST_F(QuicTimingWheelTest, DeadlineInThePast) {
+  TestTimer timer(&expired_);
+  wheel_.Schedule(&timer, Ms(-5));
+  EXPECT_EQ(Ms(1), wheel_.ExpiryTime(&timer));
+  wheel_.AdvanceTo(Ms(1));
+  EXPECT_EQ(1u, expired_.size());
+}
+
+TEST_F(QuicTimingWheelTest, Cancel) {
+  TestTimer timer1(&expired_);
+  TestTimer timer2(&expired_);
+  wheel_.Schedule(&timer1, Ms(10));
+  wheel_.Schedule(&timer2, Ms(10));
+  wheel_.Cancel(&timer1);
+  EXPECT_FALSE(timer1.scheduled());
+  EXPECT_EQ(1u, wheel_.size());
+  // Cancelling twice is fine.
+  wheel_.Cancel(&timer1);
+
+  wheel_.AdvanceTo(Ms(100));
+  ASSERT_EQ(1u, expired_.size());
+  EXPECT_EQ(&timer2, expired_[0]);
+}
+
+TEST_F(QuicTimingWheelTest, Reschedule) {
+  TestTimer timer(&expired_);
+  wheel_.Schedule(&timer, Ms(10));
+  wheel_.Reschedule(&timer, Ms(100000));
+  EXPECT_EQ(1u, wheel_.size());
+  wheel_.AdvanceTo(Ms(99999));
+  EXPECT_TRUE(expired_.empty());
+  wheel_.Reschedule(&timer, Ms(100001));
+  wheel_.AdvanceTo(Ms(100001));
+  EXPECT_EQ(1u, expired_.size());
+
+  // Reschedule also works on timers which are not scheduled.
+  wheel_.Reschedule(&timer, Ms(100002));
+  EXPECT_TRUE(timer.scheduled());
+  wheel_.Cancel(&timer);
+}
+
+TEST_F(QuicTimingWheelTest, ExpiresInOrderAcrossLevels) {
+  // Deadlines spanning all levels and the overflow list, in shuffled order.
+  const std::vector<int64_t> deadlines_ms = {
+      70000000, 3, 300, 1, 256, 65536, 100000, 255, 16777216, 5000000000};
+  std::vector<std::unique_ptr<TestTimer>> timers;
+  for (int64_t deadline_ms : deadlines_ms) {
+    timers.push_back(std::make_unique<TestTimer>(&expired_));
+    wheel_.Schedule(timers.back().get(), Ms(deadline_ms));
+  }
+  EXPECT_EQ(deadlines_ms.size(), wheel_.size());
+
+  std::vector<int64_t> sorted_ms = deadlines_ms;
+  std::sort(sorted_ms.begin(), sorted_ms.end());
+  size_t expected_expired = 0;
+  for (int64_t deadline_ms : sorted_ms) {
+    wheel_.AdvanceTo(Ms(deadline_ms - 1));
+    EXPECT_EQ(expected_expired, expired_.size()) << deadline_ms;
+    wheel_.AdvanceTo(Ms(deadline_ms));
+    ++expected_expired;
+    ASSERT_EQ(expected_expired, expired_.size()) << deadline_ms;
+    const size_t index =
+        std::find(deadlines_ms.begin(), deadlines_ms.end(), deadline_ms) -
+        deadlines_ms.begin();
+    EXPECT_EQ(timers[index].get(), expired_.back());
+  }
+  EXPECT_TRUE(wheel_.empty());
+}
+
+TEST_F(QuicTimingWheelTest, NextWakeupTimeNeverLate) {
+  TestTimer near(&expired_);
+  TestTimer far(&expired_);
+  wheel_.Schedule(&far, Ms(1000));
+  QuicTime wakeup = wheel_.NextWakeupTime();
+  EXPECT_LE(wakeup, Ms(1000));
+  EXPECT_GT(wakeup, start_);
+
+  wheel_.Schedule(&near, Ms(2));
+  EXPECT_EQ(Ms(2), wheel_.NextWakeupTime());
+
+  // Repeatedly advancing to the next wakeup time reaches every expiry.
+  while (!wheel_.empty()) {
+    wakeup = wheel_.NextWakeupTime();
+    wheel_.AdvanceTo(wakeup);
+  }
+  ASSERT_EQ(2u, expired_.size());
+  EXPECT_EQ(&near, expired_[0]);
+  EXPECT_EQ(&far, expired_[1]);
+}
+
+TEST_F(QuicTimingWheelTest, ScheduleFromCallback) {
+  TestTimer timer1(&expired_);
+  TestTimer timer2(&expired_);
+  timer1.set_on_expired([this, &timer1, &timer2]() {
+    // Reschedule itself, and a timer for the past.
+    wheel_.Schedule(&timer1, Ms(20));
+    wheel_.Schedule(&timer2, Ms(0));
+  });
+  wheel_.Schedule(&timer1, Ms(10));
+
+  wheel_.AdvanceTo(Ms(10));
+  EXPECT_EQ(1u, expired_.size());
+  EXPECT_TRUE(timer1.scheduled());
+  EXPECT_TRUE(timer2.scheduled());
+  EXPECT_EQ(Ms(11), wheel_.ExpiryTime(&timer2));
+
+  timer1.set_on_expired(nullptr);
+  wheel_.AdvanceTo(Ms(20));
+  ASSERT_EQ(3u, expired_.size());
+  EXPECT_EQ(&timer2, expired_[1]);
+  EXPECT_EQ(&timer1, expired_[2]);
+}
+
+TEST_F(QuicTimingWheelTest, CancelFromCallback) {
+  TestTimer timer1(&expired_);
+  TestTimer timer2(&expired_);
+  timer1.set_on_expired([this, &timer2]() { wheel_.Cancel(&timer2); });
+  wheel_.Schedule(&timer1, Ms(10));
+  wheel_.Schedule(&timer2, Ms(10));
+
+  wheel_.AdvanceTo(Ms(10));
+  ASSERT_EQ(1u, expired_.size());
+  EXPECT_EQ(&timer1, expired_[0]);
+  EXPECT_FALSE(timer2.scheduled());
+  EXPECT_TRUE(wheel_.empty());
+}
+
+TEST_F(QuicTimingWheelTest, DestroyWithScheduledTimers) {
+  TestTimer timer(&expired_);
+  {
+    QuicTimingWheel wheel(QuicTime::Delta::FromMilliseconds(1), start_);
+    wheel.Schedule(&timer, Ms(10));
+  }
+  EXPECT_FALSE(timer.scheduled());
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace quic
@@ -31,10 +31,19 @@ struct QUIC_EXPORT_PRIVATE QuicTransmissionInfo {
 
   ~QuicTransmissionInfo();
 
-  QuicFrames retransmittable_frames;
-  EncryptionLevel encryption_level;
-  QuicPacketLength bytes_sent;
+  // Fields read for every packet when processing acks and detecting losses
+  // come first, so that they share a cache line. Fields are ordered by size
+  // to avoid padding.
   QuicTime sent_time;
+  // The largest_acked in the ack frame, if the packet contains an ack.
+  QuicPacketNumber largest_acked;
+  // Stores the packet number of the next retransmission of this packet.
+  // Zero if the packet has not been retransmitted.
+  // TODO(fayang): rename this to first_sent_after_loss_ when deprecating
+  // QUIC_VERSION_41.
+  QuicPacketNumber retransmission;
+  QuicPacketLength bytes_sent;
+  EncryptionLevel encryption_level;
   // Reason why this packet was transmitted.
   TransmissionType transmission_type;
   // In flight packets have not been abandoned or lost.
@@ -43,19 +52,12 @@ struct QUIC_EXPORT_PRIVATE QuicTransmissionInfo {
   SentPacketState state;
   // True if the packet contains stream data from the crypto stream.
   bool has_crypto_handshake;
-  // Stores the packet number of the next retransmission of this packet.
-  // Zero if the packet has not been retransmitted.
-  // TODO(fayang): rename this to first_sent_after_loss_ when deprecating
-  // QUIC_VERSION_41.
-  QuicPacketNumber retransmission;
-  // The largest_acked in the ack frame, if the packet contains an ack.
-  QuicPacketNumber largest_acked;
+  QuicFrames retransmittable_frames;
 };
-// TODO(ianswett): Add static_assert when size of this struct is reduced below
-// 64 bytes.
-// NOTE(vlovich): Existing static_assert removed because padding differences on
-// 64-bit iOS resulted in an 88-byte struct that is greater than the 84-byte
-// limit on other platforms.  Removing per ianswett's request.
+// Keep the transmission info of a packet within one cache line on 64-bit
+// platforms. Padding differs on 32-bit platforms, which are not checked.
+static_assert(sizeof(void*) != 8 || sizeof(QuicTransmissionInfo) <= 64,
+              "QuicTransmissionInfo should fit in a 64-byte cache line");
 
 }  // namespace quic
 
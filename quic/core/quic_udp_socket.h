@@ -15,6 +15,8 @@
 #include "net/third_party/quiche/src/quic/platform/api/quic_ip_address.h"
 #include "net/third_party/quiche/src/quic/platform/api/quic_socket_address.h"
 
+struct msghdr;
+
 namespace quic {
 
 #if defined(_WIN32)
@@ -27,6 +29,11 @@ const QuicUdpSocketFd kQuicInvalidSocketFd = -1;
 
 const size_t kDefaultUdpPacketControlBufferSize = 512;
 
+// The largest buffer the kernel may deliver in a single read when UDP GRO is
+// enabled on a socket. Such a buffer holds several packets, each of which is
+// GRO_SEGMENT_SIZE bytes long except possibly the last one.
+const size_t kMaxUdpGroPacketSize = 64 * 1024;
+
 enum class QuicUdpPacketInfoBit : uint8_t {
   DROPPED_PACKETS = 0,   // Read
   V4_SELF_IP,            // Read
@@ -35,6 +42,7 @@ enum class QuicUdpPacketInfoBit : uint8_t {
   RECV_TIMESTAMP,        // Read
   TTL,                   // Read & Write
   GOOGLE_PACKET_HEADER,  // Read
+  GRO_SEGMENT_SIZE,      // Read
   NUM_BITS,
 };
 static_assert(static_cast<size_t>(QuicUdpPacketInfoBit::NUM_BITS) <=
@@ -143,6 +151,19 @@ class QUIC_EXPORT_PRIVATE QuicUdpPacketInfo {
     bitmask_.Set(QuicUdpPacketInfoBit::GOOGLE_PACKET_HEADER);
   }
 
+  // Size of each packet coalesced into the received buffer by UDP GRO. Only
+  // present if the socket has UDP GRO enabled and the kernel coalesced
+  // packets.
+  size_t gro_segment_size() const {
+    DCHECK(HasValue(QuicUdpPacketInfoBit::GRO_SEGMENT_SIZE));
+    return gro_segment_size_;
+  }
+
+  void SetGroSegmentSize(size_t gro_segment_size) {
+    gro_segment_size_ = gro_segment_size;
+    bitmask_.Set(QuicUdpPacketInfoBit::GRO_SEGMENT_SIZE);
+  }
+
  private:
   BitMask64 bitmask_;
   QuicPacketCount dropped_packets_;
@@ -152,6 +173,7 @@ class QUIC_EXPORT_PRIVATE QuicUdpPacketInfo {
   QuicWallTime receive_timestamp_ = QuicWallTime::Zero();
   int ttl_;
   BufferSpan google_packet_headers_;
+  size_t gro_segment_size_;
 };
 
 // QuicUdpSocketApi provides a minimal set of apis for sending and receiving
@@ -187,6 +209,13 @@ class QUIC_EXPORT_PRIVATE QuicUdpSocketApi {
   bool EnableReceiveTtlForV4(QuicUdpSocketFd fd);
   bool EnableReceiveTtlForV6(QuicUdpSocketFd fd);
 
+  // Enable UDP GRO on |fd|. Once enabled, a single read may return multiple
+  // packets from the same peer coalesced into one buffer of up to
+  // |kMaxUdpGroPacketSize| bytes, and the size of each packet is reported via
+  // QuicUdpPacketInfoBit::GRO_SEGMENT_SIZE. Return false if UDP GRO is not
+  // supported.
+  bool EnableUdpGro(QuicUdpSocketFd fd);
+
   // Wait for |fd| to become readable, up to |timeout|.
   // Return true if |fd| is readable upon return.
   bool WaitUntilReadable(QuicUdpSocketFd fd, QuicTime::Delta timeout);
@@ -230,6 +259,13 @@ class QUIC_EXPORT_PRIVATE QuicUdpSocketApi {
                              BitMask64 packet_info_interested,
                              ReadPacketResults* results);
 
+  // Populate |packet_info| from the control messages of |hdr|, which has been
+  // filled in by a receive operation. Used by callers which do not receive
+  // through ReadPacket(), e.g. via io_uring.
+  void ReadControlMessages(msghdr* hdr,
+                           BitMask64 packet_info_interested,
+                           QuicUdpPacketInfo* packet_info);
+
   // Write a packet to |fd|.
   // packet_buffer, packet_buffer_len:  The packet buffer to write.
   // packet_info:                       The per packet information to set.
@@ -21,10 +21,21 @@
 #include <alloca.h>
 // For SO_TIMESTAMPING.
 #include <linux/net_tstamp.h>
+// For UDP_GRO.
+#include <netinet/udp.h>
 #endif
 
 #if defined(__linux__) && !defined(__ANDROID__)
 #define QUIC_UDP_SOCKET_SUPPORT_TTL 1
+#define QUIC_UDP_SOCKET_SUPPORT_GRO 1
+
+#ifndef SOL_UDP
+#define SOL_UDP 17
+#endif
+
+#ifndef UDP_GRO
+#define UDP_GRO 104
+#endif
 #endif
 
 namespace quic {
@@ -55,6 +66,7 @@ const size_t kMinCmsgSpaceForRead =
     + CMSG_SPACE(sizeof(in_pktinfo))   // V4 Self IP
     + CMSG_SPACE(sizeof(in6_pktinfo))  // V6 Self IP
     + kCmsgSpaceForRecvTimestamp + CMSG_SPACE(sizeof(int))  // TTL
+    + CMSG_SPACE(sizeof(int))                               // GRO segment size
     + kCmsgSpaceForGooglePacketHeader;
 
 QuicUdpSocketFd CreateNonblockingSocket(int address_family) {
@@ -190,6 +202,18 @@ void PopulatePacketInfoFromControlMessage(struct cmsghdr* cmsg,
     return;
   }
 
+#if defined(QUIC_UDP_SOCKET_SUPPORT_GRO)
+  if (cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_GRO) {
+    if (packet_info_interested.IsSet(QuicUdpPacketInfoBit::GRO_SEGMENT_SIZE)) {
+      int gro_segment_size = *(reinterpret_cast<int*>(CMSG_DATA(cmsg)));
+      if (gro_segment_size > 0) {
+        packet_info->SetGroSegmentSize(gro_segment_size);
+      }
+    }
+    return;
+  }
+#endif
+
   if (packet_info_interested.IsSet(
           QuicUdpPacketInfoBit::GOOGLE_PACKET_HEADER)) {
     BufferSpan google_packet_headers;
@@ -366,6 +390,17 @@ bool QuicUdpSocketApi::EnableReceiveTtlForV6(QuicUdpSocketFd fd) {
 #endif
 }
 
+bool QuicUdpSocketApi::EnableUdpGro(QuicUdpSocketFd fd) {
+#if defined(QUIC_UDP_SOCKET_SUPPORT_GRO)
+  int enable_gro = 1;
+  return 0 ==
+         setsockopt(fd, SOL_UDP, UDP_GRO, &enable_gro, sizeof(enable_gro));
+#else
+  (void)fd;
+  return false;
+#endif
+}
+
 bool QuicUdpSocketApi::WaitUntilReadable(QuicUdpSocketFd fd,
                                          QuicTime::Delta timeout) {
   fd_set read_fds;
@@ -444,22 +479,29 @@ void QuicUdpSocketApi::ReadPacket(QuicUdpSocketFd fd,
     packet_info->SetPeerAddress(QuicSocketAddress(raw_peer_address));
   }
 
-  if (hdr.msg_controllen > 0) {
-    for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&hdr); cmsg != nullptr;
-         cmsg = CMSG_NXTHDR(&hdr, cmsg)) {
-      BitMask64 prior_bitmask = packet_info->bitmask();
-      PopulatePacketInfoFromControlMessage(cmsg, packet_info,
-                                           packet_info_interested);
-      if (packet_info->bitmask() == prior_bitmask) {
-        QUIC_DLOG(INFO) << "Ignored cmsg_level:" << cmsg->cmsg_level
-                        << ", cmsg_type:" << cmsg->cmsg_type;
-      }
-    }
-  }
+  ReadControlMessages(&hdr, packet_info_interested, packet_info);
 
   result->ok = true;
 }
 
+void QuicUdpSocketApi::ReadControlMessages(msghdr* hdr,
+                                           BitMask64 packet_info_interested,
+                                           QuicUdpPacketInfo* packet_info) {
+  if (hdr->msg_controllen == 0) {
+    return;
+  }
+  for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(hdr); cmsg != nullptr;
+       cmsg = CMSG_NXTHDR(hdr, cmsg)) {
+    BitMask64 prior_bitmask = packet_info->bitmask();
+    PopulatePacketInfoFromControlMessage(cmsg, packet_info,
+                                         packet_info_interested);
+    if (packet_info->bitmask() == prior_bitmask) {
+      QUIC_DLOG(INFO) << "Ignored cmsg_level:" << cmsg->cmsg_level
+                      << ", cmsg_type:" << cmsg->cmsg_type;
+    }
+  }
+}
+
 size_t QuicUdpSocketApi::ReadMultiplePackets(QuicUdpSocketFd fd,
                                              BitMask64 packet_info_interested,
                                              ReadPacketResults* results) {
@@ -536,13 +578,7 @@ size_t QuicUdpSocketApi::ReadMultiplePackets(QuicUdpSocketFd fd,
           QuicSocketAddress(packet_data_array[i].raw_peer_address));
     }
 
-    if (hdr.msg_controllen > 0) {
-      for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&hdr); cmsg != nullptr;
-           cmsg = CMSG_NXTHDR(&hdr, cmsg)) {
-        PopulatePacketInfoFromControlMessage(cmsg, packet_info,
-                                             packet_info_interested);
-      }
-    }
+    ReadControlMessages(&hdr, packet_info_interested, packet_info);
   }
   return packets_read;
 #else
@@ -318,6 +318,29 @@ TEST_P(QuicUdpSocketTest, Ttl) {
   EXPECT_EQ(13, read_result.packet_info.ttl());
 }
 
+TEST_P(QuicUdpSocketTest, ReadWithUdpGro) {
+  if (!api_.EnableUdpGro(fd_server_)) {
+    QUIC_LOG(INFO) << "UDP GRO is not supported";
+    return;
+  }
+
+  const size_t kPacketSize = 512;
+  memset(client_packet_buffer_, '#', kPacketSize);
+  ASSERT_EQ(WriteResult(WRITE_STATUS_OK, kPacketSize),
+            SendPacketFromClient(kPacketSize));
+
+  // A packet sent without GSO is delivered as is, GRO or not.
+  QuicUdpSocketApi::ReadPacketResult read_result =
+      ReadPacketFromServer(BitMask64(QuicUdpPacketInfoBit::GRO_SEGMENT_SIZE));
+  ASSERT_TRUE(read_result.ok);
+  ASSERT_EQ(kPacketSize, read_result.packet_buffer.buffer_len);
+  ASSERT_EQ(0, ComparePacketBuffers(kPacketSize));
+  if (read_result.packet_info.HasValue(
+          QuicUdpPacketInfoBit::GRO_SEGMENT_SIZE)) {
+    EXPECT_EQ(kPacketSize, read_result.packet_info.gro_segment_size());
+  }
+}
+
 TEST_P(QuicUdpSocketTest, ReadMultiplePackets) {
   const QuicUdpPacketInfoBit self_ip_bit =
       (address_family_ == AF_INET) ? QuicUdpPacketInfoBit::V4_SELF_IP
@@ -19,6 +19,10 @@ class MockTunDevice : public TunDeviceInterface {
   MOCK_METHOD(bool, Down, (), (override));
 
   MOCK_METHOD(int, GetFileDescriptor, (), (const, override));
+
+  MOCK_METHOD(size_t, GetNumQueues, (), (const, override));
+
+  MOCK_METHOD(int, GetQueueFileDescriptor, (size_t queue), (const, override));
 };
 
 }  // namespace quic
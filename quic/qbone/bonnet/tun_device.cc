@@ -13,6 +13,7 @@
 #include "net/third_party/quiche/src/quic/platform/api/quic_bug_tracker.h"
 #include "net/third_party/quiche/src/quic/platform/api/quic_logging.h"
 #include "net/third_party/quiche/src/quic/qbone/platform/kernel_interface.h"
+#include "net/third_party/quiche/src/quic/qbone/platform/virtio_net_header.h"
 
 namespace quic {
 
@@ -24,11 +25,27 @@ TunDevice::TunDevice(const std::string& interface_name,
                      bool persist,
                      bool setup_tun,
                      KernelInterface* kernel)
+    : TunDevice(interface_name,
+                mtu,
+                persist,
+                setup_tun,
+                /*num_queues=*/1,
+                /*enable_offload=*/false,
+                kernel) {}
+
+TunDevice::TunDevice(const std::string& interface_name,
+                     int mtu,
+                     bool persist,
+                     bool setup_tun,
+                     size_t num_queues,
+                     bool enable_offload,
+                     KernelInterface* kernel)
     : interface_name_(interface_name),
       mtu_(mtu),
       persist_(persist),
       setup_tun_(setup_tun),
-      file_descriptor_(kInvalidFd),
+      num_queues_(num_queues),
+      enable_offload_(enable_offload),
       kernel_(*kernel) {}
 
 TunDevice::~TunDevice() {
@@ -44,6 +61,11 @@ bool TunDevice::Init() {
     return false;
   }
 
+  if (num_queues_ == 0) {
+    QUIC_BUG << "num_queues must be positive";
+    return false;
+  }
+
   if (!OpenDevice()) {
     return false;
   }
@@ -94,10 +116,33 @@ bool TunDevice::Down() {
 }
 
 int TunDevice::GetFileDescriptor() const {
-  return file_descriptor_;
+  return GetQueueFileDescriptor(0);
+}
+
+size_t TunDevice::GetNumQueues() const {
+  return file_descriptors_.size();
+}
+
+int TunDevice::GetQueueFileDescriptor(size_t queue) const {
+  if (queue >= file_descriptors_.size()) {
+    return kInvalidFd;
+  }
+  return file_descriptors_[queue];
 }
 
 bool TunDevice::OpenDevice() {
+  // TODO(pengg): port MakeCleanup to quic/platform? This makes the call to
+  // CleanUpFileDescriptor nicer and less error-prone.
+  for (size_t queue = 0; queue < num_queues_; ++queue) {
+    if (!OpenQueue()) {
+      CleanUpFileDescriptor();
+      return false;
+    }
+  }
+  return true;
+}
+
+bool TunDevice::OpenQueue() {
   struct ifreq if_request;
   memset(&if_request, 0, sizeof(if_request));
   // copy does not zero-terminate the result string, but we've memset the entire
@@ -110,34 +155,40 @@ bool TunDevice::OpenDevice() {
   // routing associated with the interface, which makes the meaning of the
   // 'persist' bit ambiguous.
   if_request.ifr_flags = IFF_TUN | IFF_MULTI_QUEUE | IFF_NO_PI;
+  if (enable_offload_) {
+    if_request.ifr_flags |= IFF_VNET_HDR;
+  }
 
-  // TODO(pengg): port MakeCleanup to quic/platform? This makes the call to
-  // CleanUpFileDescriptor nicer and less error-prone.
   // When the device is running with IFF_MULTI_QUEUE set, each call to open will
   // create a queue which can be used to read/write packets from/to the device.
   int fd = kernel_.open(kTapTunDevicePath, O_RDWR);
   if (fd < 0) {
     QUIC_PLOG(WARNING) << "Failed to open " << kTapTunDevicePath;
-    CleanUpFileDescriptor();
     return false;
   }
-  file_descriptor_ = fd;
+  file_descriptors_.push_back(fd);
   if (!CheckFeatures(fd)) {
-    CleanUpFileDescriptor();
     return false;
   }
 
   if (kernel_.ioctl(fd, TUNSETIFF, reinterpret_cast<void*>(&if_request)) != 0) {
     QUIC_PLOG(WARNING) << "Failed to TUNSETIFF on fd(" << fd << ")";
-    CleanUpFileDescriptor();
     return false;
   }
 
+  // The remaining settings belong to the device rather than to the queue.
+  if (file_descriptors_.size() > 1) {
+    return true;
+  }
+
   if (kernel_.ioctl(
           fd, TUNSETPERSIST,
           persist_ ? reinterpret_cast<void*>(&if_request) : nullptr) != 0) {
     QUIC_PLOG(WARNING) << "Failed to TUNSETPERSIST on fd(" << fd << ")";
-    CleanUpFileDescriptor();
+    return false;
+  }
+
+  if (enable_offload_ && !EnableOffload(fd)) {
     return false;
   }
 
@@ -173,6 +224,12 @@ bool TunDevice::CheckFeatures(int tun_device_fd) {
     return false;
   }
   unsigned int required_features = IFF_TUN | IFF_NO_PI;
+  if (num_queues_ > 1) {
+    required_features |= IFF_MULTI_QUEUE;
+  }
+  if (enable_offload_) {
+    required_features |= IFF_VNET_HDR;
+  }
   if ((required_features & actual_features) != required_features) {
     QUIC_LOG(WARNING)
         << "Required feature does not exist. required_features: 0x" << std::hex
@@ -183,6 +240,22 @@ bool TunDevice::CheckFeatures(int tun_device_fd) {
   return true;
 }
 
+bool TunDevice::EnableOffload(int tun_device_fd) {
+  int vnet_header_size = sizeof(VirtioNetHeader);
+  if (kernel_.ioctl(tun_device_fd, TUNSETVNETHDRSZ, &vnet_header_size) != 0) {
+    QUIC_PLOG(WARNING) << "Failed to TUNSETVNETHDRSZ";
+    return false;
+  }
+  // TSO requires checksum offload. The argument is passed by value.
+  const uintptr_t offload = TUN_F_CSUM | TUN_F_TSO6;
+  if (kernel_.ioctl(tun_device_fd, TUNSETOFFLOAD,
+                    reinterpret_cast<void*>(offload)) != 0) {
+    QUIC_PLOG(WARNING) << "Failed to TUNSETOFFLOAD";
+    return false;
+  }
+  return true;
+}
+
 bool TunDevice::NetdeviceIoctl(int request, void* argp) {
   int fd = kernel_.socket(AF_INET6, SOCK_DGRAM, 0);
   if (fd < 0) {
@@ -200,10 +273,10 @@ bool TunDevice::NetdeviceIoctl(int request, void* argp) {
 }
 
 void TunDevice::CleanUpFileDescriptor() {
-  if (file_descriptor_ != kInvalidFd) {
-    kernel_.close(file_descriptor_);
-    file_descriptor_ = kInvalidFd;
+  for (int fd : file_descriptors_) {
+    kernel_.close(fd);
   }
+  file_descriptors_.clear();
 }
 
 }  // namespace quic
@@ -5,6 +5,7 @@
 #ifndef QUICHE_QUIC_QBONE_BONNET_TUN_DEVICE_H_
 #define QUICHE_QUIC_QBONE_BONNET_TUN_DEVICE_H_
 
+#include <cstddef>
 #include <string>
 #include <vector>
 
@@ -38,6 +39,23 @@ class TunDevice : public TunDeviceInterface {
             bool setup_tun,
             KernelInterface* kernel);
 
+  // Like the above, but opens |num_queues| queues on the device. Packets are
+  // spread over the queues by flow, and each queue has its own file descriptor
+  // which can be read and written independently of the others.
+  //
+  // If |enable_offload| is true, every packet read from or written to the
+  // device is preceded by a VirtioNetHeader, and the kernel may hand over TCP
+  // segments much larger than the MTU, to be split by the reader, see
+  // TunDevicePacketExchanger. This lets a bulk TCP transfer cross the device
+  // in a fraction of the reads.
+  TunDevice(const std::string& interface_name,
+            int mtu,
+            bool persist,
+            bool setup_tun,
+            size_t num_queues,
+            bool enable_offload,
+            KernelInterface* kernel);
+
   ~TunDevice() override;
 
   // Actually creates/reopens and configures the device.
@@ -53,6 +71,10 @@ class TunDevice : public TunDeviceInterface {
   // This returns -1 when the TUN device is in an invalid state.
   int GetFileDescriptor() const override;
 
+  size_t GetNumQueues() const override;
+
+  int GetQueueFileDescriptor(size_t queue) const override;
+
  private:
   // Creates or reopens the tun device.
   bool OpenDevice();
@@ -60,11 +82,18 @@ class TunDevice : public TunDeviceInterface {
   // Configure the interface.
   bool ConfigureInterface();
 
+  // Opens and configures the next queue of the device.
+  bool OpenQueue();
+
   // Checks if the required kernel features exists.
   bool CheckFeatures(int tun_device_fd);
 
-  // Closes the opened file descriptor and makes sure the file descriptor
-  // is no longer available from GetFileDescriptor;
+  // Has the kernel prepend a virtio_net_hdr to packets, and hand over
+  // checksum offloaded and TSO packets.
+  bool EnableOffload(int tun_device_fd);
+
+  // Closes the opened file descriptors and makes sure the file descriptors
+  // are no longer available from GetFileDescriptor;
   void CleanUpFileDescriptor();
 
   // Opens a socket and makes netdevice ioctl call
@@ -74,7 +103,9 @@ class TunDevice : public TunDeviceInterface {
   const int mtu_;
   const bool persist_;
   const bool setup_tun_;
-  int file_descriptor_;
+  const size_t num_queues_;
+  const bool enable_offload_;
+  std::vector<int> file_descriptors_;
   KernelInterface& kernel_;
   bool is_interface_up_ = false;
 };
@@ -5,6 +5,7 @@
 #ifndef QUICHE_QUIC_QBONE_BONNET_TUN_DEVICE_INTERFACE_H_
 #define QUICHE_QUIC_QBONE_BONNET_TUN_DEVICE_INTERFACE_H_
 
+#include <cstddef>
 #include <vector>
 
 namespace quic {
@@ -26,6 +27,13 @@ class TunDeviceInterface {
   // Gets the file descriptor that can be used to send/receive packets.
   // This returns -1 when the TUN device is in an invalid state.
   virtual int GetFileDescriptor() const = 0;
+
+  // Gets the number of queues opened on the device, and the file descriptor of
+  // each, so that each queue can be served by its own thread. Queue 0 is the
+  // one returned by GetFileDescriptor(). This returns -1 for queues which are
+  // not open.
+  virtual size_t GetNumQueues() const = 0;
+  virtual int GetQueueFileDescriptor(size_t queue) const = 0;
 };
 
 }  // namespace quic
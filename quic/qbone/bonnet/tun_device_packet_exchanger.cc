@@ -4,15 +4,99 @@
 
 #include "net/third_party/quiche/src/quic/qbone/bonnet/tun_device_packet_exchanger.h"
 
+#include <netinet/in.h>
+#include <netinet/ip6.h>
+#include <netinet/tcp.h>
+#include <sys/uio.h>
+
+#include <algorithm>
 #include <utility>
 
+#include "net/third_party/quiche/src/quic/platform/api/quic_logging.h"
+#include "net/third_party/quiche/src/quic/qbone/platform/internet_checksum.h"
+#include "net/third_party/quiche/src/quic/qbone/platform/virtio_net_header.h"
+#include "net/third_party/quiche/src/common/platform/api/quiche_endian.h"
 #include "net/third_party/quiche/src/common/platform/api/quiche_str_cat.h"
 
 namespace quic {
+namespace {
+
+// With offload, the kernel hands over IPv6 packets with a payload of up to
+// 64KB, preceded by a virtio-net header.
+const size_t kMaxOffloadedPacketSize =
+    sizeof(VirtioNetHeader) + sizeof(ip6_hdr) + 0xffff;
+
+// Offsets of the IPv6 and TCP header fields which differ between the segments
+// of a TCP packet. The headers are accessed byte-wise since the packets which
+// follow a virtio-net header are not aligned.
+const size_t kIPv6PayloadLengthOffset = 4;
+const size_t kIPv6NextHeaderOffset = 6;
+const size_t kIPv6SourceAddressOffset = 8;
+const size_t kTcpSequenceNumberOffset = 4;
+const size_t kTcpDataOffsetOffset = 12;
+const size_t kTcpFlagsOffset = 13;
+const size_t kTcpChecksumOffset = 16;
+
+const uint8_t kTcpFlagFin = 0x01;
+const uint8_t kTcpFlagPsh = 0x08;
+const uint8_t kTcpFlagCwr = 0x80;
+
+// Returns the checksum of the TCP segment of |tcp_length| bytes which follows
+// the IPv6 header at the start of |packet|.
+uint16_t TcpChecksum(const char* packet, size_t tcp_length) {
+  InternetChecksum checksum;
+  // The pseudo-header is made of the source and destination addresses, the
+  // length of the segment and the next header.
+  checksum.Update(packet + kIPv6SourceAddressOffset, 2 * sizeof(in6_addr));
+  const uint32_t length = quiche::QuicheEndian::HostToNet32(tcp_length);
+  checksum.Update(reinterpret_cast<const char*>(&length), sizeof(length));
+  const uint8_t next_header[4] = {0, 0, 0, IPPROTO_TCP};
+  checksum.Update(next_header, sizeof(next_header));
+  checksum.Update(packet + sizeof(ip6_hdr), tcp_length);
+  return checksum.Value();
+}
+
+// Stores the checksum which the kernel left for the receiver of |packet| to
+// compute. Returns false if |header| does not fit the packet.
+bool CompleteChecksum(const VirtioNetHeader& header,
+                      char* packet,
+                      size_t size) {
+  const size_t checksum_position =
+      static_cast<size_t>(header.checksum_start) + header.checksum_offset;
+  if (checksum_position + sizeof(uint16_t) > size) {
+    return false;
+  }
+  // The checksum field holds the checksum of the pseudo-header, so that it
+  // only remains to add up the rest of the packet.
+  InternetChecksum checksum;
+  checksum.Update(packet + header.checksum_start,
+                  size - header.checksum_start);
+  const uint16_t value = checksum.Value();
+  memcpy(packet + checksum_position, &value, sizeof(value));
+  return true;
+}
+
+}  // namespace
+
+TunDevicePacketExchanger::TunDevicePacketExchanger(
+    int fd,
+    size_t mtu,
+    KernelInterface* kernel,
+    QbonePacketExchanger::Visitor* visitor,
+    size_t max_pending_packets,
+    StatsInterface* stats)
+    : TunDevicePacketExchanger(fd,
+                               mtu,
+                               /*enable_offload=*/false,
+                               kernel,
+                               visitor,
+                               max_pending_packets,
+                               stats) {}
 
 TunDevicePacketExchanger::TunDevicePacketExchanger(
     int fd,
     size_t mtu,
+    bool enable_offload,
     KernelInterface* kernel,
     QbonePacketExchanger::Visitor* visitor,
     size_t max_pending_packets,
@@ -20,8 +104,11 @@ TunDevicePacketExchanger::TunDevicePacketExchanger(
     : QbonePacketExchanger(visitor, max_pending_packets),
       fd_(fd),
       mtu_(mtu),
+      enable_offload_(enable_offload),
       kernel_(kernel),
-      stats_(stats) {}
+      stats_(stats),
+      read_buffer_size_(enable_offload ? kMaxOffloadedPacketSize : mtu),
+      read_buffer_(new char[read_buffer_size_]) {}
 
 bool TunDevicePacketExchanger::WritePacket(const char* packet,
                                            size_t size,
@@ -35,7 +122,19 @@ bool TunDevicePacketExchanger::WritePacket(const char* packet,
     return false;
   }
 
-  int result = kernel_->write(fd_, packet, size);
+  int result;
+  if (enable_offload_) {
+    // Packets from the QBONE connection are never offloaded.
+    VirtioNetHeader header{};
+    struct iovec iov[2];
+    iov[0].iov_base = &header;
+    iov[0].iov_len = sizeof(header);
+    iov[1].iov_base = const_cast<char*>(packet);
+    iov[1].iov_len = size;
+    result = kernel_->writev(fd_, iov, 2);
+  } else {
+    result = kernel_->write(fd_, packet, size);
+  }
   if (result == -1) {
     if (errno == EWOULDBLOCK || errno == EAGAIN) {
       // The tunnel is blocked. Note that this does not mean the receive buffer
@@ -48,7 +147,7 @@ bool TunDevicePacketExchanger::WritePacket(const char* packet,
     }
     return false;
   }
-  stats_->OnPacketWritten(result);
+  stats_->OnPacketWritten(enable_offload_ ? size : result);
 
   return true;
 }
@@ -57,6 +156,9 @@ std::unique_ptr<QuicData> TunDevicePacketExchanger::ReadPacket(
     bool* blocked,
     std::string* error) {
   *blocked = false;
+  if (tcp_payload_length_ > 0) {
+    return NextTcpSegment();
+  }
   if (fd_ < 0) {
     *error = quiche::QuicheStrCat("Invalid file descriptor of the TUN device: ",
                                   fd_);
@@ -65,8 +167,7 @@ std::unique_ptr<QuicData> TunDevicePacketExchanger::ReadPacket(
   }
   // Reading on a TUN device returns a packet at a time. If the packet is longer
   // than the buffer, it's truncated.
-  auto read_buffer = std::make_unique<char[]>(mtu_);
-  int result = kernel_->read(fd_, read_buffer.get(), mtu_);
+  int result = kernel_->read(fd_, read_buffer_.get(), read_buffer_size_);
   // Note that 0 means end of file, but we're talking about a TUN device - there
   // is no end of file. Therefore 0 also indicates error.
   if (result <= 0) {
@@ -78,8 +179,126 @@ std::unique_ptr<QuicData> TunDevicePacketExchanger::ReadPacket(
     }
     return nullptr;
   }
+  if (enable_offload_) {
+    return ProcessOffloadedPacket(result, error);
+  }
   stats_->OnPacketRead(result);
-  return std::make_unique<QuicData>(read_buffer.release(), result, true);
+  return std::make_unique<QuicData>(read_buffer_.get(), result);
+}
+
+std::unique_ptr<QuicData> TunDevicePacketExchanger::ProcessOffloadedPacket(
+    size_t size,
+    std::string* error) {
+  VirtioNetHeader header;
+  if (size < sizeof(header)) {
+    *error = quiche::QuicheStrCat(
+        "Packet read from the TUN device is shorter than its header: ", size);
+    stats_->OnReadError(error);
+    return nullptr;
+  }
+  memcpy(&header, read_buffer_.get(), sizeof(header));
+  char* packet = read_buffer_.get() + sizeof(header);
+  const size_t packet_length = size - sizeof(header);
+
+  const uint8_t gso_type = header.gso_type & ~kVirtioNetHeaderGsoEcn;
+  if (gso_type == kVirtioNetHeaderGsoNone) {
+    if ((header.flags & kVirtioNetHeaderNeedsChecksum) &&
+        !CompleteChecksum(header, packet, packet_length)) {
+      *error = quiche::QuicheStrCat(
+          "Invalid checksum offset in packet read from the TUN device: ",
+          header.checksum_start, "+", header.checksum_offset);
+      stats_->OnReadError(error);
+      return nullptr;
+    }
+    stats_->OnPacketRead(packet_length);
+    return std::make_unique<QuicData>(packet, packet_length);
+  }
+
+  // Only TCP over IPv6 is offloaded, see TunDevice.
+  if (gso_type != kVirtioNetHeaderGsoTcpV6) {
+    *error = quiche::QuicheStrCat(
+        "Unsupported GSO type in packet read from the TUN device: ",
+        header.gso_type);
+    stats_->OnReadError(error);
+    return nullptr;
+  }
+  size_t tcp_headers_length = 0;
+  if (packet_length >= sizeof(ip6_hdr) + sizeof(tcphdr) &&
+      packet[kIPv6NextHeaderOffset] == IPPROTO_TCP) {
+    const uint8_t data_offset =
+        packet[sizeof(ip6_hdr) + kTcpDataOffsetOffset];
+    tcp_headers_length = sizeof(ip6_hdr) + 4 * (data_offset >> 4);
+  }
+  if (tcp_headers_length < sizeof(ip6_hdr) + sizeof(tcphdr) ||
+      tcp_headers_length > packet_length || header.gso_size == 0) {
+    *error = "Malformed GSO packet read from the TUN device";
+    stats_->OnReadError(error);
+    return nullptr;
+  }
+
+  memcpy(tcp_headers_, packet, tcp_headers_length);
+  tcp_headers_length_ = tcp_headers_length;
+  tcp_segment_size_ = header.gso_size;
+  tcp_payload_ = packet + tcp_headers_length;
+  tcp_payload_length_ = packet_length - tcp_headers_length;
+  uint32_t sequence_number;
+  memcpy(&sequence_number,
+         tcp_headers_ + sizeof(ip6_hdr) + kTcpSequenceNumberOffset,
+         sizeof(sequence_number));
+  tcp_sequence_number_ = quiche::QuicheEndian::NetToHost32(sequence_number);
+  tcp_first_segment_ = true;
+  if (tcp_payload_length_ == 0) {
+    // Nothing to split.
+    stats_->OnPacketRead(packet_length);
+    return std::make_unique<QuicData>(packet, packet_length);
+  }
+  return NextTcpSegment();
+}
+
+std::unique_ptr<QuicData> TunDevicePacketExchanger::NextTcpSegment() {
+  DCHECK_GT(tcp_payload_length_, 0u);
+  const size_t segment_length =
+      std::min(tcp_segment_size_, tcp_payload_length_);
+  const bool last_segment = segment_length == tcp_payload_length_;
+
+  // The headers overwrite the end of the previous segment, which was already
+  // delivered.
+  char* segment = tcp_payload_ - tcp_headers_length_;
+  memcpy(segment, tcp_headers_, tcp_headers_length_);
+  char* tcp_header = segment + sizeof(ip6_hdr);
+  const size_t tcp_length =
+      tcp_headers_length_ - sizeof(ip6_hdr) + segment_length;
+
+  const uint16_t payload_length =
+      quiche::QuicheEndian::HostToNet16(tcp_length);
+  memcpy(segment + kIPv6PayloadLengthOffset, &payload_length,
+         sizeof(payload_length));
+  const uint32_t sequence_number =
+      quiche::QuicheEndian::HostToNet32(tcp_sequence_number_);
+  memcpy(tcp_header + kTcpSequenceNumberOffset, &sequence_number,
+         sizeof(sequence_number));
+  // As the kernel does when segmenting, only the last segment may end the
+  // stream or push it, and only the first may signal congestion.
+  uint8_t flags = tcp_header[kTcpFlagsOffset];
+  if (!last_segment) {
+    flags &= ~(kTcpFlagFin | kTcpFlagPsh);
+  }
+  if (!tcp_first_segment_) {
+    flags &= ~kTcpFlagCwr;
+  }
+  tcp_header[kTcpFlagsOffset] = flags;
+  memset(tcp_header + kTcpChecksumOffset, 0, sizeof(uint16_t));
+  const uint16_t checksum = TcpChecksum(segment, tcp_length);
+  memcpy(tcp_header + kTcpChecksumOffset, &checksum, sizeof(checksum));
+
+  tcp_payload_ += segment_length;
+  tcp_payload_length_ -= segment_length;
+  tcp_sequence_number_ += segment_length;
+  tcp_first_segment_ = false;
+
+  const size_t size = tcp_headers_length_ + segment_length;
+  stats_->OnPacketRead(size);
+  return std::make_unique<QuicData>(segment, size);
 }
 
 int TunDevicePacketExchanger::file_descriptor() const {
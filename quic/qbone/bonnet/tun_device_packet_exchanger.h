@@ -5,6 +5,9 @@
 #ifndef QUICHE_QUIC_QBONE_BONNET_TUN_DEVICE_PACKET_EXCHANGER_H_
 #define QUICHE_QUIC_QBONE_BONNET_TUN_DEVICE_PACKET_EXCHANGER_H_
 
+#include <cstdint>
+#include <memory>
+
 #include "net/third_party/quiche/src/quic/core/quic_packets.h"
 #include "net/third_party/quiche/src/quic/qbone/platform/kernel_interface.h"
 #include "net/third_party/quiche/src/quic/qbone/qbone_client_interface.h"
@@ -51,6 +54,20 @@ class TunDevicePacketExchanger : public QbonePacketExchanger {
                            size_t max_pending_packets,
                            StatsInterface* stats);
 
+  // As above. If |enable_offload| is true, |fd| must have been opened with
+  // offload enabled, see TunDevice. Packets are then read and written with a
+  // virtio-net header, and the TCP segments the kernel coalesces into one
+  // packet of up to 64KB are read at once and split here. Since the QBONE
+  // connection cannot carry the segmentation metadata, it receives the same
+  // packets as without offload.
+  TunDevicePacketExchanger(int fd,
+                           size_t mtu,
+                           bool enable_offload,
+                           KernelInterface* kernel,
+                           QbonePacketExchanger::Visitor* visitor,
+                           size_t max_pending_packets,
+                           StatsInterface* stats);
+
   ABSL_MUST_USE_RESULT int file_descriptor() const;
 
   ABSL_MUST_USE_RESULT const StatsInterface* stats_interface() const;
@@ -66,11 +83,43 @@ class TunDevicePacketExchanger : public QbonePacketExchanger {
                    bool* blocked,
                    std::string* error) override;
 
+  // Handles the packet with a virtio-net header which was just read into
+  // |read_buffer_|, and returns the first packet to deliver, or nullptr if it
+  // has to be dropped.
+  std::unique_ptr<QuicData> ProcessOffloadedPacket(size_t size,
+                                                   std::string* error);
+
+  // Returns the next segment of the TCP packet in |read_buffer_| which is being
+  // split, writing its headers in front of its payload.
+  std::unique_ptr<QuicData> NextTcpSegment();
+
   int fd_ = -1;
   size_t mtu_;
+  const bool enable_offload_;
   KernelInterface* kernel_;
 
   StatsInterface* stats_;
+
+  // Every packet is read into this buffer, and is only valid until the next
+  // read.
+  const size_t read_buffer_size_;
+  std::unique_ptr<char[]> read_buffer_;
+
+  // The TCP packet in |read_buffer_| which is being split into segments.
+  // |tcp_headers_| holds its IPv6 and TCP headers as read, which are copied
+  // in front of the payload of each segment.
+  // This fits an IPv6 header without extensions and a TCP header with the
+  // most options.
+  static const size_t kMaxTcpHeadersLength = 40 + 60;
+  char tcp_headers_[kMaxTcpHeadersLength];
+  size_t tcp_headers_length_ = 0;
+  size_t tcp_segment_size_ = 0;
+  // Start of the payload which is yet to be delivered, and its length.
+  char* tcp_payload_ = nullptr;
+  size_t tcp_payload_length_ = 0;
+  // Sequence number of the first byte of |tcp_payload_|.
+  uint32_t tcp_sequence_number_ = 0;
+  bool tcp_first_segment_ = false;
 };
 
 }  // namespace quic
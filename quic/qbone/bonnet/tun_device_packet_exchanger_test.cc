@@ -4,10 +4,18 @@
 
 #include "net/third_party/quiche/src/quic/qbone/bonnet/tun_device_packet_exchanger.h"
 
+#include <netinet/ip6.h>
+#include <netinet/tcp.h>
+
+#include <vector>
+
 #include "net/third_party/quiche/src/quic/platform/api/quic_test.h"
 #include "net/third_party/quiche/src/quic/qbone/bonnet/mock_packet_exchanger_stats_interface.h"
 #include "net/third_party/quiche/src/quic/qbone/mock_qbone_client.h"
+#include "net/third_party/quiche/src/quic/qbone/platform/internet_checksum.h"
 #include "net/third_party/quiche/src/quic/qbone/platform/mock_kernel.h"
+#include "net/third_party/quiche/src/quic/qbone/platform/virtio_net_header.h"
+#include "net/third_party/quiche/src/common/platform/api/quiche_endian.h"
 
 namespace quic {
 namespace {
@@ -18,6 +26,7 @@ const int kFd = 15;
 
 using ::testing::_;
 using ::testing::Invoke;
+using ::testing::Return;
 using ::testing::StrEq;
 using ::testing::StrictMock;
 
@@ -116,5 +125,202 @@ TEST_F(TunDevicePacketExchangerTest,
   EXPECT_TRUE(exchanger_.ReadAndDeliverPacket(&mock_client_));
 }
 
+// Returns a TCP packet over IPv6 with |payload_length| bytes of payload and
+// the given flags, preceded by |header|.
+std::string MakeOffloadedTcpPacket(const VirtioNetHeader& header,
+                                   size_t payload_length,
+                                   uint8_t flags) {
+  ip6_hdr ip_header{};
+  ip_header.ip6_vfc = 0x6 << 4;
+  ip_header.ip6_plen =
+      quiche::QuicheEndian::HostToNet16(sizeof(tcphdr) + payload_length);
+  ip_header.ip6_nxt = IPPROTO_TCP;
+  ip_header.ip6_hops = 64;
+  ip_header.ip6_src.s6_addr[15] = 1;
+  ip_header.ip6_dst.s6_addr[15] = 2;
+
+  tcphdr tcp_header{};
+  tcp_header.th_sport = quiche::QuicheEndian::HostToNet16(443);
+  tcp_header.th_dport = quiche::QuicheEndian::HostToNet16(12345);
+  tcp_header.th_seq = quiche::QuicheEndian::HostToNet32(1000);
+  tcp_header.th_off = sizeof(tcphdr) / 4;
+  tcp_header.th_flags = flags;
+
+  std::string packet(reinterpret_cast<const char*>(&header), sizeof(header));
+  packet.append(reinterpret_cast<const char*>(&ip_header), sizeof(ip_header));
+  packet.append(reinterpret_cast<const char*>(&tcp_header),
+                sizeof(tcp_header));
+  for (size_t i = 0; i < payload_length; ++i) {
+    packet.push_back(static_cast<char>(i));
+  }
+  return packet;
+}
+
+bool IsTcpChecksumValid(quiche::QuicheStringPiece packet) {
+  InternetChecksum checksum;
+  checksum.Update(packet.data() + 8, 2 * sizeof(in6_addr));
+  const uint32_t length =
+      quiche::QuicheEndian::HostToNet32(packet.size() - sizeof(ip6_hdr));
+  checksum.Update(reinterpret_cast<const char*>(&length), sizeof(length));
+  const uint8_t next_header[4] = {0, 0, 0, IPPROTO_TCP};
+  checksum.Update(next_header, sizeof(next_header));
+  checksum.Update(packet.data() + sizeof(ip6_hdr),
+                  packet.size() - sizeof(ip6_hdr));
+  return checksum.Value() == 0;
+}
+
+class TunDevicePacketExchangerOffloadTest : public QuicTest {
+ protected:
+  TunDevicePacketExchangerOffloadTest()
+      : exchanger_(kFd,
+                   kMtu,
+                   /*enable_offload=*/true,
+                   &mock_kernel_,
+                   &mock_visitor_,
+                   kMaxPendingPackets,
+                   &mock_stats_) {
+    EXPECT_CALL(mock_client_, ProcessPacketFromNetwork(_))
+        .WillRepeatedly(Invoke([this](quiche::QuicheStringPiece packet) {
+          packets_delivered_.push_back(std::string(packet));
+        }));
+  }
+
+  // Makes the next read return |packet|.
+  void ExpectRead(const std::string& packet) {
+    EXPECT_CALL(mock_kernel_, read(kFd, _, _))
+        .WillOnce(Invoke([packet](int fd, void* buf, size_t count) {
+          EXPECT_LE(packet.size(), count);
+          memcpy(buf, packet.data(), packet.size());
+          return packet.size();
+        }));
+  }
+
+  MockKernel mock_kernel_;
+  StrictMock<MockVisitor> mock_visitor_;
+  MockQboneClient mock_client_;
+  MockPacketExchangerStatsInterface mock_stats_;
+  TunDevicePacketExchanger exchanger_;
+  std::vector<std::string> packets_delivered_;
+};
+
+TEST_F(TunDevicePacketExchangerOffloadTest, ReadsPacketWithoutOffload) {
+  VirtioNetHeader header{};
+  std::string packet = MakeOffloadedTcpPacket(header, 100, TH_ACK);
+  ExpectRead(packet);
+  EXPECT_CALL(mock_stats_, OnPacketRead(packet.size() - sizeof(header)));
+  EXPECT_TRUE(exchanger_.ReadAndDeliverPacket(&mock_client_));
+  ASSERT_EQ(1u, packets_delivered_.size());
+  EXPECT_EQ(packet.substr(sizeof(header)), packets_delivered_[0]);
+}
+
+TEST_F(TunDevicePacketExchangerOffloadTest, CompletesChecksum) {
+  VirtioNetHeader header{};
+  header.flags = kVirtioNetHeaderNeedsChecksum;
+  header.checksum_start = sizeof(ip6_hdr);
+  header.checksum_offset = 16;
+  std::string packet = MakeOffloadedTcpPacket(header, 101, TH_ACK);
+  // As the kernel does, leave the checksum of the pseudo-header in place.
+  std::string expected = packet.substr(sizeof(header));
+  InternetChecksum pseudo_header;
+  pseudo_header.Update(expected.data() + 8, 2 * sizeof(in6_addr));
+  const uint32_t length =
+      quiche::QuicheEndian::HostToNet32(sizeof(tcphdr) + 101);
+  pseudo_header.Update(reinterpret_cast<const char*>(&length), sizeof(length));
+  const uint8_t next_header[4] = {0, 0, 0, IPPROTO_TCP};
+  pseudo_header.Update(next_header, sizeof(next_header));
+  const uint16_t seed = ~pseudo_header.Value();
+  memcpy(&packet[sizeof(header) + sizeof(ip6_hdr) + 16], &seed, sizeof(seed));
+
+  ExpectRead(packet);
+  EXPECT_CALL(mock_stats_, OnPacketRead(_));
+  EXPECT_TRUE(exchanger_.ReadAndDeliverPacket(&mock_client_));
+  ASSERT_EQ(1u, packets_delivered_.size());
+  EXPECT_TRUE(IsTcpChecksumValid(packets_delivered_[0]));
+}
+
+TEST_F(TunDevicePacketExchangerOffloadTest, SplitsTcpSegments) {
+  VirtioNetHeader header{};
+  header.flags = kVirtioNetHeaderNeedsChecksum;
+  header.gso_type = kVirtioNetHeaderGsoTcpV6 | kVirtioNetHeaderGsoEcn;
+  header.header_length = sizeof(ip6_hdr) + sizeof(tcphdr);
+  header.gso_size = 400;
+  header.checksum_start = sizeof(ip6_hdr);
+  header.checksum_offset = 16;
+  std::string packet =
+      MakeOffloadedTcpPacket(header, 1000, TH_ACK | TH_PUSH | TH_FIN | 0x80);
+  const std::string payload =
+      packet.substr(sizeof(header) + sizeof(ip6_hdr) + sizeof(tcphdr));
+
+  // The segments are all read at once.
+  ExpectRead(packet);
+  EXPECT_CALL(mock_stats_, OnPacketRead(_)).Times(3);
+  EXPECT_TRUE(exchanger_.ReadAndDeliverPackets(&mock_client_, 3));
+  ASSERT_EQ(3u, packets_delivered_.size());
+
+  const size_t segment_sizes[] = {400, 400, 200};
+  for (size_t i = 0; i < 3; ++i) {
+    const std::string& segment = packets_delivered_[i];
+    ASSERT_EQ(sizeof(ip6_hdr) + sizeof(tcphdr) + segment_sizes[i],
+              segment.size());
+    ip6_hdr ip_header;
+    memcpy(&ip_header, segment.data(), sizeof(ip_header));
+    EXPECT_EQ(sizeof(tcphdr) + segment_sizes[i],
+              quiche::QuicheEndian::NetToHost16(ip_header.ip6_plen));
+    tcphdr tcp_header;
+    memcpy(&tcp_header, segment.data() + sizeof(ip6_hdr), sizeof(tcp_header));
+    EXPECT_EQ(1000u + 400 * i,
+              quiche::QuicheEndian::NetToHost32(tcp_header.th_seq));
+    EXPECT_EQ(i == 0, (tcp_header.th_flags & 0x80) != 0);
+    EXPECT_EQ(i == 2, (tcp_header.th_flags & TH_FIN) != 0);
+    EXPECT_EQ(i == 2, (tcp_header.th_flags & TH_PUSH) != 0);
+    EXPECT_TRUE((tcp_header.th_flags & TH_ACK) != 0);
+    EXPECT_EQ(payload.substr(400 * i, segment_sizes[i]),
+              segment.substr(sizeof(ip6_hdr) + sizeof(tcphdr)));
+    EXPECT_TRUE(IsTcpChecksumValid(segment));
+  }
+}
+
+TEST_F(TunDevicePacketExchangerOffloadTest, DropsUnsupportedGsoType) {
+  VirtioNetHeader header{};
+  header.gso_type = kVirtioNetHeaderGsoUdp;
+  header.gso_size = 400;
+  ExpectRead(MakeOffloadedTcpPacket(header, 1000, TH_ACK));
+  EXPECT_CALL(mock_stats_, OnReadError(_));
+  EXPECT_CALL(mock_visitor_, OnReadError(_));
+  EXPECT_FALSE(exchanger_.ReadAndDeliverPacket(&mock_client_));
+  EXPECT_TRUE(packets_delivered_.empty());
+}
+
+TEST_F(TunDevicePacketExchangerOffloadTest, DropsMalformedGsoPacket) {
+  VirtioNetHeader header{};
+  header.gso_type = kVirtioNetHeaderGsoTcpV6;
+  header.gso_size = 400;
+  std::string packet = MakeOffloadedTcpPacket(header, 0, TH_ACK);
+  // Claim TCP options beyond the end of the packet.
+  packet[sizeof(header) + sizeof(ip6_hdr) + 12] = static_cast<char>(0xf0);
+  ExpectRead(packet);
+  EXPECT_CALL(mock_stats_, OnReadError(_));
+  EXPECT_CALL(mock_visitor_, OnReadError(_));
+  EXPECT_FALSE(exchanger_.ReadAndDeliverPacket(&mock_client_));
+  EXPECT_TRUE(packets_delivered_.empty());
+}
+
+TEST_F(TunDevicePacketExchangerOffloadTest, WritesPacketWithHeader) {
+  std::string packet = "fake packet";
+  EXPECT_CALL(mock_kernel_, writev(kFd, _, 2))
+      .WillOnce(Invoke([packet](int fd, const struct iovec* iov, int iovcnt) {
+        EXPECT_EQ(sizeof(VirtioNetHeader), iov[0].iov_len);
+        EXPECT_EQ(std::string(sizeof(VirtioNetHeader), '\0'),
+                  std::string(static_cast<const char*>(iov[0].iov_base),
+                              iov[0].iov_len));
+        EXPECT_EQ(packet,
+                  std::string(static_cast<const char*>(iov[1].iov_base),
+                              iov[1].iov_len));
+        return iov[0].iov_len + iov[1].iov_len;
+      }));
+  EXPECT_CALL(mock_stats_, OnPacketWritten(packet.size()));
+  exchanger_.WritePacketToNetwork(packet.data(), packet.size());
+}
+
 }  // namespace
 }  // namespace quic
@@ -10,6 +10,7 @@
 
 #include "net/third_party/quiche/src/quic/platform/api/quic_test.h"
 #include "net/third_party/quiche/src/quic/qbone/platform/mock_kernel.h"
+#include "net/third_party/quiche/src/quic/qbone/platform/virtio_net_header.h"
 
 namespace quic {
 namespace {
@@ -22,8 +23,8 @@ using ::testing::StrEq;
 using ::testing::Unused;
 
 const char kDeviceName[] = "tun0";
-const int kSupportedFeatures =
-    IFF_TUN | IFF_TAP | IFF_MULTI_QUEUE | IFF_ONE_QUEUE | IFF_NO_PI;
+const int kSupportedFeatures = IFF_TUN | IFF_TAP | IFF_MULTI_QUEUE |
+                               IFF_ONE_QUEUE | IFF_NO_PI | IFF_VNET_HDR;
 
 // Quite a bit of EXPECT_CALL().Times(AnyNumber()).WillRepeatedly() are used to
 // make sure we can correctly set common expectations and override the
@@ -58,9 +59,9 @@ class TunDeviceTest : public QuicTest {
         }));
     EXPECT_CALL(mock_kernel_, ioctl(_, TUNSETIFF, _))
         .Times(AnyNumber())
-        .WillRepeatedly(Invoke([](Unused, Unused, void* argp) {
+        .WillRepeatedly(Invoke([this](Unused, Unused, void* argp) {
           auto* ifr = reinterpret_cast<struct ifreq*>(argp);
-          EXPECT_EQ(IFF_TUN | IFF_MULTI_QUEUE | IFF_NO_PI, ifr->ifr_flags);
+          EXPECT_EQ(expected_flags_, ifr->ifr_flags);
           EXPECT_THAT(ifr->ifr_name, StrEq(kDeviceName));
           return 0;
         }));
@@ -118,6 +119,7 @@ class TunDeviceTest : public QuicTest {
 
   MockKernel mock_kernel_;
   int next_fd_ = 100;
+  int expected_flags_ = IFF_TUN | IFF_MULTI_QUEUE | IFF_NO_PI;
 };
 
 // A TunDevice can be initialized and up
@@ -204,5 +206,63 @@ TEST_F(TunDeviceTest, FailToUp) {
   EXPECT_FALSE(tun_device.Up());
 }
 
+TEST_F(TunDeviceTest, MultipleQueues) {
+  SetInitExpectations(/* mtu = */ 1500, /* persist = */ true);
+  // The device is only made persistent once, through its first queue.
+  EXPECT_CALL(mock_kernel_, ioctl(100, TUNSETPERSIST, _)).WillOnce(Return(0));
+  TunDevice tun_device(kDeviceName, 1500, true, true, /* num_queues = */ 3,
+                       /* enable_offload = */ false, &mock_kernel_);
+  EXPECT_TRUE(tun_device.Init());
+  ASSERT_EQ(3u, tun_device.GetNumQueues());
+  EXPECT_EQ(100, tun_device.GetFileDescriptor());
+  EXPECT_EQ(100, tun_device.GetQueueFileDescriptor(0));
+  EXPECT_EQ(101, tun_device.GetQueueFileDescriptor(1));
+  EXPECT_EQ(102, tun_device.GetQueueFileDescriptor(2));
+  EXPECT_EQ(-1, tun_device.GetQueueFileDescriptor(3));
+}
+
+TEST_F(TunDeviceTest, FailToOpenLaterQueue) {
+  SetInitExpectations(/* mtu = */ 1500, /* persist = */ true);
+  EXPECT_CALL(mock_kernel_, ioctl(101, TUNSETIFF, _)).WillOnce(Return(-1));
+  TunDevice tun_device(kDeviceName, 1500, true, true, /* num_queues = */ 2,
+                       /* enable_offload = */ false, &mock_kernel_);
+  // Both queues are closed.
+  EXPECT_FALSE(tun_device.Init());
+  EXPECT_EQ(0u, tun_device.GetNumQueues());
+  EXPECT_EQ(tun_device.GetFileDescriptor(), -1);
+}
+
+TEST_F(TunDeviceTest, EnableOffload) {
+  expected_flags_ |= IFF_VNET_HDR;
+  SetInitExpectations(/* mtu = */ 1500, /* persist = */ false);
+  EXPECT_CALL(mock_kernel_, ioctl(100, TUNSETVNETHDRSZ, _))
+      .WillOnce(Invoke([](Unused, Unused, void* argp) {
+        EXPECT_EQ(static_cast<int>(sizeof(VirtioNetHeader)),
+                  *reinterpret_cast<int*>(argp));
+        return 0;
+      }));
+  EXPECT_CALL(mock_kernel_, ioctl(100, TUNSETOFFLOAD, _))
+      .WillOnce(Invoke([](Unused, Unused, void* argp) {
+        EXPECT_EQ(static_cast<uintptr_t>(TUN_F_CSUM | TUN_F_TSO6),
+                  reinterpret_cast<uintptr_t>(argp));
+        return 0;
+      }));
+  TunDevice tun_device(kDeviceName, 1500, false, true, /* num_queues = */ 1,
+                       /* enable_offload = */ true, &mock_kernel_);
+  EXPECT_TRUE(tun_device.Init());
+  EXPECT_GT(tun_device.GetFileDescriptor(), -1);
+}
+
+TEST_F(TunDeviceTest, FailToEnableOffload) {
+  expected_flags_ |= IFF_VNET_HDR;
+  SetInitExpectations(/* mtu = */ 1500, /* persist = */ false);
+  EXPECT_CALL(mock_kernel_, ioctl(_, TUNSETVNETHDRSZ, _)).WillOnce(Return(0));
+  EXPECT_CALL(mock_kernel_, ioctl(_, TUNSETOFFLOAD, _)).WillOnce(Return(-1));
+  TunDevice tun_device(kDeviceName, 1500, false, true, /* num_queues = */ 1,
+                       /* enable_offload = */ true, &mock_kernel_);
+  EXPECT_FALSE(tun_device.Init());
+  EXPECT_EQ(tun_device.GetFileDescriptor(), -1);
+}
+
 }  // namespace
 }  // namespace quic
@@ -4,16 +4,27 @@
 
 #include "net/third_party/quiche/src/quic/qbone/platform/internet_checksum.h"
 
+#include <cstring>
+
 namespace quic {
 
 void InternetChecksum::Update(const char* data, size_t size) {
-  const char* current;
-  for (current = data; current + 1 < data + size; current += 2) {
-    accumulator_ += *reinterpret_cast<const uint16_t*>(current);
+  // Since the one's complement sum does not depend on the order of the 16-bit
+  // words, they can be added up in pairs, as long as the final sum is folded.
+  uint64_t accumulator = accumulator_;
+  size_t offset = 0;
+  for (; offset + sizeof(uint32_t) <= size; offset += sizeof(uint32_t)) {
+    uint32_t word;
+    memcpy(&word, data + offset, sizeof(word));
+    accumulator += word;
   }
-  if (current < data + size) {
-    accumulator_ += *reinterpret_cast<const uint8_t*>(current);
+  if (offset < size) {
+    // The last word, padded with zeros.
+    uint32_t word = 0;
+    memcpy(&word, data + offset, size - offset);
+    accumulator += word;
   }
+  accumulator_ = accumulator;
 }
 
 void InternetChecksum::Update(const uint8_t* data, size_t size) {
@@ -21,8 +32,8 @@ void InternetChecksum::Update(const uint8_t* data, size_t size) {
 }
 
 uint16_t InternetChecksum::Value() const {
-  uint32_t total = accumulator_;
-  while (total & 0xffff0000u) {
+  uint64_t total = accumulator_;
+  while (total & ~uint64_t{0xffff}) {
     total = (total >> 16u) + (total & 0xffffu);
   }
   return ~static_cast<uint16_t>(total);
@@ -11,6 +11,10 @@
 namespace quic {
 
 // Incrementally compute an Internet header checksum as described in RFC 1071.
+//
+// The data is summed 32 bits at a time into a 64-bit accumulator, which
+// cannot overflow for any realistic input, and only folded into 16 bits by
+// Value(). The loop is simple enough for the compiler to vectorize.
 class InternetChecksum {
  public:
   // Update the checksum with the specified data.  Note that while the checksum
@@ -24,7 +28,7 @@ class InternetChecksum {
   uint16_t Value() const;
 
  private:
-  uint32_t accumulator_ = 0;
+  uint64_t accumulator_ = 0;
 };
 
 }  // namespace quic
@@ -4,6 +4,10 @@
 
 #include "net/third_party/quiche/src/quic/qbone/platform/internet_checksum.h"
 
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
 #include "net/third_party/quiche/src/quic/platform/api/quic_test.h"
 
 namespace quic {
@@ -63,5 +67,57 @@ TEST(InternetChecksumTest, ChecksumRequiringMultipleCarriesInLittleEndian) {
   EXPECT_EQ(0xff, result_bytes[1]);
 }
 
+// Sums |data| two bytes at a time, as the RFC describes.
+uint16_t ReferenceChecksum(const uint8_t* data, size_t size) {
+  uint64_t total = 0;
+  for (size_t i = 0; i < size; i += 2) {
+    uint16_t word = 0;
+    memcpy(&word, data + i, std::min<size_t>(2, size - i));
+    total += word;
+  }
+  while (total & ~uint64_t{0xffff}) {
+    total = (total >> 16u) + (total & 0xffffu);
+  }
+  return ~static_cast<uint16_t>(total);
+}
+
+TEST(InternetChecksumTest, MatchesReferenceForAllSizesAndAlignments) {
+  uint8_t data[1500 + 3];
+  for (size_t i = 0; i < sizeof(data); ++i) {
+    data[i] = static_cast<uint8_t>(i * 167 + 13);
+  }
+  for (size_t alignment = 0; alignment < 4; ++alignment) {
+    for (size_t size = 0; size <= 1500; ++size) {
+      InternetChecksum checksum;
+      checksum.Update(data + alignment, size);
+      ASSERT_EQ(ReferenceChecksum(data + alignment, size), checksum.Value())
+          << "alignment " << alignment << " size " << size;
+    }
+  }
+}
+
+TEST(InternetChecksumTest, MatchesReferenceWhenUpdatedInParts) {
+  uint8_t data[1000];
+  for (size_t i = 0; i < sizeof(data); ++i) {
+    data[i] = static_cast<uint8_t>(i * 59 + 211);
+  }
+  // Every part but the last has an even size.
+  for (size_t split = 0; split < sizeof(data); split += 2) {
+    InternetChecksum checksum;
+    checksum.Update(data, split);
+    checksum.Update(data + split, sizeof(data) - 1 - split);
+    ASSERT_EQ(ReferenceChecksum(data, sizeof(data) - 1), checksum.Value())
+        << "split " << split;
+  }
+}
+
+TEST(InternetChecksumTest, LargeInputDoesNotOverflow) {
+  std::vector<uint8_t> data(1 << 20, 0xff);
+  InternetChecksum checksum;
+  checksum.Update(data.data(), data.size());
+  EXPECT_EQ(ReferenceChecksum(data.data(), data.size()), checksum.Value());
+  EXPECT_EQ(0, checksum.Value());
+}
+
 }  // namespace
 }  // namespace quic
@@ -10,6 +10,7 @@
 #include <sys/ioctl.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <unistd.h>
 #include <type_traits>
 #include <utility>
@@ -46,6 +47,7 @@ class KernelInterface {
                          const void* optval,
                          socklen_t optlen) = 0;
   virtual ssize_t write(int fd, const void* buf, size_t count) = 0;
+  virtual ssize_t writev(int fd, const struct iovec* iov, int iovcnt) = 0;
 };
 
 // It is unfortunate to have R here, but std::result_of cannot be used.
@@ -137,6 +139,10 @@ class ParametrizedKernel final : public KernelInterface {
     static Runner syscall("write");
     return syscall.Run(&::write, fd, buf, count);
   }
+  ssize_t writev(int fd, const struct iovec* iov, int iovcnt) override {
+    static Runner syscall("writev");
+    return syscall.Run(&::writev, fd, iov, iovcnt);
+  }
 };
 
 class DefaultKernelRunner {
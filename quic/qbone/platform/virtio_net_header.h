@@ -0,0 +1,47 @@
+// Copyright (c) 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef QUICHE_QUIC_QBONE_PLATFORM_VIRTIO_NET_HEADER_H_
+#define QUICHE_QUIC_QBONE_PLATFORM_VIRTIO_NET_HEADER_H_
+
+#include <cstdint>
+
+namespace quic {
+
+// The header which precedes every packet read from or written to a TUN device
+// opened with IFF_VNET_HDR. This mirrors struct virtio_net_hdr, since
+// <linux/virtio_net.h> cannot be included from C++. The fields are in host
+// byte order.
+struct VirtioNetHeader {
+  uint8_t flags;
+  uint8_t gso_type;
+  // Length of the headers of a GSO packet, which are repeated in every
+  // segment.
+  uint16_t header_length;
+  // Length of the payload of each segment of a GSO packet.
+  uint16_t gso_size;
+  // If kVirtioNetHeaderNeedsChecksum is set, the checksum covering the
+  // packet from |checksum_start| on is still to be stored at
+  // |checksum_start| + |checksum_offset|. The checksum field holds the
+  // checksum of the pseudo-header.
+  uint16_t checksum_start;
+  uint16_t checksum_offset;
+};
+static_assert(sizeof(VirtioNetHeader) == 10,
+              "VirtioNetHeader must match struct virtio_net_hdr");
+
+// Values of VirtioNetHeader::flags.
+const uint8_t kVirtioNetHeaderNeedsChecksum = 1;
+
+// Values of VirtioNetHeader::gso_type.
+const uint8_t kVirtioNetHeaderGsoNone = 0;
+const uint8_t kVirtioNetHeaderGsoTcpV4 = 1;
+const uint8_t kVirtioNetHeaderGsoUdp = 3;
+const uint8_t kVirtioNetHeaderGsoTcpV6 = 4;
+// Set in addition to the type if the segments may carry ECN CWR.
+const uint8_t kVirtioNetHeaderGsoEcn = 0x80;
+
+}  // namespace quic
+
+#endif  // QUICHE_QUIC_QBONE_PLATFORM_VIRTIO_NET_HEADER_H_
@@ -23,6 +23,17 @@ bool QbonePacketExchanger::ReadAndDeliverPacket(
   return true;
 }
 
+bool QbonePacketExchanger::ReadAndDeliverPackets(
+    QboneClientInterface* qbone_client,
+    size_t max_packets) {
+  for (size_t i = 0; i < max_packets; ++i) {
+    if (!ReadAndDeliverPacket(qbone_client)) {
+      return false;
+    }
+  }
+  return true;
+}
+
 void QbonePacketExchanger::WritePacketToNetwork(const char* packet,
                                                 size_t size) {
   bool blocked = false;
@@ -39,6 +39,12 @@ class QbonePacketExchanger : public QbonePacketWriter {
   // qbone_client.
   bool ReadAndDeliverPacket(QboneClientInterface* qbone_client);
 
+  // Reads and delivers up to |max_packets| packets, stopping early when there
+  // is nothing left to read or a read fails. Returns true if there may be more
+  // packets to read.
+  bool ReadAndDeliverPackets(QboneClientInterface* qbone_client,
+                             size_t max_packets);
+
   // From QbonePacketWriter.
   // Writes a packet to the local network. If the write would be blocked, the
   // packet will be queued if the queue is smaller than max_pending_packets_.
@@ -51,7 +57,9 @@ class QbonePacketExchanger : public QbonePacketWriter {
   // The actual implementation that reads a packet from the local network.
   // Returns the packet if one is successfully read. This might nullptr when a)
   // there is no packet to read, b) the read failed. In the former case, blocked
-  // is set to true. error contains the error message.
+  // is set to true. error contains the error message. The packet may point
+  // into a buffer owned by the implementation, and is only valid until the
+  // next call.
   virtual std::unique_ptr<QuicData> ReadPacket(bool* blocked,
                                                std::string* error) = 0;
 
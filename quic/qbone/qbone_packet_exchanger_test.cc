@@ -131,6 +131,25 @@ TEST(QbonePacketExchangerTest,
   EXPECT_FALSE(exchanger.ReadAndDeliverPacket(&client));
 }
 
+TEST(QbonePacketExchangerTest, ReadAndDeliverPacketsStopsAtMaxPackets) {
+  StrictMock<MockVisitor> visitor;
+  FakeQbonePacketExchanger exchanger(&visitor, kMaxPendingPackets);
+  StrictMock<MockQboneClient> client;
+
+  std::vector<std::string> packets = {"packet0", "packet1", "packet2"};
+  for (const std::string& packet : packets) {
+    exchanger.AddPacketToBeRead(
+        std::make_unique<QuicData>(packet.data(), packet.length()));
+  }
+  EXPECT_CALL(client, ProcessPacketFromNetwork(StrEq("packet0")));
+  EXPECT_CALL(client, ProcessPacketFromNetwork(StrEq("packet1")));
+  EXPECT_TRUE(exchanger.ReadAndDeliverPackets(&client, 2));
+
+  // Only one packet is left.
+  EXPECT_CALL(client, ProcessPacketFromNetwork(StrEq("packet2")));
+  EXPECT_FALSE(exchanger.ReadAndDeliverPackets(&client, 2));
+}
+
 TEST(QbonePacketExchangerTest,
      WritePacketToNetworkWritesDirectlyToNetworkWhenNotBlocked) {
   MockVisitor visitor;
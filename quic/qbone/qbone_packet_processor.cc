@@ -4,6 +4,7 @@
 
 #include "net/third_party/quiche/src/quic/qbone/qbone_packet_processor.h"
 
+#include <cstddef>
 #include <cstring>
 
 #include "net/third_party/quiche/src/quic/platform/api/quic_bug_tracker.h"
@@ -20,6 +21,8 @@ constexpr size_t kIPv6AddressSize = 16;
 constexpr size_t kIPv6MinPacketSize = 1280;
 constexpr size_t kIcmpTtl = 64;
 constexpr size_t kICMPv6DestinationUnreachableDueToSourcePolicy = 5;
+// Number of flows whose filter result is remembered.
+constexpr size_t kFlowCacheSize = 1024;
 
 }  // namespace
 
@@ -36,7 +39,8 @@ QbonePacketProcessor::QbonePacketProcessor(QuicIpAddress self_ip,
     : client_ip_(client_ip),
       output_(output),
       stats_(stats),
-      filter_(new Filter) {
+      filter_(new Filter),
+      flow_cache_(kFlowCacheSize) {
   memcpy(self_ip_.s6_addr, self_ip.ToPackedString().data(), kIPv6AddressSize);
   DCHECK_LE(client_ip_subnet_length, kIPv6AddressSize * 8);
   client_ip_subnet_length_ = client_ip_subnet_length;
@@ -60,8 +64,90 @@ QbonePacketProcessor::Filter::FilterPacket(
   return ProcessingResult::OK;
 }
 
+bool QbonePacketProcessor::Filter::ResultDependsOnlyOnFlow() const {
+  return false;
+}
+
+QbonePacketProcessor::FlowCache::FlowCache(size_t size) : size_(size) {
+  DCHECK_EQ(0u, size & (size - 1));
+}
+
+bool QbonePacketProcessor::FlowCache::GetFlowKey(
+    Direction direction,
+    uint8_t transport_protocol,
+    quiche::QuicheStringPiece packet,
+    quiche::QuicheStringPiece payload,
+    FlowKey* key) {
+  // Both TCP and UDP headers start with the source and destination ports.
+  if ((transport_protocol != IPPROTO_TCP &&
+       transport_protocol != IPPROTO_UDP) ||
+      payload.size() < sizeof(key->ports)) {
+    return false;
+  }
+  memcpy(key->addresses, packet.data() + offsetof(ip6_hdr, ip6_src),
+         sizeof(key->addresses));
+  memcpy(&key->ports, payload.data(), sizeof(key->ports));
+  key->transport_protocol = transport_protocol;
+  key->direction = direction;
+  return true;
+}
+
+bool QbonePacketProcessor::FlowCache::Lookup(const FlowKey& key,
+                                             ProcessingResult* result,
+                                             icmp6_hdr* icmp_header) const {
+  if (entries_.empty()) {
+    return false;
+  }
+  const Entry& entry = entries_[GetIndex(key)];
+  if (!entry.valid || entry.key.ports != key.ports ||
+      entry.key.transport_protocol != key.transport_protocol ||
+      entry.key.direction != key.direction ||
+      memcmp(entry.key.addresses, key.addresses, sizeof(key.addresses)) !=
+          0) {
+    return false;
+  }
+  *result = entry.result;
+  *icmp_header = entry.icmp_header;
+  return true;
+}
+
+void QbonePacketProcessor::FlowCache::Insert(const FlowKey& key,
+                                             ProcessingResult result,
+                                             const icmp6_hdr& icmp_header) {
+  if (entries_.empty()) {
+    entries_.resize(size_);
+  }
+  Entry& entry = entries_[GetIndex(key)];
+  entry.valid = true;
+  entry.key = key;
+  entry.result = result;
+  entry.icmp_header = icmp_header;
+}
+
+void QbonePacketProcessor::FlowCache::Clear() {
+  for (Entry& entry : entries_) {
+    entry.valid = false;
+  }
+}
+
+size_t QbonePacketProcessor::FlowCache::GetIndex(const FlowKey& key) const {
+  uint64_t hash = (uint64_t{key.ports} << 16) |
+                  (uint64_t{key.transport_protocol} << 8) |
+                  static_cast<uint64_t>(key.direction);
+  for (uint64_t word : key.addresses) {
+    hash = (hash ^ word) * 0x9e3779b97f4a7c15u;
+  }
+  return (hash ^ (hash >> 32)) & (size_ - 1);
+}
+
 void QbonePacketProcessor::ProcessPacket(std::string* packet,
                                          Direction direction) {
+  ProcessPacket(&(*packet)[0], packet->size(), direction);
+}
+
+void QbonePacketProcessor::ProcessPacket(char* packet,
+                                         size_t size,
+                                         Direction direction) {
   if (QUIC_PREDICT_FALSE(!IsValid())) {
     QUIC_BUG << "QuicPacketProcessor is invoked in an invalid state.";
     stats_->OnPacketDroppedSilently(direction);
@@ -72,17 +158,19 @@ void QbonePacketProcessor::ProcessPacket(std::string* packet,
   char* transport_data;
   icmp6_hdr icmp_header;
   memset(&icmp_header, 0, sizeof(icmp_header));
-  ProcessingResult result = ProcessIPv6HeaderAndFilter(
-      packet, direction, &transport_protocol, &transport_data, &icmp_header);
+  ProcessingResult result =
+      ProcessIPv6HeaderAndFilter(packet, size, direction, &transport_protocol,
+                                 &transport_data, &icmp_header);
+  const quiche::QuicheStringPiece full_packet(packet, size);
 
   switch (result) {
     case ProcessingResult::OK:
       switch (direction) {
         case Direction::FROM_OFF_NETWORK:
-          output_->SendPacketToNetwork(*packet);
+          output_->SendPacketToNetwork(full_packet);
           break;
         case Direction::FROM_NETWORK:
-          output_->SendPacketToClient(*packet);
+          output_->SendPacketToClient(full_packet);
           break;
       }
       stats_->OnPacketForwarded(direction);
@@ -94,55 +182,54 @@ void QbonePacketProcessor::ProcessPacket(std::string* packet,
       stats_->OnPacketDeferred(direction);
       break;
     case ProcessingResult::ICMP:
-      SendIcmpResponse(&icmp_header, *packet, direction);
+      SendIcmpResponse(&icmp_header, full_packet, direction);
       stats_->OnPacketDroppedWithIcmp(direction);
       break;
     case ProcessingResult::ICMP_AND_TCP_RESET:
-      SendIcmpResponse(&icmp_header, *packet, direction);
+      SendIcmpResponse(&icmp_header, full_packet, direction);
       stats_->OnPacketDroppedWithIcmp(direction);
-      SendTcpReset(*packet, direction);
+      SendTcpReset(full_packet, direction);
       stats_->OnPacketDroppedWithTcpReset(direction);
       break;
   }
 }
 
 QbonePacketProcessor::ProcessingResult
-QbonePacketProcessor::ProcessIPv6HeaderAndFilter(std::string* packet,
+QbonePacketProcessor::ProcessIPv6HeaderAndFilter(char* packet,
+                                                 size_t size,
                                                  Direction direction,
                                                  uint8_t* transport_protocol,
                                                  char** transport_data,
                                                  icmp6_hdr* icmp_header) {
   ProcessingResult result = ProcessIPv6Header(
-      packet, direction, transport_protocol, transport_data, icmp_header);
+      packet, size, direction, transport_protocol, transport_data, icmp_header);
 
   if (result == ProcessingResult::OK) {
-    char* packet_data = &*packet->begin();
-    size_t header_size = *transport_data - packet_data;
+    size_t header_size = *transport_data - packet;
     // Sanity-check the bounds.
-    if (packet_data >= *transport_data || header_size > packet->size() ||
+    if (packet >= *transport_data || header_size > size ||
         header_size < kIPv6HeaderSize) {
       QUIC_BUG << "Invalid pointers encountered in "
                   "QbonePacketProcessor::ProcessPacket.  Dropping the packet";
       return ProcessingResult::SILENT_DROP;
     }
 
-    result = filter_->FilterPacket(
-        direction, *packet,
-        quiche::QuicheStringPiece(*transport_data,
-                                  packet->size() - header_size),
-        icmp_header, output_);
+    result = FilterPacket(
+        direction, *transport_protocol, quiche::QuicheStringPiece(packet, size),
+        quiche::QuicheStringPiece(*transport_data, size - header_size),
+        icmp_header);
   }
 
   // Do not send ICMP error messages in response to ICMP errors.
   if (result == ProcessingResult::ICMP) {
-    const uint8_t* header = reinterpret_cast<const uint8_t*>(packet->data());
+    const uint8_t* header = reinterpret_cast<const uint8_t*>(packet);
 
     constexpr size_t kIPv6NextHeaderOffset = 6;
     constexpr size_t kIcmpMessageTypeOffset = kIPv6HeaderSize + 0;
     constexpr size_t kIcmpMessageTypeMaxError = 127;
     if (
         // Check size.
-        packet->size() >= (kIPv6HeaderSize + kICMPv6HeaderSize) &&
+        size >= (kIPv6HeaderSize + kICMPv6HeaderSize) &&
         // Check that the packet is in fact ICMP.
         header[kIPv6NextHeaderOffset] == IPPROTO_ICMPV6 &&
         // Check that ICMP message type is an error.
@@ -154,20 +241,46 @@ QbonePacketProcessor::ProcessIPv6HeaderAndFilter(std::string* packet,
   return result;
 }
 
+QbonePacketProcessor::ProcessingResult QbonePacketProcessor::FilterPacket(
+    Direction direction,
+    uint8_t transport_protocol,
+    quiche::QuicheStringPiece full_packet,
+    quiche::QuicheStringPiece payload,
+    icmp6_hdr* icmp_header) {
+  FlowCache::FlowKey key;
+  const bool cacheable =
+      filter_->ResultDependsOnlyOnFlow() &&
+      FlowCache::GetFlowKey(direction, transport_protocol, full_packet,
+                            payload, &key);
+  ProcessingResult result;
+  if (cacheable && flow_cache_.Lookup(key, &result, icmp_header)) {
+    return result;
+  }
+  result = filter_->FilterPacket(direction, full_packet, payload, icmp_header,
+                                 output_);
+  // A deferred packet is the filter's to send, so the next one has to be
+  // handed to the filter too.
+  if (cacheable && result != ProcessingResult::DEFER) {
+    flow_cache_.Insert(key, result, *icmp_header);
+  }
+  return result;
+}
+
 QbonePacketProcessor::ProcessingResult QbonePacketProcessor::ProcessIPv6Header(
-    std::string* packet,
+    char* packet,
+    size_t size,
     Direction direction,
     uint8_t* transport_protocol,
     char** transport_data,
     icmp6_hdr* icmp_header) {
   // Check if the packet is big enough to have IPv6 header.
-  if (packet->size() < kIPv6HeaderSize) {
+  if (size < kIPv6HeaderSize) {
     QUIC_DVLOG(1) << "Dropped malformed packet: IPv6 header too short";
     return ProcessingResult::SILENT_DROP;
   }
 
   // Check version field.
-  ip6_hdr* header = reinterpret_cast<ip6_hdr*>(&*packet->begin());
+  ip6_hdr* header = reinterpret_cast<ip6_hdr*>(packet);
   if (header->ip6_vfc >> 4 != 6) {
     QUIC_DVLOG(1) << "Dropped malformed packet: IP version is not IPv6";
     return ProcessingResult::SILENT_DROP;
@@ -176,7 +289,7 @@ QbonePacketProcessor::ProcessingResult QbonePacketProcessor::ProcessIPv6Header(
   // Check payload size.
   const size_t declared_payload_size =
       quiche::QuicheEndian::NetToHost16(header->ip6_plen);
-  const size_t actual_payload_size = packet->size() - kIPv6HeaderSize;
+  const size_t actual_payload_size = size - kIPv6HeaderSize;
   if (declared_payload_size != actual_payload_size) {
     QUIC_DVLOG(1)
         << "Dropped malformed packet: incorrect packet length specified";
@@ -226,7 +339,7 @@ QbonePacketProcessor::ProcessingResult QbonePacketProcessor::ProcessIPv6Header(
     case IPPROTO_UDP:
     case IPPROTO_ICMPV6:
       *transport_protocol = header->ip6_nxt;
-      *transport_data = (&*packet->begin()) + kIPv6HeaderSize;
+      *transport_data = packet + kIPv6HeaderSize;
       break;
     default:
       icmp_header->icmp6_type = ICMP6_PARAM_PROB;
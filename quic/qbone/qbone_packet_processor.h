@@ -8,6 +8,10 @@
 #include <netinet/icmp6.h>
 #include <netinet/ip6.h>
 
+#include <cstdint>
+#include <memory>
+#include <vector>
+
 #include "net/third_party/quiche/src/quic/core/quic_types.h"
 #include "net/third_party/quiche/src/quic/platform/api/quic_ip_address.h"
 #include "net/third_party/quiche/src/common/platform/api/quiche_string_piece.h"
@@ -99,6 +103,15 @@ class QbonePacketProcessor {
                                           icmp6_hdr* icmp_header,
                                           OutputInterface* output);
 
+    // Returns true if FilterPacket() returns the same result, and sets the
+    // same |icmp_header|, for every packet of a TCP or UDP flow in a given
+    // direction, that is for every packet with the same addresses and ports.
+    // The processor then only calls FilterPacket() on the first packet of a
+    // flow and reuses the result for the following ones, until the flow is
+    // evicted from its cache or ClearFlowCache() is called. DEFER results are
+    // never reused.
+    virtual bool ResultDependsOnlyOnFlow() const;
+
    protected:
     // Helper methods that allow to easily extract information that is required
     // for filtering from the |ipv6_header| argument.  All of those assume that
@@ -145,10 +158,19 @@ class QbonePacketProcessor {
   // modified in the process, by having the TTL field decreased.
   void ProcessPacket(std::string* packet, Direction direction);
 
+  // As above, for the |size| bytes at |packet|, which are modified in place
+  // rather than copied.
+  void ProcessPacket(char* packet, size_t size, Direction direction);
+
   void set_filter(std::unique_ptr<Filter> filter) {
     filter_ = std::move(filter);
+    flow_cache_.Clear();
   }
 
+  // Forgets the filter results reused for flows, for instance after the policy
+  // of the filter changed.
+  void ClearFlowCache() { flow_cache_.Clear(); }
+
   void set_client_ip(QuicIpAddress client_ip) { client_ip_ = client_ip; }
   void set_client_ip_subnet_length(size_t client_ip_subnet_length) {
     client_ip_subnet_length_ = client_ip_subnet_length;
@@ -160,7 +182,8 @@ class QbonePacketProcessor {
   // Processes the header and returns what should be done with the packet.
   // After that, calls an external packet filter if registered.  TTL of the
   // packet may be decreased in the process.
-  ProcessingResult ProcessIPv6HeaderAndFilter(std::string* packet,
+  ProcessingResult ProcessIPv6HeaderAndFilter(char* packet,
+                                              size_t size,
                                               Direction direction,
                                               uint8_t* transport_protocol,
                                               char** transport_data,
@@ -186,9 +209,73 @@ class QbonePacketProcessor {
   std::unique_ptr<Filter> filter_;
 
  private:
+  // Remembers the filter results of the TCP and UDP flows seen most recently.
+  // The cache is direct-mapped: a flow replaces whichever flow hashes to the
+  // same entry, so that lookups and insertions take constant time and do not
+  // allocate.
+  class FlowCache {
+   public:
+    // The fields of a packet which identify its flow.
+    struct FlowKey {
+      // Source and destination addresses.
+      uint64_t addresses[4];
+      // Source and destination ports.
+      uint32_t ports;
+      uint8_t transport_protocol;
+      Direction direction;
+    };
+
+    // |size| must be a power of two.
+    explicit FlowCache(size_t size);
+
+    // Sets |key| to the flow of |packet|, whose IPv6 header is valid and which
+    // carries |payload| of |transport_protocol|. Returns false if the packet is
+    // not part of a TCP or UDP flow.
+    static bool GetFlowKey(Direction direction,
+                           uint8_t transport_protocol,
+                           quiche::QuicheStringPiece packet,
+                           quiche::QuicheStringPiece payload,
+                           FlowKey* key);
+
+    // Returns true and sets |result| and |icmp_header| to the ones inserted
+    // for |key|, if they are still in the cache.
+    bool Lookup(const FlowKey& key,
+                ProcessingResult* result,
+                icmp6_hdr* icmp_header) const;
+
+    void Insert(const FlowKey& key,
+                ProcessingResult result,
+                const icmp6_hdr& icmp_header);
+
+    void Clear();
+
+   private:
+    struct Entry {
+      bool valid = false;
+      FlowKey key;
+      ProcessingResult result = ProcessingResult::OK;
+      icmp6_hdr icmp_header;
+    };
+
+    size_t GetIndex(const FlowKey& key) const;
+
+    const size_t size_;
+    // Allocated on the first insertion, so that processors whose filter
+    // results cannot be reused do not pay for the cache.
+    std::vector<Entry> entries_;
+  };
+
+  // Calls the filter, unless its result for the flow of the packet is known.
+  ProcessingResult FilterPacket(Direction direction,
+                                uint8_t transport_protocol,
+                                quiche::QuicheStringPiece full_packet,
+                                quiche::QuicheStringPiece payload,
+                                icmp6_hdr* icmp_header);
+
   // Performs basic sanity and permission checks on the packet, and decreases
   // the TTL.
-  ProcessingResult ProcessIPv6Header(std::string* packet,
+  ProcessingResult ProcessIPv6Header(char* packet,
+                                     size_t size,
                                      Direction direction,
                                      uint8_t* transport_protocol,
                                      char** transport_data,
@@ -196,6 +283,8 @@ class QbonePacketProcessor {
 
   void SendResponse(Direction original_direction,
                     quiche::QuicheStringPiece packet);
+
+  FlowCache flow_cache_;
 };
 
 }  // namespace quic
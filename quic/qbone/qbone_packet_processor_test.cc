@@ -17,6 +17,7 @@ using Direction = QbonePacketProcessor::Direction;
 using ProcessingResult = QbonePacketProcessor::ProcessingResult;
 using OutputInterface = QbonePacketProcessor::OutputInterface;
 using ::testing::_;
+using ::testing::Invoke;
 using ::testing::Return;
 
 // clang-format off
@@ -210,6 +211,21 @@ TEST_F(QbonePacketProcessorTest, GoodPacketFromNetwork) {
   SendPacketFromNetwork(kReferenceNetworkPacket);
 }
 
+TEST_F(QbonePacketProcessorTest, GoodPacketFromNetworkInPlace) {
+  std::string packet(kReferenceNetworkPacket);
+  const uint8_t hops = packet[7];
+
+  EXPECT_CALL(stats_, OnPacketForwarded(Direction::FROM_NETWORK));
+  EXPECT_CALL(output_, SendPacketToClient(_))
+      .WillOnce(Invoke([&packet](quiche::QuicheStringPiece forwarded) {
+        // The packet is forwarded from the caller's buffer.
+        EXPECT_EQ(packet.data(), forwarded.data());
+        EXPECT_EQ(packet.size(), forwarded.size());
+      }));
+  processor_->ProcessPacket(&packet[0], packet.size(), Direction::FROM_NETWORK);
+  EXPECT_EQ(hops - 1, static_cast<uint8_t>(packet[7]));
+}
+
 TEST_F(QbonePacketProcessorTest, GoodPacketFromNetworkWrongDirection) {
   EXPECT_CALL(stats_, OnPacketDroppedWithIcmp(Direction::FROM_OFF_NETWORK));
   EXPECT_CALL(output_, SendPacketToClient(IsIcmpMessage(ICMP6_DST_UNREACH)));
@@ -283,5 +299,115 @@ TEST_F(QbonePacketProcessorTest, FilterHelperFunctions) {
   ASSERT_EQ(1, filter->called());
 }
 
+// Returns |result| for every packet, with a destination unreachable message if
+// |result| is ICMP. Its results can be reused for a flow.
+class FlowFilter : public QbonePacketProcessor::Filter {
+ public:
+  explicit FlowFilter(ProcessingResult result) : result_(result) {}
+
+  ProcessingResult FilterPacket(Direction direction,
+                                quiche::QuicheStringPiece full_packet,
+                                quiche::QuicheStringPiece payload,
+                                icmp6_hdr* icmp_header,
+                                OutputInterface* output) override {
+    called_++;
+    if (result_ == ProcessingResult::ICMP) {
+      icmp_header->icmp6_type = ICMP6_DST_UNREACH;
+      icmp_header->icmp6_code = ICMP6_DST_UNREACH_ADMIN;
+    }
+    return result_;
+  }
+
+  bool ResultDependsOnlyOnFlow() const override { return true; }
+
+  int called() const { return called_; }
+
+ private:
+  const ProcessingResult result_;
+  int called_ = 0;
+};
+
+TEST_F(QbonePacketProcessorTest, FlowCacheReusesFilterResult) {
+  auto filter_owned = std::make_unique<FlowFilter>(ProcessingResult::ICMP);
+  FlowFilter* filter = filter_owned.get();
+  processor_->set_filter(std::move(filter_owned));
+
+  EXPECT_CALL(stats_, OnPacketDroppedWithIcmp(Direction::FROM_OFF_NETWORK))
+      .Times(3);
+  EXPECT_CALL(output_, SendPacketToClient(IsIcmpMessage(ICMP6_DST_UNREACH)))
+      .Times(3);
+  for (int i = 0; i < 3; ++i) {
+    SendPacketFromClient(kReferenceClientPacket);
+  }
+  EXPECT_EQ(1, filter->called());
+
+  // The same addresses and ports in the other direction are another flow.
+  EXPECT_CALL(stats_, OnPacketDroppedWithIcmp(Direction::FROM_NETWORK));
+  EXPECT_CALL(output_, SendPacketToNetwork(IsIcmpMessage(ICMP6_DST_UNREACH)));
+  SendPacketFromNetwork(kReferenceNetworkPacket);
+  EXPECT_EQ(2, filter->called());
+}
+
+TEST_F(QbonePacketProcessorTest, FlowCacheDistinguishesFlows) {
+  auto filter_owned = std::make_unique<FlowFilter>(ProcessingResult::OK);
+  FlowFilter* filter = filter_owned.get();
+  processor_->set_filter(std::move(filter_owned));
+
+  EXPECT_CALL(stats_, OnPacketForwarded(Direction::FROM_OFF_NETWORK))
+      .Times(4);
+  EXPECT_CALL(output_, SendPacketToNetwork(_)).Times(4);
+  SendPacketFromClient(kReferenceClientPacket);
+  SendPacketFromClient(kReferenceClientSubnetPacket);
+  EXPECT_EQ(2, filter->called());
+
+  std::string packet(kReferenceClientPacket);
+  // Change the source port.
+  packet[41]++;
+  SendPacketFromClient(packet);
+  EXPECT_EQ(3, filter->called());
+
+  // Packets which are not TCP or UDP are always filtered.
+  packet = std::string(kReferenceClientPacket);
+  packet[6] = IPPROTO_ICMPV6;
+  SendPacketFromClient(packet);
+  EXPECT_EQ(4, filter->called());
+}
+
+TEST_F(QbonePacketProcessorTest, FlowCacheIsCleared) {
+  auto filter_owned = std::make_unique<FlowFilter>(ProcessingResult::OK);
+  FlowFilter* filter = filter_owned.get();
+  processor_->set_filter(std::move(filter_owned));
+
+  EXPECT_CALL(stats_, OnPacketForwarded(Direction::FROM_OFF_NETWORK))
+      .Times(3);
+  EXPECT_CALL(output_, SendPacketToNetwork(_)).Times(3);
+  SendPacketFromClient(kReferenceClientPacket);
+  SendPacketFromClient(kReferenceClientPacket);
+  EXPECT_EQ(1, filter->called());
+  processor_->ClearFlowCache();
+  SendPacketFromClient(kReferenceClientPacket);
+  EXPECT_EQ(2, filter->called());
+
+  // Results of a former filter are not reused.
+  auto other_filter_owned =
+      std::make_unique<FlowFilter>(ProcessingResult::SILENT_DROP);
+  FlowFilter* other_filter = other_filter_owned.get();
+  processor_->set_filter(std::move(other_filter_owned));
+  EXPECT_CALL(stats_, OnPacketDroppedSilently(Direction::FROM_OFF_NETWORK));
+  SendPacketFromClient(kReferenceClientPacket);
+  EXPECT_EQ(1, other_filter->called());
+}
+
+TEST_F(QbonePacketProcessorTest, FlowCacheDoesNotReuseDefer) {
+  auto filter_owned = std::make_unique<FlowFilter>(ProcessingResult::DEFER);
+  FlowFilter* filter = filter_owned.get();
+  processor_->set_filter(std::move(filter_owned));
+
+  EXPECT_CALL(stats_, OnPacketDeferred(Direction::FROM_OFF_NETWORK)).Times(2);
+  SendPacketFromClient(kReferenceClientPacket);
+  SendPacketFromClient(kReferenceClientPacket);
+  EXPECT_EQ(2, filter->called());
+}
+
 }  // namespace
 }  // namespace quic
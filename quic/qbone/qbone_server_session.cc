@@ -74,15 +74,15 @@ bool QboneServerSession::SendClientRequest(const QboneClientRequest& request) {
 
 void QboneServerSession::ProcessPacketFromNetwork(
     quiche::QuicheStringPiece packet) {
-  std::string buffer = std::string(packet);
-  processor_.ProcessPacket(&buffer,
+  packet_buffer_.assign(packet.data(), packet.size());
+  processor_.ProcessPacket(&packet_buffer_,
                            QbonePacketProcessor::Direction::FROM_NETWORK);
 }
 
 void QboneServerSession::ProcessPacketFromPeer(
     quiche::QuicheStringPiece packet) {
-  std::string buffer = std::string(packet);
-  processor_.ProcessPacket(&buffer,
+  packet_buffer_.assign(packet.data(), packet.size());
+  processor_.ProcessPacket(&packet_buffer_,
                            QbonePacketProcessor::Direction::FROM_OFF_NETWORK);
 }
 
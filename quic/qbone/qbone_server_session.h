@@ -5,6 +5,8 @@
 #ifndef QUICHE_QUIC_QBONE_QBONE_SERVER_SESSION_H_
 #define QUICHE_QUIC_QBONE_QBONE_SERVER_SESSION_H_
 
+#include <string>
+
 #include "net/third_party/quiche/src/quic/core/quic_crypto_server_stream_base.h"
 #include "net/third_party/quiche/src/quic/core/quic_crypto_stream.h"
 #include "net/third_party/quiche/src/quic/platform/api/quic_export.h"
@@ -87,6 +89,9 @@ class QUIC_EXPORT_PRIVATE QboneServerSession
   QboneServerControlStream::Handler* handler_;
   // The unowned control stream.
   QboneServerControlStream* control_stream_;
+  // Packets are copied here to be processed, so that the memory is reused
+  // from one packet to the next.
+  std::string packet_buffer_;
 };
 
 }  // namespace quic
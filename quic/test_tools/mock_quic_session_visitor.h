@@ -38,6 +38,10 @@ class MockQuicSessionVisitor : public QuicTimeWaitListManager::Visitor {
               OnConnectionAddedToTimeWaitList,
               (QuicConnectionId connection_id),
               (override));
+  MOCK_METHOD(void,
+              OnConnectionRemovedFromTimeWaitList,
+              (QuicConnectionId connection_id),
+              (override));
 };
 
 class MockQuicCryptoServerStreamHelper
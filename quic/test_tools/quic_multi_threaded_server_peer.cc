@@ -0,0 +1,26 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/third_party/quiche/src/quic/test_tools/quic_multi_threaded_server_peer.h"
+
+#include "net/third_party/quiche/src/quic/tools/quic_multi_threaded_server.h"
+
+namespace quic {
+namespace test {
+
+// static
+void QuicMultiThreadedServerPeer::ReceivePacketOnWorker(
+    QuicMultiThreadedServer* server,
+    size_t worker_index,
+    const QuicSocketAddress& self_address,
+    const QuicSocketAddress& peer_address,
+    const QuicReceivedPacket& packet) {
+  // Packets forwarded to a worker go through its dispatcher exactly like the
+  // packets it reads, so this is what a packet steered to the wrong socket
+  // looks like to the worker.
+  server->ForwardPacket(worker_index, self_address, peer_address, packet);
+}
+
+}  // namespace test
+}  // namespace quic
@@ -0,0 +1,34 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef QUICHE_QUIC_TEST_TOOLS_QUIC_MULTI_THREADED_SERVER_PEER_H_
+#define QUICHE_QUIC_TEST_TOOLS_QUIC_MULTI_THREADED_SERVER_PEER_H_
+
+#include <cstddef>
+
+namespace quic {
+
+class QuicMultiThreadedServer;
+class QuicReceivedPacket;
+class QuicSocketAddress;
+
+namespace test {
+
+class QuicMultiThreadedServerPeer {
+ public:
+  QuicMultiThreadedServerPeer() = delete;
+
+  // Makes worker |worker_index| process |packet| as if it had been read from
+  // its own socket, whichever worker owns the connection. Thread safe.
+  static void ReceivePacketOnWorker(QuicMultiThreadedServer* server,
+                                    size_t worker_index,
+                                    const QuicSocketAddress& self_address,
+                                    const QuicSocketAddress& peer_address,
+                                    const QuicReceivedPacket& packet);
+};
+
+}  // namespace test
+}  // namespace quic
+
+#endif  // QUICHE_QUIC_TEST_TOOLS_QUIC_MULTI_THREADED_SERVER_PEER_H_
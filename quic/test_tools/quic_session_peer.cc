@@ -191,6 +191,11 @@ QuicAlarm* QuicSessionPeer::GetCleanUpClosedStreamsAlarm(QuicSession* session) {
   return session->closed_streams_clean_up_alarm_.get();
 }
 
+// static
+QuicAlarm* QuicSessionPeer::GetResetStreamsAlarm(QuicSession* session) {
+  return session->reset_streams_alarm_.get();
+}
+
 // static
 LegacyQuicStreamIdManager* QuicSessionPeer::GetStreamIdManager(
     QuicSession* session) {
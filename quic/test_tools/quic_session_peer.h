@@ -71,6 +71,7 @@ class QuicSessionPeer {
   static QuicStream* GetStream(QuicSession* session, QuicStreamId id);
   static bool IsStreamWriteBlocked(QuicSession* session, QuicStreamId id);
   static QuicAlarm* GetCleanUpClosedStreamsAlarm(QuicSession* session);
+  static QuicAlarm* GetResetStreamsAlarm(QuicSession* session);
   static LegacyQuicStreamIdManager* GetStreamIdManager(QuicSession* session);
   static UberQuicStreamIdManager* v99_streamid_manager(QuicSession* session);
   static QuicStreamIdManager* v99_bidirectional_stream_id_manager(
@@ -38,7 +38,7 @@ QuicByteCount QuicStreamSendBufferPeer::TotalLength(
   QuicByteCount length = 0;
   for (auto slice = send_buffer->interval_deque_.DataBegin();
        slice != send_buffer->interval_deque_.DataEnd(); ++slice) {
-    length += slice->slice.length();
+    length += slice->length();
   }
   return length;
 }
@@ -0,0 +1,412 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/third_party/quiche/src/quic/test_tools/send_algorithm_benchmark.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <memory>
+#include <utility>
+
+#include "net/third_party/quiche/src/quic/core/quic_connection_stats.h"
+#include "net/third_party/quiche/src/quic/core/quic_constants.h"
+#include "net/third_party/quiche/src/quic/core/quic_latency_histogram.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_logging.h"
+#include "net/third_party/quiche/src/quic/test_tools/quic_connection_peer.h"
+#include "net/third_party/quiche/src/quic/test_tools/quic_test_utils.h"
+#include "net/third_party/quiche/src/quic/test_tools/simulator/link.h"
+#include "net/third_party/quiche/src/quic/test_tools/simulator/packet_filter.h"
+#include "net/third_party/quiche/src/quic/test_tools/simulator/quic_endpoint.h"
+#include "net/third_party/quiche/src/quic/test_tools/simulator/simulator.h"
+#include "net/third_party/quiche/src/quic/test_tools/simulator/switch.h"
+#include "net/third_party/quiche/src/quic/test_tools/simulator/traffic_policer.h"
+#include "net/third_party/quiche/src/common/platform/api/quiche_str_cat.h"
+
+namespace quic {
+namespace test {
+
+namespace {
+
+// The local links are much faster than the bottleneck, so that packets never
+// queue on their way to it.
+const QuicTime::Delta kLocalLinkDelay = QuicTime::Delta::FromMilliseconds(2);
+const float kLocalLinkSpeedup = 10;
+
+// Differences smaller than these are noise, whatever the tolerance.
+const int64_t kQueueingDelaySlackMicros = 1000;
+const double kLinkUtilizationSlack = 0.01;
+const double kLossRateSlack = 0.001;
+const double kFairnessSlack = 0.01;
+
+struct CongestionControlNameEntry {
+  const char* name;
+  CongestionControlType congestion_control;
+};
+
+const CongestionControlNameEntry kCongestionControlNames[] = {
+    {"cubic", kCubicBytes},
+    {"reno", kRenoBytes},
+    {"bbr", kBBR},
+    {"bbr2", kBBRv2},
+};
+
+// Sits on the output of the bottleneck queue. Records how long each packet
+// waited in the queue, and drops a fraction of the packets at random.
+class BottleneckTap : public simulator::PacketFilter {
+ public:
+  BottleneckTap(simulator::Simulator* simulator,
+                std::string name,
+                simulator::Endpoint* input,
+                QuicBandwidth local_bandwidth,
+                double loss_probability)
+      : simulator::PacketFilter(simulator, name, input),
+        local_bandwidth_(local_bandwidth),
+        loss_probability_(loss_probability) {}
+  BottleneckTap(const BottleneckTap&) = delete;
+  BottleneckTap& operator=(const BottleneckTap&) = delete;
+
+  const QuicLatencyHistogram& queueing_delay() const {
+    return queueing_delay_;
+  }
+
+ protected:
+  bool FilterPacket(const simulator::Packet& packet) override {
+    // Apart from queueing, a packet has only been delayed by the constant
+    // propagation delay of its local link and by its transfer time on it. So
+    // its queueing delay is its delay beyond that transfer time, less the
+    // smallest such delay of any packet of the same flow.
+    const QuicTime::Delta delay = clock_->Now() - packet.tx_timestamp -
+                                  local_bandwidth_.TransferTime(packet.size);
+    auto it = min_delays_.find(packet.source);
+    if (it == min_delays_.end()) {
+      it = min_delays_.emplace(packet.source, delay).first;
+    } else {
+      it->second = std::min(it->second, delay);
+    }
+    queueing_delay_.Add(delay - it->second);
+
+    if (loss_probability_ <= 0) {
+      return true;
+    }
+    const double u =
+        std::ldexp(simulator_->GetRandomGenerator()->RandUint64() >> 11, -53);
+    return u >= loss_probability_;
+  }
+
+ private:
+  const QuicBandwidth local_bandwidth_;
+  const double loss_probability_;
+  std::map<std::string, QuicTime::Delta> min_delays_;
+  QuicLatencyHistogram queueing_delay_;
+};
+
+double JainFairnessIndex(const std::vector<double>& values) {
+  double sum = 0;
+  double sum_of_squares = 0;
+  for (double value : values) {
+    sum += value;
+    sum_of_squares += value * value;
+  }
+  if (sum_of_squares == 0) {
+    return 0;
+  }
+  return sum * sum / (values.size() * sum_of_squares);
+}
+
+// Appends a regression to |regressions| if |current| is lower than |baseline|
+// by more than |tolerance| of |baseline| plus |slack|.
+void CheckNotLower(const SendAlgorithmBenchmarkResult& baseline_result,
+                   const char* metric,
+                   double baseline,
+                   double current,
+                   double tolerance,
+                   double slack,
+                   std::vector<std::string>* regressions) {
+  if (current >= baseline - baseline * tolerance - slack) {
+    return;
+  }
+  regressions->push_back(quiche::QuicheStrCat(
+      baseline_result.scenario(), "/", baseline_result.congestion_control(),
+      ": ", metric, " fell from ", baseline, " to ", current));
+}
+
+// Appends a regression to |regressions| if |current| is higher than
+// |baseline| by more than |tolerance| of |baseline| plus |slack|.
+void CheckNotHigher(const SendAlgorithmBenchmarkResult& baseline_result,
+                    const char* metric,
+                    double baseline,
+                    double current,
+                    double tolerance,
+                    double slack,
+                    std::vector<std::string>* regressions) {
+  if (current <= baseline + baseline * tolerance + slack) {
+    return;
+  }
+  regressions->push_back(quiche::QuicheStrCat(
+      baseline_result.scenario(), "/", baseline_result.congestion_control(),
+      ": ", metric, " rose from ", baseline, " to ", current));
+}
+
+}  // namespace
+
+QuicTime::Delta SendAlgorithmBenchmarkScenario::MinRtt() const {
+  return 2 * (kLocalLinkDelay + bottleneck_delay);
+}
+
+QuicBandwidth SendAlgorithmBenchmarkScenario::AvailableBandwidth() const {
+  if (policer_bandwidth.IsZero()) {
+    return bottleneck_bandwidth;
+  }
+  return std::min(bottleneck_bandwidth, policer_bandwidth);
+}
+
+std::vector<SendAlgorithmBenchmarkScenario> DefaultSendAlgorithmBenchmarks() {
+  std::vector<SendAlgorithmBenchmarkScenario> scenarios;
+
+  SendAlgorithmBenchmarkScenario bufferbloat;
+  bufferbloat.name = "bufferbloat";
+  bufferbloat.queue_size_in_bdp = 10;
+  scenarios.push_back(bufferbloat);
+
+  SendAlgorithmBenchmarkScenario shallow_buffer;
+  shallow_buffer.name = "shallow_buffer";
+  shallow_buffer.bottleneck_bandwidth =
+      QuicBandwidth::FromKBitsPerSecond(50000);
+  shallow_buffer.queue_size_in_bdp = 0.2;
+  scenarios.push_back(shallow_buffer);
+
+  SendAlgorithmBenchmarkScenario policer;
+  policer.name = "policer";
+  policer.bottleneck_bandwidth = QuicBandwidth::FromKBitsPerSecond(50000);
+  policer.policer_bandwidth = QuicBandwidth::FromKBitsPerSecond(10000);
+  policer.policer_burst = 128 * 1024;
+  scenarios.push_back(policer);
+
+  SendAlgorithmBenchmarkScenario random_loss;
+  random_loss.name = "random_loss";
+  random_loss.bottleneck_bandwidth = QuicBandwidth::FromKBitsPerSecond(20000);
+  random_loss.random_loss_probability = 0.01;
+  scenarios.push_back(random_loss);
+
+  SendAlgorithmBenchmarkScenario rtt_change;
+  rtt_change.name = "rtt_change";
+  rtt_change.bottleneck_delay = QuicTime::Delta::FromMilliseconds(10);
+  rtt_change.delay_change_time = QuicTime::Delta::FromSeconds(10);
+  rtt_change.new_bottleneck_delay = QuicTime::Delta::FromMilliseconds(50);
+  scenarios.push_back(rtt_change);
+
+  SendAlgorithmBenchmarkScenario competing_flows;
+  competing_flows.name = "competing_flows";
+  competing_flows.num_flows = 4;
+  competing_flows.flow_start_interval = QuicTime::Delta::FromSeconds(2);
+  competing_flows.duration = QuicTime::Delta::FromSeconds(30);
+  competing_flows.bottleneck_bandwidth =
+      QuicBandwidth::FromKBitsPerSecond(40000);
+  scenarios.push_back(competing_flows);
+
+  return scenarios;
+}
+
+bool ParseCongestionControlName(quiche::QuicheStringPiece name,
+                                CongestionControlType* congestion_control) {
+  for (const CongestionControlNameEntry& entry : kCongestionControlNames) {
+    if (name == entry.name) {
+      *congestion_control = entry.congestion_control;
+      return true;
+    }
+  }
+  return false;
+}
+
+std::string CongestionControlName(CongestionControlType congestion_control) {
+  for (const CongestionControlNameEntry& entry : kCongestionControlNames) {
+    if (congestion_control == entry.congestion_control) {
+      return entry.name;
+    }
+  }
+  return quiche::QuicheStrCat("congestion_control_",
+                              static_cast<int>(congestion_control));
+}
+
+SendAlgorithmBenchmarkResult RunSendAlgorithmBenchmark(
+    const SendAlgorithmBenchmarkScenario& scenario,
+    CongestionControlType congestion_control,
+    uint64_t random_seed) {
+  DCHECK_LT(0u, scenario.num_flows);
+  SimpleRandom random;
+  random.set_seed(random_seed);
+  simulator::Simulator simulator(&random);
+
+  std::vector<std::unique_ptr<simulator::QuicEndpoint>> senders;
+  std::vector<std::unique_ptr<simulator::QuicEndpoint>> receivers;
+  std::vector<simulator::QuicEndpointBase*> receiver_pointers;
+  for (size_t i = 0; i < scenario.num_flows; ++i) {
+    const std::string sender_name = quiche::QuicheStrCat("Sender", i + 1);
+    const std::string receiver_name = quiche::QuicheStrCat("Receiver", i + 1);
+    senders.push_back(std::make_unique<simulator::QuicEndpoint>(
+        &simulator, sender_name, receiver_name, Perspective::IS_CLIENT,
+        TestConnectionId(42 + i)));
+    receivers.push_back(std::make_unique<simulator::QuicEndpoint>(
+        &simulator, receiver_name, sender_name, Perspective::IS_SERVER,
+        TestConnectionId(42 + i)));
+    receiver_pointers.push_back(receivers.back().get());
+    QuicConnectionPeer::GetSentPacketManager(senders.back()->connection())
+        ->SetSendAlgorithm(congestion_control);
+  }
+  simulator::QuicEndpointMultiplexer receiver_multiplexer(
+      "Receiver multiplexer", receiver_pointers);
+
+  const QuicByteCount bdp =
+      scenario.bottleneck_bandwidth.ToBytesPerPeriod(scenario.MinRtt());
+  const QuicByteCount queue_capacity =
+      std::max(static_cast<QuicByteCount>(scenario.queue_size_in_bdp * bdp),
+               2 * kMaxOutgoingPacketSize);
+  simulator::Switch network_switch(&simulator, "Switch",
+                                   scenario.num_flows + 1, queue_capacity);
+
+  const QuicBandwidth local_bandwidth =
+      scenario.bottleneck_bandwidth * kLocalLinkSpeedup;
+  std::vector<std::unique_ptr<simulator::SymmetricLink>> local_links;
+  for (size_t i = 0; i < scenario.num_flows; ++i) {
+    local_links.push_back(std::make_unique<simulator::SymmetricLink>(
+        senders[i].get(), network_switch.port(i + 2), local_bandwidth,
+        kLocalLinkDelay));
+  }
+
+  simulator::Endpoint* bottleneck_output = network_switch.port(1);
+  std::unique_ptr<simulator::TrafficPolicer> policer;
+  if (!scenario.policer_bandwidth.IsZero()) {
+    policer = std::make_unique<simulator::TrafficPolicer>(
+        &simulator, "Policer", scenario.policer_burst, scenario.policer_burst,
+        scenario.policer_bandwidth, bottleneck_output);
+    bottleneck_output = policer.get();
+  }
+  BottleneckTap tap(&simulator, "Bottleneck tap", bottleneck_output,
+                    local_bandwidth, scenario.random_loss_probability);
+  simulator::SymmetricLink bottleneck_link(&receiver_multiplexer, &tap,
+                                           scenario.bottleneck_bandwidth,
+                                           scenario.bottleneck_delay);
+
+  // Each flow has more data than it could possibly deliver.
+  const QuicByteCount bytes_per_flow =
+      2 * scenario.bottleneck_bandwidth.ToBytesPerPeriod(scenario.duration);
+  const QuicTime start_time = simulator.GetClock()->Now();
+  std::vector<QuicTime> flow_start_times;
+  bool delay_changed = scenario.delay_change_time.IsZero();
+  while (true) {
+    const size_t next_flow = flow_start_times.size();
+    const QuicTime::Delta next_flow_start =
+        next_flow < scenario.num_flows
+            ? scenario.flow_start_interval * static_cast<int>(next_flow)
+            : QuicTime::Delta::Infinite();
+    const QuicTime::Delta next_delay_change =
+        delay_changed ? QuicTime::Delta::Infinite()
+                      : scenario.delay_change_time;
+    const QuicTime::Delta next_event =
+        std::min(next_flow_start, next_delay_change);
+    if (next_event >= scenario.duration) {
+      break;
+    }
+    const QuicTime next_event_time = start_time + next_event;
+    if (next_event_time > simulator.GetClock()->Now()) {
+      simulator.RunFor(next_event_time - simulator.GetClock()->Now());
+    }
+    if (next_event == next_flow_start) {
+      senders[next_flow]->AddBytesToTransfer(bytes_per_flow);
+      flow_start_times.push_back(simulator.GetClock()->Now());
+    } else {
+      bottleneck_link.set_propagation_delay(scenario.new_bottleneck_delay);
+      delay_changed = true;
+    }
+  }
+  simulator.RunFor(start_time + scenario.duration -
+                   simulator.GetClock()->Now());
+  const QuicTime end_time = simulator.GetClock()->Now();
+
+  SendAlgorithmBenchmarkResult result;
+  result.set_scenario(scenario.name);
+  result.set_congestion_control(CongestionControlName(congestion_control));
+  result.set_random_seed(random_seed);
+  result.set_simulated_duration_micros(
+      (end_time - start_time).ToMicroseconds());
+
+  QuicByteCount bytes_received = 0;
+  QuicPacketCount packets_sent = 0;
+  QuicPacketCount packets_lost = 0;
+  std::vector<double> flow_goodputs;
+  for (size_t i = 0; i < flow_start_times.size(); ++i) {
+    QuicConnection* connection = senders[i]->connection();
+    const QuicConnectionStats& stats = connection->GetStats();
+    const RttStats* rtt_stats = connection->sent_packet_manager().GetRttStats();
+    const QuicBandwidth goodput = QuicBandwidth::FromBytesAndTimeDelta(
+        receivers[i]->bytes_received(), end_time - flow_start_times[i]);
+
+    SendAlgorithmBenchmarkFlowResult* flow = result.add_flows();
+    flow->set_goodput_bits_per_second(goodput.ToBitsPerSecond());
+    flow->set_packets_sent(stats.packets_sent);
+    flow->set_packets_lost(stats.packets_lost);
+    flow->set_min_rtt_micros(rtt_stats->min_rtt().ToMicroseconds());
+    flow->set_smoothed_rtt_micros(rtt_stats->smoothed_rtt().ToMicroseconds());
+
+    bytes_received += receivers[i]->bytes_received();
+    packets_sent += stats.packets_sent;
+    packets_lost += stats.packets_lost;
+    flow_goodputs.push_back(goodput.ToBitsPerSecond());
+  }
+
+  const QuicBandwidth goodput = QuicBandwidth::FromBytesAndTimeDelta(
+      bytes_received, end_time - start_time);
+  result.set_goodput_bits_per_second(goodput.ToBitsPerSecond());
+  result.set_link_utilization(
+      static_cast<double>(goodput.ToBitsPerSecond()) /
+      scenario.AvailableBandwidth().ToBitsPerSecond());
+  result.set_queueing_delay_p50_micros(
+      tap.queueing_delay().Percentile(50).ToMicroseconds());
+  result.set_queueing_delay_p99_micros(
+      tap.queueing_delay().Percentile(99).ToMicroseconds());
+  result.set_loss_rate(packets_sent == 0 ? 0
+                                         : static_cast<double>(packets_lost) /
+                                               packets_sent);
+  result.set_jain_fairness_index(JainFairnessIndex(flow_goodputs));
+
+  QUIC_LOG(INFO) << "Finished " << scenario.name << " with "
+                 << result.congestion_control() << ": goodput "
+                 << goodput.ToDebuggingValue() << ", queueing delay "
+                 << tap.queueing_delay().ToString();
+  return result;
+}
+
+bool CompareSendAlgorithmBenchmarkResult(
+    const SendAlgorithmBenchmarkResult& baseline,
+    const SendAlgorithmBenchmarkResult& current,
+    double tolerance,
+    std::vector<std::string>* regressions) {
+  DCHECK_EQ(baseline.scenario(), current.scenario());
+  DCHECK_EQ(baseline.congestion_control(), current.congestion_control());
+  const size_t num_regressions = regressions->size();
+  CheckNotLower(baseline, "goodput_bits_per_second",
+                baseline.goodput_bits_per_second(),
+                current.goodput_bits_per_second(), tolerance, 0, regressions);
+  CheckNotLower(baseline, "link_utilization", baseline.link_utilization(),
+                current.link_utilization(), tolerance, kLinkUtilizationSlack,
+                regressions);
+  CheckNotLower(baseline, "jain_fairness_index",
+                baseline.jain_fairness_index(), current.jain_fairness_index(),
+                tolerance, kFairnessSlack, regressions);
+  CheckNotHigher(baseline, "queueing_delay_p50_micros",
+                 baseline.queueing_delay_p50_micros(),
+                 current.queueing_delay_p50_micros(), tolerance,
+                 kQueueingDelaySlackMicros, regressions);
+  CheckNotHigher(baseline, "queueing_delay_p99_micros",
+                 baseline.queueing_delay_p99_micros(),
+                 current.queueing_delay_p99_micros(), tolerance,
+                 kQueueingDelaySlackMicros, regressions);
+  CheckNotHigher(baseline, "loss_rate", baseline.loss_rate(),
+                 current.loss_rate(), tolerance, kLossRateSlack, regressions);
+  return regressions->size() == num_regressions;
+}
+
+}  // namespace test
+}  // namespace quic
@@ -0,0 +1,97 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Benchmarks congestion control algorithms in simulated networks.
+//
+// In every scenario, each flow is sent by its own QuicEndpoint over a fast
+// local link into a switch. The switch port towards the receivers is the
+// bottleneck: its queue drains at the bottleneck bandwidth, optionally through
+// a traffic policer, and a tap on its output records how long packets waited
+// in the queue and drops packets at random. The receivers share the far end of
+// the bottleneck link.
+
+#ifndef QUICHE_QUIC_TEST_TOOLS_SEND_ALGORITHM_BENCHMARK_H_
+#define QUICHE_QUIC_TEST_TOOLS_SEND_ALGORITHM_BENCHMARK_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "net/third_party/quiche/src/quic/core/quic_bandwidth.h"
+#include "net/third_party/quiche/src/quic/core/quic_time.h"
+#include "net/third_party/quiche/src/quic/core/quic_types.h"
+#include "net/third_party/quiche/src/quic/test_tools/send_algorithm_test_result.pb.h"
+#include "net/third_party/quiche/src/common/platform/api/quiche_string_piece.h"
+
+namespace quic {
+namespace test {
+
+struct SendAlgorithmBenchmarkScenario {
+  std::string name;
+
+  // Number of flows, and the time between the starts of consecutive flows.
+  size_t num_flows = 1;
+  QuicTime::Delta flow_start_interval = QuicTime::Delta::Zero();
+  // Time from the start of the first flow to the end of the benchmark.
+  QuicTime::Delta duration = QuicTime::Delta::FromSeconds(20);
+
+  QuicBandwidth bottleneck_bandwidth = QuicBandwidth::FromKBitsPerSecond(10000);
+  // One-way propagation delay of the bottleneck link.
+  QuicTime::Delta bottleneck_delay = QuicTime::Delta::FromMilliseconds(20);
+  // Capacity of the bottleneck queue, as a multiple of the bandwidth-delay
+  // product of the path.
+  double queue_size_in_bdp = 1.0;
+
+  // If not zero, packets leaving the bottleneck queue beyond this rate, after
+  // a burst of |policer_burst| bytes, are dropped.
+  QuicBandwidth policer_bandwidth = QuicBandwidth::Zero();
+  QuicByteCount policer_burst = 0;
+
+  // Probability that a packet leaving the bottleneck queue is dropped.
+  double random_loss_probability = 0.0;
+
+  // If not zero, the bottleneck delay changes to |new_bottleneck_delay| this
+  // long after the start of the first flow.
+  QuicTime::Delta delay_change_time = QuicTime::Delta::Zero();
+  QuicTime::Delta new_bottleneck_delay = QuicTime::Delta::Zero();
+
+  // Round trip time of the path before any delay change, without queueing.
+  QuicTime::Delta MinRtt() const;
+  // The rate at which data can leave the bottleneck.
+  QuicBandwidth AvailableBandwidth() const;
+};
+
+// Returns the scenarios run by default: a single flow into a deep buffer, a
+// shallow buffer, a policer and a lossy link, a single flow whose round trip
+// time grows, and several flows competing for one bottleneck.
+std::vector<SendAlgorithmBenchmarkScenario> DefaultSendAlgorithmBenchmarks();
+
+// Converts between congestion control types and the names used in results.
+// Returns false if |name| is not known.
+bool ParseCongestionControlName(quiche::QuicheStringPiece name,
+                                CongestionControlType* congestion_control);
+std::string CongestionControlName(CongestionControlType congestion_control);
+
+// Runs |scenario| with every flow using |congestion_control|. The run is
+// deterministic for a given |random_seed|.
+SendAlgorithmBenchmarkResult RunSendAlgorithmBenchmark(
+    const SendAlgorithmBenchmarkScenario& scenario,
+    CongestionControlType congestion_control,
+    uint64_t random_seed);
+
+// Compares |current| to |baseline|, which must be for the same scenario and
+// congestion control, and appends a description of each metric which got
+// worse by more than the fraction |tolerance| to |regressions|. Returns true
+// if there were none.
+bool CompareSendAlgorithmBenchmarkResult(
+    const SendAlgorithmBenchmarkResult& baseline,
+    const SendAlgorithmBenchmarkResult& current,
+    double tolerance,
+    std::vector<std::string>* regressions);
+
+}  // namespace test
+}  // namespace quic
+
+#endif  // QUICHE_QUIC_TEST_TOOLS_SEND_ALGORITHM_BENCHMARK_H_
@@ -0,0 +1,136 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/third_party/quiche/src/quic/test_tools/send_algorithm_benchmark.h"
+
+#include <string>
+#include <vector>
+
+#include "net/third_party/quiche/src/quic/platform/api/quic_test.h"
+
+namespace quic {
+namespace test {
+namespace {
+
+SendAlgorithmBenchmarkScenario ShortScenario() {
+  SendAlgorithmBenchmarkScenario scenario;
+  scenario.name = "short";
+  scenario.duration = QuicTime::Delta::FromSeconds(5);
+  return scenario;
+}
+
+TEST(SendAlgorithmBenchmarkTest, CongestionControlNames) {
+  for (CongestionControlType congestion_control :
+       {kCubicBytes, kRenoBytes, kBBR, kBBRv2}) {
+    CongestionControlType parsed;
+    ASSERT_TRUE(ParseCongestionControlName(
+        CongestionControlName(congestion_control), &parsed));
+    EXPECT_EQ(congestion_control, parsed);
+  }
+  CongestionControlType parsed;
+  EXPECT_FALSE(ParseCongestionControlName("vegas", &parsed));
+}
+
+TEST(SendAlgorithmBenchmarkTest, SingleFlowFillsBottleneck) {
+  const SendAlgorithmBenchmarkScenario scenario = ShortScenario();
+  const SendAlgorithmBenchmarkResult result =
+      RunSendAlgorithmBenchmark(scenario, kBBRv2, 1);
+  EXPECT_EQ("short", result.scenario());
+  EXPECT_EQ("bbr2", result.congestion_control());
+  EXPECT_EQ(1u, result.random_seed());
+  EXPECT_EQ(scenario.duration.ToMicroseconds(),
+            result.simulated_duration_micros());
+  EXPECT_LT(0.8, result.link_utilization());
+  EXPECT_GE(1.0, result.link_utilization());
+  EXPECT_DOUBLE_EQ(1.0, result.jain_fairness_index());
+  ASSERT_EQ(1, result.flows_size());
+  EXPECT_EQ(result.goodput_bits_per_second(),
+            result.flows(0).goodput_bits_per_second());
+  EXPECT_LE(scenario.MinRtt().ToMicroseconds(),
+            result.flows(0).min_rtt_micros());
+}
+
+TEST(SendAlgorithmBenchmarkTest, DeepBufferFillsWithCubic) {
+  SendAlgorithmBenchmarkScenario scenario = ShortScenario();
+  scenario.duration = QuicTime::Delta::FromSeconds(20);
+  scenario.queue_size_in_bdp = 4;
+  const SendAlgorithmBenchmarkResult result =
+      RunSendAlgorithmBenchmark(scenario, kCubicBytes, 1);
+  // Cubic keeps growing its window until the queue overflows.
+  EXPECT_LT(scenario.MinRtt().ToMicroseconds(),
+            result.queueing_delay_p99_micros());
+}
+
+TEST(SendAlgorithmBenchmarkTest, RandomLossIsDetected) {
+  SendAlgorithmBenchmarkScenario scenario = ShortScenario();
+  scenario.random_loss_probability = 0.05;
+  const SendAlgorithmBenchmarkResult result =
+      RunSendAlgorithmBenchmark(scenario, kBBRv2, 1);
+  EXPECT_LT(0.04, result.loss_rate());
+}
+
+TEST(SendAlgorithmBenchmarkTest, LaterFlowsStartLater) {
+  SendAlgorithmBenchmarkScenario scenario = ShortScenario();
+  scenario.num_flows = 3;
+  scenario.flow_start_interval = QuicTime::Delta::FromSeconds(3);
+  const SendAlgorithmBenchmarkResult result =
+      RunSendAlgorithmBenchmark(scenario, kBBRv2, 1);
+  // The third flow would start after the benchmark ends.
+  ASSERT_EQ(2, result.flows_size());
+  EXPECT_LT(0, result.flows(1).goodput_bits_per_second());
+  EXPECT_LT(0.5, result.jain_fairness_index());
+}
+
+TEST(SendAlgorithmBenchmarkTest, RunsAreDeterministic) {
+  SendAlgorithmBenchmarkScenario scenario = ShortScenario();
+  scenario.random_loss_probability = 0.01;
+  scenario.delay_change_time = QuicTime::Delta::FromSeconds(2);
+  scenario.new_bottleneck_delay = QuicTime::Delta::FromMilliseconds(40);
+  EXPECT_EQ(
+      RunSendAlgorithmBenchmark(scenario, kBBR, 7).SerializeAsString(),
+      RunSendAlgorithmBenchmark(scenario, kBBR, 7).SerializeAsString());
+}
+
+TEST(SendAlgorithmBenchmarkTest, CompareDetectsRegressions) {
+  SendAlgorithmBenchmarkResult baseline;
+  baseline.set_scenario("bufferbloat");
+  baseline.set_congestion_control("bbr2");
+  baseline.set_goodput_bits_per_second(10000000);
+  baseline.set_link_utilization(0.8);
+  baseline.set_queueing_delay_p50_micros(5000);
+  baseline.set_queueing_delay_p99_micros(20000);
+  baseline.set_loss_rate(0.01);
+  baseline.set_jain_fairness_index(1.0);
+
+  std::vector<std::string> regressions;
+  SendAlgorithmBenchmarkResult current = baseline;
+  current.set_goodput_bits_per_second(9600000);
+  current.set_queueing_delay_p99_micros(21000);
+  EXPECT_TRUE(CompareSendAlgorithmBenchmarkResult(baseline, current, 0.05,
+                                                  &regressions));
+  EXPECT_TRUE(regressions.empty());
+
+  current.set_goodput_bits_per_second(9000000);
+  current.set_queueing_delay_p99_micros(30000);
+  EXPECT_FALSE(CompareSendAlgorithmBenchmarkResult(baseline, current, 0.05,
+                                                   &regressions));
+  ASSERT_EQ(2u, regressions.size());
+  EXPECT_EQ(0u, regressions[0].find("bufferbloat/bbr2: goodput"));
+  EXPECT_EQ(0u, regressions[1].find("bufferbloat/bbr2: queueing_delay_p99"));
+
+  regressions.clear();
+  current = baseline;
+  current.set_link_utilization(0.78);
+  EXPECT_TRUE(CompareSendAlgorithmBenchmarkResult(baseline, current, 0.05,
+                                                  &regressions));
+  current.set_link_utilization(0.7);
+  EXPECT_FALSE(CompareSendAlgorithmBenchmarkResult(baseline, current, 0.05,
+                                                   &regressions));
+  ASSERT_EQ(1u, regressions.size());
+  EXPECT_EQ(0u, regressions[0].find("bufferbloat/bbr2: link_utilization"));
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace quic
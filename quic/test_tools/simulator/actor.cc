@@ -8,10 +8,13 @@
 namespace quic {
 namespace simulator {
 
+const size_t Actor::kNotScheduled;
+
 Actor::Actor(Simulator* simulator, std::string name)
     : simulator_(simulator),
       clock_(simulator->GetClock()),
-      name_(std::move(name)) {
+      name_(std::move(name)),
+      schedule_index_(kNotScheduled) {
   simulator_->AddActor(this);
 }
 
@@ -5,6 +5,8 @@
 #ifndef QUICHE_QUIC_TEST_TOOLS_SIMULATOR_ACTOR_H_
 #define QUICHE_QUIC_TEST_TOOLS_SIMULATOR_ACTOR_H_
 
+#include <cstddef>
+#include <limits>
 #include <string>
 
 #include "net/third_party/quiche/src/quic/core/quic_clock.h"
@@ -37,7 +39,7 @@ class Actor {
   // to schedule the next call manually.
   virtual void Act() = 0;
 
-  inline std::string name() const { return name_; }
+  inline const std::string& name() const { return name_; }
   inline Simulator* simulator() const { return simulator_; }
 
  protected:
@@ -52,12 +54,21 @@ class Actor {
   std::string name_;
 
  private:
+  friend class Simulator;
+
+  // The value of |schedule_index_| for an actor which is not scheduled.
+  static const size_t kNotScheduled = std::numeric_limits<size_t>::max();
+
   // Since the Actor object registers itself with a simulator using a pointer to
   // itself, do not allow it to be moved.
   Actor(Actor&&) = delete;
   Actor(const Actor&) = delete;
   Actor& operator=(const Actor&) = delete;
   Actor& operator=(Actor&&) = delete;
+
+  // Position of the actor in the schedule of |simulator_|, maintained by the
+  // simulator.
+  size_t schedule_index_;
 };
 
 }  // namespace simulator
@@ -38,6 +38,14 @@ class OneWayLink : public Actor, public ConstrainedPortInterface {
   inline void set_bandwidth(QuicBandwidth new_bandwidth) {
     bandwidth_ = new_bandwidth;
   }
+  inline QuicTime::Delta propagation_delay() const {
+    return propagation_delay_;
+  }
+  // Packets already on the link keep their delivery times. Packets accepted
+  // after a decrease are delivered no earlier than the ones before them.
+  inline void set_propagation_delay(QuicTime::Delta new_propagation_delay) {
+    propagation_delay_ = new_propagation_delay;
+  }
 
  protected:
   // Get the value of a random delay imposed on each packet.  By default, this
@@ -64,7 +72,7 @@ class OneWayLink : public Actor, public ConstrainedPortInterface {
   QuicCircularDeque<QueuedPacket> packets_in_transit_;
 
   QuicBandwidth bandwidth_;
-  const QuicTime::Delta propagation_delay_;
+  QuicTime::Delta propagation_delay_;
 
   QuicTime next_write_at_;
 };
@@ -91,6 +99,13 @@ class SymmetricLink {
     a_to_b_link_.set_bandwidth(new_bandwidth);
     b_to_a_link_.set_bandwidth(new_bandwidth);
   }
+  inline QuicTime::Delta propagation_delay() {
+    return a_to_b_link_.propagation_delay();
+  }
+  inline void set_propagation_delay(QuicTime::Delta new_propagation_delay) {
+    a_to_b_link_.set_propagation_delay(new_propagation_delay);
+    b_to_a_link_.set_propagation_delay(new_propagation_delay);
+  }
 
  private:
   OneWayLink a_to_b_link_;
@@ -0,0 +1,74 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/third_party/quiche/src/quic/test_tools/simulator/parallel_simulations.h"
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+
+#include "net/third_party/quiche/src/quic/platform/api/quic_mutex.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_thread.h"
+
+namespace quic {
+namespace simulator {
+
+namespace {
+
+// Hands out the simulations to the worker threads one at a time, so that a
+// thread which finishes a short simulation picks up the next one.
+class SimulationQueue {
+ public:
+  explicit SimulationQueue(std::vector<std::function<void()>> simulations)
+      : simulations_(std::move(simulations)), next_(0) {}
+
+  // Returns the next simulation to run, or nullptr once all have started.
+  std::function<void()>* Next() {
+    QuicWriterMutexLock lock(&mutex_);
+    if (next_ == simulations_.size()) {
+      return nullptr;
+    }
+    return &simulations_[next_++];
+  }
+
+ private:
+  QuicMutex mutex_;
+  std::vector<std::function<void()>> simulations_;
+  size_t next_ QUIC_GUARDED_BY(mutex_);
+};
+
+class SimulationThread : public QuicThread {
+ public:
+  explicit SimulationThread(SimulationQueue* queue)
+      : QuicThread("simulation_thread"), queue_(queue) {}
+
+  void Run() override {
+    for (std::function<void()>* simulation = queue_->Next();
+         simulation != nullptr; simulation = queue_->Next()) {
+      (*simulation)();
+    }
+  }
+
+ private:
+  SimulationQueue* queue_;  // Unowned.
+};
+
+}  // namespace
+
+void RunSimulationsInParallel(std::vector<std::function<void()>> simulations,
+                              size_t num_threads) {
+  num_threads = std::min(std::max<size_t>(num_threads, 1), simulations.size());
+  SimulationQueue queue(std::move(simulations));
+  std::vector<std::unique_ptr<SimulationThread>> threads;
+  for (size_t i = 0; i < num_threads; ++i) {
+    threads.push_back(std::make_unique<SimulationThread>(&queue));
+    threads.back()->Start();
+  }
+  for (std::unique_ptr<SimulationThread>& thread : threads) {
+    thread->Join();
+  }
+}
+
+}  // namespace simulator
+}  // namespace quic
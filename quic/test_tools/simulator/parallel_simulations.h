@@ -0,0 +1,27 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef QUICHE_QUIC_TEST_TOOLS_SIMULATOR_PARALLEL_SIMULATIONS_H_
+#define QUICHE_QUIC_TEST_TOOLS_SIMULATOR_PARALLEL_SIMULATIONS_H_
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+namespace quic {
+namespace simulator {
+
+// Runs every one of |simulations| on a pool of |num_threads| threads, and
+// returns once all of them have returned.  Each simulation must create its own
+// Simulator and actors, and must not share mutable state with the others
+// except through state it alone writes, such as its own slot of a results
+// vector.  Independent simulations never interact, so running them in parallel
+// gives the same results as running them one after another.
+void RunSimulationsInParallel(std::vector<std::function<void()>> simulations,
+                              size_t num_threads);
+
+}  // namespace simulator
+}  // namespace quic
+
+#endif  // QUICHE_QUIC_TEST_TOOLS_SIMULATOR_PARALLEL_SIMULATIONS_H_
@@ -10,13 +10,21 @@
 namespace quic {
 namespace simulator {
 
+namespace {
+
+// Most packets kept for reuse by CreatePacket().
+const size_t kMaxFreePackets = 1024;
+
+}  // namespace
+
 Simulator::Simulator() : Simulator(nullptr) {}
 
 Simulator::Simulator(QuicRandom* random_generator)
     : random_generator_(random_generator),
       alarm_factory_(this, "Default Alarm Manager"),
       run_for_should_stop_(false),
-      enable_random_delays_(false) {
+      enable_random_delays_(false),
+      next_sequence_number_(0) {
   run_for_alarm_.reset(
       alarm_factory_.CreateAlarm(new RunForDelegate(&run_for_should_stop_)));
 }
@@ -43,62 +51,108 @@ QuicWallTime Simulator::Clock::WallNow() const {
 }
 
 void Simulator::AddActor(Actor* actor) {
-  auto emplace_times_result =
-      scheduled_times_.insert(std::make_pair(actor, QuicTime::Infinite()));
   auto emplace_names_result = actor_names_.insert(actor->name());
 
-  // Ensure that the object was actually placed into the map.
-  DCHECK(emplace_times_result.second);
+  // Ensure that the object was actually placed into the set.
   DCHECK(emplace_names_result.second);
 }
 
 void Simulator::RemoveActor(Actor* actor) {
-  auto scheduled_time_it = scheduled_times_.find(actor);
   auto actor_names_it = actor_names_.find(actor->name());
-  DCHECK(scheduled_time_it != scheduled_times_.end());
   DCHECK(actor_names_it != actor_names_.end());
 
-  QuicTime scheduled_time = scheduled_time_it->second;
-  if (scheduled_time != QuicTime::Infinite()) {
+  if (actor->schedule_index_ != Actor::kNotScheduled) {
     Unschedule(actor);
   }
 
-  scheduled_times_.erase(scheduled_time_it);
   actor_names_.erase(actor_names_it);
 }
 
 void Simulator::Schedule(Actor* actor, QuicTime new_time) {
-  auto scheduled_time_it = scheduled_times_.find(actor);
-  DCHECK(scheduled_time_it != scheduled_times_.end());
-  QuicTime scheduled_time = scheduled_time_it->second;
-
-  if (scheduled_time <= new_time) {
+  const size_t index = actor->schedule_index_;
+  if (index == Actor::kNotScheduled) {
+    schedule_.push_back({new_time, next_sequence_number_++, actor});
+    actor->schedule_index_ = schedule_.size() - 1;
+    SiftUp(schedule_.size() - 1);
     return;
   }
 
-  if (scheduled_time != QuicTime::Infinite()) {
-    Unschedule(actor);
+  DCHECK_EQ(actor, schedule_[index].actor);
+  if (schedule_[index].time <= new_time) {
+    return;
   }
 
-  scheduled_time_it->second = new_time;
-  schedule_.insert(std::make_pair(new_time, actor));
+  // The actor goes behind the actors already scheduled for |new_time|, as if
+  // it had been unscheduled and scheduled again.
+  schedule_[index].time = new_time;
+  schedule_[index].sequence_number = next_sequence_number_++;
+  SiftUp(index);
 }
 
 void Simulator::Unschedule(Actor* actor) {
-  auto scheduled_time_it = scheduled_times_.find(actor);
-  DCHECK(scheduled_time_it != scheduled_times_.end());
-  QuicTime scheduled_time = scheduled_time_it->second;
-
-  DCHECK(scheduled_time != QuicTime::Infinite());
-  auto range = schedule_.equal_range(scheduled_time);
-  for (auto it = range.first; it != range.second; ++it) {
-    if (it->second == actor) {
-      schedule_.erase(it);
-      scheduled_time_it->second = QuicTime::Infinite();
-      return;
+  const size_t index = actor->schedule_index_;
+  DCHECK(index != Actor::kNotScheduled);
+  DCHECK_EQ(actor, schedule_[index].actor);
+  actor->schedule_index_ = Actor::kNotScheduled;
+
+  const ScheduledActor last = schedule_.back();
+  schedule_.pop_back();
+  if (index == schedule_.size()) {
+    return;
+  }
+  PlaceInSchedule(last, index);
+  if (index > 0 && ActsBefore(last, schedule_[(index - 1) / 2])) {
+    SiftUp(index);
+  } else {
+    SiftDown(index);
+  }
+}
+
+// static
+bool Simulator::ActsBefore(const ScheduledActor& a, const ScheduledActor& b) {
+  if (a.time != b.time) {
+    return a.time < b.time;
+  }
+  return a.sequence_number < b.sequence_number;
+}
+
+void Simulator::SiftUp(size_t index) {
+  const ScheduledActor entry = schedule_[index];
+  while (index > 0) {
+    const size_t parent = (index - 1) / 2;
+    if (!ActsBefore(entry, schedule_[parent])) {
+      break;
     }
+    PlaceInSchedule(schedule_[parent], index);
+    index = parent;
   }
-  DCHECK(false);
+  PlaceInSchedule(entry, index);
+}
+
+void Simulator::SiftDown(size_t index) {
+  const ScheduledActor entry = schedule_[index];
+  const size_t size = schedule_.size();
+  while (true) {
+    size_t child = 2 * index + 1;
+    if (child >= size) {
+      break;
+    }
+    if (child + 1 < size &&
+        ActsBefore(schedule_[child + 1], schedule_[child])) {
+      ++child;
+    }
+    if (!ActsBefore(schedule_[child], entry)) {
+      break;
+    }
+    PlaceInSchedule(schedule_[child], index);
+    index = child;
+  }
+  PlaceInSchedule(entry, index);
+}
+
+void Simulator::PlaceInSchedule(const ScheduledActor& entry, size_t index) {
+  schedule_[index] = entry;
+  entry.actor->schedule_index_ = index;
 }
 
 const QuicClock* Simulator::GetClock() const {
@@ -121,6 +175,28 @@ QuicAlarmFactory* Simulator::GetAlarmFactory() {
   return &alarm_factory_;
 }
 
+std::unique_ptr<Packet> Simulator::CreatePacket() {
+  if (free_packets_.empty()) {
+    return std::make_unique<Packet>();
+  }
+  std::unique_ptr<Packet> packet = std::move(free_packets_.back());
+  free_packets_.pop_back();
+  return packet;
+}
+
+void Simulator::ReleasePacket(std::unique_ptr<Packet> packet) {
+  if (free_packets_.size() >= kMaxFreePackets) {
+    return;
+  }
+  // Clearing the strings keeps their capacity.
+  packet->source.clear();
+  packet->destination.clear();
+  packet->tx_timestamp = QuicTime::Zero();
+  packet->contents.clear();
+  packet->size = 0;
+  free_packets_.push_back(std::move(packet));
+}
+
 Simulator::RunForDelegate::RunForDelegate(bool* run_for_should_stop)
     : run_for_should_stop_(run_for_should_stop) {}
 
@@ -146,9 +222,8 @@ void Simulator::RunFor(QuicTime::Delta time_span) {
 }
 
 void Simulator::HandleNextScheduledActor() {
-  const auto current_event_it = schedule_.begin();
-  QuicTime event_time = current_event_it->first;
-  Actor* actor = current_event_it->second;
+  const QuicTime event_time = schedule_.front().time;
+  Actor* actor = schedule_.front().actor;
   QUIC_DVLOG(3) << "At t = " << event_time.ToDebuggingValue() << ", calling "
                 << actor->name();
 
@@ -5,7 +5,9 @@
 #ifndef QUICHE_QUIC_TEST_TOOLS_SIMULATOR_SIMULATOR_H_
 #define QUICHE_QUIC_TEST_TOOLS_SIMULATOR_SIMULATOR_H_
 
-#include <map>
+#include <cstdint>
+#include <memory>
+#include <vector>
 
 #include "net/third_party/quiche/src/quic/core/quic_connection.h"
 #include "net/third_party/quiche/src/quic/core/quic_simple_buffer_allocator.h"
@@ -13,6 +15,7 @@
 #include "net/third_party/quiche/src/quic/platform/api/quic_containers.h"
 #include "net/third_party/quiche/src/quic/test_tools/simulator/actor.h"
 #include "net/third_party/quiche/src/quic/test_tools/simulator/alarm_factory.h"
+#include "net/third_party/quiche/src/quic/test_tools/simulator/port.h"
 
 namespace quic {
 namespace simulator {
@@ -45,6 +48,14 @@ class Simulator : public QuicConnectionHelperInterface {
 
   QuicAlarmFactory* GetAlarmFactory();
 
+  // Returns an empty packet, reusing one released earlier if possible so that
+  // its strings keep their capacity.
+  std::unique_ptr<Packet> CreatePacket();
+
+  // Keeps |packet|, which has reached its destination, for reuse by
+  // CreatePacket(). Packets which are not released are simply destroyed.
+  void ReleasePacket(std::unique_ptr<Packet> packet);
+
   inline void set_random_generator(QuicRandom* random) {
     random_generator_ = random;
   }
@@ -96,6 +107,15 @@ class Simulator : public QuicConnectionHelperInterface {
     bool* run_for_should_stop_;
   };
 
+  // An entry of |schedule_|. Entries for the same time are ordered by
+  // |sequence_number|, so that actors scheduled for the same time act in the
+  // order in which they were scheduled.
+  struct ScheduledActor {
+    QuicTime time;
+    uint64_t sequence_number;
+    Actor* actor;
+  };
+
   // Register an actor with the simulator. Invoked by Actor constructor.
   void AddActor(Actor* actor);
 
@@ -106,6 +126,16 @@ class Simulator : public QuicConnectionHelperInterface {
   // notifies the actor.
   void HandleNextScheduledActor();
 
+  // Whether |a| acts before |b|.
+  static bool ActsBefore(const ScheduledActor& a, const ScheduledActor& b);
+
+  // Moves the entry at |index| of |schedule_| towards the root or the leaves
+  // until the heap order is restored, updating the indices of the actors
+  // moved.
+  void SiftUp(size_t index);
+  void SiftDown(size_t index);
+  void PlaceInSchedule(const ScheduledActor& entry, size_t index);
+
   Clock clock_;
   QuicRandom* random_generator_;
   SimpleBufferAllocator buffer_allocator_;
@@ -120,18 +150,21 @@ class Simulator : public QuicConnectionHelperInterface {
   // order to avoid synchronization issues.
   bool enable_random_delays_;
 
-  // Schedule of when the actors will be executed via an Act() call.  The
-  // schedule is subject to the following invariants:
+  // Schedule of when the actors will be executed via an Act() call, as a
+  // binary min-heap ordered by ActsBefore().  Every scheduled actor records
+  // its index in the heap, so rescheduling and unscheduling it need no search.
+  // The schedule is subject to the following invariants:
   // - An actor cannot be scheduled for a later time than it's currently in the
   //   schedule.
   // - An actor is removed from schedule either immediately before Act() is
   //   called or by explicitly calling Unschedule().
-  // - Each Actor appears in the map at most once.
-  std::multimap<QuicTime, Actor*> schedule_;
-  // For each actor, maintain the time it is scheduled at.  The value for
-  // unscheduled actors is QuicTime::Infinite().
-  QuicHashMap<Actor*, QuicTime> scheduled_times_;
+  // - Each Actor appears in the heap at most once.
+  std::vector<ScheduledActor> schedule_;
+  uint64_t next_sequence_number_;
   QuicHashSet<std::string> actor_names_;
+
+  // Packets released for reuse by CreatePacket().
+  std::vector<std::unique_ptr<Packet>> free_packets_;
 };
 
 template <class TerminationPredicate>
@@ -4,7 +4,9 @@
 
 #include "net/third_party/quiche/src/quic/test_tools/simulator/simulator.h"
 
+#include <functional>
 #include <utility>
+#include <vector>
 
 #include "net/third_party/quiche/src/quic/platform/api/quic_containers.h"
 #include "net/third_party/quiche/src/quic/platform/api/quic_logging.h"
@@ -13,11 +15,14 @@
 #include "net/third_party/quiche/src/quic/test_tools/simulator/alarm_factory.h"
 #include "net/third_party/quiche/src/quic/test_tools/simulator/link.h"
 #include "net/third_party/quiche/src/quic/test_tools/simulator/packet_filter.h"
+#include "net/third_party/quiche/src/quic/test_tools/simulator/parallel_simulations.h"
 #include "net/third_party/quiche/src/quic/test_tools/simulator/queue.h"
 #include "net/third_party/quiche/src/quic/test_tools/simulator/switch.h"
 #include "net/third_party/quiche/src/quic/test_tools/simulator/traffic_policer.h"
+#include "net/third_party/quiche/src/common/platform/api/quiche_str_cat.h"
 
 using testing::_;
+using testing::ElementsAre;
 using testing::Return;
 using testing::StrictMock;
 
@@ -67,6 +72,101 @@ TEST_F(SimulatorTest, Counters) {
   }
 }
 
+// An actor which appends its name to a list whenever it acts.
+class OrderRecorder : public Actor {
+ public:
+  OrderRecorder(Simulator* simulator,
+                std::string name,
+                std::vector<std::string>* order)
+      : Actor(simulator, name), order_(order) {}
+  ~OrderRecorder() override {}
+
+  void Act() override { order_->push_back(name_); }
+
+  using Actor::Schedule;
+  using Actor::Unschedule;
+
+ private:
+  std::vector<std::string>* order_;
+};
+
+// Test that actors scheduled for the same time act in the order in which they
+// were scheduled, and that moving an actor earlier puts it behind the actors
+// already scheduled for its new time.
+TEST_F(SimulatorTest, SimultaneousActorsActInScheduleOrder) {
+  Simulator simulator;
+  std::vector<std::string> order;
+  OrderRecorder a(&simulator, "a", &order);
+  OrderRecorder b(&simulator, "b", &order);
+  OrderRecorder c(&simulator, "c", &order);
+  OrderRecorder d(&simulator, "d", &order);
+  const QuicTime start = simulator.GetClock()->Now();
+  const QuicTime::Delta millisecond = QuicTime::Delta::FromMilliseconds(1);
+
+  c.Schedule(start + millisecond);
+  a.Schedule(start + millisecond);
+  d.Schedule(start + 2 * millisecond);
+  b.Schedule(start + 3 * millisecond);
+  b.Schedule(start + millisecond);
+  // Scheduling an actor for later than it is scheduled has no effect.
+  d.Schedule(start + 3 * millisecond);
+
+  simulator.RunUntil([]() { return false; });
+  EXPECT_THAT(order, ElementsAre("c", "a", "b", "d"));
+  EXPECT_EQ(start + 2 * millisecond, simulator.GetClock()->Now());
+}
+
+// Test that unscheduled and destroyed actors do not act, and that the others
+// still act in time order.
+TEST_F(SimulatorTest, UnscheduledActorsDoNotAct) {
+  Simulator simulator;
+  std::vector<std::string> order;
+  std::vector<std::unique_ptr<OrderRecorder>> actors;
+  const QuicTime start = simulator.GetClock()->Now();
+  const int kNumActors = 100;
+  for (int i = 0; i < kNumActors; ++i) {
+    actors.push_back(std::make_unique<OrderRecorder>(
+        &simulator, quiche::QuicheStrCat("actor", i), &order));
+    actors.back()->Schedule(start +
+                            QuicTime::Delta::FromMilliseconds(kNumActors - i));
+  }
+  for (int i = 1; i < kNumActors; i += 2) {
+    actors[i]->Unschedule();
+  }
+  actors[10].reset();
+
+  simulator.RunUntil([]() { return false; });
+  std::vector<std::string> expected_order;
+  for (int i = kNumActors - 2; i >= 0; i -= 2) {
+    if (i != 10) {
+      expected_order.push_back(quiche::QuicheStrCat("actor", i));
+    }
+  }
+  EXPECT_EQ(expected_order, order);
+}
+
+// Test that independent simulations can run on several threads at once.
+TEST_F(SimulatorTest, ParallelSimulations) {
+  const int kNumSimulations = 8;
+  std::vector<int> values(kNumSimulations, 0);
+  std::vector<std::function<void()>> simulations;
+  for (int i = 0; i < kNumSimulations; ++i) {
+    simulations.push_back([i, &values]() {
+      Simulator simulator;
+      Counter counter(&simulator, "counter",
+                      QuicTime::Delta::FromSeconds(i + 1));
+      simulator.RunFor(QuicTime::Delta::FromSeconds(100) +
+                       QuicTime::Delta::FromMilliseconds(1));
+      values[i] = counter.get_value();
+    });
+  }
+
+  RunSimulationsInParallel(std::move(simulations), /*num_threads=*/4);
+  for (int i = 0; i < kNumSimulations; ++i) {
+    EXPECT_EQ(100 / (i + 1), values[i]) << i;
+  }
+}
+
 // A port which counts the number of packets received on it, both total and
 // per-destination.
 class CounterPort : public UnconstrainedPortInterface {
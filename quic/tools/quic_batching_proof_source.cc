@@ -0,0 +1,329 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/third_party/quiche/src/quic/tools/quic_batching_proof_source.h"
+
+#include <atomic>
+#include <utility>
+
+#include "net/third_party/quiche/src/quic/platform/api/quic_logging.h"
+
+namespace quic {
+
+class QuicBatchingProofSource::Request {
+ public:
+  virtual ~Request() = default;
+
+  // Calls |delegate|, and calls OnRequestDone() on |batch| once the delegate
+  // is done. Runs on a pool thread.
+  virtual void Start(ProofSource* delegate, BatchOperation* batch) = 0;
+
+  // Runs the caller's callback. Runs on the event loop thread.
+  virtual void Complete() = 0;
+};
+
+// Runs the requests of one batch back to back on a pool thread, and completes
+// them together on the event loop thread.
+class QuicBatchingProofSource::BatchOperation
+    : public QuicCryptoThreadPool::Operation {
+ public:
+  BatchOperation(ProofSource* delegate,
+                 std::vector<std::unique_ptr<Request>> requests)
+      : delegate_(delegate),
+        requests_(std::move(requests)),
+        pool_(nullptr),
+        num_running_requests_(0) {}
+
+  void Start(QuicCryptoThreadPool* pool) override;
+  void Complete() override;
+
+  // Called once by each request when its delegate call is done, from any
+  // thread.
+  void OnRequestDone() {
+    if (num_running_requests_.fetch_sub(1) == 1) {
+      pool_->OnOperationDone(this);
+    }
+  }
+
+ private:
+  ProofSource* delegate_;  // Unowned.
+  std::vector<std::unique_ptr<Request>> requests_;
+  QuicCryptoThreadPool* pool_;  // Unowned.
+  std::atomic<size_t> num_running_requests_;
+};
+
+void QuicBatchingProofSource::BatchOperation::Start(
+    QuicCryptoThreadPool* pool) {
+  pool_ = pool;
+  // Hold one count until all requests have started, so that requests which
+  // finish synchronously do not hand the batch back while it is iterated.
+  num_running_requests_ = requests_.size() + 1;
+  for (const std::unique_ptr<Request>& request : requests_) {
+    request->Start(delegate_, this);
+  }
+  OnRequestDone();
+}
+
+void QuicBatchingProofSource::BatchOperation::Complete() {
+  for (const std::unique_ptr<Request>& request : requests_) {
+    request->Complete();
+  }
+}
+
+class QuicBatchingProofSource::GetProofRequest : public Request {
+ public:
+  GetProofRequest(const QuicSocketAddress& server_address,
+                  const QuicSocketAddress& client_address,
+                  const std::string& hostname,
+                  const std::string& server_config,
+                  QuicTransportVersion transport_version,
+                  quiche::QuicheStringPiece chlo_hash,
+                  std::unique_ptr<ProofSource::Callback> callback)
+      : server_address_(server_address),
+        client_address_(client_address),
+        hostname_(hostname),
+        server_config_(server_config),
+        transport_version_(transport_version),
+        chlo_hash_(chlo_hash),
+        callback_(std::move(callback)),
+        ok_(false) {}
+
+  void Start(ProofSource* delegate, BatchOperation* batch) override {
+    delegate->GetProof(server_address_, client_address_, hostname_,
+                       server_config_, transport_version_, chlo_hash_,
+                       std::make_unique<DoneCallback>(this, batch));
+  }
+
+  void Complete() override {
+    callback_->Run(ok_, chain_, proof_, std::move(details_));
+  }
+
+ private:
+  class DoneCallback : public ProofSource::Callback {
+   public:
+    DoneCallback(GetProofRequest* request, BatchOperation* batch)
+        : request_(request), batch_(batch) {}
+
+    void Run(bool ok,
+             const QuicReferenceCountedPointer<ProofSource::Chain>& chain,
+             const QuicCryptoProof& proof,
+             std::unique_ptr<ProofSource::Details> details) override {
+      request_->ok_ = ok;
+      request_->chain_ = chain;
+      request_->proof_ = proof;
+      request_->details_ = std::move(details);
+      batch_->OnRequestDone();
+    }
+
+   private:
+    GetProofRequest* request_;
+    BatchOperation* batch_;
+  };
+
+  const QuicSocketAddress server_address_;
+  const QuicSocketAddress client_address_;
+  const std::string hostname_;
+  const std::string server_config_;
+  const QuicTransportVersion transport_version_;
+  const std::string chlo_hash_;
+  std::unique_ptr<ProofSource::Callback> callback_;
+
+  bool ok_;
+  QuicReferenceCountedPointer<ProofSource::Chain> chain_;
+  QuicCryptoProof proof_;
+  std::unique_ptr<ProofSource::Details> details_;
+};
+
+class QuicBatchingProofSource::SignatureRequest : public Request {
+ public:
+  SignatureRequest(const QuicSocketAddress& server_address,
+                   const QuicSocketAddress& client_address,
+                   const std::string& hostname,
+                   uint16_t signature_algorithm,
+                   quiche::QuicheStringPiece in,
+                   std::unique_ptr<ProofSource::SignatureCallback> callback)
+      : server_address_(server_address),
+        client_address_(client_address),
+        hostname_(hostname),
+        signature_algorithm_(signature_algorithm),
+        in_(in),
+        callback_(std::move(callback)),
+        ok_(false) {}
+
+  void Start(ProofSource* delegate, BatchOperation* batch) override {
+    delegate->ComputeTlsSignature(server_address_, client_address_, hostname_,
+                                  signature_algorithm_, in_,
+                                  std::make_unique<DoneCallback>(this, batch));
+  }
+
+  void Complete() override {
+    callback_->Run(ok_, std::move(signature_), std::move(details_));
+  }
+
+ private:
+  class DoneCallback : public ProofSource::SignatureCallback {
+   public:
+    DoneCallback(SignatureRequest* request, BatchOperation* batch)
+        : request_(request), batch_(batch) {}
+
+    void Run(bool ok,
+             std::string signature,
+             std::unique_ptr<ProofSource::Details> details) override {
+      request_->ok_ = ok;
+      request_->signature_ = std::move(signature);
+      request_->details_ = std::move(details);
+      batch_->OnRequestDone();
+    }
+
+   private:
+    SignatureRequest* request_;
+    BatchOperation* batch_;
+  };
+
+  const QuicSocketAddress server_address_;
+  const QuicSocketAddress client_address_;
+  const std::string hostname_;
+  const uint16_t signature_algorithm_;
+  const std::string in_;
+  std::unique_ptr<ProofSource::SignatureCallback> callback_;
+
+  bool ok_;
+  std::string signature_;
+  std::unique_ptr<ProofSource::Details> details_;
+};
+
+class QuicBatchingProofSource::FlushAlarmDelegate
+    : public QuicAlarm::Delegate {
+ public:
+  explicit FlushAlarmDelegate(QuicBatchingProofSource* proof_source)
+      : proof_source_(proof_source) {}
+
+  void OnAlarm() override { proof_source_->Flush(); }
+
+ private:
+  QuicBatchingProofSource* proof_source_;  // Unowned.
+};
+
+QuicBatchingProofSource::PendingBatch::PendingBatch() = default;
+
+QuicBatchingProofSource::PendingBatch::PendingBatch(PendingBatch&& other) =
+    default;
+
+QuicBatchingProofSource::PendingBatch::~PendingBatch() = default;
+
+QuicBatchingProofSource::QuicBatchingProofSource(
+    std::unique_ptr<ProofSource> delegate,
+    QuicCryptoThreadPool* pool,
+    const QuicClock* clock,
+    QuicAlarmFactory* alarm_factory,
+    size_t max_batch_size,
+    QuicTime::Delta max_delay)
+    : delegate_(std::move(delegate)),
+      pool_(pool),
+      clock_(clock),
+      max_batch_size_(max_batch_size),
+      max_delay_(max_delay),
+      num_queued_requests_(0),
+      num_batches_(0),
+      flush_alarm_(
+          alarm_factory->CreateAlarm(new FlushAlarmDelegate(this))) {
+  DCHECK_LT(0u, max_batch_size_);
+}
+
+QuicBatchingProofSource::~QuicBatchingProofSource() {
+  flush_alarm_->Cancel();
+  // The pool may already be gone, so queued requests are failed rather than
+  // run. A request which has not started completes with ok=false.
+  for (auto& entry : batches_) {
+    for (const std::unique_ptr<Request>& request : entry.second.requests) {
+      request->Complete();
+    }
+  }
+}
+
+void QuicBatchingProofSource::GetProof(
+    const QuicSocketAddress& server_address,
+    const QuicSocketAddress& client_address,
+    const std::string& hostname,
+    const std::string& server_config,
+    QuicTransportVersion transport_version,
+    quiche::QuicheStringPiece chlo_hash,
+    std::unique_ptr<Callback> callback) {
+  Enqueue(server_address, client_address, hostname,
+          std::make_unique<GetProofRequest>(
+              server_address, client_address, hostname, server_config,
+              transport_version, chlo_hash, std::move(callback)));
+}
+
+QuicReferenceCountedPointer<ProofSource::Chain>
+QuicBatchingProofSource::GetCertChain(const QuicSocketAddress& server_address,
+                                      const QuicSocketAddress& client_address,
+                                      const std::string& hostname) {
+  return delegate_->GetCertChain(server_address, client_address, hostname);
+}
+
+void QuicBatchingProofSource::ComputeTlsSignature(
+    const QuicSocketAddress& server_address,
+    const QuicSocketAddress& client_address,
+    const std::string& hostname,
+    uint16_t signature_algorithm,
+    quiche::QuicheStringPiece in,
+    std::unique_ptr<SignatureCallback> callback) {
+  Enqueue(server_address, client_address, hostname,
+          std::make_unique<SignatureRequest>(server_address, client_address,
+                                             hostname, signature_algorithm, in,
+                                             std::move(callback)));
+}
+
+ProofSource::TicketCrypter* QuicBatchingProofSource::GetTicketCrypter() {
+  return delegate_->GetTicketCrypter();
+}
+
+void QuicBatchingProofSource::Flush() {
+  flush_alarm_->Cancel();
+  std::map<const Chain*, PendingBatch> batches;
+  batches.swap(batches_);
+  num_queued_requests_ = 0;
+  for (auto& entry : batches) {
+    RunBatch(std::move(entry.second));
+  }
+}
+
+void QuicBatchingProofSource::Enqueue(const QuicSocketAddress& server_address,
+                                      const QuicSocketAddress& client_address,
+                                      const std::string& hostname,
+                                      std::unique_ptr<Request> request) {
+  QuicReferenceCountedPointer<Chain> chain =
+      delegate_->GetCertChain(server_address, client_address, hostname);
+  auto it = batches_.find(chain.get());
+  if (it == batches_.end()) {
+    it = batches_.emplace(chain.get(), PendingBatch()).first;
+    it->second.chain = chain;
+  }
+  it->second.requests.push_back(std::move(request));
+  ++num_queued_requests_;
+
+  if (it->second.requests.size() >= max_batch_size_) {
+    PendingBatch batch = std::move(it->second);
+    batches_.erase(it);
+    num_queued_requests_ -= batch.requests.size();
+    RunBatch(std::move(batch));
+  }
+
+  if (num_queued_requests_ == 0) {
+    flush_alarm_->Cancel();
+  } else if (!flush_alarm_->IsSet()) {
+    flush_alarm_->Set(clock_->ApproximateNow() + max_delay_);
+  }
+}
+
+void QuicBatchingProofSource::RunBatch(PendingBatch batch) {
+  QUIC_DVLOG(1) << "Running batch of " << batch.requests.size()
+                << " proof requests";
+  ++num_batches_;
+  pool_->Post(std::make_unique<BatchOperation>(delegate_.get(),
+                                               std::move(batch.requests)));
+}
+
+}  // namespace quic
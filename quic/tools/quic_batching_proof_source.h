@@ -0,0 +1,122 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef QUICHE_QUIC_TOOLS_QUIC_BATCHING_PROOF_SOURCE_H_
+#define QUICHE_QUIC_TOOLS_QUIC_BATCHING_PROOF_SOURCE_H_
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "net/third_party/quiche/src/quic/core/crypto/proof_source.h"
+#include "net/third_party/quiche/src/quic/core/quic_alarm.h"
+#include "net/third_party/quiche/src/quic/core/quic_alarm_factory.h"
+#include "net/third_party/quiche/src/quic/core/quic_clock.h"
+#include "net/third_party/quiche/src/quic/core/quic_time.h"
+#include "net/third_party/quiche/src/quic/tools/quic_crypto_thread_pool.h"
+
+namespace quic {
+
+// A ProofSource which collects the GetProof and ComputeTlsSignature calls made
+// for the same certificate chain within a short window, and runs each
+// collection as a single operation on a QuicCryptoThreadPool.
+//
+// During connection storms many handshakes sign with the same key in one
+// event loop iteration. Batching them costs one hand off to the pool and one
+// completion wake up per batch rather than per signature, and signs with the
+// same key back to back on one thread.
+class QuicBatchingProofSource : public ProofSource {
+ public:
+  // A batch is run once it holds |max_batch_size| requests or its first
+  // request has waited |max_delay|, whichever comes first. |clock| and
+  // |alarm_factory| must outlive the proof source. |pool| must be destroyed
+  // before the proof source, since running batches call into |delegate|.
+  // Requests still queued when the proof source is destroyed fail.
+  QuicBatchingProofSource(std::unique_ptr<ProofSource> delegate,
+                          QuicCryptoThreadPool* pool,
+                          const QuicClock* clock,
+                          QuicAlarmFactory* alarm_factory,
+                          size_t max_batch_size,
+                          QuicTime::Delta max_delay);
+  QuicBatchingProofSource(const QuicBatchingProofSource&) = delete;
+  QuicBatchingProofSource& operator=(const QuicBatchingProofSource&) = delete;
+  ~QuicBatchingProofSource() override;
+
+  // ProofSource interface.
+  void GetProof(const QuicSocketAddress& server_address,
+                const QuicSocketAddress& client_address,
+                const std::string& hostname,
+                const std::string& server_config,
+                QuicTransportVersion transport_version,
+                quiche::QuicheStringPiece chlo_hash,
+                std::unique_ptr<Callback> callback) override;
+  QuicReferenceCountedPointer<Chain> GetCertChain(
+      const QuicSocketAddress& server_address,
+      const QuicSocketAddress& client_address,
+      const std::string& hostname) override;
+  void ComputeTlsSignature(
+      const QuicSocketAddress& server_address,
+      const QuicSocketAddress& client_address,
+      const std::string& hostname,
+      uint16_t signature_algorithm,
+      quiche::QuicheStringPiece in,
+      std::unique_ptr<SignatureCallback> callback) override;
+  TicketCrypter* GetTicketCrypter() override;
+
+  // Runs all collected requests now.
+  void Flush();
+
+  // Number of requests collected but not yet handed to the pool.
+  size_t num_queued_requests() const { return num_queued_requests_; }
+
+  // Number of batches handed to the pool.
+  uint64_t num_batches() const { return num_batches_; }
+
+ private:
+  class BatchOperation;
+  class FlushAlarmDelegate;
+  class GetProofRequest;
+  class Request;
+  class SignatureRequest;
+
+  // Requests for one certificate chain.
+  struct PendingBatch {
+    PendingBatch();
+    PendingBatch(PendingBatch&& other);
+    ~PendingBatch();
+
+    QuicReferenceCountedPointer<Chain> chain;
+    std::vector<std::unique_ptr<Request>> requests;
+  };
+
+  // Adds |request| to the batch of |hostname|'s certificate chain.
+  void Enqueue(const QuicSocketAddress& server_address,
+               const QuicSocketAddress& client_address,
+               const std::string& hostname,
+               std::unique_ptr<Request> request);
+
+  // Hands |batch| to the pool.
+  void RunBatch(PendingBatch batch);
+
+  std::unique_ptr<ProofSource> delegate_;
+  QuicCryptoThreadPool* pool_;  // Unowned.
+  const QuicClock* clock_;      // Unowned.
+  const size_t max_batch_size_;
+  const QuicTime::Delta max_delay_;
+
+  // Requests waiting to run, by the certificate chain they sign for. Each
+  // batch holds a reference to its chain, so the keys stay valid.
+  std::map<const Chain*, PendingBatch> batches_;
+  size_t num_queued_requests_;
+  uint64_t num_batches_;
+
+  // Fires |max_delay_| after the oldest queued request was added.
+  std::unique_ptr<QuicAlarm> flush_alarm_;
+};
+
+}  // namespace quic
+
+#endif  // QUICHE_QUIC_TOOLS_QUIC_BATCHING_PROOF_SOURCE_H_
@@ -0,0 +1,135 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/third_party/quiche/src/quic/tools/quic_batching_proof_source.h"
+
+#include <memory>
+#include <string>
+
+#include "third_party/boringssl/src/include/openssl/ssl.h"
+#include "net/third_party/quiche/src/quic/core/quic_epoll_alarm_factory.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_test.h"
+#include "net/quic/platform/impl/quic_epoll_clock.h"
+#include "net/third_party/quiche/src/quic/test_tools/crypto_test_utils.h"
+
+namespace quic {
+namespace test {
+namespace {
+
+class TestSignatureCallback : public ProofSource::SignatureCallback {
+ public:
+  TestSignatureCallback(int* num_done, int* num_ok)
+      : num_done_(num_done), num_ok_(num_ok) {}
+
+  void Run(bool ok,
+           std::string signature,
+           std::unique_ptr<ProofSource::Details> /*details*/) override {
+    ++*num_done_;
+    if (ok && !signature.empty()) {
+      ++*num_ok_;
+    }
+  }
+
+ private:
+  int* num_done_;
+  int* num_ok_;
+};
+
+class QuicBatchingProofSourceTest : public QuicTest {
+ protected:
+  QuicBatchingProofSourceTest()
+      : clock_(&epoll_server_),
+        alarm_factory_(&epoll_server_),
+        num_done_(0),
+        num_ok_(0) {
+    epoll_server_.set_timeout_in_us(10 * 1000);
+  }
+
+  void CreateProofSource(size_t max_batch_size, QuicTime::Delta max_delay) {
+    pool_ = std::make_unique<QuicCryptoThreadPool>(
+        /*num_threads=*/2, /*max_pending_operations=*/16);
+    pool_->AttachToEpollServer(&epoll_server_);
+    proof_source_ = std::make_unique<QuicBatchingProofSource>(
+        crypto_test_utils::ProofSourceForTesting(), pool_.get(), &clock_,
+        &alarm_factory_, max_batch_size, max_delay);
+  }
+
+  void ComputeTlsSignature() {
+    proof_source_->ComputeTlsSignature(
+        QuicSocketAddress(), QuicSocketAddress(), "test.example.com",
+        SSL_SIGN_RSA_PSS_RSAE_SHA256, "Test data",
+        std::make_unique<TestSignatureCallback>(&num_done_, &num_ok_));
+  }
+
+  // Runs the event loop until |num_done_| reaches |num_signatures|.
+  void RunUntilDone(int num_signatures) {
+    while (num_done_ < num_signatures) {
+      epoll_server_.WaitForEventsAndExecuteCallbacks();
+    }
+  }
+
+  QuicEpollServer epoll_server_;
+  QuicEpollClock clock_;
+  QuicEpollAlarmFactory alarm_factory_;
+  std::unique_ptr<QuicBatchingProofSource> proof_source_;
+  // Declared after |proof_source_|, since running batches call into it.
+  std::unique_ptr<QuicCryptoThreadPool> pool_;
+  int num_done_;
+  int num_ok_;
+};
+
+TEST_F(QuicBatchingProofSourceTest, RunsFullBatch) {
+  CreateProofSource(/*max_batch_size=*/3, QuicTime::Delta::FromSeconds(10));
+  ComputeTlsSignature();
+  ComputeTlsSignature();
+  EXPECT_EQ(2u, proof_source_->num_queued_requests());
+  EXPECT_EQ(0u, proof_source_->num_batches());
+
+  ComputeTlsSignature();
+  EXPECT_EQ(0u, proof_source_->num_queued_requests());
+  EXPECT_EQ(1u, proof_source_->num_batches());
+  EXPECT_EQ(1u, pool_->num_pending_operations());
+
+  RunUntilDone(3);
+  EXPECT_EQ(3, num_ok_);
+  EXPECT_EQ(0u, pool_->num_pending_operations());
+}
+
+TEST_F(QuicBatchingProofSourceTest, RunsPartialBatchAfterDelay) {
+  CreateProofSource(/*max_batch_size=*/10,
+                    QuicTime::Delta::FromMilliseconds(1));
+  ComputeTlsSignature();
+  ComputeTlsSignature();
+  EXPECT_EQ(2u, proof_source_->num_queued_requests());
+
+  RunUntilDone(2);
+  EXPECT_EQ(2, num_ok_);
+  EXPECT_EQ(0u, proof_source_->num_queued_requests());
+  EXPECT_EQ(1u, proof_source_->num_batches());
+}
+
+TEST_F(QuicBatchingProofSourceTest, Flush) {
+  CreateProofSource(/*max_batch_size=*/10, QuicTime::Delta::FromSeconds(10));
+  ComputeTlsSignature();
+  proof_source_->Flush();
+  EXPECT_EQ(0u, proof_source_->num_queued_requests());
+  EXPECT_EQ(1u, proof_source_->num_batches());
+
+  RunUntilDone(1);
+  EXPECT_EQ(1, num_ok_);
+}
+
+TEST_F(QuicBatchingProofSourceTest, DestructionFailsQueuedRequests) {
+  CreateProofSource(/*max_batch_size=*/10, QuicTime::Delta::FromSeconds(10));
+  ComputeTlsSignature();
+  ComputeTlsSignature();
+  pool_.reset();
+  proof_source_.reset();
+  EXPECT_EQ(2, num_done_);
+  EXPECT_EQ(0, num_ok_);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace quic
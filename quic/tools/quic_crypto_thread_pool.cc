@@ -0,0 +1,486 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/third_party/quiche/src/quic/tools/quic_crypto_thread_pool.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <utility>
+
+#include "net/third_party/quiche/src/quic/core/crypto/key_exchange.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_logging.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_thread.h"
+#include "net/third_party/quiche/src/common/platform/api/quiche_str_cat.h"
+
+namespace quic {
+
+namespace {
+
+// Adds |value| to the counter of eventfd |fd|.
+void AddToEventFd(int fd, uint64_t value) {
+  while (write(fd, &value, sizeof(value)) < 0 && errno == EINTR) {
+  }
+}
+
+// Runs ProofSource::GetProof of |proof_source| on the pool.
+class GetProofOperation : public QuicCryptoThreadPool::Operation {
+ public:
+  GetProofOperation(ProofSource* proof_source,
+                    const QuicSocketAddress& server_address,
+                    const QuicSocketAddress& client_address,
+                    const std::string& hostname,
+                    const std::string& server_config,
+                    QuicTransportVersion transport_version,
+                    quiche::QuicheStringPiece chlo_hash,
+                    std::unique_ptr<ProofSource::Callback> callback)
+      : proof_source_(proof_source),
+        server_address_(server_address),
+        client_address_(client_address),
+        hostname_(hostname),
+        server_config_(server_config),
+        transport_version_(transport_version),
+        chlo_hash_(chlo_hash),
+        callback_(std::move(callback)),
+        ok_(false) {}
+
+  void Start(QuicCryptoThreadPool* pool) override {
+    proof_source_->GetProof(server_address_, client_address_, hostname_,
+                            server_config_, transport_version_, chlo_hash_,
+                            std::make_unique<DoneCallback>(this, pool));
+  }
+
+  void Complete() override {
+    callback_->Run(ok_, chain_, proof_, std::move(details_));
+  }
+
+ private:
+  class DoneCallback : public ProofSource::Callback {
+   public:
+    DoneCallback(GetProofOperation* operation, QuicCryptoThreadPool* pool)
+        : operation_(operation), pool_(pool) {}
+
+    void Run(bool ok,
+             const QuicReferenceCountedPointer<ProofSource::Chain>& chain,
+             const QuicCryptoProof& proof,
+             std::unique_ptr<ProofSource::Details> details) override {
+      operation_->ok_ = ok;
+      operation_->chain_ = chain;
+      operation_->proof_ = proof;
+      operation_->details_ = std::move(details);
+      pool_->OnOperationDone(operation_);
+    }
+
+   private:
+    GetProofOperation* operation_;
+    QuicCryptoThreadPool* pool_;
+  };
+
+  ProofSource* proof_source_;
+  const QuicSocketAddress server_address_;
+  const QuicSocketAddress client_address_;
+  const std::string hostname_;
+  const std::string server_config_;
+  const QuicTransportVersion transport_version_;
+  const std::string chlo_hash_;
+  std::unique_ptr<ProofSource::Callback> callback_;
+
+  bool ok_;
+  QuicReferenceCountedPointer<ProofSource::Chain> chain_;
+  QuicCryptoProof proof_;
+  std::unique_ptr<ProofSource::Details> details_;
+};
+
+// Runs ProofSource::ComputeTlsSignature of |proof_source| on the pool.
+class ComputeTlsSignatureOperation : public QuicCryptoThreadPool::Operation {
+ public:
+  ComputeTlsSignatureOperation(
+      ProofSource* proof_source,
+      const QuicSocketAddress& server_address,
+      const QuicSocketAddress& client_address,
+      const std::string& hostname,
+      uint16_t signature_algorithm,
+      quiche::QuicheStringPiece in,
+      std::unique_ptr<ProofSource::SignatureCallback> callback)
+      : proof_source_(proof_source),
+        server_address_(server_address),
+        client_address_(client_address),
+        hostname_(hostname),
+        signature_algorithm_(signature_algorithm),
+        in_(in),
+        callback_(std::move(callback)),
+        ok_(false) {}
+
+  void Start(QuicCryptoThreadPool* pool) override {
+    proof_source_->ComputeTlsSignature(
+        server_address_, client_address_, hostname_, signature_algorithm_, in_,
+        std::make_unique<DoneCallback>(this, pool));
+  }
+
+  void Complete() override {
+    callback_->Run(ok_, std::move(signature_), std::move(details_));
+  }
+
+ private:
+  class DoneCallback : public ProofSource::SignatureCallback {
+   public:
+    DoneCallback(ComputeTlsSignatureOperation* operation,
+                 QuicCryptoThreadPool* pool)
+        : operation_(operation), pool_(pool) {}
+
+    void Run(bool ok,
+             std::string signature,
+             std::unique_ptr<ProofSource::Details> details) override {
+      operation_->ok_ = ok;
+      operation_->signature_ = std::move(signature);
+      operation_->details_ = std::move(details);
+      pool_->OnOperationDone(operation_);
+    }
+
+   private:
+    ComputeTlsSignatureOperation* operation_;
+    QuicCryptoThreadPool* pool_;
+  };
+
+  ProofSource* proof_source_;
+  const QuicSocketAddress server_address_;
+  const QuicSocketAddress client_address_;
+  const std::string hostname_;
+  const uint16_t signature_algorithm_;
+  // The caller's copy of the input is only valid during the call.
+  const std::string in_;
+  std::unique_ptr<ProofSource::SignatureCallback> callback_;
+
+  bool ok_;
+  std::string signature_;
+  std::unique_ptr<ProofSource::Details> details_;
+};
+
+// Computes a shared key with |key_exchange| on the pool. The key is written to
+// the caller's |shared_key| only once the operation completes on the event
+// loop thread.
+class SharedKeyOperation : public QuicCryptoThreadPool::Operation {
+ public:
+  SharedKeyOperation(
+      std::shared_ptr<const AsynchronousKeyExchange> key_exchange,
+      quiche::QuicheStringPiece peer_public_value,
+      std::string* shared_key,
+      std::unique_ptr<AsynchronousKeyExchange::Callback> callback)
+      : key_exchange_(std::move(key_exchange)),
+        peer_public_value_(peer_public_value),
+        shared_key_(shared_key),
+        callback_(std::move(callback)),
+        ok_(false) {}
+
+  void Start(QuicCryptoThreadPool* pool) override {
+    key_exchange_->CalculateSharedKeyAsync(
+        peer_public_value_, &result_,
+        std::make_unique<DoneCallback>(this, pool));
+  }
+
+  void Complete() override {
+    if (ok_) {
+      *shared_key_ = std::move(result_);
+    }
+    callback_->Run(ok_);
+  }
+
+ private:
+  class DoneCallback : public AsynchronousKeyExchange::Callback {
+   public:
+    DoneCallback(SharedKeyOperation* operation, QuicCryptoThreadPool* pool)
+        : operation_(operation), pool_(pool) {}
+
+    void Run(bool ok) override {
+      operation_->ok_ = ok;
+      pool_->OnOperationDone(operation_);
+    }
+
+   private:
+    SharedKeyOperation* operation_;
+    QuicCryptoThreadPool* pool_;
+  };
+
+  // Shared with the key exchange which posted the operation, which may be
+  // destroyed first.
+  std::shared_ptr<const AsynchronousKeyExchange> key_exchange_;
+  const std::string peer_public_value_;
+  std::string* shared_key_;
+  std::unique_ptr<AsynchronousKeyExchange::Callback> callback_;
+
+  bool ok_;
+  std::string result_;
+};
+
+class ThreadPoolProofSource : public ProofSource {
+ public:
+  ThreadPoolProofSource(QuicCryptoThreadPool* pool,
+                        std::unique_ptr<ProofSource> proof_source)
+      : pool_(pool), proof_source_(std::move(proof_source)) {}
+
+  void GetProof(const QuicSocketAddress& server_address,
+                const QuicSocketAddress& client_address,
+                const std::string& hostname,
+                const std::string& server_config,
+                QuicTransportVersion transport_version,
+                quiche::QuicheStringPiece chlo_hash,
+                std::unique_ptr<Callback> callback) override {
+    pool_->Post(std::make_unique<GetProofOperation>(
+        proof_source_.get(), server_address, client_address, hostname,
+        server_config, transport_version, chlo_hash, std::move(callback)));
+  }
+
+  QuicReferenceCountedPointer<Chain> GetCertChain(
+      const QuicSocketAddress& server_address,
+      const QuicSocketAddress& client_address,
+      const std::string& hostname) override {
+    return proof_source_->GetCertChain(server_address, client_address,
+                                       hostname);
+  }
+
+  void ComputeTlsSignature(
+      const QuicSocketAddress& server_address,
+      const QuicSocketAddress& client_address,
+      const std::string& hostname,
+      uint16_t signature_algorithm,
+      quiche::QuicheStringPiece in,
+      std::unique_ptr<SignatureCallback> callback) override {
+    pool_->Post(std::make_unique<ComputeTlsSignatureOperation>(
+        proof_source_.get(), server_address, client_address, hostname,
+        signature_algorithm, in, std::move(callback)));
+  }
+
+  TicketCrypter* GetTicketCrypter() override {
+    return proof_source_->GetTicketCrypter();
+  }
+
+ private:
+  QuicCryptoThreadPool* pool_;  // Unowned.
+  std::unique_ptr<ProofSource> proof_source_;
+};
+
+class ThreadPoolKeyExchange : public AsynchronousKeyExchange {
+ public:
+  ThreadPoolKeyExchange(QuicCryptoThreadPool* pool,
+                        std::unique_ptr<AsynchronousKeyExchange> key_exchange)
+      : pool_(pool), key_exchange_(std::move(key_exchange)) {}
+
+  void CalculateSharedKeyAsync(
+      quiche::QuicheStringPiece peer_public_value,
+      std::string* shared_key,
+      std::unique_ptr<Callback> callback) const override {
+    pool_->Post(std::make_unique<SharedKeyOperation>(
+        key_exchange_, peer_public_value, shared_key, std::move(callback)));
+  }
+
+  QuicTag type() const override { return key_exchange_->type(); }
+
+ private:
+  QuicCryptoThreadPool* pool_;  // Unowned.
+  std::shared_ptr<const AsynchronousKeyExchange> key_exchange_;
+};
+
+class ThreadPoolKeyExchangeSource : public KeyExchangeSource {
+ public:
+  ThreadPoolKeyExchangeSource(
+      QuicCryptoThreadPool* pool,
+      std::unique_ptr<KeyExchangeSource> key_exchange_source)
+      : pool_(pool), key_exchange_source_(std::move(key_exchange_source)) {}
+
+  std::unique_ptr<AsynchronousKeyExchange> Create(
+      std::string server_config_id,
+      bool is_fallback,
+      QuicTag type,
+      quiche::QuicheStringPiece private_key) override {
+    std::unique_ptr<AsynchronousKeyExchange> key_exchange =
+        key_exchange_source_->Create(std::move(server_config_id), is_fallback,
+                                     type, private_key);
+    if (key_exchange == nullptr) {
+      return nullptr;
+    }
+    return std::make_unique<ThreadPoolKeyExchange>(pool_,
+                                                   std::move(key_exchange));
+  }
+
+ private:
+  QuicCryptoThreadPool* pool_;  // Unowned.
+  std::unique_ptr<KeyExchangeSource> key_exchange_source_;
+};
+
+}  // namespace
+
+class QuicCryptoThreadPool::Worker : public QuicThread {
+ public:
+  Worker(QuicCryptoThreadPool* pool, size_t index)
+      : QuicThread(quiche::QuicheStrCat("quic_crypto_worker_", index)),
+        pool_(pool) {}
+
+  void Run() override {
+    while (true) {
+      std::unique_ptr<Operation> operation = pool_->WaitForOperation();
+      if (operation == nullptr) {
+        return;
+      }
+      // The operation hands itself back through OnOperationDone().
+      operation.release()->Start(pool_);
+    }
+  }
+
+ private:
+  QuicCryptoThreadPool* pool_;  // Unowned.
+};
+
+QuicCryptoThreadPool::QuicCryptoThreadPool(size_t num_threads,
+                                           size_t max_pending_operations)
+    : max_pending_operations_(max_pending_operations),
+      num_pending_operations_(0),
+      work_fd_(eventfd(0, EFD_CLOEXEC | EFD_SEMAPHORE)),
+      done_fd_(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)),
+      epoll_server_(nullptr),
+      stopping_(false) {
+  if (work_fd_ < 0 || done_fd_ < 0) {
+    QUIC_LOG(ERROR) << "Failed to create eventfd: " << strerror(errno)
+                    << ". Running crypto operations on the calling thread.";
+    if (work_fd_ >= 0) {
+      close(work_fd_);
+      work_fd_ = -1;
+    }
+    if (done_fd_ >= 0) {
+      close(done_fd_);
+      done_fd_ = -1;
+    }
+    return;
+  }
+  for (size_t i = 0; i < num_threads; ++i) {
+    workers_.push_back(std::make_unique<Worker>(this, i));
+    workers_.back()->Start();
+  }
+}
+
+QuicCryptoThreadPool::~QuicCryptoThreadPool() {
+  {
+    QuicWriterMutexLock lock(&lock_);
+    stopping_ = true;
+  }
+  if (!workers_.empty()) {
+    AddToEventFd(work_fd_, workers_.size());
+  }
+  for (const std::unique_ptr<Worker>& worker : workers_) {
+    worker->Join();
+  }
+  if (epoll_server_ != nullptr) {
+    epoll_server_->UnregisterFD(done_fd_);
+  }
+  if (work_fd_ >= 0) {
+    close(work_fd_);
+  }
+  if (done_fd_ >= 0) {
+    close(done_fd_);
+  }
+}
+
+void QuicCryptoThreadPool::AttachToEpollServer(QuicEpollServer* epoll_server) {
+  DCHECK(epoll_server_ == nullptr);
+  if (done_fd_ < 0) {
+    return;
+  }
+  epoll_server_ = epoll_server;
+  epoll_server_->RegisterFD(done_fd_, this, EPOLLIN);
+}
+
+std::unique_ptr<ProofSource> QuicCryptoThreadPool::WrapProofSource(
+    std::unique_ptr<ProofSource> proof_source) {
+  return std::make_unique<ThreadPoolProofSource>(this, std::move(proof_source));
+}
+
+std::unique_ptr<KeyExchangeSource> QuicCryptoThreadPool::WrapKeyExchangeSource(
+    std::unique_ptr<KeyExchangeSource> key_exchange_source) {
+  return std::make_unique<ThreadPoolKeyExchangeSource>(
+      this, std::move(key_exchange_source));
+}
+
+void QuicCryptoThreadPool::Post(std::unique_ptr<Operation> operation) {
+  ++num_pending_operations_;
+  if (workers_.empty() || num_pending_operations_ > max_pending_operations_) {
+    // The operation still completes through the event loop, so that callers
+    // see the same ordering either way.
+    operation.release()->Start(this);
+    return;
+  }
+  {
+    QuicWriterMutexLock lock(&lock_);
+    queued_operations_.push_back(std::move(operation));
+  }
+  AddToEventFd(work_fd_, 1);
+}
+
+void QuicCryptoThreadPool::OnOperationDone(Operation* operation) {
+  if (done_fd_ < 0) {
+    // There are no pool threads, so this is the event loop thread, and there
+    // is no way to signal it later.
+    std::unique_ptr<Operation> done(operation);
+    DCHECK_LT(0u, num_pending_operations_);
+    --num_pending_operations_;
+    done->Complete();
+    return;
+  }
+  {
+    QuicWriterMutexLock lock(&lock_);
+    done_operations_.push_back(std::unique_ptr<Operation>(operation));
+  }
+  AddToEventFd(done_fd_, 1);
+}
+
+void QuicCryptoThreadPool::RunCompletions() {
+  std::vector<std::unique_ptr<Operation>> operations;
+  {
+    QuicWriterMutexLock lock(&lock_);
+    operations.swap(done_operations_);
+  }
+  for (const std::unique_ptr<Operation>& operation : operations) {
+    DCHECK_LT(0u, num_pending_operations_);
+    --num_pending_operations_;
+    operation->Complete();
+  }
+}
+
+void QuicCryptoThreadPool::OnEvent(int fd, QuicEpollEvent* event) {
+  DCHECK_EQ(fd, done_fd_);
+  event->out_ready_mask = 0;
+  uint64_t value;
+  while (read(done_fd_, &value, sizeof(value)) < 0 && errno == EINTR) {
+  }
+  RunCompletions();
+}
+
+std::unique_ptr<QuicCryptoThreadPool::Operation>
+QuicCryptoThreadPool::WaitForOperation() {
+  while (true) {
+    uint64_t value;
+    if (read(work_fd_, &value, sizeof(value)) < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      QUIC_LOG(ERROR) << "Failed to read eventfd: " << strerror(errno);
+      return nullptr;
+    }
+    QuicWriterMutexLock lock(&lock_);
+    if (stopping_) {
+      return nullptr;
+    }
+    if (queued_operations_.empty()) {
+      continue;
+    }
+    std::unique_ptr<Operation> operation =
+        std::move(queued_operations_.front());
+    queued_operations_.pop_front();
+    return operation;
+  }
+}
+
+}  // namespace quic
@@ -0,0 +1,136 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// A pool of threads which run the expensive parts of server handshakes,
+// certificate signing and key exchange, off the event loop thread.
+//
+// ProofSource and KeyExchangeSource already allow asynchronous completion.
+// The pool wraps existing implementations of both, runs their operations on
+// its threads, and runs the callbacks on the event loop thread once the
+// operations are done. The wrapped implementations must be safe to call from
+// several threads at once.
+
+#ifndef QUICHE_QUIC_TOOLS_QUIC_CRYPTO_THREAD_POOL_H_
+#define QUICHE_QUIC_TOOLS_QUIC_CRYPTO_THREAD_POOL_H_
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "net/third_party/quiche/src/quic/core/crypto/proof_source.h"
+#include "net/third_party/quiche/src/quic/core/crypto/quic_crypto_server_config.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_epoll.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_mutex.h"
+
+namespace quic {
+
+class QuicCryptoThreadPool : public QuicEpollCallbackInterface {
+ public:
+  // An operation which starts on a pool thread and completes on the event loop
+  // thread.
+  class Operation {
+   public:
+    virtual ~Operation() = default;
+
+    // Runs on a pool thread. Must call OnOperationDone() on |pool| exactly
+    // once, from any thread, when the result is ready, and before the pool is
+    // destroyed.
+    virtual void Start(QuicCryptoThreadPool* pool) = 0;
+
+    // Runs on the event loop thread after OnOperationDone().
+    virtual void Complete() = 0;
+  };
+
+  // Starts |num_threads| threads. At most |max_pending_operations| operations
+  // are queued or running at a time; further operations run on the calling
+  // thread.
+  QuicCryptoThreadPool(size_t num_threads, size_t max_pending_operations);
+  QuicCryptoThreadPool(const QuicCryptoThreadPool&) = delete;
+  QuicCryptoThreadPool& operator=(const QuicCryptoThreadPool&) = delete;
+
+  // Stops and joins the threads. Operations which have not completed are
+  // destroyed without running their callbacks. Must be destroyed before the
+  // sources it wraps.
+  ~QuicCryptoThreadPool() override;
+
+  // Runs completions on |epoll_server|, which must outlive the pool.
+  // Completions are held until this is called.
+  void AttachToEpollServer(QuicEpollServer* epoll_server);
+
+  // Returns a ProofSource which runs GetProof and ComputeTlsSignature of
+  // |proof_source| on the pool.
+  std::unique_ptr<ProofSource> WrapProofSource(
+      std::unique_ptr<ProofSource> proof_source);
+
+  // Returns a KeyExchangeSource whose key exchanges compute shared keys on the
+  // pool.
+  std::unique_ptr<KeyExchangeSource> WrapKeyExchangeSource(
+      std::unique_ptr<KeyExchangeSource> key_exchange_source);
+
+  // Queues |operation| to run on the pool, or starts it on the calling thread
+  // if the pool is full. Called on the event loop thread.
+  void Post(std::unique_ptr<Operation> operation);
+
+  // Hands |operation| back to the event loop thread. Thread safe. If the pool
+  // could not start its threads, completes |operation| right away.
+  void OnOperationDone(Operation* operation);
+
+  // Runs the completions of all finished operations. Called on the event loop
+  // thread.
+  void RunCompletions();
+
+  // Number of operations which have been posted but not completed.
+  size_t num_pending_operations() const { return num_pending_operations_; }
+
+  // Number of operations which can be posted before the pool is full. Servers
+  // limit the sessions they create per event loop to this, so that handshakes
+  // queue as buffered CHLOs instead of on the pool.
+  size_t available_capacity() const {
+    return num_pending_operations_ >= max_pending_operations_
+               ? 0
+               : max_pending_operations_ - num_pending_operations_;
+  }
+
+  // From QuicEpollCallbackInterface.
+  std::string Name() const override { return "QuicCryptoThreadPool"; }
+  void OnRegistration(QuicEpollServer* /*eps*/,
+                      int /*fd*/,
+                      int /*event_mask*/) override {}
+  void OnModification(int /*fd*/, int /*event_mask*/) override {}
+  void OnEvent(int fd, QuicEpollEvent* event) override;
+  void OnUnregistration(int /*fd*/, bool /*replaced*/) override {}
+  void OnShutdown(QuicEpollServer* /*eps*/, int /*fd*/) override {}
+
+ private:
+  class Worker;
+
+  // Blocks until an operation is queued, and returns it, or returns nullptr if
+  // the pool is stopping. Called on pool threads.
+  std::unique_ptr<Operation> WaitForOperation();
+
+  const size_t max_pending_operations_;
+  // Only accessed on the event loop thread.
+  size_t num_pending_operations_;
+
+  // Counts queued operations, and wakes pool threads.
+  int work_fd_;
+  // Signals finished operations to the event loop.
+  int done_fd_;
+
+  QuicEpollServer* epoll_server_;  // Unowned.
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+
+  QuicMutex lock_;
+  std::deque<std::unique_ptr<Operation>> queued_operations_
+      QUIC_GUARDED_BY(lock_);
+  std::vector<std::unique_ptr<Operation>> done_operations_
+      QUIC_GUARDED_BY(lock_);
+  bool stopping_ QUIC_GUARDED_BY(lock_);
+};
+
+}  // namespace quic
+
+#endif  // QUICHE_QUIC_TOOLS_QUIC_CRYPTO_THREAD_POOL_H_
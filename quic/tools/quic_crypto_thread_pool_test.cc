@@ -0,0 +1,172 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/third_party/quiche/src/quic/tools/quic_crypto_thread_pool.h"
+
+#include <memory>
+#include <string>
+
+#include "third_party/boringssl/src/include/openssl/ssl.h"
+#include "net/third_party/quiche/src/quic/core/crypto/crypto_protocol.h"
+#include "net/third_party/quiche/src/quic/core/crypto/curve25519_key_exchange.h"
+#include "net/third_party/quiche/src/quic/core/crypto/quic_random.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_test.h"
+#include "net/third_party/quiche/src/quic/test_tools/crypto_test_utils.h"
+
+namespace quic {
+namespace test {
+namespace {
+
+class QuicCryptoThreadPoolTest : public QuicTest {
+ protected:
+  QuicCryptoThreadPoolTest()
+      : pool_(/*num_threads=*/2, /*max_pending_operations=*/8) {
+    epoll_server_.set_timeout_in_us(10 * 1000);
+    pool_.AttachToEpollServer(&epoll_server_);
+  }
+
+  // Runs the event loop until |*done| is true.
+  void RunUntil(const bool* done) {
+    while (!*done) {
+      epoll_server_.WaitForEventsAndExecuteCallbacks();
+    }
+  }
+
+  QuicEpollServer epoll_server_;
+  QuicCryptoThreadPool pool_;
+};
+
+class TestSignatureCallback : public ProofSource::SignatureCallback {
+ public:
+  TestSignatureCallback(bool* done, bool* ok, std::string* signature)
+      : done_(done), ok_(ok), signature_(signature) {}
+
+  void Run(bool ok,
+           std::string signature,
+           std::unique_ptr<ProofSource::Details> /*details*/) override {
+    *done_ = true;
+    *ok_ = ok;
+    *signature_ = std::move(signature);
+  }
+
+ private:
+  bool* done_;
+  bool* ok_;
+  std::string* signature_;
+};
+
+class TestKeyExchangeCallback : public AsynchronousKeyExchange::Callback {
+ public:
+  TestKeyExchangeCallback(bool* done, bool* ok) : done_(done), ok_(ok) {}
+
+  void Run(bool ok) override {
+    *done_ = true;
+    *ok_ = ok;
+  }
+
+ private:
+  bool* done_;
+  bool* ok_;
+};
+
+// Counts the calls to Start and Complete.
+class CountingOperation : public QuicCryptoThreadPool::Operation {
+ public:
+  CountingOperation(int* num_started, int* num_completed)
+      : num_started_(num_started), num_completed_(num_completed) {}
+
+  void Start(QuicCryptoThreadPool* pool) override {
+    ++*num_started_;
+    pool->OnOperationDone(this);
+  }
+
+  void Complete() override { ++*num_completed_; }
+
+ private:
+  int* num_started_;
+  int* num_completed_;
+};
+
+TEST_F(QuicCryptoThreadPoolTest, ComputeTlsSignature) {
+  std::unique_ptr<ProofSource> proof_source =
+      pool_.WrapProofSource(crypto_test_utils::ProofSourceForTesting());
+  bool done = false;
+  bool ok = false;
+  std::string signature;
+  {
+    // The input only has to be valid during the call.
+    std::string in = "Test data";
+    proof_source->ComputeTlsSignature(
+        QuicSocketAddress(), QuicSocketAddress(), "test.example.com",
+        SSL_SIGN_RSA_PSS_RSAE_SHA256, in,
+        std::make_unique<TestSignatureCallback>(&done, &ok, &signature));
+  }
+  // Callbacks only run on the event loop.
+  EXPECT_FALSE(done);
+  EXPECT_EQ(1u, pool_.num_pending_operations());
+
+  RunUntil(&done);
+  EXPECT_TRUE(ok);
+  EXPECT_FALSE(signature.empty());
+  EXPECT_EQ(0u, pool_.num_pending_operations());
+}
+
+TEST_F(QuicCryptoThreadPoolTest, CalculateSharedKey) {
+  QuicRandom* rand = QuicRandom::GetInstance();
+  const std::string private_key = Curve25519KeyExchange::NewPrivateKey(rand);
+  std::unique_ptr<Curve25519KeyExchange> peer =
+      Curve25519KeyExchange::New(rand);
+
+  std::string expected_shared_key;
+  ASSERT_TRUE(Curve25519KeyExchange::New(private_key)
+                  ->CalculateSharedKeySync(peer->public_value(),
+                                           &expected_shared_key));
+
+  std::unique_ptr<KeyExchangeSource> key_exchange_source =
+      pool_.WrapKeyExchangeSource(KeyExchangeSource::Default());
+  std::unique_ptr<AsynchronousKeyExchange> key_exchange =
+      key_exchange_source->Create("server_config_id", /*is_fallback=*/false,
+                                  kC255, private_key);
+  ASSERT_TRUE(key_exchange != nullptr);
+  EXPECT_EQ(kC255, key_exchange->type());
+
+  bool done = false;
+  bool ok = false;
+  std::string shared_key;
+  key_exchange->CalculateSharedKeyAsync(
+      peer->public_value(), &shared_key,
+      std::make_unique<TestKeyExchangeCallback>(&done, &ok));
+  // The key exchange may be destroyed while the operation is running.
+  key_exchange.reset();
+
+  RunUntil(&done);
+  EXPECT_TRUE(ok);
+  EXPECT_EQ(expected_shared_key, shared_key);
+}
+
+TEST_F(QuicCryptoThreadPoolTest, RunsOnCallingThreadWhenFull) {
+  // Without threads, every operation starts on the calling thread.
+  QuicCryptoThreadPool pool(/*num_threads=*/0, /*max_pending_operations=*/2);
+  int num_started = 0;
+  int num_completed = 0;
+  EXPECT_EQ(2u, pool.available_capacity());
+
+  for (int i = 0; i < 3; ++i) {
+    pool.Post(std::make_unique<CountingOperation>(&num_started,
+                                                  &num_completed));
+  }
+  EXPECT_EQ(3, num_started);
+  EXPECT_EQ(0, num_completed);
+  EXPECT_EQ(3u, pool.num_pending_operations());
+  EXPECT_EQ(0u, pool.available_capacity());
+
+  pool.RunCompletions();
+  EXPECT_EQ(3, num_completed);
+  EXPECT_EQ(0u, pool.num_pending_operations());
+  EXPECT_EQ(2u, pool.available_capacity());
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace quic
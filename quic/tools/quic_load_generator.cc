@@ -0,0 +1,953 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/third_party/quiche/src/quic/tools/quic_load_generator.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/epoll.h>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <utility>
+
+#include "net/third_party/quiche/src/quic/core/crypto/quic_crypto_client_config.h"
+#include "net/third_party/quiche/src/quic/core/crypto/quic_random.h"
+#include "net/third_party/quiche/src/quic/core/crypto/transport_parameters.h"
+#include "net/third_party/quiche/src/quic/core/http/quic_spdy_client_stream.h"
+#include "net/third_party/quiche/src/quic/core/quic_alarm.h"
+#include "net/third_party/quiche/src/quic/core/quic_connection_id.h"
+#include "net/third_party/quiche/src/quic/core/quic_default_packet_writer.h"
+#include "net/third_party/quiche/src/quic/core/quic_epoll_alarm_factory.h"
+#include "net/third_party/quiche/src/quic/core/quic_epoll_connection_helper.h"
+#include "net/third_party/quiche/src/quic/core/quic_framer.h"
+#include "net/third_party/quiche/src/quic/core/quic_packet_reader.h"
+#include "net/third_party/quiche/src/quic/core/quic_process_packet_interface.h"
+#include "net/third_party/quiche/src/quic/core/quic_udp_socket.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_bug_tracker.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_containers.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_default_proof_providers.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_epoll.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_logging.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_thread.h"
+#include "net/quic/platform/impl/quic_epoll_clock.h"
+#include "net/third_party/quiche/src/quic/tools/fake_proof_verifier.h"
+#include "net/third_party/quiche/src/quic/tools/quic_simple_client_session.h"
+#include "net/third_party/quiche/src/quic/tools/quic_simple_client_stream.h"
+#include "net/third_party/quiche/src/quic/tools/quic_spdy_client_base.h"
+#include "net/third_party/quiche/src/common/platform/api/quiche_str_cat.h"
+#include "net/third_party/quiche/src/common/platform/api/quiche_text_utils.h"
+#include "net/third_party/quiche/src/spdy/core/spdy_header_block.h"
+
+namespace quic {
+
+namespace {
+
+const int kEpollFlags = EPOLLIN | EPOLLOUT | EPOLLET;
+
+// Length of the client connection IDs which demultiplex shared sockets.
+const uint8_t kClientConnectionIdLength = 8;
+
+// A UDP socket of a worker, which delivers the packets it receives to the
+// clients using it. A shared socket finds the client of a packet by its
+// destination connection ID; a dedicated socket has only one client.
+class LoadGeneratorSocket : public QuicEpollCallbackInterface,
+                            public ProcessPacketInterface {
+ public:
+  LoadGeneratorSocket(QuicEpollServer* epoll_server, bool shared)
+      : epoll_server_(epoll_server),
+        shared_(shared),
+        fd_(kQuicInvalidSocketFd),
+        packets_dropped_(0),
+        overflow_supported_(false),
+        packet_reader_(new QuicPacketReader()) {}
+  LoadGeneratorSocket(const LoadGeneratorSocket&) = delete;
+  LoadGeneratorSocket& operator=(const LoadGeneratorSocket&) = delete;
+
+  ~LoadGeneratorSocket() override {
+    if (fd_ != kQuicInvalidSocketFd) {
+      epoll_server_->UnregisterFD(fd_);
+      QuicUdpSocketApi().Destroy(fd_);
+    }
+  }
+
+  // Creates a socket for sending to |server_address|, bound to an ephemeral
+  // port.
+  bool Bind(const QuicSocketAddress& server_address) {
+    QuicUdpSocketApi socket_api;
+    fd_ = socket_api.Create(
+        server_address.host().AddressFamilyToInt(),
+        /*receive_buffer_size =*/kDefaultSocketReceiveBuffer,
+        /*send_buffer_size =*/kDefaultSocketReceiveBuffer);
+    if (fd_ == kQuicInvalidSocketFd) {
+      QUIC_LOG(ERROR) << "CreateSocket() failed: " << strerror(errno);
+      return false;
+    }
+    overflow_supported_ = socket_api.EnableDroppedPacketCount(fd_);
+    socket_api.EnableReceiveTimestamp(fd_);
+
+    const QuicIpAddress any =
+        server_address.host().address_family() == IpAddressFamily::IP_V4
+            ? QuicIpAddress::Any4()
+            : QuicIpAddress::Any6();
+    if (!socket_api.Bind(fd_, QuicSocketAddress(any, 0))) {
+      QUIC_LOG(ERROR) << "Bind failed: " << strerror(errno);
+      return false;
+    }
+    if (address_.FromSocket(fd_) != 0) {
+      QUIC_LOG(ERROR) << "Unable to get self address.  Error: "
+                      << strerror(errno);
+      return false;
+    }
+    epoll_server_->RegisterFD(fd_, this, kEpollFlags);
+    return true;
+  }
+
+  // Delivers packets for |connection_id| to |client|. A dedicated socket
+  // ignores |connection_id|.
+  void AddClient(const QuicConnectionId& connection_id,
+                 QuicClientBase* client) {
+    DCHECK(shared_ || clients_.empty());
+    clients_[connection_id] = client;
+  }
+
+  void RemoveClient(const QuicConnectionId& connection_id) {
+    clients_.erase(connection_id);
+  }
+
+  int fd() const { return fd_; }
+
+  const QuicSocketAddress& address() const { return address_; }
+
+  // From QuicEpollCallbackInterface.
+  std::string Name() const override { return "LoadGeneratorSocket"; }
+  void OnRegistration(QuicEpollServer* /*eps*/,
+                      int /*fd*/,
+                      int /*event_mask*/) override {}
+  void OnModification(int /*fd*/, int /*event_mask*/) override {}
+  void OnEvent(int fd, QuicEpollEvent* event) override {
+    DCHECK_EQ(fd, fd_);
+    if (event->in_events & EPOLLIN) {
+      bool more_to_read = true;
+      while (more_to_read) {
+        more_to_read = packet_reader_->ReadAndDispatchPackets(
+            fd_, address_.port(), QuicEpollClock(epoll_server_), this,
+            overflow_supported_ ? &packets_dropped_ : nullptr);
+      }
+    }
+    if (event->in_events & EPOLLOUT) {
+      for (const auto& entry : clients_) {
+        QuicClientBase* client = entry.second;
+        if (client->connected() && client->writer()->IsWriteBlocked()) {
+          client->writer()->SetWritable();
+          client->session()->connection()->OnCanWrite();
+        }
+      }
+    }
+  }
+  void OnUnregistration(int /*fd*/, bool /*replaced*/) override {}
+  void OnShutdown(QuicEpollServer* /*eps*/, int /*fd*/) override {}
+
+  // From ProcessPacketInterface.
+  void ProcessPacket(const QuicSocketAddress& self_address,
+                     const QuicSocketAddress& peer_address,
+                     const QuicReceivedPacket& packet) override {
+    QuicClientBase* client = FindClient(packet);
+    if (client == nullptr || !client->connected()) {
+      QUIC_DVLOG(1) << "Dropping packet for unknown or closed connection";
+      return;
+    }
+    client->session()->ProcessUdpPacket(self_address, peer_address, packet);
+  }
+
+ private:
+  QuicClientBase* FindClient(const QuicReceivedPacket& packet) const {
+    if (!shared_) {
+      return clients_.empty() ? nullptr : clients_.begin()->second;
+    }
+    PacketHeaderFormat format;
+    QuicLongHeaderType long_packet_type;
+    bool version_present;
+    bool has_length_prefix;
+    QuicVersionLabel version_label;
+    ParsedQuicVersion parsed_version = UnsupportedQuicVersion();
+    QuicConnectionId destination_connection_id;
+    QuicConnectionId source_connection_id;
+    bool retry_token_present;
+    quiche::QuicheStringPiece retry_token;
+    std::string detailed_error;
+    if (QuicFramer::ParsePublicHeaderDispatcher(
+            packet, kClientConnectionIdLength, &format, &long_packet_type,
+            &version_present, &has_length_prefix, &version_label,
+            &parsed_version, &destination_connection_id, &source_connection_id,
+            &retry_token_present, &retry_token,
+            &detailed_error) != QUIC_NO_ERROR) {
+      QUIC_DVLOG(1) << "Unable to parse packet header: " << detailed_error;
+      return nullptr;
+    }
+    auto it = clients_.find(destination_connection_id);
+    return it == clients_.end() ? nullptr : it->second;
+  }
+
+  QuicEpollServer* epoll_server_;  // Unowned.
+  const bool shared_;
+  QuicUdpSocketFd fd_;
+  QuicSocketAddress address_;
+  QuicPacketCount packets_dropped_;
+  bool overflow_supported_;
+  std::unique_ptr<QuicPacketReader> packet_reader_;
+  QuicHashMap<QuicConnectionId, QuicClientBase*, QuicConnectionIdHash>
+      clients_;
+};
+
+// Connects a client to either a shared socket of its worker or a socket of its
+// own. The worker drives the event loop, so RunEventLoop must not be called.
+class LoadGeneratorNetworkHelper : public QuicClientBase::NetworkHelper {
+ public:
+  LoadGeneratorNetworkHelper(QuicEpollServer* epoll_server,
+                             LoadGeneratorSocket* shared_socket,
+                             QuicClientBase* client)
+      : epoll_server_(epoll_server),
+        shared_socket_(shared_socket),
+        socket_(nullptr),
+        client_(client) {}
+  LoadGeneratorNetworkHelper(const LoadGeneratorNetworkHelper&) = delete;
+  LoadGeneratorNetworkHelper& operator=(const LoadGeneratorNetworkHelper&) =
+      delete;
+
+  ~LoadGeneratorNetworkHelper() override { CleanUpAllUDPSockets(); }
+
+  // Routes packets sent to |connection_id| on the shared socket to the
+  // client, in place of the connection ID used before.
+  void SetClientConnectionId(const QuicConnectionId& connection_id) {
+    if (socket_ != shared_socket_ || socket_ == nullptr) {
+      return;
+    }
+    socket_->RemoveClient(client_connection_id_);
+    client_connection_id_ = connection_id;
+    socket_->AddClient(client_connection_id_, client_);
+  }
+
+  // From QuicClientBase::NetworkHelper.
+  void RunEventLoop() override {
+    QUIC_BUG << "Load generator clients are driven by their worker";
+  }
+  bool CreateUDPSocketAndBind(QuicSocketAddress server_address,
+                              QuicIpAddress /*bind_to_address*/,
+                              int /*bind_to_port*/) override {
+    if (shared_socket_ != nullptr) {
+      socket_ = shared_socket_;
+      return true;
+    }
+    dedicated_socket_ =
+        std::make_unique<LoadGeneratorSocket>(epoll_server_, /*shared=*/false);
+    if (!dedicated_socket_->Bind(server_address)) {
+      dedicated_socket_.reset();
+      return false;
+    }
+    dedicated_socket_->AddClient(EmptyQuicConnectionId(), client_);
+    socket_ = dedicated_socket_.get();
+    return true;
+  }
+  void CleanUpAllUDPSockets() override {
+    if (socket_ == shared_socket_ && socket_ != nullptr) {
+      socket_->RemoveClient(client_connection_id_);
+      client_connection_id_ = EmptyQuicConnectionId();
+    }
+    dedicated_socket_.reset();
+    socket_ = nullptr;
+  }
+  QuicSocketAddress GetLatestClientAddress() const override {
+    return socket_ == nullptr ? QuicSocketAddress() : socket_->address();
+  }
+  QuicPacketWriter* CreateQuicPacketWriter() override {
+    DCHECK(socket_ != nullptr);
+    return new QuicDefaultPacketWriter(socket_->fd());
+  }
+
+ private:
+  QuicEpollServer* epoll_server_;        // Unowned.
+  LoadGeneratorSocket* shared_socket_;  // Unowned. May be nullptr.
+  // The socket in use, either |shared_socket_| or |dedicated_socket_|.
+  LoadGeneratorSocket* socket_;
+  std::unique_ptr<LoadGeneratorSocket> dedicated_socket_;
+  QuicClientBase* client_;  // Unowned.
+  QuicConnectionId client_connection_id_;
+};
+
+// Receives the events of a connection which the load generator measures.
+class LoadGeneratorSessionVisitor {
+ public:
+  virtual ~LoadGeneratorSessionVisitor() {}
+
+  // Called when 1-RTT keys become available.
+  virtual void OnHandshakeComplete() = 0;
+
+  // Called when the response headers of stream |id| have been received.
+  virtual void OnResponseHeaders(QuicStreamId id) = 0;
+
+  // Called when the connection may be able to send more requests, or has
+  // closed.
+  virtual void OnSessionChanged() = 0;
+};
+
+class LoadGeneratorStream : public QuicSimpleClientStream {
+ public:
+  LoadGeneratorStream(QuicStreamId id,
+                      QuicSpdyClientSession* session,
+                      LoadGeneratorSessionVisitor* visitor)
+      : QuicSimpleClientStream(id,
+                               session,
+                               BIDIRECTIONAL,
+                               /*drop_response_body=*/true),
+        visitor_(visitor) {}
+
+  void OnInitialHeadersComplete(bool fin,
+                                size_t frame_len,
+                                const QuicHeaderList& header_list) override {
+    QuicSimpleClientStream::OnInitialHeadersComplete(fin, frame_len,
+                                                     header_list);
+    visitor_->OnResponseHeaders(id());
+  }
+
+ private:
+  LoadGeneratorSessionVisitor* visitor_;  // Unowned.
+};
+
+class LoadGeneratorSession : public QuicSimpleClientSession {
+ public:
+  LoadGeneratorSession(const QuicConfig& config,
+                       const ParsedQuicVersionVector& supported_versions,
+                       QuicConnection* connection,
+                       const QuicServerId& server_id,
+                       QuicCryptoClientConfig* crypto_config,
+                       QuicClientPushPromiseIndex* push_promise_index,
+                       LoadGeneratorSessionVisitor* visitor)
+      : QuicSimpleClientSession(config,
+                                supported_versions,
+                                connection,
+                                server_id,
+                                crypto_config,
+                                push_promise_index,
+                                /*drop_response_body=*/true),
+        visitor_(visitor) {}
+
+  std::unique_ptr<QuicSpdyClientStream> CreateClientStream() override {
+    return std::make_unique<LoadGeneratorStream>(
+        GetNextOutgoingBidirectionalStreamId(), this, visitor_);
+  }
+
+  void SetDefaultEncryptionLevel(EncryptionLevel level) override {
+    QuicSimpleClientSession::SetDefaultEncryptionLevel(level);
+    // Google QUIC has 1-RTT keys once it is forward secure.
+    if (level == ENCRYPTION_FORWARD_SECURE &&
+        !connection()->version().UsesTls()) {
+      visitor_->OnHandshakeComplete();
+    } else {
+      visitor_->OnSessionChanged();
+    }
+  }
+
+  void OnOneRttKeysAvailable() override {
+    QuicSimpleClientSession::OnOneRttKeysAvailable();
+    visitor_->OnHandshakeComplete();
+  }
+
+  void OnConnectionClosed(const QuicConnectionCloseFrame& frame,
+                          ConnectionCloseSource source) override {
+    QuicSimpleClientSession::OnConnectionClosed(frame, source);
+    visitor_->OnSessionChanged();
+  }
+
+ private:
+  LoadGeneratorSessionVisitor* visitor_;  // Unowned.
+};
+
+// Keeps the TLS session ticket, transport parameters and application state of
+// the last connection of a client, so that its next connection can resume.
+// Every client connects to the same server, so only one entry is kept.
+class LoadGeneratorSessionCache : public SessionCache {
+ public:
+  LoadGeneratorSessionCache() = default;
+  LoadGeneratorSessionCache(const LoadGeneratorSessionCache&) = delete;
+  LoadGeneratorSessionCache& operator=(const LoadGeneratorSessionCache&) =
+      delete;
+  ~LoadGeneratorSessionCache() override = default;
+
+  void Insert(const QuicServerId& server_id,
+              bssl::UniquePtr<SSL_SESSION> session,
+              const TransportParameters& params,
+              const ApplicationState* application_state) override {
+    if (!(server_id_ == server_id)) {
+      server_id_ = server_id;
+      session_.reset();
+      application_state_.reset();
+    }
+    if (session != nullptr) {
+      session_ = std::move(session);
+    }
+    if (application_state != nullptr) {
+      application_state_ =
+          std::make_unique<ApplicationState>(*application_state);
+    }
+    params_ = std::make_unique<TransportParameters>(params);
+  }
+
+  std::unique_ptr<QuicResumptionState> Lookup(
+      const QuicServerId& server_id,
+      const SSL_CTX* /*ctx*/) override {
+    if (!(server_id_ == server_id) || session_ == nullptr) {
+      return nullptr;
+    }
+    // A ticket is used only once; the resumed connection receives a new one.
+    auto state = std::make_unique<QuicResumptionState>();
+    state->tls_session = std::move(session_);
+    state->transport_params = params_.get();
+    state->application_state = application_state_.get();
+    return state;
+  }
+
+  void ClearEarlyData(const QuicServerId& /*server_id*/) override {}
+
+ private:
+  QuicServerId server_id_;
+  bssl::UniquePtr<SSL_SESSION> session_;
+  std::unique_ptr<TransportParameters> params_;
+  std::unique_ptr<ApplicationState> application_state_;
+};
+
+// A client which makes one connection at a time, sends its requests as soon as
+// it can and records what it measures in the stats of its worker. Callbacks
+// only record events and ask the worker for an update; Update() sends requests
+// and decides whether the connection has finished, outside of any callback.
+class LoadGeneratorClient : public QuicSpdyClientBase,
+                            public LoadGeneratorSessionVisitor {
+ public:
+  class Visitor {
+   public:
+    virtual ~Visitor() {}
+
+    // Called when Update() should be called on |client|.
+    virtual void OnClientChanged(LoadGeneratorClient* client) = 0;
+  };
+
+  LoadGeneratorClient(const QuicLoadGenerator::Options& options,
+                      QuicEpollServer* epoll_server,
+                      LoadGeneratorSocket* shared_socket,
+                      std::unique_ptr<ProofVerifier> proof_verifier,
+                      std::unique_ptr<SessionCache> session_cache,
+                      Visitor* visitor,
+                      QuicLoadGenerator::Stats* stats)
+      : QuicSpdyClientBase(
+            options.server_id,
+            options.supported_versions,
+            options.config,
+            new QuicEpollConnectionHelper(epoll_server, QuicAllocator::SIMPLE),
+            new QuicEpollAlarmFactory(epoll_server),
+            std::make_unique<LoadGeneratorNetworkHelper>(epoll_server,
+                                                         shared_socket,
+                                                         this),
+            std::move(proof_verifier),
+            std::move(session_cache)),
+        options_(options),
+        visitor_(visitor),
+        stats_(stats),
+        next_request_(0),
+        requests_completed_(0),
+        handshake_complete_(false),
+        update_pending_(false) {
+    set_server_address(options.server_address);
+    set_store_response(false);
+    if (shared_socket != nullptr) {
+      set_client_connection_id_length(kClientConnectionIdLength);
+    }
+  }
+  LoadGeneratorClient(const LoadGeneratorClient&) = delete;
+  LoadGeneratorClient& operator=(const LoadGeneratorClient&) = delete;
+
+  ~LoadGeneratorClient() override {
+    if (connected()) {
+      Disconnect();
+    }
+  }
+
+  // Starts a connection which requests |paths|. Returns false if no socket
+  // could be created for it.
+  bool StartLoad(std::vector<std::string> paths) {
+    paths_ = std::move(paths);
+    next_request_ = 0;
+    requests_completed_ = 0;
+    requests_.clear();
+    handshake_complete_ = false;
+    update_pending_ = false;
+    if (!initialized() && !Initialize()) {
+      return false;
+    }
+    ++stats_->connections_started;
+    connect_time_ = Now();
+    StartConnect();
+    OnSessionChanged();
+    return true;
+  }
+
+  // Sends as many requests as the connection allows. Returns true, having
+  // recorded the outcome of the connection, once the handshake has completed
+  // and every response has been received, or once the connection has closed.
+  bool Update() {
+    update_pending_ = false;
+    if (handshake_complete_ && requests_completed_ == paths_.size()) {
+      Finish(/*succeeded=*/true);
+      return true;
+    }
+    if (!connected()) {
+      Finish(/*succeeded=*/false);
+      return true;
+    }
+    // CreateClientStream() would spin the event loop waiting for stream
+    // credit, so check for it first.
+    while (next_request_ < paths_.size() &&
+           requests_.size() < options_.concurrent_requests_per_connection &&
+           session()->IsEncryptionEstablished() &&
+           client_session()->CanOpenNextOutgoingBidirectionalStream()) {
+      QuicSpdyClientStream* stream = CreateClientStream();
+      if (stream == nullptr) {
+        break;
+      }
+      spdy::SpdyHeaderBlock headers;
+      headers[":method"] = "GET";
+      headers[":scheme"] = "https";
+      headers[":authority"] = server_id().host();
+      headers[":path"] = paths_[next_request_++];
+      requests_[stream->id()] = {Now(), false};
+      stream->SendRequest(std::move(headers), "", /*fin=*/true);
+    }
+    return false;
+  }
+
+  bool update_pending() const { return update_pending_; }
+
+  // From QuicSpdyClientBase.
+  std::unique_ptr<QuicSession> CreateQuicClientSession(
+      const ParsedQuicVersionVector& supported_versions,
+      QuicConnection* connection) override {
+    return std::make_unique<LoadGeneratorSession>(
+        *config(), supported_versions, connection, server_id(),
+        crypto_config(), push_promise_index(), this);
+  }
+  void OnClose(QuicSpdyStream* stream) override {
+    QuicSpdyClientBase::OnClose(stream);
+    auto it = requests_.find(stream->id());
+    if (it == requests_.end()) {
+      return;
+    }
+    const int response_code =
+        static_cast<QuicSpdyClientStream*>(stream)->response_code();
+    if (stream->stream_error() == QUIC_STREAM_NO_ERROR &&
+        response_code >= 200 && response_code < 300) {
+      ++stats_->requests_succeeded;
+      stats_->request_latency.Add(Now() - it->second.start_time);
+    } else {
+      ++stats_->requests_failed;
+    }
+    requests_.erase(it);
+    // Requests reset by the closing connection do not count as completed.
+    if (connected()) {
+      ++requests_completed_;
+    }
+    OnSessionChanged();
+  }
+
+  // From LoadGeneratorSessionVisitor.
+  void OnHandshakeComplete() override {
+    if (!handshake_complete_) {
+      handshake_complete_ = true;
+      stats_->handshake_latency.Add(Now() - connect_time_);
+    }
+    OnSessionChanged();
+  }
+  void OnResponseHeaders(QuicStreamId id) override {
+    auto it = requests_.find(id);
+    if (it == requests_.end() || it->second.received_headers) {
+      return;
+    }
+    it->second.received_headers = true;
+    stats_->time_to_first_byte.Add(Now() - it->second.start_time);
+  }
+  void OnSessionChanged() override {
+    if (!update_pending_) {
+      update_pending_ = true;
+      visitor_->OnClientChanged(this);
+    }
+  }
+
+ protected:
+  QuicConnectionId GetClientConnectionId() override {
+    QuicConnectionId connection_id =
+        QuicSpdyClientBase::GetClientConnectionId();
+    static_cast<LoadGeneratorNetworkHelper*>(network_helper())
+        ->SetClientConnectionId(connection_id);
+    return connection_id;
+  }
+
+ private:
+  struct Request {
+    QuicTime start_time;
+    bool received_headers;
+  };
+
+  QuicTime Now() { return helper()->GetClock()->ApproximateNow(); }
+
+  void Finish(bool succeeded) {
+    if (succeeded) {
+      ++stats_->connections_succeeded;
+      stats_->connection_latency.Add(Now() - connect_time_);
+    } else {
+      ++stats_->connections_failed;
+      ++stats_->connection_errors[session()->error()];
+    }
+    if (handshake_complete_ && EarlyDataAccepted()) {
+      ++stats_->early_data_accepted;
+    }
+  }
+
+  const QuicLoadGenerator::Options& options_;
+  Visitor* visitor_;                   // Unowned.
+  QuicLoadGenerator::Stats* stats_;  // Unowned.
+
+  std::vector<std::string> paths_;
+  // Index in |paths_| of the next request to send.
+  size_t next_request_;
+  size_t requests_completed_;
+  // Outstanding requests, by stream ID.
+  QuicHashMap<QuicStreamId, Request> requests_;
+  QuicTime connect_time_ = QuicTime::Zero();
+  bool handshake_complete_;
+  bool update_pending_;
+};
+
+}  // namespace
+
+// One event loop of the load generator, with its own sockets, clients and
+// stats. All methods except Run must be called before the thread is started.
+class QuicLoadGenerator::Worker : public QuicThread,
+                                  public LoadGeneratorClient::Visitor {
+ public:
+  Worker(const Options& options,
+         size_t index,
+         size_t num_connections,
+         double connections_per_second,
+         size_t max_open_connections)
+      : QuicThread(quiche::QuicheStrCat("quic_load_generator_worker_", index)),
+        options_(options),
+        num_connections_(num_connections),
+        connections_per_second_(connections_per_second),
+        max_open_connections_(max_open_connections),
+        alarm_factory_(&epoll_server_),
+        arrival_alarm_(alarm_factory_.CreateAlarm(new ArrivalDelegate(this))),
+        random_(QuicRandom::GetInstance()),
+        total_weight_(0),
+        next_socket_(0),
+        num_arrivals_(0),
+        next_arrival_time_(QuicTime::Zero()) {
+    epoll_server_.set_timeout_in_us(50 * 1000);
+    for (const RequestSpec& request : options_.request_mix) {
+      total_weight_ += request.weight;
+    }
+  }
+  Worker(const Worker&) = delete;
+  Worker& operator=(const Worker&) = delete;
+
+  ~Worker() override {
+    arrival_alarm_->Cancel();
+    open_clients_.clear();
+    idle_clients_.clear();
+  }
+
+  // Creates the shared sockets, if the clients can use them.
+  bool CreateSockets() {
+    const bool share_sockets = std::all_of(
+        options_.supported_versions.begin(), options_.supported_versions.end(),
+        [](const ParsedQuicVersion& version) {
+          return version.SupportsClientConnectionIds();
+        });
+    if (!share_sockets) {
+      return true;
+    }
+    for (size_t i = 0; i < std::max<size_t>(options_.sockets_per_worker, 1);
+         ++i) {
+      auto socket = std::make_unique<LoadGeneratorSocket>(&epoll_server_,
+                                                          /*shared=*/true);
+      if (!socket->Bind(options_.server_address)) {
+        return false;
+      }
+      sockets_.push_back(std::move(socket));
+    }
+    return true;
+  }
+
+  void Run() override {
+    if (num_connections_ > 0) {
+      next_arrival_time_ = QuicEpollClock(&epoll_server_).Now();
+      arrival_alarm_->Set(next_arrival_time_);
+    }
+    while (num_arrivals_ < num_connections_ || !open_clients_.empty()) {
+      epoll_server_.WaitForEventsAndExecuteCallbacks();
+      UpdateChangedClients();
+    }
+    open_clients_.clear();
+    idle_clients_.clear();
+  }
+
+  const Stats& stats() const { return stats_; }
+
+  // From LoadGeneratorClient::Visitor.
+  void OnClientChanged(LoadGeneratorClient* client) override {
+    changed_clients_.push_back(client);
+  }
+
+ private:
+  class ArrivalDelegate : public QuicAlarm::Delegate {
+   public:
+    explicit ArrivalDelegate(Worker* worker) : worker_(worker) {}
+
+    void OnAlarm() override { worker_->OnArrival(); }
+
+   private:
+    Worker* worker_;  // Unowned.
+  };
+
+  void OnArrival() {
+    ++num_arrivals_;
+    if (open_clients_.size() >= max_open_connections_) {
+      ++stats_.arrivals_dropped;
+    } else {
+      StartConnection();
+    }
+    if (num_arrivals_ < num_connections_) {
+      // Arrivals are scheduled from the previous arrival rather than from
+      // now, so that a slow event loop does not lower the offered load.
+      next_arrival_time_ = next_arrival_time_ + NextInterArrivalTime();
+      arrival_alarm_->Set(std::max(next_arrival_time_,
+                                   QuicEpollClock(&epoll_server_).Now()));
+    }
+  }
+
+  QuicTime::Delta NextInterArrivalTime() {
+    if (connections_per_second_ <= 0) {
+      return QuicTime::Delta::Zero();
+    }
+    double seconds = 1 / connections_per_second_;
+    if (options_.poisson_arrivals) {
+      // |u| takes the top 53 bits of a random number, so it is uniform in
+      // [0, 1) and log(1 - u) is finite.
+      const double u = std::ldexp(random_->RandUint64() >> 11, -53);
+      seconds *= -std::log(1 - u);
+    }
+    return QuicTime::Delta::FromMicroseconds(
+        static_cast<int64_t>(seconds * kNumMicrosPerSecond));
+  }
+
+  void StartConnection() {
+    std::unique_ptr<LoadGeneratorClient> client;
+    if (!idle_clients_.empty()) {
+      client = std::move(idle_clients_.back());
+      idle_clients_.pop_back();
+    } else {
+      client = CreateClient();
+    }
+    LoadGeneratorClient* raw_client = client.get();
+    if (!raw_client->StartLoad(ChooseRequests())) {
+      QUIC_LOG_FIRST_N(ERROR, 10) << "Failed to create a client socket";
+      ++stats_.connections_failed;
+      return;
+    }
+    open_clients_[raw_client] = std::move(client);
+  }
+
+  std::unique_ptr<LoadGeneratorClient> CreateClient() {
+    std::unique_ptr<ProofVerifier> proof_verifier;
+    if (options_.verify_certificates) {
+      proof_verifier = CreateDefaultProofVerifier(options_.server_id.host());
+    } else {
+      proof_verifier = std::make_unique<FakeProofVerifier>();
+    }
+    std::unique_ptr<SessionCache> session_cache;
+    if (options_.resume_sessions) {
+      session_cache = std::make_unique<LoadGeneratorSessionCache>();
+    }
+    LoadGeneratorSocket* socket = nullptr;
+    if (!sockets_.empty()) {
+      socket = sockets_[next_socket_++ % sockets_.size()].get();
+    }
+    return std::make_unique<LoadGeneratorClient>(
+        options_, &epoll_server_, socket, std::move(proof_verifier),
+        std::move(session_cache), this, &stats_);
+  }
+
+  // Draws the paths of one connection from the request mix.
+  std::vector<std::string> ChooseRequests() {
+    std::vector<std::string> paths;
+    paths.reserve(options_.requests_per_connection);
+    for (size_t i = 0; i < options_.requests_per_connection; ++i) {
+      uint64_t choice = random_->RandUint64() % total_weight_;
+      for (const RequestSpec& request : options_.request_mix) {
+        if (choice < request.weight) {
+          paths.push_back(request.path);
+          break;
+        }
+        choice -= request.weight;
+      }
+    }
+    return paths;
+  }
+
+  void UpdateChangedClients() {
+    std::vector<LoadGeneratorClient*> changed_clients;
+    changed_clients.swap(changed_clients_);
+    for (LoadGeneratorClient* client : changed_clients) {
+      auto it = open_clients_.find(client);
+      if (it == open_clients_.end() || !client->Update()) {
+        continue;
+      }
+      std::unique_ptr<LoadGeneratorClient> finished = std::move(it->second);
+      open_clients_.erase(it);
+      finished->Disconnect();
+      if (options_.resume_sessions) {
+        idle_clients_.push_back(std::move(finished));
+      }
+    }
+  }
+
+  const Options& options_;
+  const size_t num_connections_;
+  const double connections_per_second_;
+  const size_t max_open_connections_;
+
+  QuicEpollServer epoll_server_;
+  QuicEpollAlarmFactory alarm_factory_;
+  std::unique_ptr<QuicAlarm> arrival_alarm_;
+  QuicRandom* random_;  // Unowned.
+  uint64_t total_weight_;
+
+  std::vector<std::unique_ptr<LoadGeneratorSocket>> sockets_;
+  size_t next_socket_;
+  QuicHashMap<LoadGeneratorClient*, std::unique_ptr<LoadGeneratorClient>>
+      open_clients_;
+  // Clients kept for resumption. The most recently used is reused first.
+  std::vector<std::unique_ptr<LoadGeneratorClient>> idle_clients_;
+  // Clients whose Update() is due. May contain closed clients.
+  std::vector<LoadGeneratorClient*> changed_clients_;
+
+  size_t num_arrivals_;
+  QuicTime next_arrival_time_;
+  Stats stats_;
+};
+
+QuicLoadGenerator::Options::Options()
+    : verify_certificates(true),
+      num_workers(1),
+      sockets_per_worker(1),
+      num_connections(1),
+      connections_per_second(1),
+      poisson_arrivals(false),
+      max_open_connections(1000),
+      requests_per_connection(1),
+      concurrent_requests_per_connection(1),
+      resume_sessions(false) {}
+
+QuicLoadGenerator::Options::Options(const Options& other) = default;
+
+QuicLoadGenerator::Options::~Options() = default;
+
+QuicLoadGenerator::Stats::Stats()
+    : connections_started(0),
+      connections_succeeded(0),
+      connections_failed(0),
+      arrivals_dropped(0),
+      early_data_accepted(0),
+      requests_succeeded(0),
+      requests_failed(0) {}
+
+QuicLoadGenerator::Stats::Stats(const Stats& other) = default;
+
+QuicLoadGenerator::Stats::~Stats() = default;
+
+void QuicLoadGenerator::Stats::Merge(const Stats& other) {
+  connections_started += other.connections_started;
+  connections_succeeded += other.connections_succeeded;
+  connections_failed += other.connections_failed;
+  arrivals_dropped += other.arrivals_dropped;
+  early_data_accepted += other.early_data_accepted;
+  requests_succeeded += other.requests_succeeded;
+  requests_failed += other.requests_failed;
+  for (const auto& error : other.connection_errors) {
+    connection_errors[error.first] += error.second;
+  }
+  handshake_latency.Merge(other.handshake_latency);
+  time_to_first_byte.Merge(other.time_to_first_byte);
+  request_latency.Merge(other.request_latency);
+  connection_latency.Merge(other.connection_latency);
+}
+
+QuicLoadGenerator::QuicLoadGenerator(const Options& options)
+    : options_(options) {
+  DCHECK(!options_.request_mix.empty());
+  DCHECK_GT(options_.num_workers, 0u);
+  DCHECK_GT(options_.concurrent_requests_per_connection, 0u);
+}
+
+QuicLoadGenerator::~QuicLoadGenerator() = default;
+
+QuicLoadGenerator::Stats QuicLoadGenerator::Run() {
+  const size_t num_workers = std::max<size_t>(options_.num_workers, 1);
+  std::vector<std::unique_ptr<Worker>> workers;
+  for (size_t i = 0; i < num_workers; ++i) {
+    const size_t num_connections = options_.num_connections / num_workers +
+                                   (i < options_.num_connections % num_workers);
+    workers.push_back(std::make_unique<Worker>(
+        options_, i, num_connections,
+        options_.connections_per_second / num_workers,
+        std::max<size_t>(options_.max_open_connections / num_workers, 1)));
+    if (!workers.back()->CreateSockets()) {
+      QUIC_LOG(ERROR) << "Failed to create the sockets of worker " << i;
+      return Stats();
+    }
+  }
+  for (std::unique_ptr<Worker>& worker : workers) {
+    worker->Start();
+  }
+  Stats stats;
+  for (std::unique_ptr<Worker>& worker : workers) {
+    worker->Join();
+    stats.Merge(worker->stats());
+  }
+  return stats;
+}
+
+// static
+bool QuicLoadGenerator::ParseRequestMix(quiche::QuicheStringPiece spec,
+                                        std::vector<RequestSpec>* request_mix) {
+  request_mix->clear();
+  for (quiche::QuicheStringPiece entry :
+       quiche::QuicheTextUtils::Split(spec, ',')) {
+    RequestSpec request = {std::string(entry), 1};
+    const size_t colon = entry.rfind(':');
+    if (colon != quiche::QuicheStringPiece::npos) {
+      request.path = std::string(entry.substr(0, colon));
+      if (!quiche::QuicheTextUtils::StringToUint32(entry.substr(colon + 1),
+                                                   &request.weight) ||
+          request.weight == 0) {
+        return false;
+      }
+    }
+    if (request.path.empty() || request.path[0] != '/') {
+      return false;
+    }
+    request_mix->push_back(std::move(request));
+  }
+  return !request_mix->empty();
+}
+
+}  // namespace quic
@@ -0,0 +1,148 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// A load generator which keeps many QUIC connections to one server open at a
+// time, to find the load at which the server saturates.
+//
+// Each worker thread runs one event loop, which drives all of its connections.
+// Connections arrive at a configured rate, either evenly spaced or as a
+// Poisson process, send a configured number of HTTP requests drawn from a
+// weighted mix of paths, and close once every response has been received.
+// When the version supports client connection IDs, the connections of a worker
+// share a few UDP sockets and received packets are demultiplexed by
+// destination connection ID. Otherwise each connection has its own socket.
+//
+// With session resumption enabled, each worker reuses idle clients for new
+// connections, so that they resume with the session tickets and server
+// configs they cached on earlier connections and send their requests as
+// 0-RTT data.
+
+#ifndef QUICHE_QUIC_TOOLS_QUIC_LOAD_GENERATOR_H_
+#define QUICHE_QUIC_TOOLS_QUIC_LOAD_GENERATOR_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "net/third_party/quiche/src/quic/core/quic_config.h"
+#include "net/third_party/quiche/src/quic/core/quic_error_codes.h"
+#include "net/third_party/quiche/src/quic/core/quic_latency_histogram.h"
+#include "net/third_party/quiche/src/quic/core/quic_server_id.h"
+#include "net/third_party/quiche/src/quic/core/quic_time.h"
+#include "net/third_party/quiche/src/quic/core/quic_versions.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_socket_address.h"
+#include "net/third_party/quiche/src/common/platform/api/quiche_string_piece.h"
+
+namespace quic {
+
+class QuicLoadGenerator {
+ public:
+  // A path to request, and how often it is requested relative to the other
+  // paths of the mix.
+  struct RequestSpec {
+    std::string path;
+    uint32_t weight;
+  };
+
+  struct Options {
+    Options();
+    Options(const Options& other);
+    ~Options();
+
+    QuicSocketAddress server_address;
+    QuicServerId server_id;
+    ParsedQuicVersionVector supported_versions;
+    QuicConfig config;
+    // If false, server certificates are not verified.
+    bool verify_certificates;
+
+    // Number of threads, each with its own event loop.
+    size_t num_workers;
+    // Number of sockets shared by the connections of each worker, if the
+    // version supports client connection IDs.
+    size_t sockets_per_worker;
+
+    // Total number of connections to make, split evenly among the workers.
+    size_t num_connections;
+    // Rate at which connections are started, summed over all workers.
+    double connections_per_second;
+    // If true, the times between connections are exponentially distributed,
+    // as for independent clients. Otherwise they are all the same.
+    bool poisson_arrivals;
+    // Most connections open at a time, summed over all workers. Connections
+    // which arrive while this many are open are not made, and are counted as
+    // dropped arrivals.
+    size_t max_open_connections;
+
+    // Requests sent on each connection, and how many of them may be
+    // outstanding at a time.
+    size_t requests_per_connection;
+    size_t concurrent_requests_per_connection;
+    // The paths requested. Must not be empty.
+    std::vector<RequestSpec> request_mix;
+
+    // If true, new connections reuse idle clients so that they can resume
+    // earlier sessions.
+    bool resume_sessions;
+  };
+
+  struct Stats {
+    Stats();
+    Stats(const Stats& other);
+    ~Stats();
+
+    // Adds the counts and latencies of |other| to these.
+    void Merge(const Stats& other);
+
+    // Connections which were started, which received every response, and
+    // which were closed before that.
+    uint64_t connections_started;
+    uint64_t connections_succeeded;
+    uint64_t connections_failed;
+    // Connections which were not started, because too many were open.
+    uint64_t arrivals_dropped;
+    // Connections whose 0-RTT data was accepted by the server.
+    uint64_t early_data_accepted;
+    // Requests which received a 2xx response, and which did not.
+    uint64_t requests_succeeded;
+    uint64_t requests_failed;
+    // The errors of connections which failed.
+    std::map<QuicErrorCode, uint64_t> connection_errors;
+
+    // Time from starting a connection to having 1-RTT keys.
+    QuicLatencyHistogram handshake_latency;
+    // Time from sending a request to receiving its response headers.
+    QuicLatencyHistogram time_to_first_byte;
+    // Time from sending a request to receiving all of its response.
+    QuicLatencyHistogram request_latency;
+    // Time from starting a connection to receiving all of its responses.
+    QuicLatencyHistogram connection_latency;
+  };
+
+  explicit QuicLoadGenerator(const Options& options);
+  QuicLoadGenerator(const QuicLoadGenerator&) = delete;
+  QuicLoadGenerator& operator=(const QuicLoadGenerator&) = delete;
+  ~QuicLoadGenerator();
+
+  // Runs the workers until every connection has been made or dropped and has
+  // finished, and returns their combined stats.
+  Stats Run();
+
+  // Parses a request mix of the form "path[:weight],path[:weight],...", where
+  // weights default to 1. Returns false if |spec| is malformed.
+  static bool ParseRequestMix(quiche::QuicheStringPiece spec,
+                              std::vector<RequestSpec>* request_mix);
+
+ private:
+  class Worker;
+
+  const Options options_;
+};
+
+}  // namespace quic
+
+#endif  // QUICHE_QUIC_TOOLS_QUIC_LOAD_GENERATOR_H_
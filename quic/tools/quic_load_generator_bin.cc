@@ -0,0 +1,215 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Opens many QUIC connections to a server at a fixed rate and reports how many
+// succeeded and the latency distributions of their handshakes and requests.
+// Raising --connections_per_second until latencies climb or connections fail
+// finds the load at which the server saturates.
+//
+// Usage: quic_load_generator --host=127.0.0.1 --port=6121
+//            --connections_per_second=500 --num_connections=10000
+//            --requests=/index.html:9,/large:1 --num_threads=4
+
+#include <time.h>
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "net/third_party/quiche/src/quic/core/quic_server_id.h"
+#include "net/third_party/quiche/src/quic/core/quic_versions.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_flags.h"
+#include "net/third_party/quiche/src/quic/tools/quic_client.h"
+#include "net/third_party/quiche/src/quic/tools/quic_load_generator.h"
+#include "net/third_party/quiche/src/common/platform/api/quiche_str_cat.h"
+
+DEFINE_QUIC_COMMAND_LINE_FLAG(std::string,
+                              host,
+                              "127.0.0.1",
+                              "The IP or hostname to connect to.");
+
+DEFINE_QUIC_COMMAND_LINE_FLAG(int32_t, port, 6121, "The port to connect to.");
+
+DEFINE_QUIC_COMMAND_LINE_FLAG(
+    std::string,
+    server_name,
+    "",
+    "The server name sent in the handshake and requests. Defaults to --host.");
+
+DEFINE_QUIC_COMMAND_LINE_FLAG(
+    std::string,
+    quic_version,
+    "",
+    "QUIC versions to offer, e.g. h3-27. If not set, all supported versions "
+    "are offered.");
+
+DEFINE_QUIC_COMMAND_LINE_FLAG(int32_t,
+                              num_threads,
+                              1,
+                              "Number of threads which make connections.");
+
+DEFINE_QUIC_COMMAND_LINE_FLAG(int32_t,
+                              sockets_per_thread,
+                              4,
+                              "Number of UDP sockets each thread shares "
+                              "between its connections, if the version "
+                              "supports client connection IDs.");
+
+DEFINE_QUIC_COMMAND_LINE_FLAG(int32_t,
+                              num_connections,
+                              1000,
+                              "Number of connections to make.");
+
+DEFINE_QUIC_COMMAND_LINE_FLAG(double,
+                              connections_per_second,
+                              100,
+                              "Rate at which connections are started.");
+
+DEFINE_QUIC_COMMAND_LINE_FLAG(bool,
+                              poisson,
+                              true,
+                              "If true, connections arrive as a Poisson "
+                              "process. Otherwise they are evenly spaced.");
+
+DEFINE_QUIC_COMMAND_LINE_FLAG(int32_t,
+                              max_open_connections,
+                              10000,
+                              "Most connections open at a time. Connections "
+                              "arriving beyond this are dropped.");
+
+DEFINE_QUIC_COMMAND_LINE_FLAG(int32_t,
+                              requests_per_connection,
+                              1,
+                              "Number of requests sent on each connection.");
+
+DEFINE_QUIC_COMMAND_LINE_FLAG(int32_t,
+                              concurrent_requests,
+                              1,
+                              "Number of requests outstanding at a time on "
+                              "each connection.");
+
+DEFINE_QUIC_COMMAND_LINE_FLAG(std::string,
+                              requests,
+                              "/",
+                              "Paths to request, with optional relative "
+                              "weights, e.g. /small:9,/large:1.");
+
+DEFINE_QUIC_COMMAND_LINE_FLAG(bool,
+                              resume_sessions,
+                              false,
+                              "If true, connections resume earlier sessions "
+                              "and send their requests as 0-RTT data.");
+
+DEFINE_QUIC_COMMAND_LINE_FLAG(bool,
+                              disable_certificate_verification,
+                              false,
+                              "If true, don't verify the server certificate.");
+
+namespace quic {
+
+namespace {
+
+double MonotonicSeconds() {
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+int RunLoadGenerator() {
+  QuicLoadGenerator::Options options;
+  const std::string host = GetQuicFlag(FLAGS_host);
+  const int32_t port = GetQuicFlag(FLAGS_port);
+  options.server_address =
+      tools::LookupAddress(host, quiche::QuicheStrCat(port));
+  if (!options.server_address.IsInitialized()) {
+    std::cerr << "Unable to resolve address: " << host << std::endl;
+    return 1;
+  }
+  std::string server_name = GetQuicFlag(FLAGS_server_name);
+  if (server_name.empty()) {
+    server_name = host;
+  }
+  options.server_id = QuicServerId(server_name, port, false);
+
+  options.supported_versions = CurrentSupportedVersions();
+  const std::string quic_version_string = GetQuicFlag(FLAGS_quic_version);
+  if (!quic_version_string.empty()) {
+    options.supported_versions =
+        ParseQuicVersionVectorString(quic_version_string);
+  }
+  if (options.supported_versions.empty()) {
+    std::cerr << "No known version selected." << std::endl;
+    return 1;
+  }
+  for (const ParsedQuicVersion& version : options.supported_versions) {
+    QuicEnableVersion(version);
+  }
+
+  if (!QuicLoadGenerator::ParseRequestMix(GetQuicFlag(FLAGS_requests),
+                                          &options.request_mix)) {
+    std::cerr << "Invalid --requests: " << GetQuicFlag(FLAGS_requests)
+              << std::endl;
+    return 1;
+  }
+  options.verify_certificates =
+      !GetQuicFlag(FLAGS_disable_certificate_verification);
+  options.num_workers = std::max(GetQuicFlag(FLAGS_num_threads), 1);
+  options.sockets_per_worker =
+      std::max(GetQuicFlag(FLAGS_sockets_per_thread), 1);
+  options.num_connections = std::max(GetQuicFlag(FLAGS_num_connections), 0);
+  options.connections_per_second = GetQuicFlag(FLAGS_connections_per_second);
+  options.poisson_arrivals = GetQuicFlag(FLAGS_poisson);
+  options.max_open_connections =
+      std::max(GetQuicFlag(FLAGS_max_open_connections), 1);
+  options.requests_per_connection =
+      std::max(GetQuicFlag(FLAGS_requests_per_connection), 0);
+  options.concurrent_requests_per_connection =
+      std::max(GetQuicFlag(FLAGS_concurrent_requests), 1);
+  options.resume_sessions = GetQuicFlag(FLAGS_resume_sessions);
+
+  QuicLoadGenerator load_generator(options);
+  const double start_time = MonotonicSeconds();
+  const QuicLoadGenerator::Stats stats = load_generator.Run();
+  const double elapsed = MonotonicSeconds() - start_time;
+
+  std::cout << "connections: " << stats.connections_started
+            << ", succeeded: " << stats.connections_succeeded
+            << ", failed: " << stats.connections_failed
+            << ", dropped arrivals: " << stats.arrivals_dropped
+            << ", 0-RTT accepted: " << stats.early_data_accepted << std::endl;
+  for (const auto& error : stats.connection_errors) {
+    std::cout << "  " << QuicErrorCodeToString(error.first) << ": "
+              << error.second << std::endl;
+  }
+  std::cout << "requests succeeded: " << stats.requests_succeeded
+            << ", failed: " << stats.requests_failed << std::endl;
+  std::cout << "connections per second: "
+            << stats.connections_succeeded / elapsed
+            << ", requests per second: " << stats.requests_succeeded / elapsed
+            << std::endl;
+  std::cout << "handshake: " << stats.handshake_latency.ToString()
+            << std::endl;
+  std::cout << "time to first byte: " << stats.time_to_first_byte.ToString()
+            << std::endl;
+  std::cout << "request: " << stats.request_latency.ToString() << std::endl;
+  std::cout << "connection: " << stats.connection_latency.ToString()
+            << std::endl;
+  return stats.connections_failed == 0 ? 0 : 1;
+}
+
+}  // namespace
+
+}  // namespace quic
+
+int main(int argc, char* argv[]) {
+  const char* usage = "Usage: quic_load_generator [options]";
+  std::vector<std::string> args =
+      quic::QuicParseCommandLineFlags(usage, argc, argv);
+  if (!args.empty()) {
+    quic::QuicPrintCommandLineFlagHelp(usage);
+    exit(0);
+  }
+  return quic::RunLoadGenerator();
+}
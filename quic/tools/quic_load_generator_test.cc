@@ -0,0 +1,168 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/third_party/quiche/src/quic/tools/quic_load_generator.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "net/third_party/quiche/src/quic/platform/api/quic_socket_address.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_test.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_test_loopback.h"
+#include "net/third_party/quiche/src/quic/test_tools/fake_proof_source.h"
+#include "net/third_party/quiche/src/quic/test_tools/test_ticket_crypter.h"
+#include "net/third_party/quiche/src/quic/tools/quic_memory_cache_backend.h"
+#include "net/third_party/quiche/src/quic/tools/quic_multi_threaded_server.h"
+
+namespace quic {
+namespace test {
+namespace {
+
+const char kServerHostname[] = "www.example.org";
+
+class QuicLoadGeneratorTest : public QuicTest {
+ public:
+  QuicLoadGeneratorTest() {
+    backend_.AddSimpleResponse(kServerHostname, "/small", 200, "small");
+    backend_.AddSimpleResponse(kServerHostname, "/large", 200,
+                               std::string(20000, 'a'));
+  }
+
+  void SetUp() override {
+    // The server reads these when it creates its SSL_CTX, so they are set
+    // before it is constructed.
+    SetQuicReloadableFlag(quic_enable_tls_resumption_v2, true);
+    SetQuicReloadableFlag(quic_enable_zero_rtt_for_tls, true);
+    auto proof_source = std::make_unique<FakeProofSource>();
+    proof_source->SetTicketCrypter(std::make_unique<TestTicketCrypter>());
+    server_ = std::make_unique<QuicMultiThreadedServer>(
+        std::move(proof_source), &backend_, /*num_workers=*/2);
+    ASSERT_TRUE(server_->CreateUDPSocketAndListen(
+        QuicSocketAddress(TestLoopback(), 0)));
+    server_->Start();
+  }
+
+  void TearDown() override { server_->Shutdown(); }
+
+ protected:
+  QuicLoadGenerator::Options DefaultOptions() {
+    QuicLoadGenerator::Options options;
+    options.server_address =
+        QuicSocketAddress(TestLoopback(), server_->port());
+    options.server_id = QuicServerId(kServerHostname, server_->port(), false);
+    options.supported_versions = {CurrentSupportedVersions()[0]};
+    options.verify_certificates = false;
+    options.connections_per_second = 1000;
+    EXPECT_TRUE(QuicLoadGenerator::ParseRequestMix("/small:3,/large",
+                                                   &options.request_mix));
+    return options;
+  }
+
+  QuicMemoryCacheBackend backend_;
+  std::unique_ptr<QuicMultiThreadedServer> server_;
+};
+
+TEST_F(QuicLoadGeneratorTest, ParseRequestMix) {
+  std::vector<QuicLoadGenerator::RequestSpec> request_mix;
+  ASSERT_TRUE(QuicLoadGenerator::ParseRequestMix("/a:3,/b,/c:d:2",
+                                                 &request_mix));
+  ASSERT_EQ(3u, request_mix.size());
+  EXPECT_EQ("/a", request_mix[0].path);
+  EXPECT_EQ(3u, request_mix[0].weight);
+  EXPECT_EQ("/b", request_mix[1].path);
+  EXPECT_EQ(1u, request_mix[1].weight);
+  EXPECT_EQ("/c:d", request_mix[2].path);
+  EXPECT_EQ(2u, request_mix[2].weight);
+
+  EXPECT_FALSE(QuicLoadGenerator::ParseRequestMix("", &request_mix));
+  EXPECT_FALSE(QuicLoadGenerator::ParseRequestMix("/a,", &request_mix));
+  EXPECT_FALSE(QuicLoadGenerator::ParseRequestMix("a", &request_mix));
+  EXPECT_FALSE(QuicLoadGenerator::ParseRequestMix("/a:0", &request_mix));
+  EXPECT_FALSE(QuicLoadGenerator::ParseRequestMix("/a:x", &request_mix));
+}
+
+TEST_F(QuicLoadGeneratorTest, EveryConnectionReceivesItsResponses) {
+  QuicLoadGenerator::Options options = DefaultOptions();
+  options.num_workers = 2;
+  options.num_connections = 20;
+  options.requests_per_connection = 3;
+  options.concurrent_requests_per_connection = 2;
+
+  const QuicLoadGenerator::Stats stats = QuicLoadGenerator(options).Run();
+  EXPECT_EQ(20u, stats.connections_started);
+  EXPECT_EQ(20u, stats.connections_succeeded);
+  EXPECT_EQ(0u, stats.connections_failed);
+  EXPECT_EQ(0u, stats.arrivals_dropped);
+  EXPECT_EQ(60u, stats.requests_succeeded);
+  EXPECT_EQ(0u, stats.requests_failed);
+  EXPECT_EQ(20u, stats.handshake_latency.count());
+  EXPECT_EQ(60u, stats.time_to_first_byte.count());
+  EXPECT_EQ(60u, stats.request_latency.count());
+  EXPECT_EQ(20u, stats.connection_latency.count());
+}
+
+TEST_F(QuicLoadGeneratorTest, UnknownPathsFail) {
+  QuicLoadGenerator::Options options = DefaultOptions();
+  options.num_connections = 2;
+  ASSERT_TRUE(
+      QuicLoadGenerator::ParseRequestMix("/missing", &options.request_mix));
+
+  const QuicLoadGenerator::Stats stats = QuicLoadGenerator(options).Run();
+  EXPECT_EQ(2u, stats.connections_succeeded);
+  EXPECT_EQ(0u, stats.requests_succeeded);
+  EXPECT_EQ(2u, stats.requests_failed);
+}
+
+TEST_F(QuicLoadGeneratorTest, ResumedConnectionsSendEarlyData) {
+  QuicLoadGenerator::Options options = DefaultOptions();
+  // Google QUIC crypto resumes with the server config cached by the client.
+  options.supported_versions.clear();
+  for (const ParsedQuicVersion& version : CurrentSupportedVersions()) {
+    if (version.handshake_protocol == PROTOCOL_QUIC_CRYPTO) {
+      options.supported_versions.push_back(version);
+      break;
+    }
+  }
+  if (options.supported_versions.empty()) {
+    return;
+  }
+  // Connections arrive one at a time, so that each reuses the previous
+  // client.
+  options.num_connections = 5;
+  options.connections_per_second = 20;
+  options.poisson_arrivals = false;
+  options.resume_sessions = true;
+
+  const QuicLoadGenerator::Stats stats = QuicLoadGenerator(options).Run();
+  EXPECT_EQ(5u, stats.connections_succeeded);
+  EXPECT_LT(0u, stats.early_data_accepted);
+}
+
+TEST_F(QuicLoadGeneratorTest, ResumedTlsConnectionsSendEarlyData) {
+  QuicLoadGenerator::Options options = DefaultOptions();
+  // TLS resumes with the session ticket kept in the client's session cache.
+  options.supported_versions.clear();
+  for (const ParsedQuicVersion& version : CurrentSupportedVersions()) {
+    if (version.handshake_protocol == PROTOCOL_TLS1_3) {
+      options.supported_versions.push_back(version);
+      break;
+    }
+  }
+  if (options.supported_versions.empty()) {
+    return;
+  }
+  options.num_connections = 5;
+  options.connections_per_second = 20;
+  options.poisson_arrivals = false;
+  options.resume_sessions = true;
+
+  const QuicLoadGenerator::Stats stats = QuicLoadGenerator(options).Run();
+  EXPECT_EQ(5u, stats.connections_succeeded);
+  EXPECT_LT(0u, stats.early_data_accepted);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace quic
@@ -0,0 +1,472 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/third_party/quiche/src/quic/tools/quic_multi_threaded_server.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+
+#if defined(__linux__)
+#include <linux/filter.h>
+#endif
+
+#include <memory>
+#include <utility>
+
+#include "net/third_party/quiche/src/quic/core/crypto/quic_random.h"
+#include "net/third_party/quiche/src/quic/core/quic_default_packet_writer.h"
+#include "net/third_party/quiche/src/quic/core/quic_epoll_alarm_factory.h"
+#include "net/third_party/quiche/src/quic/core/quic_epoll_connection_helper.h"
+#include "net/third_party/quiche/src/quic/core/quic_packet_reader.h"
+#include "net/third_party/quiche/src/quic/core/quic_udp_socket.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_epoll.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_logging.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_mutex.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_thread.h"
+#include "net/quic/platform/impl/quic_epoll_clock.h"
+#include "net/third_party/quiche/src/quic/tools/quic_simple_crypto_server_stream_helper.h"
+#include "net/third_party/quiche/src/quic/tools/quic_simple_dispatcher.h"
+#include "net/third_party/quiche/src/common/platform/api/quiche_str_cat.h"
+
+#if defined(__linux__) && !defined(SO_ATTACH_REUSEPORT_CBPF)
+#define SO_ATTACH_REUSEPORT_CBPF 51
+#endif
+
+namespace quic {
+
+namespace {
+
+const int kEpollFlags = EPOLLIN | EPOLLOUT | EPOLLET;
+const char kSourceAddressTokenSecret[] = "secret";
+const size_t kNumSessionsToCreatePerSocketEvent = 16;
+
+// The first byte of a connection ID can encode at most 256 workers.
+const size_t kMaxNumWorkers = 256;
+
+}  // namespace
+
+// A dispatcher which stamps its worker index into every server connection ID
+// it picks, and forwards packets for connection IDs owned by other workers.
+class QuicMultiThreadedServer::WorkerDispatcher : public QuicSimpleDispatcher {
+ public:
+  WorkerDispatcher(
+      QuicMultiThreadedServer* server,
+      size_t worker_index,
+      QuicVersionManager* version_manager,
+      std::unique_ptr<QuicConnectionHelperInterface> helper,
+      std::unique_ptr<QuicCryptoServerStreamBase::Helper> session_helper,
+      std::unique_ptr<QuicAlarmFactory> alarm_factory)
+      : QuicSimpleDispatcher(&server->config_,
+                             &server->crypto_config_,
+                             version_manager,
+                             std::move(helper),
+                             std::move(session_helper),
+                             std::move(alarm_factory),
+                             server->quic_simple_server_backend_,
+                             server->expected_server_connection_id_length_),
+        server_(server),
+        worker_index_(worker_index) {}
+
+ protected:
+  bool OnFailedToDispatchPacket(
+      const ReceivedPacketInfo& packet_info) override {
+    const size_t owner = GetWorkerIndexForConnectionId(
+        packet_info.destination_connection_id, server_->num_workers());
+    if (owner == worker_index_) {
+      return false;
+    }
+    QUIC_CODE_COUNT(quic_multi_threaded_server_forwarded_packet);
+    server_->ForwardPacket(owner, packet_info.self_address,
+                           packet_info.peer_address, packet_info.packet);
+    return true;
+  }
+
+  QuicConnectionId ReplaceShortServerConnectionId(
+      const ParsedQuicVersion& version,
+      const QuicConnectionId& server_connection_id,
+      uint8_t expected_server_connection_id_length) const override {
+    return StampWorkerIndex(
+        QuicSimpleDispatcher::ReplaceShortServerConnectionId(
+            version, server_connection_id,
+            expected_server_connection_id_length));
+  }
+
+  QuicConnectionId ReplaceLongServerConnectionId(
+      const ParsedQuicVersion& version,
+      const QuicConnectionId& server_connection_id,
+      uint8_t expected_server_connection_id_length) const override {
+    return StampWorkerIndex(
+        QuicSimpleDispatcher::ReplaceLongServerConnectionId(
+            version, server_connection_id,
+            expected_server_connection_id_length));
+  }
+
+ private:
+  QuicConnectionId StampWorkerIndex(QuicConnectionId connection_id) const {
+    if (!connection_id.IsEmpty()) {
+      connection_id.mutable_data()[0] = static_cast<char>(worker_index_);
+    }
+    return connection_id;
+  }
+
+  QuicMultiThreadedServer* server_;  // Unowned.
+  const size_t worker_index_;
+};
+
+// One event loop of the server. All methods except EnqueueForwardedPacket and
+// Quit must be called either before the thread is started or on the thread
+// itself.
+class QuicMultiThreadedServer::Worker : public QuicThread,
+                                        public QuicEpollCallbackInterface {
+ public:
+  Worker(QuicMultiThreadedServer* server, size_t index)
+      : QuicThread(quiche::QuicheStrCat("quic_server_worker_", index)),
+        server_(server),
+        index_(index),
+        version_manager_(server->supported_versions_),
+        fd_(kQuicInvalidSocketFd),
+        port_(0),
+        packets_dropped_(0),
+        overflow_supported_(false),
+        packet_reader_(new QuicPacketReader()) {
+    epoll_server_.set_timeout_in_us(50 * 1000);
+  }
+  Worker(const Worker&) = delete;
+  Worker& operator=(const Worker&) = delete;
+
+  ~Worker() override { QuicUdpSocketApi().Destroy(fd_); }
+
+  // Creates a socket bound to |address| with SO_REUSEPORT and the dispatcher
+  // which serves it.
+  bool Listen(const QuicSocketAddress& address) {
+    QuicUdpSocketApi socket_api;
+    fd_ = socket_api.Create(
+        address.host().AddressFamilyToInt(),
+        /*receive_buffer_size =*/kDefaultSocketReceiveBuffer,
+        /*send_buffer_size =*/kDefaultSocketReceiveBuffer);
+    if (fd_ == kQuicInvalidSocketFd) {
+      QUIC_LOG(ERROR) << "CreateSocket() failed: " << strerror(errno);
+      return false;
+    }
+
+    int reuse_port = 1;
+    if (setsockopt(fd_, SOL_SOCKET, SO_REUSEPORT, &reuse_port,
+                   sizeof(reuse_port)) != 0) {
+      QUIC_LOG(ERROR) << "Failed to set SO_REUSEPORT: " << strerror(errno);
+      return false;
+    }
+
+    overflow_supported_ = socket_api.EnableDroppedPacketCount(fd_);
+    socket_api.EnableReceiveTimestamp(fd_);
+
+    if (!socket_api.Bind(fd_, address)) {
+      QUIC_LOG(ERROR) << "Bind failed: " << strerror(errno);
+      return false;
+    }
+    QuicSocketAddress bound_address;
+    if (bound_address.FromSocket(fd_) != 0) {
+      QUIC_LOG(ERROR) << "Unable to get self address.  Error: "
+                      << strerror(errno);
+      return false;
+    }
+    port_ = bound_address.port();
+
+    epoll_server_.RegisterFD(fd_, this, kEpollFlags);
+    dispatcher_ = std::make_unique<WorkerDispatcher>(
+        server_, index_, &version_manager_,
+        std::make_unique<QuicEpollConnectionHelper>(
+            &epoll_server_, QuicAllocator::BUFFER_POOL),
+        std::make_unique<QuicSimpleCryptoServerStreamHelper>(),
+        std::make_unique<QuicEpollAlarmFactory>(&epoll_server_));
+    dispatcher_->InitializeWithWriter(new QuicDefaultPacketWriter(fd_));
+    return true;
+  }
+
+  void Run() override {
+    if (dispatcher_ == nullptr) {
+      QUIC_BUG << "Worker " << index_ << " started without a socket";
+      return;
+    }
+    while (!quit_.HasBeenNotified()) {
+      epoll_server_.WaitForEventsAndExecuteCallbacks();
+      ProcessForwardedPackets();
+    }
+    dispatcher_->Shutdown();
+    epoll_server_.Shutdown();
+  }
+
+  // Asks the worker thread to exit. Thread safe.
+  void Quit() {
+    quit_.Notify();
+    epoll_server_.Wake();
+  }
+
+  // Queues a packet received by another worker. Thread safe.
+  void EnqueueForwardedPacket(const QuicSocketAddress& self_address,
+                              const QuicSocketAddress& peer_address,
+                              const QuicReceivedPacket& packet) {
+    // The receive buffer of |packet| belongs to the pool of the worker which
+    // read it, and must not be referenced from this one.
+    std::unique_ptr<QuicReceivedPacket> copy = packet.CopyToHeap();
+    {
+      QuicWriterMutexLock lock(&forwarded_packets_lock_);
+      forwarded_packets_.push_back(
+          {self_address, peer_address, std::move(copy)});
+    }
+    epoll_server_.Wake();
+  }
+
+  int fd() const { return fd_; }
+
+  int port() const { return port_; }
+
+  // From QuicEpollCallbackInterface.
+  std::string Name() const override {
+    return "QuicMultiThreadedServer::Worker";
+  }
+  void OnRegistration(QuicEpollServer* /*eps*/,
+                      int /*fd*/,
+                      int /*event_mask*/) override {}
+  void OnModification(int /*fd*/, int /*event_mask*/) override {}
+  void OnEvent(int fd, QuicEpollEvent* event) override {
+    DCHECK_EQ(fd, fd_);
+    event->out_ready_mask = 0;
+
+    if (event->in_events & EPOLLIN) {
+      dispatcher_->ProcessBufferedChlos(kNumSessionsToCreatePerSocketEvent);
+
+      bool more_to_read = true;
+      while (more_to_read) {
+        more_to_read = packet_reader_->ReadAndDispatchPackets(
+            fd_, port_, QuicEpollClock(&epoll_server_), dispatcher_.get(),
+            overflow_supported_ ? &packets_dropped_ : nullptr);
+      }
+
+      if (dispatcher_->HasChlosBuffered()) {
+        // Register EPOLLIN event to consume buffered CHLO(s).
+        event->out_ready_mask |= EPOLLIN;
+      }
+    }
+    if (event->in_events & EPOLLOUT) {
+      dispatcher_->OnCanWrite();
+      if (dispatcher_->HasPendingWrites()) {
+        event->out_ready_mask |= EPOLLOUT;
+      }
+    }
+  }
+  void OnUnregistration(int /*fd*/, bool /*replaced*/) override {}
+  void OnShutdown(QuicEpollServer* /*eps*/, int /*fd*/) override {}
+
+ private:
+  struct ForwardedPacket {
+    QuicSocketAddress self_address;
+    QuicSocketAddress peer_address;
+    std::unique_ptr<QuicReceivedPacket> packet;
+  };
+
+  void ProcessForwardedPackets() {
+    std::vector<ForwardedPacket> packets;
+    {
+      QuicWriterMutexLock lock(&forwarded_packets_lock_);
+      packets.swap(forwarded_packets_);
+    }
+    for (const ForwardedPacket& forwarded : packets) {
+      dispatcher_->ProcessPacket(forwarded.self_address,
+                                 forwarded.peer_address, *forwarded.packet);
+    }
+  }
+
+  QuicMultiThreadedServer* server_;  // Unowned.
+  const size_t index_;
+
+  QuicVersionManager version_manager_;
+  QuicEpollServer epoll_server_;
+  QuicUdpSocketFd fd_;
+  int port_;
+  QuicPacketCount packets_dropped_;
+  bool overflow_supported_;
+  std::unique_ptr<QuicPacketReader> packet_reader_;
+  std::unique_ptr<QuicDispatcher> dispatcher_;
+
+  QuicNotification quit_;
+
+  QuicMutex forwarded_packets_lock_;
+  std::vector<ForwardedPacket> forwarded_packets_
+      QUIC_GUARDED_BY(forwarded_packets_lock_);
+};
+
+QuicMultiThreadedServer::QuicMultiThreadedServer(
+    std::unique_ptr<ProofSource> proof_source,
+    QuicSimpleServerBackend* quic_simple_server_backend,
+    size_t num_workers)
+    : QuicMultiThreadedServer(std::move(proof_source),
+                              QuicConfig(),
+                              QuicCryptoServerConfig::ConfigOptions(),
+                              AllSupportedVersions(),
+                              quic_simple_server_backend,
+                              kQuicDefaultConnectionIdLength,
+                              num_workers) {}
+
+QuicMultiThreadedServer::QuicMultiThreadedServer(
+    std::unique_ptr<ProofSource> proof_source,
+    const QuicConfig& config,
+    const QuicCryptoServerConfig::ConfigOptions& crypto_config_options,
+    const ParsedQuicVersionVector& supported_versions,
+    QuicSimpleServerBackend* quic_simple_server_backend,
+    uint8_t expected_server_connection_id_length,
+    size_t num_workers)
+    : config_(config),
+      crypto_config_(kSourceAddressTokenSecret,
+                     QuicRandom::GetInstance(),
+                     std::move(proof_source),
+                     KeyExchangeSource::Default()),
+      crypto_config_options_(crypto_config_options),
+      supported_versions_(supported_versions),
+      quic_simple_server_backend_(quic_simple_server_backend),
+      expected_server_connection_id_length_(
+          expected_server_connection_id_length),
+      port_(0),
+      kernel_steering_enabled_(false),
+      started_(false) {
+  DCHECK(quic_simple_server_backend_);
+  DCHECK_GT(num_workers, 0u);
+  if (num_workers > kMaxNumWorkers) {
+    QUIC_BUG << "Too many workers: " << num_workers;
+    num_workers = kMaxNumWorkers;
+  }
+
+  // If an initial flow control window has not explicitly been set, then use a
+  // sensible value for a server: 1 MB for session, 64 KB for each stream.
+  const uint32_t kInitialSessionFlowControlWindow = 1 * 1024 * 1024;  // 1 MB
+  const uint32_t kInitialStreamFlowControlWindow = 64 * 1024;         // 64 KB
+  if (config_.GetInitialStreamFlowControlWindowToSend() ==
+      kDefaultFlowControlSendWindow) {
+    config_.SetInitialStreamFlowControlWindowToSend(
+        kInitialStreamFlowControlWindow);
+  }
+  if (config_.GetInitialSessionFlowControlWindowToSend() ==
+      kDefaultFlowControlSendWindow) {
+    config_.SetInitialSessionFlowControlWindowToSend(
+        kInitialSessionFlowControlWindow);
+  }
+
+  for (size_t i = 0; i < num_workers; ++i) {
+    workers_.push_back(std::make_unique<Worker>(this, i));
+  }
+
+  QuicEpollServer epoll_server;
+  QuicEpollClock clock(&epoll_server);
+  std::unique_ptr<CryptoHandshakeMessage> scfg(crypto_config_.AddDefaultConfig(
+      QuicRandom::GetInstance(), &clock, crypto_config_options_));
+}
+
+QuicMultiThreadedServer::~QuicMultiThreadedServer() {
+  Shutdown();
+}
+
+bool QuicMultiThreadedServer::CreateUDPSocketAndListen(
+    const QuicSocketAddress& address) {
+  QuicSocketAddress listen_address = address;
+  for (std::unique_ptr<Worker>& worker : workers_) {
+    if (!worker->Listen(listen_address)) {
+      return false;
+    }
+    // All workers must share the port picked for the first one.
+    listen_address = QuicSocketAddress(address.host(), worker->port());
+  }
+  port_ = listen_address.port();
+  QUIC_LOG(INFO) << "Listening on " << listen_address.ToString() << " with "
+                 << workers_.size() << " workers";
+
+  kernel_steering_enabled_ = AttachSteeringProgram(workers_[0]->fd());
+  if (!kernel_steering_enabled_) {
+    QUIC_LOG(WARNING) << "Unable to attach reuseport steering program, "
+                         "packets will be forwarded between workers.";
+  }
+  return true;
+}
+
+void QuicMultiThreadedServer::HandleEventsForever() {
+  Start();
+  // The workers only exit when asked to, and are joined by Shutdown().
+  workers_stopped_.WaitForNotification();
+}
+
+void QuicMultiThreadedServer::Start() {
+  if (started_.exchange(true)) {
+    return;
+  }
+  for (std::unique_ptr<Worker>& worker : workers_) {
+    worker->Start();
+  }
+}
+
+void QuicMultiThreadedServer::Shutdown() {
+  if (!started_.exchange(false)) {
+    return;
+  }
+  for (std::unique_ptr<Worker>& worker : workers_) {
+    worker->Quit();
+  }
+  for (std::unique_ptr<Worker>& worker : workers_) {
+    worker->Join();
+  }
+  workers_stopped_.Notify();
+}
+
+// static
+size_t QuicMultiThreadedServer::GetWorkerIndexForConnectionId(
+    const QuicConnectionId& connection_id,
+    size_t num_workers) {
+  if (connection_id.IsEmpty() || num_workers == 0) {
+    return 0;
+  }
+  return static_cast<uint8_t>(connection_id.data()[0]) % num_workers;
+}
+
+void QuicMultiThreadedServer::ForwardPacket(
+    size_t worker_index,
+    const QuicSocketAddress& self_address,
+    const QuicSocketAddress& peer_address,
+    const QuicReceivedPacket& packet) {
+  DCHECK_LT(worker_index, workers_.size());
+  workers_[worker_index]->EnqueueForwardedPacket(self_address, peer_address,
+                                                 packet);
+}
+
+bool QuicMultiThreadedServer::AttachSteeringProgram(int fd) {
+#if defined(__linux__)
+  // The program runs with the UDP payload at offset 0 and returns the index
+  // of the socket within the reuseport group, which is the bind order and
+  // therefore the worker index. The destination connection ID starts at
+  // offset 1 in short headers and at offset 6 in long headers.
+  sock_filter code[] = {
+      // A = first byte of the packet.
+      BPF_STMT(BPF_LD | BPF_B | BPF_ABS, 0),
+      // If the long header bit is set, fall through, otherwise skip 2.
+      BPF_JUMP(BPF_JMP | BPF_JSET | BPF_K, 0x80, 0, 2),
+      // Long header: A = first byte of the destination connection ID.
+      BPF_STMT(BPF_LD | BPF_B | BPF_ABS, 6),
+      BPF_JUMP(BPF_JMP | BPF_JA, 1, 0, 0),
+      // Short header: A = first byte of the destination connection ID.
+      BPF_STMT(BPF_LD | BPF_B | BPF_ABS, 1),
+      // A = A % num_workers.
+      BPF_STMT(BPF_ALU | BPF_MOD | BPF_K,
+               static_cast<uint32_t>(workers_.size())),
+      BPF_STMT(BPF_RET | BPF_A, 0),
+  };
+  sock_fprog program;
+  program.len = sizeof(code) / sizeof(code[0]);
+  program.filter = code;
+  return setsockopt(fd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &program,
+                    sizeof(program)) == 0;
+#else
+  (void)fd;
+  return false;
+#endif
+}
+
+}  // namespace quic
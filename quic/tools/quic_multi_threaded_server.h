@@ -0,0 +1,130 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// A server which runs several independent QUIC event loops, one per worker
+// thread, all listening on the same address via SO_REUSEPORT.
+//
+// Each worker owns its own socket, QuicEpollServer, QuicDispatcher and, through
+// the dispatcher, its own QuicTimeWaitListManager. The QuicConfig,
+// QuicCryptoServerConfig, QuicVersionManager and backend are shared between
+// the workers.
+//
+// Server connection IDs encode the index of the worker which owns the
+// connection in their first byte. Packets are steered to the owning worker
+// by a classic BPF reuseport program when the kernel supports one. Otherwise,
+// or if a packet reaches the wrong worker anyway, the receiving worker
+// forwards it to the owner in user space.
+
+#ifndef QUICHE_QUIC_TOOLS_QUIC_MULTI_THREADED_SERVER_H_
+#define QUICHE_QUIC_TOOLS_QUIC_MULTI_THREADED_SERVER_H_
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "net/third_party/quiche/src/quic/core/crypto/quic_crypto_server_config.h"
+#include "net/third_party/quiche/src/quic/core/quic_config.h"
+#include "net/third_party/quiche/src/quic/core/quic_connection_id.h"
+#include "net/third_party/quiche/src/quic/core/quic_packets.h"
+#include "net/third_party/quiche/src/quic/core/quic_version_manager.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_mutex.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_socket_address.h"
+#include "net/third_party/quiche/src/quic/tools/quic_simple_server_backend.h"
+#include "net/third_party/quiche/src/quic/tools/quic_spdy_server_base.h"
+
+namespace quic {
+
+namespace test {
+class QuicMultiThreadedServerPeer;
+}  // namespace test
+
+class QuicMultiThreadedServer : public QuicSpdyServerBase {
+ public:
+  QuicMultiThreadedServer(std::unique_ptr<ProofSource> proof_source,
+                          QuicSimpleServerBackend* quic_simple_server_backend,
+                          size_t num_workers);
+  QuicMultiThreadedServer(
+      std::unique_ptr<ProofSource> proof_source,
+      const QuicConfig& config,
+      const QuicCryptoServerConfig::ConfigOptions& crypto_config_options,
+      const ParsedQuicVersionVector& supported_versions,
+      QuicSimpleServerBackend* quic_simple_server_backend,
+      uint8_t expected_server_connection_id_length,
+      size_t num_workers);
+  QuicMultiThreadedServer(const QuicMultiThreadedServer&) = delete;
+  QuicMultiThreadedServer& operator=(const QuicMultiThreadedServer&) = delete;
+
+  ~QuicMultiThreadedServer() override;
+
+  // Creates one socket per worker, all bound to |address| with SO_REUSEPORT,
+  // and tries to attach the connection ID steering program to them.
+  bool CreateUDPSocketAndListen(const QuicSocketAddress& address) override;
+
+  // Starts the worker threads and waits for them. Does not return unless
+  // Shutdown() is called from another thread.
+  void HandleEventsForever() override;
+
+  // Starts the worker threads and returns immediately.
+  void Start();
+
+  // Stops all worker threads, closing their connections, and waits for them
+  // to exit.
+  void Shutdown();
+
+  // Returns the index of the worker which owns |connection_id|.
+  static size_t GetWorkerIndexForConnectionId(
+      const QuicConnectionId& connection_id,
+      size_t num_workers);
+
+  size_t num_workers() const { return workers_.size(); }
+
+  int port() const { return port_; }
+
+  // True if packets are steered to workers by the kernel. If false, steering
+  // relies entirely on user-space forwarding between workers.
+  bool kernel_steering_enabled() const { return kernel_steering_enabled_; }
+
+ private:
+  friend class quic::test::QuicMultiThreadedServerPeer;
+
+  class Worker;
+  class WorkerDispatcher;
+
+  // Hands |packet| to worker |worker_index|. Called on the receiving worker's
+  // thread.
+  void ForwardPacket(size_t worker_index,
+                     const QuicSocketAddress& self_address,
+                     const QuicSocketAddress& peer_address,
+                     const QuicReceivedPacket& packet);
+
+  // Attaches a reuseport program which picks the socket from the first byte
+  // of the destination connection ID. Returns false if not supported.
+  bool AttachSteeringProgram(int fd);
+
+  // Shared by all workers.
+  QuicConfig config_;
+  QuicCryptoServerConfig crypto_config_;
+  QuicCryptoServerConfig::ConfigOptions crypto_config_options_;
+  // Each worker has its own QuicVersionManager built from these, since the
+  // manager refilters its versions in place when flags change.
+  const ParsedQuicVersionVector supported_versions_;
+  QuicSimpleServerBackend* quic_simple_server_backend_;  // Unowned.
+  uint8_t expected_server_connection_id_length_;
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+
+  // The port the server is listening on.
+  int port_;
+
+  bool kernel_steering_enabled_;
+
+  // Written by Start() and Shutdown(), which may run on different threads.
+  std::atomic<bool> started_;
+  // Notified once Shutdown() has joined the workers.
+  QuicNotification workers_stopped_;
+};
+
+}  // namespace quic
+
+#endif  // QUICHE_QUIC_TOOLS_QUIC_MULTI_THREADED_SERVER_H_
@@ -0,0 +1,145 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/third_party/quiche/src/quic/tools/quic_multi_threaded_server.h"
+
+#include <memory>
+
+#include "net/third_party/quiche/src/quic/core/quic_clock.h"
+#include "net/third_party/quiche/src/quic/core/quic_packet_writer_wrapper.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_socket_address.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_test.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_test_loopback.h"
+#include "net/third_party/quiche/src/quic/test_tools/crypto_test_utils.h"
+#include "net/third_party/quiche/src/quic/test_tools/quic_multi_threaded_server_peer.h"
+#include "net/third_party/quiche/src/quic/test_tools/quic_test_client.h"
+#include "net/third_party/quiche/src/quic/test_tools/quic_test_utils.h"
+#include "net/third_party/quiche/src/quic/tools/quic_memory_cache_backend.h"
+
+namespace quic {
+namespace test {
+namespace {
+
+// A client writer which, once diverted, hands packets straight to a chosen
+// worker of the server instead of sending them, so that they reach that
+// worker rather than the one the kernel would pick.
+class DivertingPacketWriter : public QuicPacketWriterWrapper {
+ public:
+  DivertingPacketWriter(QuicMultiThreadedServer* server, const QuicClock* clock)
+      : server_(server), clock_(clock), diverted_(false), worker_index_(0) {}
+
+  WriteResult WritePacket(const char* buffer,
+                          size_t buf_len,
+                          const QuicIpAddress& self_address,
+                          const QuicSocketAddress& peer_address,
+                          PerPacketOptions* options) override {
+    if (!diverted_) {
+      return QuicPacketWriterWrapper::WritePacket(
+          buffer, buf_len, self_address, peer_address, options);
+    }
+    QuicReceivedPacket packet(buffer, buf_len, clock_->Now());
+    QuicMultiThreadedServerPeer::ReceivePacketOnWorker(
+        server_, worker_index_, peer_address, client_address_, packet);
+    return WriteResult(WRITE_STATUS_OK, buf_len);
+  }
+
+  // Diverts all further packets to worker |worker_index|, as if they came
+  // from |client_address|.
+  void DivertTo(size_t worker_index, const QuicSocketAddress& client_address) {
+    diverted_ = true;
+    worker_index_ = worker_index;
+    client_address_ = client_address;
+  }
+
+ private:
+  QuicMultiThreadedServer* server_;  // Unowned.
+  const QuicClock* clock_;           // Unowned.
+  bool diverted_;
+  size_t worker_index_;
+  QuicSocketAddress client_address_;
+};
+
+class QuicMultiThreadedServerTest : public QuicTest {
+ public:
+  QuicMultiThreadedServerTest()
+      : server_(crypto_test_utils::ProofSourceForTesting(),
+                &quic_simple_server_backend_,
+                /*num_workers=*/4) {}
+
+ protected:
+  QuicMemoryCacheBackend quic_simple_server_backend_;
+  QuicMultiThreadedServer server_;
+};
+
+TEST_F(QuicMultiThreadedServerTest, WorkerIndexForConnectionId) {
+  EXPECT_EQ(0u, QuicMultiThreadedServer::GetWorkerIndexForConnectionId(
+                    EmptyQuicConnectionId(), 4));
+  char connection_id_bytes[8] = {0x07, 0x01, 0x02, 0x03,
+                                 0x04, 0x05, 0x06, 0x07};
+  QuicConnectionId connection_id(connection_id_bytes,
+                                 sizeof(connection_id_bytes));
+  EXPECT_EQ(3u, QuicMultiThreadedServer::GetWorkerIndexForConnectionId(
+                    connection_id, 4));
+  EXPECT_EQ(0u, QuicMultiThreadedServer::GetWorkerIndexForConnectionId(
+                    connection_id, 1));
+
+  // The first byte is treated as unsigned.
+  connection_id_bytes[0] = static_cast<char>(0xff);
+  connection_id =
+      QuicConnectionId(connection_id_bytes, sizeof(connection_id_bytes));
+  EXPECT_EQ(255u % 7, QuicMultiThreadedServer::GetWorkerIndexForConnectionId(
+                          connection_id, 7));
+}
+
+TEST_F(QuicMultiThreadedServerTest, WorkersShareOnePort) {
+  EXPECT_EQ(4u, server_.num_workers());
+  ASSERT_TRUE(
+      server_.CreateUDPSocketAndListen(QuicSocketAddress(TestLoopback(), 0)));
+  EXPECT_NE(0, server_.port());
+  if (!server_.kernel_steering_enabled()) {
+    QUIC_LOG(INFO) << "Reuseport steering is not supported";
+  }
+  server_.Start();
+  server_.Shutdown();
+}
+
+TEST_F(QuicMultiThreadedServerTest, PacketsOnWrongWorkerReachTheirSession) {
+  quic_simple_server_backend_.AddSimpleResponse("test.example.com", "/foo",
+                                                200, "bar");
+  ASSERT_TRUE(
+      server_.CreateUDPSocketAndListen(QuicSocketAddress(TestLoopback(), 0)));
+  server_.Start();
+
+  QuicTestClient client(QuicSocketAddress(TestLoopback(), server_.port()),
+                        "test.example.com", CurrentSupportedVersions());
+  // Owned by |client|.
+  DivertingPacketWriter* writer = new DivertingPacketWriter(
+      &server_, client.client()->helper()->GetClock());
+  client.UseWriter(writer);
+  client.Connect();
+  ASSERT_TRUE(client.connected());
+  EXPECT_EQ("bar", client.SendSynchronousRequest("/foo"));
+
+  // The worker which created the connection stamped its index into the
+  // server connection ID. Deliver the next request to another worker, which
+  // has to forward it to the owner.
+  const size_t owner = QuicMultiThreadedServer::GetWorkerIndexForConnectionId(
+      client.client()->client_session()->connection()->connection_id(),
+      server_.num_workers());
+  const size_t wrong_worker = (owner + 1) % server_.num_workers();
+  writer->DivertTo(
+      wrong_worker,
+      QuicSocketAddress(
+          TestLoopback(),
+          client.client()->network_helper()->GetLatestClientAddress().port()));
+  EXPECT_EQ("bar", client.SendSynchronousRequest("/foo"));
+  EXPECT_TRUE(client.connected());
+
+  client.Disconnect();
+  server_.Shutdown();
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace quic
@@ -0,0 +1,249 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Runs congestion control algorithms through simulated networks, such as a
+// deep buffer, a shallow buffer, a policer, a lossy link, a changing round
+// trip time and competing flows, and reports the goodput, queueing delay, loss
+// and fairness each achieves. The results can be saved, as a serialized
+// SendAlgorithmBenchmarkResults, and compared against a saved baseline, in
+// which case the exit status is non-zero if any metric regressed or any run
+// has no baseline.
+//
+// Usage: quic_send_algorithm_benchmark --congestion_controls=cubic,bbr2
+//            --output_file=/tmp/new.pb --baseline_file=/tmp/old.pb
+//            --num_threads=8
+
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "net/third_party/quiche/src/quic/platform/api/quic_file_utils.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_flags.h"
+#include "net/third_party/quiche/src/quic/test_tools/send_algorithm_benchmark.h"
+#include "net/third_party/quiche/src/quic/test_tools/send_algorithm_test_result.pb.h"
+#include "net/third_party/quiche/src/quic/test_tools/simulator/parallel_simulations.h"
+#include "net/third_party/quiche/src/common/platform/api/quiche_str_cat.h"
+#include "net/third_party/quiche/src/common/platform/api/quiche_text_utils.h"
+
+DEFINE_QUIC_COMMAND_LINE_FLAG(std::string,
+                              scenarios,
+                              "",
+                              "Comma-separated scenarios to run. If not set, "
+                              "all of them are run.");
+
+DEFINE_QUIC_COMMAND_LINE_FLAG(std::string,
+                              congestion_controls,
+                              "cubic,bbr,bbr2",
+                              "Comma-separated congestion controls to run "
+                              "each scenario with: cubic, reno, bbr or bbr2.");
+
+DEFINE_QUIC_COMMAND_LINE_FLAG(int32_t,
+                              random_seed,
+                              1,
+                              "Seed of the random generator of every run.");
+
+DEFINE_QUIC_COMMAND_LINE_FLAG(int32_t,
+                              num_threads,
+                              1,
+                              "Number of runs simulated at a time.");
+
+DEFINE_QUIC_COMMAND_LINE_FLAG(std::string,
+                              output_file,
+                              "",
+                              "If set, the results are written to this file.");
+
+DEFINE_QUIC_COMMAND_LINE_FLAG(std::string,
+                              baseline_file,
+                              "",
+                              "If set, the results are compared to the ones "
+                              "in this file, written by an earlier run.");
+
+DEFINE_QUIC_COMMAND_LINE_FLAG(double,
+                              tolerance,
+                              0.05,
+                              "Fraction by which a metric may get worse than "
+                              "in the baseline before it is a regression.");
+
+namespace quic {
+namespace test {
+
+namespace {
+
+bool SelectScenarios(std::vector<SendAlgorithmBenchmarkScenario>* scenarios) {
+  *scenarios = DefaultSendAlgorithmBenchmarks();
+  const std::string names = GetQuicFlag(FLAGS_scenarios);
+  if (names.empty()) {
+    return true;
+  }
+  std::vector<SendAlgorithmBenchmarkScenario> selected;
+  for (quiche::QuicheStringPiece name :
+       quiche::QuicheTextUtils::Split(names, ',')) {
+    bool found = false;
+    for (const SendAlgorithmBenchmarkScenario& scenario : *scenarios) {
+      if (scenario.name == name) {
+        selected.push_back(scenario);
+        found = true;
+        break;
+      }
+    }
+    if (!found) {
+      std::cerr << "Unknown scenario: " << name << std::endl;
+      return false;
+    }
+  }
+  *scenarios = selected;
+  return true;
+}
+
+bool SelectCongestionControls(
+    std::vector<CongestionControlType>* congestion_controls) {
+  for (quiche::QuicheStringPiece name : quiche::QuicheTextUtils::Split(
+           GetQuicFlag(FLAGS_congestion_controls), ',')) {
+    CongestionControlType congestion_control;
+    if (!ParseCongestionControlName(name, &congestion_control)) {
+      std::cerr << "Unknown congestion control: " << name << std::endl;
+      return false;
+    }
+    congestion_controls->push_back(congestion_control);
+  }
+  return !congestion_controls->empty();
+}
+
+void PrintResults(const SendAlgorithmBenchmarkResults& results) {
+  std::cout << quiche::QuicheStringPrintf(
+      "%-16s %-6s %12s %6s %10s %10s %7s %8s\n", "scenario", "cc",
+      "goodput_bps", "util", "qdelay_p50", "qdelay_p99", "loss", "fairness");
+  for (const SendAlgorithmBenchmarkResult& result : results.results()) {
+    std::cout << quiche::QuicheStringPrintf(
+        "%-16s %-6s %12lld %6.3f %8.1fms %8.1fms %7.4f %8.3f\n",
+        result.scenario().c_str(), result.congestion_control().c_str(),
+        static_cast<long long>(result.goodput_bits_per_second()),
+        result.link_utilization(), result.queueing_delay_p50_micros() / 1e3,
+        result.queueing_delay_p99_micros() / 1e3, result.loss_rate(),
+        result.jain_fairness_index());
+  }
+}
+
+// Returns false if any result regressed from its baseline, or has none.
+bool CompareToBaseline(const SendAlgorithmBenchmarkResults& results,
+                       const SendAlgorithmBenchmarkResults& baseline) {
+  bool all_have_baselines = true;
+  std::vector<std::string> regressions;
+  for (const SendAlgorithmBenchmarkResult& result : results.results()) {
+    const SendAlgorithmBenchmarkResult* baseline_result = nullptr;
+    for (const SendAlgorithmBenchmarkResult& candidate : baseline.results()) {
+      if (candidate.scenario() == result.scenario() &&
+          candidate.congestion_control() == result.congestion_control()) {
+        baseline_result = &candidate;
+        break;
+      }
+    }
+    if (baseline_result == nullptr) {
+      std::cerr << "No baseline for " << result.scenario() << "/"
+                << result.congestion_control() << std::endl;
+      all_have_baselines = false;
+      continue;
+    }
+    if (baseline_result->random_seed() != result.random_seed()) {
+      std::cout << "Baseline for " << result.scenario() << "/"
+                << result.congestion_control()
+                << " was run with a different seed" << std::endl;
+    }
+    CompareSendAlgorithmBenchmarkResult(*baseline_result, result,
+                                        GetQuicFlag(FLAGS_tolerance),
+                                        &regressions);
+  }
+  for (const std::string& regression : regressions) {
+    std::cout << "REGRESSION: " << regression << std::endl;
+  }
+  return all_have_baselines && regressions.empty();
+}
+
+int RunBenchmarks() {
+  std::vector<SendAlgorithmBenchmarkScenario> scenarios;
+  std::vector<CongestionControlType> congestion_controls;
+  if (!SelectScenarios(&scenarios) ||
+      !SelectCongestionControls(&congestion_controls)) {
+    return 1;
+  }
+
+  SendAlgorithmBenchmarkResults baseline;
+  const std::string baseline_file = GetQuicFlag(FLAGS_baseline_file);
+  if (!baseline_file.empty()) {
+    std::string contents;
+    ReadFileContents(baseline_file, &contents);
+    if (contents.empty()) {
+      // A missing baseline must not make every comparison pass.
+      std::cerr << "Unable to read baseline: " << baseline_file << std::endl;
+      return 1;
+    }
+    if (!baseline.ParseFromString(contents)) {
+      std::cerr << "Unable to parse baseline: " << baseline_file << std::endl;
+      return 1;
+    }
+  }
+
+  // Every run writes its own slot, so that the results are in the same order
+  // whatever the number of threads.
+  const uint64_t random_seed = GetQuicFlag(FLAGS_random_seed);
+  std::vector<SendAlgorithmBenchmarkResult> run_results(
+      scenarios.size() * congestion_controls.size());
+  std::vector<std::function<void()>> simulations;
+  for (size_t i = 0; i < scenarios.size(); ++i) {
+    for (size_t j = 0; j < congestion_controls.size(); ++j) {
+      SendAlgorithmBenchmarkResult* result =
+          &run_results[i * congestion_controls.size() + j];
+      const SendAlgorithmBenchmarkScenario& scenario = scenarios[i];
+      const CongestionControlType congestion_control = congestion_controls[j];
+      simulations.push_back(
+          [result, &scenario, congestion_control, random_seed]() {
+            *result = RunSendAlgorithmBenchmark(scenario, congestion_control,
+                                                random_seed);
+          });
+    }
+  }
+  simulator::RunSimulationsInParallel(
+      std::move(simulations), std::max(GetQuicFlag(FLAGS_num_threads), 1));
+
+  SendAlgorithmBenchmarkResults results;
+  for (const SendAlgorithmBenchmarkResult& result : run_results) {
+    *results.add_results() = result;
+  }
+  PrintResults(results);
+
+  const std::string output_file = GetQuicFlag(FLAGS_output_file);
+  if (!output_file.empty()) {
+    std::ofstream output(output_file, std::ios::binary);
+    output << results.SerializeAsString();
+    if (!output) {
+      std::cerr << "Unable to write results to " << output_file << std::endl;
+      return 1;
+    }
+  }
+
+  if (!baseline_file.empty() && !CompareToBaseline(results, baseline)) {
+    return 1;
+  }
+  return 0;
+}
+
+}  // namespace
+
+}  // namespace test
+}  // namespace quic
+
+int main(int argc, char* argv[]) {
+  const char* usage = "Usage: quic_send_algorithm_benchmark [options]";
+  std::vector<std::string> args =
+      quic::QuicParseCommandLineFlags(usage, argc, argv);
+  if (!args.empty()) {
+    quic::QuicPrintCommandLineFlagHelp(usage);
+    exit(0);
+  }
+  return quic::test::RunBenchmarks();
+}
@@ -11,6 +11,7 @@
 #include <sys/epoll.h>
 #include <sys/socket.h>
 
+#include <algorithm>
 #include <cstdint>
 #include <memory>
 
@@ -39,6 +40,25 @@ namespace {
 const int kEpollFlags = EPOLLIN | EPOLLOUT | EPOLLET;
 const char kSourceAddressTokenSecret[] = "secret";
 
+std::unique_ptr<ProofSource> MaybeWrapProofSource(
+    QuicCryptoThreadPool* crypto_thread_pool,
+    std::unique_ptr<ProofSource> proof_source) {
+  if (crypto_thread_pool == nullptr) {
+    return proof_source;
+  }
+  return crypto_thread_pool->WrapProofSource(std::move(proof_source));
+}
+
+std::unique_ptr<KeyExchangeSource> MaybeWrapKeyExchangeSource(
+    QuicCryptoThreadPool* crypto_thread_pool,
+    std::unique_ptr<KeyExchangeSource> key_exchange_source) {
+  if (crypto_thread_pool == nullptr) {
+    return key_exchange_source;
+  }
+  return crypto_thread_pool->WrapKeyExchangeSource(
+      std::move(key_exchange_source));
+}
+
 }  // namespace
 
 const size_t kNumSessionsToCreatePerSocketEvent = 16;
@@ -66,17 +86,37 @@ QuicServer::QuicServer(
     const ParsedQuicVersionVector& supported_versions,
     QuicSimpleServerBackend* quic_simple_server_backend,
     uint8_t expected_server_connection_id_length)
+    : QuicServer(std::move(proof_source),
+                 config,
+                 crypto_config_options,
+                 supported_versions,
+                 quic_simple_server_backend,
+                 expected_server_connection_id_length,
+                 /*crypto_thread_pool=*/nullptr) {}
+
+QuicServer::QuicServer(
+    std::unique_ptr<ProofSource> proof_source,
+    const QuicConfig& config,
+    const QuicCryptoServerConfig::ConfigOptions& crypto_config_options,
+    const ParsedQuicVersionVector& supported_versions,
+    QuicSimpleServerBackend* quic_simple_server_backend,
+    uint8_t expected_server_connection_id_length,
+    std::unique_ptr<QuicCryptoThreadPool> crypto_thread_pool)
     : port_(0),
       fd_(-1),
       packets_dropped_(0),
       overflow_supported_(false),
+      enable_udp_gro_(false),
       silent_close_(false),
       config_(config),
       crypto_config_(kSourceAddressTokenSecret,
                      QuicRandom::GetInstance(),
-                     std::move(proof_source),
-                     KeyExchangeSource::Default()),
+                     MaybeWrapProofSource(crypto_thread_pool.get(),
+                                          std::move(proof_source)),
+                     MaybeWrapKeyExchangeSource(crypto_thread_pool.get(),
+                                                KeyExchangeSource::Default())),
       crypto_config_options_(crypto_config_options),
+      crypto_thread_pool_(std::move(crypto_thread_pool)),
       version_manager_(supported_versions),
       packet_reader_(new QuicPacketReader()),
       quic_simple_server_backend_(quic_simple_server_backend),
@@ -103,6 +143,9 @@ void QuicServer::Initialize() {
   }
 
   epoll_server_.set_timeout_in_us(50 * 1000);
+  if (crypto_thread_pool_ != nullptr) {
+    crypto_thread_pool_->AttachToEpollServer(&epoll_server_);
+  }
 
   QuicEpollClock clock(&epoll_server_);
 
@@ -110,7 +153,11 @@ void QuicServer::Initialize() {
       QuicRandom::GetInstance(), &clock, crypto_config_options_));
 }
 
-QuicServer::~QuicServer() = default;
+QuicServer::~QuicServer() {
+  // Sessions cancel the callbacks of their pending crypto operations, which
+  // are owned by crypto_thread_pool_, so they go first.
+  dispatcher_.reset();
+}
 
 bool QuicServer::CreateUDPSocketAndListen(const QuicSocketAddress& address) {
   QuicUdpSocketApi socket_api;
@@ -124,6 +171,14 @@ bool QuicServer::CreateUDPSocketAndListen(const QuicSocketAddress& address) {
 
   overflow_supported_ = socket_api.EnableDroppedPacketCount(fd_);
   socket_api.EnableReceiveTimestamp(fd_);
+  if (enable_udp_gro_) {
+    if (socket_api.EnableUdpGro(fd_)) {
+      packet_reader_->EnableUdpGro();
+    } else {
+      QUIC_LOG(WARNING) << "UDP GRO is not supported, reading one packet at "
+                           "a time.";
+    }
+  }
 
   sockaddr_storage addr = address.generic_address();
   int rc = bind(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
@@ -196,7 +251,13 @@ void QuicServer::OnEvent(int fd, QuicEpollEvent* event) {
   if (event->in_events & EPOLLIN) {
     QUIC_DVLOG(1) << "EPOLLIN";
 
-    dispatcher_->ProcessBufferedChlos(kNumSessionsToCreatePerSocketEvent);
+    size_t max_sessions_to_create = kNumSessionsToCreatePerSocketEvent;
+    if (crypto_thread_pool_ != nullptr) {
+      // Leave further CHLOs buffered while the pool is busy.
+      max_sessions_to_create = std::min(
+          max_sessions_to_create, crypto_thread_pool_->available_capacity());
+    }
+    dispatcher_->ProcessBufferedChlos(max_sessions_to_create);
 
     bool more_to_read = true;
     while (more_to_read) {
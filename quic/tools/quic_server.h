@@ -22,6 +22,7 @@
 #include "net/third_party/quiche/src/quic/core/quic_version_manager.h"
 #include "net/third_party/quiche/src/quic/platform/api/quic_epoll.h"
 #include "net/third_party/quiche/src/quic/platform/api/quic_socket_address.h"
+#include "net/third_party/quiche/src/quic/tools/quic_crypto_thread_pool.h"
 #include "net/third_party/quiche/src/quic/tools/quic_simple_server_backend.h"
 #include "net/third_party/quiche/src/quic/tools/quic_spdy_server_base.h"
 #include "net/third_party/quiche/src/common/platform/api/quiche_string_piece.h"
@@ -49,6 +50,16 @@ class QuicServer : public QuicSpdyServerBase,
              const ParsedQuicVersionVector& supported_versions,
              QuicSimpleServerBackend* quic_simple_server_backend,
              uint8_t expected_server_connection_id_length);
+  // If |crypto_thread_pool| is not null, handshake signing and key exchange
+  // run on it, and the server creates no more sessions per event than the pool
+  // has capacity for.
+  QuicServer(std::unique_ptr<ProofSource> proof_source,
+             const QuicConfig& config,
+             const QuicCryptoServerConfig::ConfigOptions& crypto_config_options,
+             const ParsedQuicVersionVector& supported_versions,
+             QuicSimpleServerBackend* quic_simple_server_backend,
+             uint8_t expected_server_connection_id_length,
+             std::unique_ptr<QuicCryptoThreadPool> crypto_thread_pool);
   QuicServer(const QuicServer&) = delete;
   QuicServer& operator=(const QuicServer&) = delete;
 
@@ -91,6 +102,10 @@ class QuicServer : public QuicSpdyServerBase,
 
   int port() { return port_; }
 
+  // If set before CreateUDPSocketAndListen, the listening socket reads
+  // coalesced UDP GRO buffers when the kernel supports it.
+  void set_enable_udp_gro(bool value) { enable_udp_gro_ = value; }
+
   QuicEpollServer* epoll_server() { return &epoll_server_; }
 
  protected:
@@ -141,6 +156,9 @@ class QuicServer : public QuicSpdyServerBase,
   // because the socket would otherwise overflow.
   bool overflow_supported_;
 
+  // If true, try to enable UDP GRO on the listening socket.
+  bool enable_udp_gro_;
+
   // If true, do not call Shutdown on the dispatcher.  Connections will close
   // without sending a final connection close.
   bool silent_close_;
@@ -152,6 +170,10 @@ class QuicServer : public QuicSpdyServerBase,
   QuicCryptoServerConfig crypto_config_;
   // crypto_config_options_ contains crypto parameters for the handshake.
   QuicCryptoServerConfig::ConfigOptions crypto_config_options_;
+  // Runs the crypto operations of crypto_config_ if not null. Declared after
+  // crypto_config_ so that its threads stop before the sources they call into
+  // are destroyed.
+  std::unique_ptr<QuicCryptoThreadPool> crypto_thread_pool_;
 
   // Used to generate current supported versions.
   QuicVersionManager version_manager_;
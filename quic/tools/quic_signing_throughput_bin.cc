@@ -0,0 +1,196 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Measures how many handshake signatures a server signs per second with the
+// test certificate, with and without batching. Each TLS 1.3 handshake and each
+// full QUIC crypto handshake signs once, so this bounds the handshakes per
+// second of a server which is limited by signing.
+//
+// Usage: quic_signing_throughput --num_threads=2 --batch_size=16
+
+#include <sys/resource.h>
+#include <time.h>
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "third_party/boringssl/src/include/openssl/ssl.h"
+#include "net/third_party/quiche/src/quic/core/crypto/certificate_view.h"
+#include "net/third_party/quiche/src/quic/core/crypto/proof_source_x509.h"
+#include "net/third_party/quiche/src/quic/core/quic_epoll_alarm_factory.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_epoll.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_flags.h"
+#include "net/quic/platform/impl/quic_epoll_clock.h"
+#include "net/third_party/quiche/src/quic/test_tools/test_certificates.h"
+#include "net/third_party/quiche/src/quic/tools/quic_batching_proof_source.h"
+#include "net/third_party/quiche/src/quic/tools/quic_crypto_thread_pool.h"
+
+DEFINE_QUIC_COMMAND_LINE_FLAG(int32_t,
+                              num_threads,
+                              1,
+                              "Number of crypto threads which sign.");
+
+DEFINE_QUIC_COMMAND_LINE_FLAG(int32_t,
+                              num_signatures,
+                              10000,
+                              "Number of signatures to compute.");
+
+DEFINE_QUIC_COMMAND_LINE_FLAG(int32_t,
+                              concurrency,
+                              64,
+                              "Number of signatures requested at a time, as "
+                              "by concurrent handshakes.");
+
+DEFINE_QUIC_COMMAND_LINE_FLAG(int32_t,
+                              batch_size,
+                              0,
+                              "If positive, batch up to this many signatures "
+                              "per crypto thread operation.");
+
+DEFINE_QUIC_COMMAND_LINE_FLAG(int32_t,
+                              batch_delay_us,
+                              1000,
+                              "Longest time a signature waits for its batch "
+                              "to fill.");
+
+namespace quic {
+
+namespace {
+
+double MonotonicSeconds() {
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+double ProcessCpuSeconds() {
+  rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 +
+         usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+}
+
+// Keeps |concurrency| signatures outstanding until |num_signatures| are done.
+class SigningLoad {
+ public:
+  SigningLoad(ProofSource* proof_source, int num_signatures)
+      : proof_source_(proof_source),
+        num_signatures_(num_signatures),
+        num_requested_(0),
+        num_done_(0),
+        num_failed_(0) {}
+
+  void RequestSignature() {
+    if (num_requested_ >= num_signatures_) {
+      return;
+    }
+    ++num_requested_;
+    proof_source_->ComputeTlsSignature(
+        QuicSocketAddress(), QuicSocketAddress(), "www.example.org",
+        SSL_SIGN_RSA_PSS_RSAE_SHA256, std::string(32, 'h'),
+        std::make_unique<Callback>(this));
+  }
+
+  bool done() const { return num_done_ == num_signatures_; }
+  int num_failed() const { return num_failed_; }
+
+ private:
+  class Callback : public ProofSource::SignatureCallback {
+   public:
+    explicit Callback(SigningLoad* load) : load_(load) {}
+
+    void Run(bool ok,
+             std::string /*signature*/,
+             std::unique_ptr<ProofSource::Details> /*details*/) override {
+      ++load_->num_done_;
+      if (!ok) {
+        ++load_->num_failed_;
+      }
+      load_->RequestSignature();
+    }
+
+   private:
+    SigningLoad* load_;
+  };
+
+  ProofSource* proof_source_;
+  const int num_signatures_;
+  int num_requested_;
+  int num_done_;
+  int num_failed_;
+};
+
+int RunSigningThroughput() {
+  std::unique_ptr<CertificatePrivateKey> key =
+      CertificatePrivateKey::LoadFromDer(test::kTestCertificatePrivateKey);
+  QuicReferenceCountedPointer<ProofSource::Chain> chain(new ProofSource::Chain(
+      std::vector<std::string>{std::string(test::kTestCertificate)}));
+  std::unique_ptr<ProofSource> x509_proof_source =
+      ProofSourceX509::Create(chain, std::move(*key));
+  if (x509_proof_source == nullptr) {
+    std::cerr << "Failed to load the test certificate" << std::endl;
+    return 1;
+  }
+
+  QuicEpollServer epoll_server;
+  epoll_server.set_timeout_in_us(10 * 1000);
+  QuicEpollClock clock(&epoll_server);
+  QuicEpollAlarmFactory alarm_factory(&epoll_server);
+
+  const int32_t num_threads = GetQuicFlag(FLAGS_num_threads);
+  const int32_t concurrency = GetQuicFlag(FLAGS_concurrency);
+  const int32_t batch_size = GetQuicFlag(FLAGS_batch_size);
+  std::unique_ptr<ProofSource> proof_source;
+  // Declared after |proof_source|, since running operations call into it.
+  auto pool = std::make_unique<QuicCryptoThreadPool>(num_threads, concurrency);
+  pool->AttachToEpollServer(&epoll_server);
+  if (batch_size > 0) {
+    proof_source = std::make_unique<QuicBatchingProofSource>(
+        std::move(x509_proof_source), pool.get(), &clock, &alarm_factory,
+        batch_size,
+        QuicTime::Delta::FromMicroseconds(GetQuicFlag(FLAGS_batch_delay_us)));
+  } else {
+    proof_source = pool->WrapProofSource(std::move(x509_proof_source));
+  }
+
+  SigningLoad load(proof_source.get(), GetQuicFlag(FLAGS_num_signatures));
+  const double start_time = MonotonicSeconds();
+  const double start_cpu_time = ProcessCpuSeconds();
+  for (int32_t i = 0; i < concurrency; ++i) {
+    load.RequestSignature();
+  }
+  while (!load.done()) {
+    epoll_server.WaitForEventsAndExecuteCallbacks();
+  }
+  const double elapsed = MonotonicSeconds() - start_time;
+  const double cpu_time = ProcessCpuSeconds() - start_cpu_time;
+
+  const int32_t num_signatures = GetQuicFlag(FLAGS_num_signatures);
+  std::cout << "threads: " << num_threads << ", batch size: " << batch_size
+            << ", concurrency: " << concurrency << std::endl;
+  std::cout << "signatures: " << num_signatures
+            << ", failed: " << load.num_failed() << std::endl;
+  std::cout << "signatures per second: " << num_signatures / elapsed
+            << std::endl;
+  std::cout << "signatures per CPU second: " << num_signatures / cpu_time
+            << std::endl;
+  return load.num_failed() == 0 ? 0 : 1;
+}
+
+}  // namespace
+
+}  // namespace quic
+
+int main(int argc, char* argv[]) {
+  const char* usage = "Usage: quic_signing_throughput [options]";
+  std::vector<std::string> args =
+      quic::QuicParseCommandLineFlags(usage, argc, argv);
+  if (!args.empty()) {
+    quic::QuicPrintCommandLineFlagHelp(usage);
+    exit(0);
+  }
+  return quic::RunSigningThroughput();
+}
@@ -31,9 +31,10 @@ bool HpackHeaderTable::EntriesEq::operator()(const HpackEntry* lhs,
 }
 
 HpackHeaderTable::HpackHeaderTable()
-    : static_entries_(ObtainHpackStaticTable().GetStaticEntries()),
-      static_index_(ObtainHpackStaticTable().GetStaticIndex()),
-      static_name_index_(ObtainHpackStaticTable().GetStaticNameIndex()),
+    : static_table_(ObtainHpackStaticTable()),
+      static_entries_(static_table_.GetStaticEntries()),
+      static_index_(static_table_.GetStaticIndex()),
+      static_name_index_(static_table_.GetStaticNameIndex()),
       settings_size_bound_(kDefaultHeaderTableSizeSetting),
       size_(0),
       max_size_(kDefaultHeaderTableSizeSetting),
@@ -62,9 +63,9 @@ const HpackEntry* HpackHeaderTable::GetByIndex(size_t index) {
 
 const HpackEntry* HpackHeaderTable::GetByName(quiche::QuicheStringPiece name) {
   {
-    auto it = static_name_index_.find(name);
-    if (it != static_name_index_.end()) {
-      return it->second;
+    const HpackEntry* result = static_table_.GetByName(name);
+    if (result != nullptr) {
+      return result;
     }
   }
   {
@@ -83,14 +84,14 @@ const HpackEntry* HpackHeaderTable::GetByName(quiche::QuicheStringPiece name) {
 const HpackEntry* HpackHeaderTable::GetByNameAndValue(
     quiche::QuicheStringPiece name,
     quiche::QuicheStringPiece value) {
-  HpackEntry query(name, value);
   {
-    auto it = static_index_.find(&query);
-    if (it != static_index_.end()) {
-      return *it;
+    const HpackEntry* result = static_table_.GetByNameAndValue(name, value);
+    if (result != nullptr) {
+      return result;
     }
   }
   {
+    HpackEntry query(name, value);
     auto it = dynamic_index_.find(&query);
     if (it != dynamic_index_.end()) {
       const HpackEntry* result = *it;
@@ -24,6 +24,8 @@ namespace test {
 class HpackHeaderTablePeer;
 }  // namespace test
 
+class HpackStaticTable;
+
 // A data structure for the static table (2.3.1) and the dynamic table (2.3.2).
 class QUICHE_EXPORT_PRIVATE HpackHeaderTable {
  public:
@@ -141,8 +143,11 @@ class QUICHE_EXPORT_PRIVATE HpackHeaderTable {
   // Evicts |count| oldest entries from the table.
   void Evict(size_t count);
 
-  // |static_entries_|, |static_index_|, and |static_name_index_| are owned by
-  // HpackStaticTable singleton.
+  // |static_table_|, |static_entries_|, |static_index_|, and
+  // |static_name_index_| are owned by HpackStaticTable singleton.
+
+  // Looks up static entries by name, or by name and value.
+  const HpackStaticTable& static_table_;
 
   // Tracks HpackEntries by index.
   const EntryTable& static_entries_;
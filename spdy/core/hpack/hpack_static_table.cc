@@ -4,6 +4,9 @@
 
 #include "net/third_party/quiche/src/spdy/core/hpack/hpack_static_table.h"
 
+#include <cstring>
+#include <limits>
+
 #include "net/third_party/quiche/src/common/platform/api/quiche_string_piece.h"
 #include "net/third_party/quiche/src/spdy/core/hpack/hpack_constants.h"
 #include "net/third_party/quiche/src/spdy/core/hpack/hpack_entry.h"
@@ -12,6 +15,48 @@
 
 namespace spdy {
 
+namespace {
+
+const uint64_t kHashMultiplier = UINT64_C(0x9e3779b97f4a7c15);
+
+// Number of seeds tried for each table size before doubling it.
+const int kMaxSeedsPerTableSize = 1000;
+
+// Largest perfect hash table built, in log2 of the number of slots.
+const int kMaxTableSizeLog2 = 12;
+
+// Hashes |data| eight bytes at a time. This only needs to spread the static
+// table keys well enough for a collision-free seed to be found quickly.
+uint64_t HashString(quiche::QuicheStringPiece data, uint64_t seed) {
+  uint64_t hash = seed ^ (data.size() * kHashMultiplier);
+  size_t offset = 0;
+  for (; offset + sizeof(uint64_t) <= data.size();
+       offset += sizeof(uint64_t)) {
+    uint64_t word;
+    memcpy(&word, data.data() + offset, sizeof(word));
+    hash = (hash ^ word) * kHashMultiplier;
+    hash ^= hash >> 29;
+  }
+  if (offset < data.size()) {
+    uint64_t word = 0;
+    memcpy(&word, data.data() + offset, data.size() - offset);
+    hash = (hash ^ word) * kHashMultiplier;
+  }
+  return hash ^ (hash >> 32);
+}
+
+uint64_t HashName(quiche::QuicheStringPiece name, uint64_t seed) {
+  return HashString(name, seed);
+}
+
+uint64_t HashNameAndValue(quiche::QuicheStringPiece name,
+                          quiche::QuicheStringPiece value,
+                          uint64_t seed) {
+  return HashString(value, HashString(name, seed));
+}
+
+}  // namespace
+
 HpackStaticTable::HpackStaticTable() = default;
 
 HpackStaticTable::~HpackStaticTable() = default;
@@ -35,16 +80,115 @@ void HpackStaticTable::Initialize(const HpackStaticEntry* static_entry_table,
 
     ++total_insertions;
   }
+
+  if (static_entries_.size() >= std::numeric_limits<uint16_t>::max()) {
+    return;
+  }
+  std::vector<const HpackEntry*> entries;
+  std::vector<const HpackEntry*> first_entry_per_name;
+  for (const HpackEntry& entry : static_entries_) {
+    entries.push_back(&entry);
+    if (static_name_index_.find(entry.name())->second == &entry) {
+      first_entry_per_name.push_back(&entry);
+    }
+  }
+  if (!BuildPerfectHashIndex(
+          first_entry_per_name,
+          [](const HpackEntry& entry, uint64_t seed) {
+            return HashName(entry.name(), seed);
+          },
+          &name_hash_index_) ||
+      !BuildPerfectHashIndex(
+          entries,
+          [](const HpackEntry& entry, uint64_t seed) {
+            return HashNameAndValue(entry.name(), entry.value(), seed);
+          },
+          &entry_hash_index_)) {
+    SPDY_LOG(WARNING) << "No perfect hash found for static table.";
+    name_hash_index_ = PerfectHashIndex();
+    entry_hash_index_ = PerfectHashIndex();
+  }
+}
+
+template <typename HashFunction>
+bool HpackStaticTable::BuildPerfectHashIndex(
+    const std::vector<const HpackEntry*>& entries,
+    HashFunction hash,
+    PerfectHashIndex* index) {
+  // Start with at least twice as many slots as keys, which keeps the expected
+  // number of seeds to try small.
+  int table_size_log2 = 1;
+  while ((size_t{1} << table_size_log2) < 2 * entries.size()) {
+    ++table_size_log2;
+  }
+  for (; table_size_log2 <= kMaxTableSizeLog2; ++table_size_log2) {
+    index->shift = 64 - table_size_log2;
+    for (int attempt = 1; attempt <= kMaxSeedsPerTableSize; ++attempt) {
+      index->seed = attempt * kHashMultiplier;
+      index->slots.assign(size_t{1} << table_size_log2, 0);
+      bool collision = false;
+      for (const HpackEntry* entry : entries) {
+        uint16_t& slot =
+            index->slots[hash(*entry, index->seed) >> index->shift];
+        if (slot != 0) {
+          collision = true;
+          break;
+        }
+        slot = static_cast<uint16_t>(entry->InsertionIndex() + 1);
+      }
+      if (!collision) {
+        return true;
+      }
+    }
+  }
+  return false;
 }
 
 bool HpackStaticTable::IsInitialized() const {
   return !static_entries_.empty();
 }
 
+const HpackEntry* HpackStaticTable::GetByName(
+    quiche::QuicheStringPiece name) const {
+  if (name_hash_index_.slots.empty()) {
+    auto it = static_name_index_.find(name);
+    return it == static_name_index_.end() ? nullptr : it->second;
+  }
+  const uint16_t slot =
+      name_hash_index_.slots[HashName(name, name_hash_index_.seed) >>
+                             name_hash_index_.shift];
+  if (slot == 0) {
+    return nullptr;
+  }
+  const HpackEntry& entry = static_entries_[slot - 1];
+  return entry.name() == name ? &entry : nullptr;
+}
+
+const HpackEntry* HpackStaticTable::GetByNameAndValue(
+    quiche::QuicheStringPiece name,
+    quiche::QuicheStringPiece value) const {
+  if (entry_hash_index_.slots.empty()) {
+    HpackEntry query(name, value);
+    auto it = static_index_.find(&query);
+    return it == static_index_.end() ? nullptr : *it;
+  }
+  const uint16_t slot =
+      entry_hash_index_.slots[HashNameAndValue(name, value,
+                                               entry_hash_index_.seed) >>
+                              entry_hash_index_.shift];
+  if (slot == 0) {
+    return nullptr;
+  }
+  const HpackEntry& entry = static_entries_[slot - 1];
+  return entry.name() == name && entry.value() == value ? &entry : nullptr;
+}
+
 size_t HpackStaticTable::EstimateMemoryUsage() const {
   return SpdyEstimateMemoryUsage(static_entries_) +
          SpdyEstimateMemoryUsage(static_index_) +
-         SpdyEstimateMemoryUsage(static_name_index_);
+         SpdyEstimateMemoryUsage(static_name_index_) +
+         SpdyEstimateMemoryUsage(name_hash_index_.slots) +
+         SpdyEstimateMemoryUsage(entry_hash_index_.slots);
 }
 
 }  // namespace spdy
@@ -5,7 +5,12 @@
 #ifndef QUICHE_SPDY_CORE_HPACK_HPACK_STATIC_TABLE_H_
 #define QUICHE_SPDY_CORE_HPACK_HPACK_STATIC_TABLE_H_
 
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
 #include "net/third_party/quiche/src/common/platform/api/quiche_export.h"
+#include "net/third_party/quiche/src/common/platform/api/quiche_string_piece.h"
 #include "net/third_party/quiche/src/spdy/core/hpack/hpack_header_table.h"
 
 namespace spdy {
@@ -29,6 +34,13 @@ class QUICHE_EXPORT_PRIVATE HpackStaticTable {
   // Returns whether Initialize() has been called.
   bool IsInitialized() const;
 
+  // Returns the lowest-index static entry having |name|, or nullptr.
+  const HpackEntry* GetByName(quiche::QuicheStringPiece name) const;
+
+  // Returns the static entry matching |name| and |value|, or nullptr.
+  const HpackEntry* GetByNameAndValue(quiche::QuicheStringPiece name,
+                                      quiche::QuicheStringPiece value) const;
+
   // Accessors.
   const HpackHeaderTable::EntryTable& GetStaticEntries() const {
     return static_entries_;
@@ -44,9 +56,36 @@ class QUICHE_EXPORT_PRIVATE HpackStaticTable {
   size_t EstimateMemoryUsage() const;
 
  private:
+  // A perfect hash over a fixed set of keys: hashing any of the keys with
+  // |seed| yields a distinct slot, so that a lookup takes one probe and one
+  // key comparison. Keys not in the set may land anywhere and are rejected by
+  // the comparison.
+  struct QUICHE_EXPORT_PRIVATE PerfectHashIndex {
+    uint64_t seed = 0;
+    // A hash selects slot |hash >> shift|.
+    int shift = 0;
+    // Index of the static entry for each slot plus one, or zero if the slot
+    // is unused.
+    std::vector<uint16_t> slots;
+  };
+
+  // Searches for a seed and table size for which |hash| is a perfect hash of
+  // |entries|, and fills in |index|. Returns false if none is found, in which
+  // case lookups fall back to |static_index_| and |static_name_index_|.
+  template <typename HashFunction>
+  static bool BuildPerfectHashIndex(
+      const std::vector<const HpackEntry*>& entries,
+      HashFunction hash,
+      PerfectHashIndex* index);
+
   HpackHeaderTable::EntryTable static_entries_;
   HpackHeaderTable::UnorderedEntrySet static_index_;
   HpackHeaderTable::NameToEntryMap static_name_index_;
+
+  // Perfect hashes of the distinct names and of the name-value pairs of
+  // |static_entries_|.
+  PerfectHashIndex name_hash_index_;
+  PerfectHashIndex entry_hash_index_;
 };
 
 }  // namespace spdy
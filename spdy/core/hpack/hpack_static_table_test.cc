@@ -46,6 +46,31 @@ TEST_F(HpackStaticTableTest, Initialize) {
   EXPECT_EQ(names.size(), static_name_index.size());
 }
 
+TEST_F(HpackStaticTableTest, Lookup) {
+  table_.Initialize(HpackStaticTableVector().data(),
+                    HpackStaticTableVector().size());
+
+  for (const HpackEntry& entry : table_.GetStaticEntries()) {
+    EXPECT_EQ(&entry, table_.GetByNameAndValue(entry.name(), entry.value()));
+    const HpackEntry* by_name = table_.GetByName(entry.name());
+    ASSERT_NE(nullptr, by_name);
+    EXPECT_EQ(entry.name(), by_name->name());
+    EXPECT_LE(by_name->InsertionIndex(), entry.InsertionIndex());
+  }
+
+  // The lowest-index entry is returned for names with several entries.
+  EXPECT_EQ(1u, table_.GetByName(":method")->InsertionIndex());
+  EXPECT_EQ(7u, table_.GetByName(":status")->InsertionIndex());
+
+  EXPECT_EQ(nullptr, table_.GetByName(":foo"));
+  EXPECT_EQ(nullptr, table_.GetByName(""));
+  EXPECT_EQ(nullptr, table_.GetByName("accept-encodin"));
+  EXPECT_EQ(nullptr, table_.GetByNameAndValue(":method", "PUT"));
+  EXPECT_EQ(nullptr, table_.GetByNameAndValue(":status", "201"));
+  EXPECT_EQ(nullptr, table_.GetByNameAndValue("accept", "gzip"));
+  EXPECT_EQ(nullptr, table_.GetByNameAndValue("", ""));
+}
+
 // Test that ObtainHpackStaticTable returns the same instance every time.
 TEST_F(HpackStaticTableTest, IsSingleton) {
   const HpackStaticTable* static_table_one = &ObtainHpackStaticTable();